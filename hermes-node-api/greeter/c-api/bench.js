@@ -0,0 +1,100 @@
+// Compares the cost per greeting of the single-call and the batched APIs.
+// Usage: node bench.js [count] [rounds]
+//        hermes-cli bench.js [count] [rounds]
+
+const greeter = require("bindings")("greeter");
+const common = require("../common");
+
+const count = Number(process.argv[2]) || 1000;
+const rounds = Number(process.argv[3]) || 200;
+
+const now =
+  typeof performance !== "undefined" && performance.now
+    ? () => performance.now()
+    : () => Date.now();
+
+// Decodes the UTF-8 bytes in [start, end) of the blob.
+// TextDecoder is not available in all runtimes.
+const decodeUtf8 =
+  typeof TextDecoder !== "undefined"
+    ? (() => {
+        const decoder = new TextDecoder();
+        return (blob, start, end) => decoder.decode(blob.subarray(start, end));
+      })()
+    : (blob, start, end) => {
+        let result = "";
+        let i = start;
+        while (i < end) {
+          let c = blob[i++];
+          if (c >= 0xf0) {
+            c = ((c & 0x07) << 18) | ((blob[i++] & 0x3f) << 12) |
+                ((blob[i++] & 0x3f) << 6) | (blob[i++] & 0x3f);
+          } else if (c >= 0xe0) {
+            c = ((c & 0x0f) << 12) | ((blob[i++] & 0x3f) << 6) |
+                (blob[i++] & 0x3f);
+          } else if (c >= 0xc0) {
+            c = ((c & 0x1f) << 6) | (blob[i++] & 0x3f);
+          }
+          result += String.fromCodePoint(c);
+        }
+        return result;
+      };
+
+// Splits the ArrayBuffer returned by sayHelloManyBuffer into strings.
+function decodeGreetings(buffer, count) {
+  const offsets = new Uint32Array(buffer, 0, count + 1);
+  const blob = new Uint8Array(buffer, offsets.byteLength);
+  const result = new Array(count);
+  for (let i = 0; i < count; ++i) {
+    result[i] = decodeUtf8(blob, offsets[i], offsets[i + 1]);
+  }
+  return result;
+}
+
+const names = [];
+for (let i = 0; i < count; ++i) {
+  names.push("name #" + i + (i % 10 === 0 ? " (Grüße, 世界)" : ""));
+}
+
+const benchmarks = {
+  "sayHello per item": () => {
+    const result = new Array(count);
+    for (let i = 0; i < count; ++i) {
+      result[i] = greeter.sayHello(names[i]);
+    }
+    return result;
+  },
+  "sayHelloMany": () => greeter.sayHelloMany(names),
+  "sayHelloManyBuffer": () => greeter.sayHelloManyBuffer(names),
+  "sayHelloManyBuffer + decode": () =>
+    decodeGreetings(greeter.sayHelloManyBuffer(names), count),
+};
+
+// All variants must produce the same greetings.
+const expected = benchmarks["sayHello per item"]();
+const actual = benchmarks["sayHelloManyBuffer + decode"]();
+const batched = benchmarks["sayHelloMany"]();
+for (let i = 0; i < count; ++i) {
+  if (expected[i] !== batched[i] || expected[i] !== actual[i]) {
+    throw new Error("Greeting mismatch at index " + i);
+  }
+}
+
+console.log(common.format("Greeting " + count + " names x " + rounds +
+    " rounds"));
+for (const name of Object.keys(benchmarks)) {
+  const run = benchmarks[name];
+  for (let i = 0; i < rounds / 10; ++i) {
+    run();
+  }
+  const start = now();
+  for (let i = 0; i < rounds; ++i) {
+    run();
+  }
+  const elapsedMs = now() - start;
+  const nsPerItem = (elapsedMs * 1e6) / (rounds * count);
+  console.log(name.padEnd(28) + nsPerItem.toFixed(1).padStart(10) +
+      " ns/item");
+}
+
+common.printJSEngineInfo();
@@ -1,5 +1,35 @@
 #include <node_api.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GREETING_PREFIX "C API: Hello, "
+#define GREETING_PREFIX_LENGTH (sizeof(GREETING_PREFIX) - 1)
+
+// Returns NULL from the function if the Node-API call fails.
+// The error is thrown to JS unless an exception is already pending.
+#define NAPI_CALL(env, call)                                                   \
+  do {                                                                         \
+    if ((call) != napi_ok) {                                                   \
+      ThrowLastError((env));                                                   \
+      return NULL;                                                             \
+    }                                                                          \
+  } while (0)
+
+static void ThrowLastError(napi_env env) {
+  const napi_extended_error_info* error_info = NULL;
+  bool is_pending = false;
+  napi_is_exception_pending(env, &is_pending);
+  if (!is_pending) {
+    napi_get_last_error_info(env, &error_info);
+    napi_throw_error(env,
+                     NULL,
+                     error_info != NULL && error_info->error_message != NULL
+                         ? error_info->error_message
+                         : "Node-API call failed");
+  }
+}
 
 static napi_value SayHello(napi_env env, const napi_callback_info info) {
   size_t argc = 1;
@@ -17,10 +47,411 @@ static napi_value SayHello(napi_env env, const napi_callback_info info) {
   return result;
 }
 
+// Gets the array argument and its length.
+static napi_value GetArrayArg(napi_env env,
+                              const napi_callback_info info,
+                              uint32_t* length) {
+  size_t argc = 1;
+  napi_value array = NULL;
+  bool is_array = false;
+
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, &array, NULL, NULL));
+  if (argc < 1 || napi_is_array(env, array, &is_array) != napi_ok ||
+      !is_array) {
+    napi_throw_type_error(env, NULL, "Expected an array of names");
+    return NULL;
+  }
+  NAPI_CALL(env, napi_get_array_length(env, array, length));
+  return array;
+}
+
+// sayHelloMany(names: string[]): string[]
+// Greets all names in one call. The greetings are formatted in a buffer that
+// is reused for all items and only grows for longer names.
+static napi_value SayHelloMany(napi_env env, const napi_callback_info info) {
+  uint32_t length = 0;
+  napi_value names = GetArrayArg(env, info, &length);
+  napi_value result = NULL;
+  char* message = NULL;
+  size_t message_capacity = 0;
+  uint32_t i = 0;
+
+  if (names == NULL) return NULL;
+  NAPI_CALL(env, napi_create_array_with_length(env, length, &result));
+
+  for (i = 0; i < length; ++i) {
+    napi_value name = NULL;
+    napi_value greeting = NULL;
+    size_t name_length = 0;
+
+    if (napi_get_element(env, names, i, &name) != napi_ok ||
+        napi_get_value_string_utf8(env, name, NULL, 0, &name_length) !=
+            napi_ok) {
+      free(message);
+      napi_throw_type_error(env, NULL, "Expected an array of names");
+      return NULL;
+    }
+
+    // The prefix, the name, and the terminating zero.
+    if (GREETING_PREFIX_LENGTH + name_length + 1 > message_capacity) {
+      char* new_message = NULL;
+      message_capacity = (GREETING_PREFIX_LENGTH + name_length + 1) * 2;
+      new_message = (char*)realloc(message, message_capacity);
+      if (new_message == NULL) {
+        free(message);
+        napi_throw_error(env, NULL, "Out of memory");
+        return NULL;
+      }
+      message = new_message;
+      memcpy(message, GREETING_PREFIX, GREETING_PREFIX_LENGTH);
+    }
+
+    napi_get_value_string_utf8(env,
+                               name,
+                               message + GREETING_PREFIX_LENGTH,
+                               name_length + 1,
+                               NULL);
+    if (napi_create_string_utf8(env,
+                                message,
+                                GREETING_PREFIX_LENGTH + name_length,
+                                &greeting) != napi_ok ||
+        napi_set_element(env, result, i, greeting) != napi_ok) {
+      free(message);
+      ThrowLastError(env);
+      return NULL;
+    }
+  }
+
+  free(message);
+  return result;
+}
+
+// sayHelloManyBuffer(names: string[]): ArrayBuffer
+// Greets all names in one call without creating JS strings.
+// The result is one ArrayBuffer with the layout:
+//   uint32 offsets[names.length + 1]; // byte offsets into the UTF-8 blob
+//   uint8  blob[];                    // concatenated UTF-8 greetings
+// Greeting i is blob[offsets[i]..offsets[i + 1]).
+static napi_value SayHelloManyBuffer(napi_env env,
+                                     const napi_callback_info info) {
+  uint32_t length = 0;
+  napi_value names = GetArrayArg(env, info, &length);
+  napi_value* name_values = NULL;
+  napi_value result = NULL;
+  void* data = NULL;
+  uint32_t* offsets = NULL;
+  char* blob = NULL;
+  size_t offsets_size = 0;
+  size_t blob_size = 0;
+  uint32_t i = 0;
+
+  if (names == NULL) return NULL;
+  name_values = (napi_value*)malloc((length + 1) * sizeof(napi_value));
+  if (name_values == NULL) {
+    napi_throw_error(env, NULL, "Out of memory");
+    return NULL;
+  }
+
+  // The first pass computes the blob size.
+  for (i = 0; i < length; ++i) {
+    size_t name_length = 0;
+    if (napi_get_element(env, names, i, &name_values[i]) != napi_ok ||
+        napi_get_value_string_utf8(
+            env, name_values[i], NULL, 0, &name_length) != napi_ok) {
+      free(name_values);
+      napi_throw_type_error(env, NULL, "Expected an array of names");
+      return NULL;
+    }
+    blob_size += GREETING_PREFIX_LENGTH + name_length;
+  }
+  if (blob_size > UINT32_MAX) {
+    free(name_values);
+    napi_throw_range_error(env, NULL, "Greetings are too large");
+    return NULL;
+  }
+
+  // One extra byte for the zero written after the last name.
+  offsets_size = ((size_t)length + 1) * sizeof(uint32_t);
+  if (napi_create_arraybuffer(
+          env, offsets_size + blob_size + 1, &data, &result) != napi_ok) {
+    free(name_values);
+    ThrowLastError(env);
+    return NULL;
+  }
+  offsets = (uint32_t*)data;
+  blob = (char*)data + offsets_size;
+
+  // The second pass writes the greetings straight into the ArrayBuffer.
+  // The zero written after each name is overwritten by the next prefix.
+  offsets[0] = 0;
+  for (i = 0; i < length; ++i) {
+    size_t name_length = 0;
+    char* greeting = blob + offsets[i];
+    memcpy(greeting, GREETING_PREFIX, GREETING_PREFIX_LENGTH);
+    napi_get_value_string_utf8(env,
+                               name_values[i],
+                               greeting + GREETING_PREFIX_LENGTH,
+                               blob_size + 1 - offsets[i] -
+                                   GREETING_PREFIX_LENGTH,
+                               &name_length);
+    offsets[i + 1] =
+        offsets[i] + (uint32_t)(GREETING_PREFIX_LENGTH + name_length);
+  }
+
+  free(name_values);
+  return result;
+}
+
+// A greeting request formatted on a worker thread by the async work.
+// The names and the greetings are stored as UTF-8 blobs with offsets in the
+// same layout as the sayHelloManyBuffer result.
+typedef struct {
+  napi_async_work work;
+  napi_deferred deferred;
+  bool is_batch;
+  uint32_t count;
+  uint32_t* name_offsets;
+  char* names;
+  uint32_t* greeting_offsets;
+  char* greetings;
+} GreetRequest;
+
+static void DeleteGreetRequest(napi_env env, GreetRequest* request) {
+  if (request->work != NULL) {
+    napi_delete_async_work(env, request->work);
+  }
+  free(request->name_offsets);
+  free(request->names);
+  free(request->greeting_offsets);
+  free(request->greetings);
+  free(request);
+}
+
+// Copies the names to the request. It must be called on the JS thread.
+static bool CopyNames(napi_env env,
+                      GreetRequest* request,
+                      const napi_value* names) {
+  size_t names_size = 0;
+  uint32_t i = 0;
+
+  request->name_offsets =
+      (uint32_t*)malloc(((size_t)request->count + 1) * sizeof(uint32_t));
+  if (request->name_offsets == NULL) return false;
+  request->name_offsets[0] = 0;
+  for (i = 0; i < request->count; ++i) {
+    size_t name_length = 0;
+    if (napi_get_value_string_utf8(env, names[i], NULL, 0, &name_length) !=
+        napi_ok) {
+      return false;
+    }
+    names_size += name_length;
+    if (names_size > UINT32_MAX) return false;
+    request->name_offsets[i + 1] = (uint32_t)names_size;
+  }
+
+  request->names = (char*)malloc(names_size + 1);
+  if (request->names == NULL) return false;
+  for (i = 0; i < request->count; ++i) {
+    uint32_t offset = request->name_offsets[i];
+    napi_get_value_string_utf8(env,
+                               names[i],
+                               request->names + offset,
+                               names_size + 1 - offset,
+                               NULL);
+  }
+  return true;
+}
+
+// Formats the greetings. It is called on a worker thread and must not call
+// Node-API functions.
+static void ExecuteGreetRequest(napi_env env, void* data) {
+  GreetRequest* request = (GreetRequest*)data;
+  size_t greetings_size = 0;
+  uint32_t i = 0;
+
+  greetings_size = (size_t)request->count * GREETING_PREFIX_LENGTH +
+                   request->name_offsets[request->count];
+  request->greeting_offsets =
+      (uint32_t*)malloc(((size_t)request->count + 1) * sizeof(uint32_t));
+  request->greetings = (char*)malloc(greetings_size + 1);
+  if (request->greeting_offsets == NULL || request->greetings == NULL) {
+    return;
+  }
+
+  request->greeting_offsets[0] = 0;
+  for (i = 0; i < request->count; ++i) {
+    uint32_t name_offset = request->name_offsets[i];
+    uint32_t name_length = request->name_offsets[i + 1] - name_offset;
+    char* greeting = request->greetings + request->greeting_offsets[i];
+    memcpy(greeting, GREETING_PREFIX, GREETING_PREFIX_LENGTH);
+    memcpy(greeting + GREETING_PREFIX_LENGTH,
+           request->names + name_offset,
+           name_length);
+    request->greeting_offsets[i + 1] = request->greeting_offsets[i] +
+                                       GREETING_PREFIX_LENGTH + name_length;
+  }
+}
+
+static napi_value CreateGreetResult(napi_env env, GreetRequest* request) {
+  napi_value result = NULL;
+  uint32_t i = 0;
+
+  if (request->greetings == NULL || request->greeting_offsets == NULL) {
+    napi_throw_error(env, NULL, "Out of memory");
+    return NULL;
+  }
+  if (!request->is_batch) {
+    NAPI_CALL(env,
+              napi_create_string_utf8(env,
+                                      request->greetings,
+                                      request->greeting_offsets[1],
+                                      &result));
+    return result;
+  }
+
+  NAPI_CALL(env, napi_create_array_with_length(env, request->count, &result));
+  for (i = 0; i < request->count; ++i) {
+    napi_value greeting = NULL;
+    uint32_t offset = request->greeting_offsets[i];
+    NAPI_CALL(env,
+              napi_create_string_utf8(env,
+                                      request->greetings + offset,
+                                      request->greeting_offsets[i + 1] - offset,
+                                      &greeting));
+    NAPI_CALL(env, napi_set_element(env, result, i, greeting));
+  }
+  return result;
+}
+
+// Settles the promise on the JS thread.
+static void CompleteGreetRequest(napi_env env, napi_status status, void* data) {
+  GreetRequest* request = (GreetRequest*)data;
+  napi_value result = NULL;
+
+  if (status == napi_ok) {
+    result = CreateGreetResult(env, request);
+  }
+  if (result != NULL) {
+    napi_resolve_deferred(env, request->deferred, result);
+  } else {
+    bool is_pending = false;
+    napi_is_exception_pending(env, &is_pending);
+    if (is_pending) {
+      napi_get_and_clear_last_exception(env, &result);
+    } else {
+      napi_value message = NULL;
+      napi_create_string_utf8(
+          env, "The greeting request was cancelled", NAPI_AUTO_LENGTH,
+          &message);
+      napi_create_error(env, NULL, message, &result);
+    }
+    napi_reject_deferred(env, request->deferred, result);
+  }
+  DeleteGreetRequest(env, request);
+}
+
+// Queues the async work for the names and returns its promise.
+static napi_value QueueGreetRequest(napi_env env,
+                                    const napi_value* names,
+                                    uint32_t count,
+                                    bool is_batch,
+                                    const char* resource_name) {
+  GreetRequest* request = NULL;
+  napi_value promise = NULL;
+  napi_value resource_name_value = NULL;
+
+  request = (GreetRequest*)calloc(1, sizeof(GreetRequest));
+  if (request == NULL) {
+    napi_throw_error(env, NULL, "Out of memory");
+    return NULL;
+  }
+  request->is_batch = is_batch;
+  request->count = count;
+  if (!CopyNames(env, request, names)) {
+    DeleteGreetRequest(env, request);
+    napi_throw_type_error(env, NULL, "Expected a string name");
+    return NULL;
+  }
+
+  if (napi_create_string_utf8(env,
+                              resource_name,
+                              NAPI_AUTO_LENGTH,
+                              &resource_name_value) != napi_ok ||
+      napi_create_async_work(env,
+                             NULL,
+                             resource_name_value,
+                             ExecuteGreetRequest,
+                             CompleteGreetRequest,
+                             request,
+                             &request->work) != napi_ok ||
+      napi_create_promise(env, &request->deferred, &promise) != napi_ok) {
+    // Throw first: deleting the request overwrites the last error info.
+    ThrowLastError(env);
+    DeleteGreetRequest(env, request);
+    return NULL;
+  }
+  if (napi_queue_async_work(env, request->work) != napi_ok) {
+    ThrowLastError(env);
+    DeleteGreetRequest(env, request);
+    return NULL;
+  }
+  // The promise owns the request from here. It is deleted on completion.
+  return promise;
+}
+
+// sayHelloAsync(name: string): Promise<string>
+// Formats the greeting on a worker thread.
+static napi_value SayHelloAsync(napi_env env, const napi_callback_info info) {
+  size_t argc = 1;
+  napi_value name = NULL;
+
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, &name, NULL, NULL));
+  return QueueGreetRequest(env, &name, 1, false, "sayHelloAsync");
+}
+
+// sayHelloBatchAsync(names: string[]): Promise<string[]>
+// Formats all greetings on a worker thread in one async work item.
+static napi_value SayHelloBatchAsync(napi_env env,
+                                     const napi_callback_info info) {
+  uint32_t length = 0;
+  napi_value names = GetArrayArg(env, info, &length);
+  napi_value* name_values = NULL;
+  napi_value result = NULL;
+  uint32_t i = 0;
+
+  if (names == NULL) return NULL;
+  name_values = (napi_value*)malloc((length + 1) * sizeof(napi_value));
+  if (name_values == NULL) {
+    napi_throw_error(env, NULL, "Out of memory");
+    return NULL;
+  }
+  for (i = 0; i < length; ++i) {
+    if (napi_get_element(env, names, i, &name_values[i]) != napi_ok) {
+      free(name_values);
+      ThrowLastError(env);
+      return NULL;
+    }
+  }
+  result =
+      QueueGreetRequest(env, name_values, length, true, "sayHelloBatchAsync");
+  free(name_values);
+  return result;
+}
+
 static napi_value Init(napi_env env, napi_value exports) {
-  napi_property_descriptor prop_desc = {
-      "sayHello", NULL, SayHello, NULL, NULL, NULL, napi_default, NULL};
-  napi_define_properties(env, exports, 1, &prop_desc);
+  napi_property_descriptor prop_descs[] = {
+      {"sayHello", NULL, SayHello, NULL, NULL, NULL, napi_default, NULL},
+      {"sayHelloMany", NULL, SayHelloMany, NULL, NULL, NULL, napi_default,
+       NULL},
+      {"sayHelloManyBuffer", NULL, SayHelloManyBuffer, NULL, NULL, NULL,
+       napi_default, NULL},
+      {"sayHelloAsync", NULL, SayHelloAsync, NULL, NULL, NULL, napi_default,
+       NULL},
+      {"sayHelloBatchAsync", NULL, SayHelloBatchAsync, NULL, NULL, NULL,
+       napi_default, NULL},
+  };
+  napi_define_properties(
+      env, exports, sizeof(prop_descs) / sizeof(prop_descs[0]), prop_descs);
   return exports;
 }
 
@@ -0,0 +1,89 @@
+// Stress test of the async greeter functions of the C and C++ demos.
+// It issues many concurrent requests, waits for all of them, and reports the
+// throughput of the cross-thread completion path.
+// It is for the demo purpose only. Do not use this code in production.
+//
+// Usage: hermes-cli stress.js <demo_dir> [count] [batchSize]
+//        node stress.js <demo_dir> [count] [batchSize]
+
+const fs = require("fs");
+const path = require("path");
+const common = require("./index");
+
+const now =
+  typeof performance !== "undefined" && performance.now
+    ? () => performance.now()
+    : () => Date.now();
+
+function report(label, requests, greetings, elapsedMs) {
+  const seconds = elapsedMs / 1000;
+  console.log(label.padEnd(20) + String(requests).padStart(8) + " requests " +
+      (requests / seconds).toFixed(0).padStart(10) + " req/s " +
+      (greetings / seconds).toFixed(0).padStart(10) + " greetings/s");
+}
+
+function check(greeting, expected) {
+  if (greeting !== expected) {
+    throw new Error("Unexpected greeting: '" + greeting + "', expected: '" +
+        expected + "'");
+  }
+}
+
+// Loads the greeter addon built in the demo folder.
+function loadGreeter(demoDir) {
+  for (const buildDir of ["build/Release", "build/Debug"]) {
+    const addonPath = path.resolve(demoDir, buildDir, "greeter.node");
+    if (fs.existsSync(addonPath)) {
+      return require(addonPath);
+    }
+  }
+  throw new Error("The greeter addon is not built in '" + demoDir + "'");
+}
+
+// greeter - the module with sayHello, sayHelloAsync, and sayHelloBatchAsync.
+// count - the number of concurrent single requests.
+// batchSize - the number of names in one batch request.
+async function run(greeter, count, batchSize) {
+  console.log(common.format("Async stress test: " + count + " greetings"));
+
+  const names = new Array(count);
+  for (let i = 0; i < count; ++i) {
+    names[i] = "name #" + i;
+  }
+
+  let start = now();
+  const promises = new Array(count);
+  for (let i = 0; i < count; ++i) {
+    promises[i] = greeter.sayHelloAsync(names[i]);
+  }
+  const greetings = await Promise.all(promises);
+  report("sayHelloAsync", count, count, now() - start);
+  for (let i = 0; i < count; i += 997) {
+    check(greetings[i], greeter.sayHello(names[i]));
+  }
+
+  start = now();
+  const batches = [];
+  for (let i = 0; i < count; i += batchSize) {
+    batches.push(greeter.sayHelloBatchAsync(names.slice(i, i + batchSize)));
+  }
+  const batchGreetings = await Promise.all(batches);
+  report("sayHelloBatchAsync", batches.length, count, now() - start);
+  for (let i = 0; i < count; i += 997) {
+    check(batchGreetings[Math.floor(i / batchSize)][i % batchSize],
+        greeter.sayHello(names[i]));
+  }
+
+  common.printJSEngineInfo();
+}
+
+const demoDir = process.argv[2] || ".";
+const count = Number(process.argv[3]) || 100000;
+const batchSize = Number(process.argv[4]) || 100;
+
+Promise.resolve()
+  .then(() => run(loadGreeter(demoDir), count, batchSize))
+  .catch((error) => {
+    console.log(String(error));
+    process.exitCode = 1;
+  });
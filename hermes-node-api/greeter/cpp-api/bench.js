@@ -0,0 +1,52 @@
+// Compares the call rate of sayHello and sayHelloFast.
+// Usage: node bench.js [calls]
+//        hermes-cli bench.js [calls]
+
+const greeter = require("bindings")("greeter");
+const common = require("../common");
+
+const calls = Number(process.argv[2]) || 200000;
+
+const now =
+  typeof performance !== "undefined" && performance.now
+    ? () => performance.now()
+    : () => Date.now();
+
+const names = {
+  "short latin1": "world",
+  "long latin1": "Jörg ".repeat(40),
+  "short UTF-16": "世界",
+  "long UTF-16": "世界 ".repeat(40),
+};
+
+// Both functions must produce the same greetings.
+for (const name of Object.values(names)) {
+  if (greeter.sayHello(name) !== greeter.sayHelloFast(name)) {
+    throw new Error("Greeting mismatch for '" + name + "'");
+  }
+}
+
+function measure(func, name) {
+  for (let i = 0; i < calls / 10; ++i) {
+    func(name);
+  }
+  const start = now();
+  for (let i = 0; i < calls; ++i) {
+    func(name);
+  }
+  const elapsedMs = now() - start;
+  return elapsedMs > 0 ? (calls * 1000) / elapsedMs : Infinity;
+}
+
+console.log(common.format("Calling each function " + calls + " times"));
+console.log("name".padEnd(16) + "sayHello/s".padStart(14) +
+    "sayHelloFast/s".padStart(16) + "speedup".padStart(10));
+for (const [label, name] of Object.entries(names)) {
+  const baseRate = measure(greeter.sayHello, name);
+  const fastRate = measure(greeter.sayHelloFast, name);
+  console.log(label.padEnd(16) + baseRate.toFixed(0).padStart(14) +
+      fastRate.toFixed(0).padStart(16) +
+      ((fastRate / baseRate).toFixed(2) + "x").padStart(10));
+}
+
+common.printJSEngineInfo();
@@ -1,4 +1,209 @@
 #include <napi.h>
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view kGreetingPrefix = "C++ API: Hello, ";
+constexpr std::string_view kGreetingSuffix = "!";
+
+// A greeting request formatted on the worker thread.
+// The names are replaced by their greetings in place.
+struct GreetRequest {
+  napi_deferred deferred{};
+  bool is_batch{};
+  std::vector<std::string> names;
+};
+
+// Formats greetings on a native worker thread and settles their promises on
+// the JS thread through a threadsafe function. One worker thread and one TSFN
+// are shared by all requests of the env. The TSFN is ref'ed only while there
+// are pending requests, so that an idle worker does not keep the process
+// alive. The worker is deleted by the TSFN finalizer.
+class GreeterWorker {
+ public:
+  static GreeterWorker* Create(napi_env env) {
+    napi_value resource_name{};
+    if (napi_create_string_utf8(
+            env, "GreeterWorker", NAPI_AUTO_LENGTH, &resource_name) !=
+        napi_ok) {
+      return nullptr;
+    }
+    GreeterWorker* worker = new GreeterWorker();
+    if (napi_create_threadsafe_function(env,
+                                        nullptr,
+                                        nullptr,
+                                        resource_name,
+                                        0,
+                                        1,
+                                        nullptr,
+                                        Finalize,
+                                        worker,
+                                        CompleteRequest,
+                                        &worker->tsfn_) != napi_ok) {
+      delete worker;
+      return nullptr;
+    }
+    napi_unref_threadsafe_function(env, worker->tsfn_);
+    worker->thread_ = std::thread([worker]() { worker->Run(); });
+    return worker;
+  }
+
+  // Queues the request. It is called on the JS thread.
+  bool Post(napi_env env, std::unique_ptr<GreetRequest> request) {
+    if (pending_count_ == 0 &&
+        napi_ref_threadsafe_function(env, tsfn_) != napi_ok) {
+      return false;
+    }
+    ++pending_count_;
+    {
+      std::scoped_lock lock{mutex_};
+      queue_.push_back(std::move(request));
+    }
+    request_queued_.notify_one();
+    return true;
+  }
+
+ private:
+  GreeterWorker() = default;
+
+  void Run() {
+    std::vector<std::unique_ptr<GreetRequest>> batch;
+    for (;;) {
+      {
+        std::unique_lock lock{mutex_};
+        request_queued_.wait(
+            lock, [this]() { return !queue_.empty() || is_stopped_; });
+        if (is_stopped_) {
+          return;
+        }
+        batch.swap(queue_);
+      }
+      for (std::unique_ptr<GreetRequest>& request : batch) {
+        for (std::string& name : request->names) {
+          name.reserve(kGreetingPrefix.size() + name.size() +
+                       kGreetingSuffix.size());
+          name.insert(0, kGreetingPrefix);
+          name.append(kGreetingSuffix);
+        }
+        if (napi_call_threadsafe_function(
+                tsfn_, request.get(), napi_tsfn_nonblocking) == napi_ok) {
+          request.release();
+        }
+      }
+      batch.clear();
+    }
+  }
+
+  // Settles the request promise on the JS thread.
+  // The env is null if the TSFN is aborted.
+  static void CompleteRequest(napi_env env,
+                              napi_value /*js_callback*/,
+                              void* context,
+                              void* data) {
+    std::unique_ptr<GreetRequest> request{static_cast<GreetRequest*>(data)};
+    if (env == nullptr) {
+      return;
+    }
+    GreeterWorker* worker = static_cast<GreeterWorker*>(context);
+    if (--worker->pending_count_ == 0) {
+      napi_unref_threadsafe_function(env, worker->tsfn_);
+    }
+
+    napi_value result{};
+    if (request->is_batch) {
+      napi_create_array_with_length(env, request->names.size(), &result);
+      for (size_t i = 0; i < request->names.size(); ++i) {
+        napi_value greeting{};
+        const std::string& name = request->names[i];
+        napi_create_string_utf8(env, name.data(), name.size(), &greeting);
+        napi_set_element(env, result, static_cast<uint32_t>(i), greeting);
+      }
+    } else {
+      const std::string& name = request->names.front();
+      napi_create_string_utf8(env, name.data(), name.size(), &result);
+    }
+    napi_resolve_deferred(env, request->deferred, result);
+  }
+
+  static void Finalize(napi_env /*env*/, void* /*data*/, void* context) {
+    GreeterWorker* worker = static_cast<GreeterWorker*>(context);
+    {
+      std::scoped_lock lock{worker->mutex_};
+      worker->is_stopped_ = true;
+    }
+    worker->request_queued_.notify_one();
+    worker->thread_.join();
+    delete worker;
+  }
+
+ private:
+  napi_threadsafe_function tsfn_{};
+  std::thread thread_;
+
+  // These are variables protected by the mutex.
+  std::mutex mutex_;
+  std::condition_variable request_queued_;
+  std::vector<std::unique_ptr<GreetRequest>> queue_;
+  bool is_stopped_{false};
+
+  // It is accessed only on the JS thread.
+  size_t pending_count_{0};
+};
+
+// The greeting prefix and suffix encoded once per env.
+// It is stored with napi_set_instance_data.
+struct GreeterData {
+  std::string prefix_latin1{kGreetingPrefix};
+  std::string suffix_latin1{kGreetingSuffix};
+  std::u16string prefix_utf16{kGreetingPrefix.begin(), kGreetingPrefix.end()};
+  std::u16string suffix_utf16{kGreetingSuffix.begin(), kGreetingSuffix.end()};
+  // Created by the first async request. It is owned by its TSFN.
+  GreeterWorker* worker{};
+};
+
+// Formats "<prefix><name><suffix>" into the buffer.
+template <typename TString, typename TChar>
+void FormatGreeting(TString& buffer,
+                    const TString& prefix,
+                    const TChar* name,
+                    size_t name_length,
+                    const TString& suffix) {
+  buffer.clear();
+  buffer.append(prefix);
+  buffer.append(name, name + name_length);
+  buffer.append(suffix);
+}
+
+// Creates a JS string from the latin1 greeting.
+// The engine copies the thread-local buffer, so no per-call heap buffer is
+// needed on the addon side.
+napi_value CreateLatin1String(napi_env env, const std::string& greeting) {
+  napi_value result{};
+  if (napi_create_string_latin1(
+          env, greeting.data(), greeting.size(), &result) != napi_ok) {
+    return nullptr;
+  }
+  return result;
+}
+
+// Creates a JS string from the UTF-16 greeting.
+napi_value CreateUtf16String(napi_env env, const std::u16string& greeting) {
+  napi_value result{};
+  if (napi_create_string_utf16(
+          env, greeting.data(), greeting.size(), &result) != napi_ok) {
+    return nullptr;
+  }
+  return result;
+}
+
+}  // namespace
 
 static Napi::Value SayHello(const Napi::CallbackInfo& info) {
   std::string name = info[0].As<Napi::String>();
@@ -7,9 +212,126 @@ static Napi::Value SayHello(const Napi::CallbackInfo& info) {
   return Napi::String::From(info.Env(), message);
 }
 
+// The same greeting as SayHello, but without the per-call allocations.
+// The name is read as UTF-16 into a thread-local buffer. If all its code
+// units fit into latin1, then the greeting is returned as a latin1 string.
+// Otherwise, it is returned as a UTF-16 string. No UTF-8 transcoding is done.
+static Napi::Value SayHelloFast(const Napi::CallbackInfo& info) {
+  thread_local std::u16string name;
+  thread_local std::string latin1_greeting;
+  thread_local std::u16string utf16_greeting;
+
+  Napi::Env env = info.Env();
+  const GreeterData* data = env.GetInstanceData<GreeterData>();
+  napi_value name_value = info[0];
+
+  size_t name_length{};
+  if (napi_get_value_string_utf16(
+          env, name_value, nullptr, 0, &name_length) != napi_ok) {
+    Napi::TypeError::New(env, "Expected a string").ThrowAsJavaScriptException();
+    return Napi::Value();
+  }
+  name.resize(name_length + 1);
+  napi_get_value_string_utf16(
+      env, name_value, name.data(), name.size(), &name_length);
+
+  bool is_latin1 =
+      std::all_of(name.data(), name.data() + name_length, [](char16_t ch) {
+        return ch <= 0xFF;
+      });
+
+  napi_value result{};
+  if (is_latin1) {
+    FormatGreeting(latin1_greeting,
+                   data->prefix_latin1,
+                   name.data(),
+                   name_length,
+                   data->suffix_latin1);
+    result = CreateLatin1String(env, latin1_greeting);
+  } else {
+    FormatGreeting(utf16_greeting,
+                   data->prefix_utf16,
+                   name.data(),
+                   name_length,
+                   data->suffix_utf16);
+    result = CreateUtf16String(env, utf16_greeting);
+  }
+  if (result == nullptr) {
+    Napi::Error::New(env).ThrowAsJavaScriptException();
+    return Napi::Value();
+  }
+  return Napi::Value(env, result);
+}
+
+// Copies the JS strings and posts the request to the worker thread.
+static Napi::Value PostGreetRequest(Napi::Env env,
+                                    const napi_value* names,
+                                    size_t count,
+                                    bool is_batch) {
+  auto request = std::make_unique<GreetRequest>();
+  request->is_batch = is_batch;
+  request->names.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    size_t length{};
+    if (napi_get_value_string_utf8(env, names[i], nullptr, 0, &length) !=
+        napi_ok) {
+      Napi::TypeError::New(env, "Expected a string name")
+          .ThrowAsJavaScriptException();
+      return Napi::Value();
+    }
+    std::string& name = request->names[i];
+    name.resize(length);
+    napi_get_value_string_utf8(env, names[i], name.data(), length + 1, nullptr);
+  }
+
+  GreeterData* data = env.GetInstanceData<GreeterData>();
+  if (data->worker == nullptr) {
+    data->worker = GreeterWorker::Create(env);
+  }
+  napi_value promise{};
+  if (data->worker == nullptr ||
+      napi_create_promise(env, &request->deferred, &promise) != napi_ok) {
+    Napi::Error::New(env).ThrowAsJavaScriptException();
+    return Napi::Value();
+  }
+  if (!data->worker->Post(env, std::move(request))) {
+    Napi::Error::New(env).ThrowAsJavaScriptException();
+    return Napi::Value();
+  }
+  return Napi::Value(env, promise);
+}
+
+// sayHelloAsync(name: string): Promise<string>
+static Napi::Value SayHelloAsync(const Napi::CallbackInfo& info) {
+  napi_value name = info[0];
+  return PostGreetRequest(info.Env(), &name, 1, false);
+}
+
+// sayHelloBatchAsync(names: string[]): Promise<string[]>
+// All greetings are formatted by one worker request.
+static Napi::Value SayHelloBatchAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsArray()) {
+    Napi::TypeError::New(env, "Expected an array of names")
+        .ThrowAsJavaScriptException();
+    return Napi::Value();
+  }
+  Napi::Array array = info[0].As<Napi::Array>();
+  std::vector<napi_value> names(array.Length());
+  for (uint32_t i = 0; i < names.size(); ++i) {
+    names[i] = array.Get(i);
+  }
+  return PostGreetRequest(env, names.data(), names.size(), true);
+}
+
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
+  env.SetInstanceData(new GreeterData());
   exports.DefineProperties(
-      {Napi::PropertyDescriptor::Function("sayHello", SayHello)});
+      {Napi::PropertyDescriptor::Function("sayHello", SayHello),
+       Napi::PropertyDescriptor::Function("sayHelloFast", SayHelloFast),
+       Napi::PropertyDescriptor::Function("sayHelloAsync", SayHelloAsync),
+       Napi::PropertyDescriptor::Function("sayHelloBatchAsync",
+                                          SayHelloBatchAsync)});
   return exports;
 }
 
@@ -0,0 +1,224 @@
+#include "node_api.h"
+#include "node_lite.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// !!! This is a minimal implementation of the async work that is good enough
+// !!! to run the demos.
+// !!! Do not use it in production code.
+
+// The execute callbacks run on a fixed pool of worker threads similar to the
+// libuv thread pool used by Node.js. The complete callbacks are posted to the
+// task runner and run on the JS thread. Queued work keeps the task runner
+// alive until it is completed or cancelled.
+
+using node_api_tests::ReportOnException;
+using node_api_tests::NodeApi;
+using node_api_tests::NodeApiHandleScope;
+using node_api_tests::NodeLiteErrorHandler;
+using node_api_tests::NodeLiteTaskRunner;
+
+extern std::shared_ptr<NodeLiteTaskRunner> tsfnTaskRunner;
+
+namespace {
+
+// The same default as the libuv thread pool size.
+constexpr size_t kMaxWorkerThreadCount = 4;
+
+class AsyncWork;
+
+// Runs the execute callbacks of the queued async work.
+class AsyncWorkPool {
+ public:
+  static AsyncWorkPool& Instance() {
+    static AsyncWorkPool instance;
+    return instance;
+  }
+
+  ~AsyncWorkPool() {
+    {
+      std::scoped_lock lock{mutex_};
+      is_stopped_ = true;
+    }
+    work_queued_.notify_all();
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void Submit(AsyncWork* work) {
+    {
+      std::scoped_lock lock{mutex_};
+      queue_.push_back(work);
+      // Threads are started on demand.
+      if (threads_.size() < kMaxWorkerThreadCount &&
+          threads_.size() < queue_.size() + busy_thread_count_) {
+        threads_.emplace_back([this]() { RunWorker(); });
+      }
+    }
+    work_queued_.notify_one();
+  }
+
+  // Removes the work if it has not started yet.
+  bool Remove(AsyncWork* work) {
+    std::scoped_lock lock{mutex_};
+    auto it = std::find(queue_.begin(), queue_.end(), work);
+    if (it == queue_.end()) {
+      return false;
+    }
+    queue_.erase(it);
+    return true;
+  }
+
+ private:
+  AsyncWorkPool() = default;
+
+  void RunWorker();
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable work_queued_;
+  std::deque<AsyncWork*> queue_;
+  std::vector<std::thread> threads_;
+  size_t busy_thread_count_{0};
+  bool is_stopped_{false};
+};
+
+class AsyncWork {
+ public:
+  AsyncWork(napi_env env,
+            napi_async_execute_callback execute,
+            napi_async_complete_callback complete,
+            void* data)
+      : env_(env),
+        execute_(execute),
+        complete_(complete),
+        data_(data),
+        task_runner_(tsfnTaskRunner) {}
+
+  napi_status Queue() {
+    if (is_queued_) {
+      return napi_generic_failure;
+    }
+    is_queued_ = true;
+    task_runner_->Ref();
+    AsyncWorkPool::Instance().Submit(this);
+    return napi_ok;
+  }
+
+  napi_status Cancel() {
+    if (!is_queued_ || !AsyncWorkPool::Instance().Remove(this)) {
+      return napi_generic_failure;
+    }
+    PostComplete(napi_cancelled);
+    return napi_ok;
+  }
+
+  // Called on a worker thread.
+  void Execute() {
+    execute_(env_, data_);
+    PostComplete(napi_ok);
+  }
+
+ private:
+  void PostComplete(napi_status status) {
+    task_runner_->PostTask([this, status]() { Complete(status); });
+  }
+
+  // Called on the JS thread. The complete callback usually deletes the work.
+  void Complete(napi_status status) {
+    is_queued_ = false;
+    std::shared_ptr<NodeLiteTaskRunner> task_runner = task_runner_;
+    if (complete_ != nullptr) {
+      napi_env env = env_;
+      napi_async_complete_callback complete = complete_;
+      void* data = data_;
+      ReportOnException(env, [env, complete, status, data]() {
+        NodeApiHandleScope scope{env};
+        complete(env, status, data);
+        if (NodeApi::IsExceptionPending(env)) {
+          NODE_LITE_CALL(napi_pending_exception);
+        }
+      });
+    }
+    task_runner->Unref();
+  }
+
+ private:
+  napi_env env_{nullptr};
+  napi_async_execute_callback execute_{nullptr};
+  napi_async_complete_callback complete_{nullptr};
+  void* data_{nullptr};
+  std::shared_ptr<NodeLiteTaskRunner> task_runner_;
+  // It is accessed only from the JS thread.
+  bool is_queued_{false};
+};
+
+void AsyncWorkPool::RunWorker() {
+  for (;;) {
+    AsyncWork* work{};
+    {
+      std::unique_lock lock{mutex_};
+      work_queued_.wait(lock,
+                        [this]() { return !queue_.empty() || is_stopped_; });
+      if (is_stopped_) {
+        return;
+      }
+      work = queue_.front();
+      queue_.pop_front();
+      ++busy_thread_count_;
+    }
+    work->Execute();
+    std::scoped_lock lock{mutex_};
+    --busy_thread_count_;
+  }
+}
+
+}  // namespace
+
+// hermes-cli has no async_hooks, so the async resource is not used.
+NAPI_EXTERN napi_status NAPI_CDECL
+napi_create_async_work(napi_env env,
+                       napi_value /*async_resource*/,
+                       napi_value async_resource_name,
+                       napi_async_execute_callback execute,
+                       napi_async_complete_callback complete,
+                       void* data,
+                       napi_async_work* result) {
+  if (env == nullptr) return napi_invalid_arg;
+  if (async_resource_name == nullptr) return napi_invalid_arg;
+  if (execute == nullptr) return napi_invalid_arg;
+  if (result == nullptr) return napi_invalid_arg;
+
+  *result = reinterpret_cast<napi_async_work>(
+      new AsyncWork(env, execute, complete, data));
+  return napi_ok;
+}
+
+NAPI_EXTERN napi_status NAPI_CDECL napi_delete_async_work(napi_env env,
+                                                          napi_async_work work) {
+  if (env == nullptr) return napi_invalid_arg;
+  if (work == nullptr) return napi_invalid_arg;
+  delete reinterpret_cast<AsyncWork*>(work);
+  return napi_ok;
+}
+
+NAPI_EXTERN napi_status NAPI_CDECL napi_queue_async_work(node_api_basic_env env,
+                                                         napi_async_work work) {
+  if (env == nullptr) return napi_invalid_arg;
+  if (work == nullptr) return napi_invalid_arg;
+  return reinterpret_cast<AsyncWork*>(work)->Queue();
+}
+
+NAPI_EXTERN napi_status NAPI_CDECL
+napi_cancel_async_work(node_api_basic_env env, napi_async_work work) {
+  if (env == nullptr) return napi_invalid_arg;
+  if (work == nullptr) return napi_invalid_arg;
+  return reinterpret_cast<AsyncWork*>(work)->Cancel();
+}
@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Hashing throughput benchmark for the crypto module.
+// Usage: hermes-cli crypto_hash.js [byteLength] [iterations]
+//
+// Hashes a buffer of byteLength pseudo-random bytes with each algorithm and
+// reports the best throughput in MB per second. It also hashes the buffer in
+// 4 KB updates to show the cost of the calls. It also runs in Node.js for
+// comparison, where crc32c is skipped.
+//   hermes-cli crypto_hash.js 16777216 10
+
+'use strict';
+
+const crypto = require('crypto');
+
+const byteLength = Number(process.argv[2]) || 1 << 24;
+const iterations = Number(process.argv[3]) || 10;
+const chunkSize = 4096;
+
+const data = Buffer.alloc(byteLength);
+let seed = 1;
+for (let i = 0; i < byteLength; ++i) {
+  seed = (seed * 1103515245 + 12345) >>> 0;
+  data[i] = seed >>> 24;
+}
+
+// Returns the best throughput in MB/s.
+function measure(run) {
+  let best = Infinity;
+  for (let i = 0; i < iterations; ++i) {
+    const start = performance.now();
+    run();
+    best = Math.min(best, performance.now() - start);
+  }
+  return byteLength / (1 << 20) / (best / 1000);
+}
+
+function format(value) {
+  return value.toFixed(0).padStart(10);
+}
+
+console.log('algorithm'.padEnd(10) + 'one-shot'.padStart(10) +
+            '4 KB'.padStart(10) + '  digest');
+for (const algorithm of ['sha256', 'sha1', 'md5', 'crc32c']) {
+  if (!crypto.getHashes().includes(algorithm)) {
+    continue;
+  }
+  let digest;
+  const oneShotRate = measure(() => {
+    digest = crypto.createHash(algorithm).update(data).digest('hex');
+  });
+  let chunkedDigest;
+  const chunkedRate = measure(() => {
+    const hash = crypto.createHash(algorithm);
+    for (let offset = 0; offset < byteLength; offset += chunkSize) {
+      hash.update(data.subarray(offset, offset + chunkSize));
+    }
+    chunkedDigest = hash.digest('hex');
+  });
+  if (chunkedDigest !== digest) {
+    console.log(`${algorithm}: the chunked digest does not match`);
+    process.exit(1);
+  }
+  console.log(algorithm.padEnd(10) + format(oneShotRate) +
+              format(chunkedRate) + '  ' + digest.slice(0, 16));
+}
@@ -0,0 +1,150 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// HTTP/1.1 load test for the "http" module.
+// Usage:
+//   hermes-cli http_load.js [connections] [duration_ms] [pipeline]
+//   hermes-cli http_load.js --server [port]
+//   hermes-cli http_load.js --client <port> [connections] [duration_ms]
+//       [pipeline]
+//
+// Without a mode, the server and the load generator run in one process.
+// The --server and --client modes run them separately. The script also runs
+// in Node.js, so the same server can be measured with Node.js and
+// hermes-cli under the same load generator on the same machine:
+//   node http_load.js --server 8080
+//   hermes-cli http_load.js --client 8080 50 5000 4
+//
+// The load generator keeps the given number of keep-alive connections with
+// up to <pipeline> outstanding requests on each. It prints the requests per
+// second and the request latency percentiles.
+
+'use strict';
+
+const http = require('http');
+const net = require('net');
+
+const kRequest = 'GET / HTTP/1.1\r\nHost: localhost\r\n\r\n';
+const kResponseBody = 'Hello, World!';
+
+function startServer(port, callback) {
+  const server = http.createServer((req, res) => {
+    res.setHeader('Content-Type', 'text/plain');
+    res.end(kResponseBody);
+  });
+  server.listen(port, '127.0.0.1', () => callback(server));
+  return server;
+}
+
+function runLoad(port, connections, durationMs, pipeline, callback) {
+  const latencies = [];
+  const startTime = performance.now();
+  let finishedClients = 0;
+  let errors = 0;
+
+  function runClient() {
+    const socket = net.connect(port, '127.0.0.1');
+    // The send times of the outstanding requests.
+    const sendTimes = [];
+    let input = '';
+
+    function send() {
+      sendTimes.push(performance.now());
+      socket.write(kRequest);
+    }
+
+    socket.setEncoding('utf8');
+    socket.setNoDelay(true);
+    socket.on('connect', () => {
+      for (let i = 0; i < pipeline; ++i) {
+        send();
+      }
+    });
+    socket.on('data', (chunk) => {
+      input += chunk;
+      for (;;) {
+        const headEnd = input.indexOf('\r\n\r\n');
+        if (headEnd < 0) {
+          return;
+        }
+        const match = /content-length: *(\d+)/i.exec(input.slice(0, headEnd));
+        const responseEnd = headEnd + 4 + (match ? Number(match[1]) : 0);
+        if (input.length < responseEnd) {
+          return;
+        }
+        input = input.slice(responseEnd);
+        const now = performance.now();
+        latencies.push(now - sendTimes.shift());
+        if (now - startTime < durationMs) {
+          send();
+        } else if (sendTimes.length === 0) {
+          socket.end();
+        }
+      }
+    });
+    socket.on('error', () => {
+      ++errors;
+    });
+    socket.on('close', () => {
+      if (++finishedClients === connections) {
+        callback(latencies, performance.now() - startTime, errors);
+      }
+    });
+  }
+
+  for (let i = 0; i < connections; ++i) {
+    runClient();
+  }
+}
+
+function percentile(sorted, p) {
+  const index = Math.min(sorted.length - 1, Math.floor(sorted.length * p));
+  return sorted[index];
+}
+
+function report(connections, pipeline, latencies, elapsedMs, errors) {
+  const sorted = latencies.slice().sort((a, b) => a - b);
+  console.log('connections:  ' + connections);
+  console.log('pipeline:     ' + pipeline);
+  console.log('requests:     ' + sorted.length);
+  console.log('errors:       ' + errors);
+  console.log(
+      'requests/sec: ' + Math.round(sorted.length / (elapsedMs / 1000)));
+  if (sorted.length > 0) {
+    console.log('latency p50:  ' + percentile(sorted, 0.5).toFixed(3) + ' ms');
+    console.log(
+        'latency p99:  ' + percentile(sorted, 0.99).toFixed(3) + ' ms');
+    console.log(
+        'latency max:  ' + sorted[sorted.length - 1].toFixed(3) + ' ms');
+  }
+}
+
+const argv = process.argv.slice(2);
+if (argv[0] === '--server') {
+  startServer(Number(argv[1]) || 8080, (server) => {
+    console.log('Listening on port ' + server.address().port);
+  });
+} else {
+  const isClient = argv[0] === '--client';
+  const args = isClient ? argv.slice(2) : argv;
+  const connections = Number(args[0]) || 50;
+  const durationMs = Number(args[1]) || 5000;
+  const pipeline = Number(args[2]) || 1;
+  const onDone = (server) => (latencies, elapsedMs, errors) => {
+    report(connections, pipeline, latencies, elapsedMs, errors);
+    if (server) {
+      server.close();
+    }
+  };
+  if (isClient) {
+    runLoad(Number(argv[1]), connections, durationMs, pipeline, onDone(null));
+  } else {
+    startServer(0, (server) => {
+      runLoad(server.address().port,
+              connections,
+              durationMs,
+              pipeline,
+              onDone(server));
+    });
+  }
+}
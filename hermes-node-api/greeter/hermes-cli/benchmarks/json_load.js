@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// JSON file loading benchmark for fs.readJSONSync.
+// Usage: hermes-cli json_load.js <file> [iterations]
+//
+// Compares fs.readJSONSync, which maps the file and parses it natively, with
+// JSON.parse of the fs.readFileSync result. Both results must be equal.
+// For example, with a file of 100000 records generated by Node.js:
+//   node -e "console.log(JSON.stringify(Array.from({length: 100000},
+//     (_, i) => ({id: i, name: 'item ' + i, tags: ['a', 'b'], ok: true}))))"
+//     > data.json
+//   hermes-cli json_load.js data.json 5
+
+'use strict';
+
+const fs = require('fs');
+
+const filePath = process.argv[2];
+const iterations = Number(process.argv[3]) || 5;
+if (!filePath) {
+  console.log('Usage: hermes-cli json_load.js <file> [iterations]');
+  process.exit(1);
+}
+
+function parseInJS() {
+  return JSON.parse(fs.readFileSync(filePath, 'utf8'));
+}
+
+function readJSONSync() {
+  return fs.readJSONSync(filePath);
+}
+
+function measure(name, run) {
+  let best = Infinity;
+  let result;
+  for (let i = 0; i < iterations; ++i) {
+    result = undefined;
+    const start = performance.now();
+    result = run();
+    best = Math.min(best, performance.now() - start);
+  }
+  console.log(name.padEnd(24) + best.toFixed(1).padStart(9) + ' ms');
+  return result;
+}
+
+const js = JSON.stringify(measure('JSON.parse+readFileSync', parseInJS));
+const native = JSON.stringify(measure('fs.readJSONSync', readJSONSync));
+console.log('JSON length: ' + native.length);
+if (js !== native) {
+  console.log('Mismatch: the results of JSON.parse and fs.readJSONSync differ');
+  process.exit(1);
+}
@@ -0,0 +1,93 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// TCP echo load test for the "net" module.
+// Usage: hermes-cli net_echo.js [connections] [duration_ms] [message_size]
+//
+// Starts an echo server on a loopback port and connects the clients to it.
+// Each client sends a message, waits for the whole echo, and sends the next
+// one until the duration ends. Prints the requests per second and the
+// request latency percentiles.
+
+'use strict';
+
+const net = require('net');
+
+const argv = process.argv.slice(2);
+const connections = Number(argv[0]) || 50;
+const durationMs = Number(argv[1]) || 5000;
+const messageSize = Number(argv[2]) || 64;
+
+const message = 'x'.repeat(messageSize);
+const latencies = [];
+let startTime = 0;
+let finishedClients = 0;
+
+const server = net.createServer({noDelay: true}, (socket) => {
+  socket.on('data', (chunk) => socket.write(chunk));
+  socket.on('error', () => {});
+});
+
+server.listen(0, '127.0.0.1', () => {
+  const port = server.address().port;
+  startTime = performance.now();
+  for (let i = 0; i < connections; ++i) {
+    runClient(port);
+  }
+});
+
+function runClient(port) {
+  const socket = net.connect(port, '127.0.0.1');
+  let received = 0;
+  let sendTime = 0;
+
+  function send() {
+    received = 0;
+    sendTime = performance.now();
+    socket.write(message);
+  }
+
+  socket.setNoDelay(true);
+  socket.on('connect', send);
+  socket.on('data', (chunk) => {
+    received += chunk.length;
+    if (received < messageSize) {
+      return;
+    }
+    const now = performance.now();
+    latencies.push(now - sendTime);
+    if (now - startTime < durationMs) {
+      send();
+    } else {
+      socket.end();
+    }
+  });
+  socket.on('close', () => {
+    if (++finishedClients === connections) {
+      report();
+      server.close();
+    }
+  });
+  socket.on('error', (error) => {
+    console.log('Client error: ' + error.message);
+  });
+}
+
+function percentile(sorted, p) {
+  const index = Math.min(sorted.length - 1, Math.floor(sorted.length * p));
+  return sorted[index];
+}
+
+function report() {
+  const elapsedMs = performance.now() - startTime;
+  const sorted = latencies.slice().sort((a, b) => a - b);
+  console.log('connections:  ' + connections);
+  console.log('message size: ' + messageSize + ' bytes');
+  console.log('requests:     ' + sorted.length);
+  console.log(
+      'requests/sec: ' + Math.round(sorted.length / (elapsedMs / 1000)));
+  console.log('latency p50:  ' + percentile(sorted, 0.5).toFixed(3) + ' ms');
+  console.log('latency p99:  ' + percentile(sorted, 0.99).toFixed(3) + ' ms');
+  console.log(
+      'latency max:  ' + sorted[sorted.length - 1].toFixed(3) + ' ms');
+}
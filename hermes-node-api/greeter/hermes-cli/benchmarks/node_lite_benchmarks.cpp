@@ -0,0 +1,573 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Micro-benchmarks for the node_lite host layer.
+// They measure the host-side overhead in isolation from the JS code.
+// Each benchmark reports the number of C++ heap allocations per operation
+// made by hermes-cli code. The engine allocations are not counted.
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include "node_lite.h"
+#include "node_lite_path.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace fs = std::filesystem;
+
+extern std::shared_ptr<node_api_tests::NodeLiteTaskRunner> tsfnTaskRunner;
+
+//=============================================================================
+// Counting allocator
+//=============================================================================
+
+namespace {
+std::atomic<uint64_t> g_allocation_count{0};
+
+void* TryCountedAlloc(size_t size) noexcept {
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size != 0 ? size : 1);
+}
+
+void* TryCountedAlignedAlloc(size_t size, std::align_val_t align) noexcept {
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  size_t alignment = static_cast<size_t>(align);
+  if (size == 0) {
+    size = 1;
+  }
+#ifdef _WIN32
+  return _aligned_malloc(size, alignment);
+#else
+  if (alignment < sizeof(void*)) {
+    alignment = sizeof(void*);
+  }
+  void* ptr{};
+  return posix_memalign(&ptr, alignment, size) == 0 ? ptr : nullptr;
+#endif
+}
+
+void AlignedFree(void* ptr) noexcept {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+void* CountedAlloc(size_t size) {
+  if (void* ptr = TryCountedAlloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void* CountedAlignedAlloc(size_t size, std::align_val_t align) {
+  if (void* ptr = TryCountedAlignedAlloc(size, align)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+}  // namespace
+
+void* operator new(size_t size) {
+  return CountedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+  return CountedAlloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t& /*tag*/) noexcept {
+  return TryCountedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& /*tag*/) noexcept {
+  return TryCountedAlloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+  return CountedAlignedAlloc(size, align);
+}
+
+void* operator new[](size_t size, std::align_val_t align) {
+  return CountedAlignedAlloc(size, align);
+}
+
+void* operator new(size_t size,
+                   std::align_val_t align,
+                   const std::nothrow_t& /*tag*/) noexcept {
+  return TryCountedAlignedAlloc(size, align);
+}
+
+void* operator new[](size_t size,
+                     std::align_val_t align,
+                     const std::nothrow_t& /*tag*/) noexcept {
+  return TryCountedAlignedAlloc(size, align);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t /*size*/) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t& /*tag*/) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t& /*tag*/) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t /*align*/) noexcept {
+  AlignedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t /*align*/) noexcept {
+  AlignedFree(ptr);
+}
+
+void operator delete(void* ptr,
+                     size_t /*size*/,
+                     std::align_val_t /*align*/) noexcept {
+  AlignedFree(ptr);
+}
+
+void operator delete[](void* ptr,
+                       size_t /*size*/,
+                       std::align_val_t /*align*/) noexcept {
+  AlignedFree(ptr);
+}
+
+void operator delete(void* ptr,
+                     std::align_val_t /*align*/,
+                     const std::nothrow_t& /*tag*/) noexcept {
+  AlignedFree(ptr);
+}
+
+void operator delete[](void* ptr,
+                       std::align_val_t /*align*/,
+                       const std::nothrow_t& /*tag*/) noexcept {
+  AlignedFree(ptr);
+}
+
+namespace node_api_tests {
+
+namespace {
+
+// Reports the average number of allocations per iteration on destruction.
+class AllocationCounter {
+ public:
+  explicit AllocationCounter(benchmark::State& state) noexcept
+      : state_(state), start_count_(g_allocation_count.load()) {}
+
+  ~AllocationCounter() {
+    state_.counters["allocs/op"] = benchmark::Counter(
+        static_cast<double>(g_allocation_count.load() - start_count_),
+        benchmark::Counter::kAvgIterations);
+  }
+
+ private:
+  benchmark::State& state_;
+  uint64_t start_count_;
+};
+
+// The runtime shared by all benchmarks that need a napi_env.
+class BenchmarkRuntime {
+ public:
+  static BenchmarkRuntime& Get() {
+    static BenchmarkRuntime instance;
+    return instance;
+  }
+
+  NodeLiteRuntime& runtime() { return *runtime_; }
+
+  std::unique_ptr<NodeLiteRuntime> CreateRuntime() {
+    NodeLiteOptions options;
+    options.exe_path = "hermes-cli-bench";
+    options.script_path = (temp_dir_ / "module.js").string();
+    return NodeLiteRuntime::Create(
+        task_runner_, temp_dir_.string(), std::move(options));
+  }
+
+  napi_env env() { return runtime_->GetEnv(); }
+  NodeLiteTaskRunner& task_runner() { return *task_runner_; }
+  const fs::path& temp_dir() { return temp_dir_; }
+
+  fs::path CreateTempFile(const std::string& name, size_t size) {
+    fs::path file_path = temp_dir_ / name;
+    std::ofstream file_stream(file_path, std::ios::binary);
+    std::string line = "// node_lite benchmark file\n";
+    for (size_t written = 0; written < size; written += line.size()) {
+      file_stream << line;
+    }
+    return file_path;
+  }
+
+ private:
+  BenchmarkRuntime() {
+    temp_dir_ = fs::temp_directory_path() / "hermes-cli-bench";
+    fs::create_directories(temp_dir_);
+    CreateTempFile("module.js", 64);
+
+    task_runner_ = std::make_shared<NodeLiteTaskRunner>();
+    tsfnTaskRunner = task_runner_;
+    runtime_ = CreateRuntime();
+  }
+
+  ~BenchmarkRuntime() {
+    runtime_.reset();
+    std::error_code ec;
+    fs::remove_all(temp_dir_, ec);
+  }
+
+ private:
+  fs::path temp_dir_;
+  std::shared_ptr<NodeLiteTaskRunner> task_runner_;
+  std::unique_ptr<NodeLiteRuntime> runtime_;
+};
+
+//=============================================================================
+// Startup
+//=============================================================================
+
+double ToMicroseconds(std::chrono::nanoseconds duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// Creates and deletes the runtime.
+// The counters break the creation time into the startup phases.
+void BM_Startup_CreateRuntime(benchmark::State& state) {
+  BenchmarkRuntime& bench_runtime = BenchmarkRuntime::Get();
+  double runtime_create_us = 0;
+  double builtin_setup_us = 0;
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    std::unique_ptr<NodeLiteRuntime> runtime = bench_runtime.CreateRuntime();
+    runtime_create_us +=
+        ToMicroseconds(runtime->startup_stats().runtime_create);
+    builtin_setup_us += ToMicroseconds(runtime->startup_stats().builtin_setup);
+  }
+  state.counters["runtime_create_us"] =
+      benchmark::Counter(runtime_create_us, benchmark::Counter::kAvgIterations);
+  state.counters["builtin_setup_us"] =
+      benchmark::Counter(builtin_setup_us, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Startup_CreateRuntime)->Unit(benchmark::kMicrosecond);
+
+// Creates the runtime, requires a small script module, and accesses the
+// lazily created global.console.
+void BM_Startup_FirstRequire(benchmark::State& state) {
+  BenchmarkRuntime& bench_runtime = BenchmarkRuntime::Get();
+  fs::path parent_path = bench_runtime.temp_dir() / "main.js";
+  double first_require_us = 0;
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    std::unique_ptr<NodeLiteRuntime> runtime = bench_runtime.CreateRuntime();
+    napi_env env = runtime->GetEnv();
+    {
+      NodeApiEnvScope env_scope{env};
+      NodeApiHandleScope scope{env};
+      runtime->Require(parent_path, "./module");
+      benchmark::DoNotOptimize(
+          NodeApi::GetProperty(env, NodeApi::GetGlobal(env), "console"));
+    }
+    first_require_us += ToMicroseconds(runtime->startup_stats().first_require);
+  }
+  state.counters["first_require_us"] =
+      benchmark::Counter(first_require_us, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Startup_FirstRequire)->Unit(benchmark::kMicrosecond);
+
+//=============================================================================
+// NodeLiteTaskRunner
+//=============================================================================
+
+void BM_TaskRunner_PostDrain(benchmark::State& state) {
+  NodeLiteTaskRunner task_runner;
+  int64_t batch_size = state.range(0);
+  int64_t counter = 0;
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    for (int64_t i = 0; i < batch_size; ++i) {
+      task_runner.PostTask([&counter]() { ++counter; });
+    }
+    task_runner.DrainTaskQueue();
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_TaskRunner_PostDrain)->Arg(1)->Arg(64);
+
+// Posts and removes a task while the queue has range(0) pending tasks.
+void BM_TaskRunner_PostRemove(benchmark::State& state) {
+  NodeLiteTaskRunner task_runner;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    task_runner.PostTask([]() {});
+  }
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    uint32_t task_id = task_runner.PostTask([]() {});
+    task_runner.RemoveTask(task_id);
+  }
+  task_runner.DrainTaskQueue();
+}
+BENCHMARK(BM_TaskRunner_PostRemove)->Arg(0)->Arg(100)->Arg(10000);
+
+//=============================================================================
+// NodeApi strings and functions
+//=============================================================================
+
+void BM_NodeApi_CreateString(benchmark::State& state) {
+  napi_env env = BenchmarkRuntime::Get().env();
+  NodeApiEnvScope env_scope{env};
+  std::string value(static_cast<size_t>(state.range(0)), 'a');
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    NodeApiHandleScope scope{env};
+    benchmark::DoNotOptimize(NodeApi::CreateString(env, value));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NodeApi_CreateString)->Arg(16)->Arg(256)->Arg(4096);
+
+void BM_NodeApi_ToStdString(benchmark::State& state) {
+  napi_env env = BenchmarkRuntime::Get().env();
+  NodeApiEnvScope env_scope{env};
+  NodeApiHandleScope handle_scope{env};
+  napi_value value = NodeApi::CreateString(
+      env, std::string(static_cast<size_t>(state.range(0)), 'a'));
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(NodeApi::ToStdString(env, value));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NodeApi_ToStdString)->Arg(16)->Arg(256)->Arg(4096);
+
+// Measures the dispatch of a call from JS to a NodeApi::CreateFunction
+// callback with range(0) arguments.
+void BM_NodeApi_CreateFunctionCall(benchmark::State& state) {
+  napi_env env = BenchmarkRuntime::Get().env();
+  NodeApiEnvScope env_scope{env};
+  NodeApiHandleScope handle_scope{env};
+  napi_value func = NodeApi::CreateFunction(
+      env, "benchmark", [](napi_env env, span<napi_value> args) {
+        return args.size() > 0 ? args[0] : nullptr;
+      });
+  std::vector<napi_value> args(static_cast<size_t>(state.range(0)),
+                               NodeApi::GetUndefined(env));
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    NodeApiHandleScope scope{env};
+    benchmark::DoNotOptimize(NodeApi::CallFunction(
+        env, func, span<napi_value>(args.data(), args.size())));
+  }
+}
+BENCHMARK(BM_NodeApi_CreateFunctionCall)->Arg(0)->Arg(4)->Arg(20);
+
+//=============================================================================
+// Module resolution and file reading
+//=============================================================================
+
+void BM_ResolveModulePath_Relative(benchmark::State& state) {
+  BenchmarkRuntime& bench_runtime = BenchmarkRuntime::Get();
+  std::string parent_path = bench_runtime.temp_dir().string();
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        bench_runtime.runtime().ResolveModulePath(parent_path, "./module"));
+  }
+}
+BENCHMARK(BM_ResolveModulePath_Relative);
+
+void BM_ResolveModulePath_BuiltIn(benchmark::State& state) {
+  BenchmarkRuntime& bench_runtime = BenchmarkRuntime::Get();
+  std::string parent_path = bench_runtime.temp_dir().string();
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        bench_runtime.runtime().ResolveModulePath(parent_path, "fs"));
+  }
+}
+BENCHMARK(BM_ResolveModulePath_BuiltIn);
+
+void BM_ReadFileText(benchmark::State& state) {
+  BenchmarkRuntime& bench_runtime = BenchmarkRuntime::Get();
+  fs::path file_path = bench_runtime.CreateTempFile(
+      "read_" + std::to_string(state.range(0)) + ".js",
+      static_cast<size_t>(state.range(0)));
+  napi_env env = bench_runtime.env();
+  int64_t file_size = static_cast<int64_t>(fs::file_size(file_path));
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ReadFileText(env, file_path));
+  }
+  state.SetBytesProcessed(state.iterations() * file_size);
+}
+BENCHMARK(BM_ReadFileText)->Arg(1 << 10)->Arg(64 << 10)->Arg(1 << 20);
+
+//=============================================================================
+// Path module
+//=============================================================================
+
+// The segments of a typical module path join.
+constexpr std::string_view kJoinSegments[] = {
+    "/usr/lib/node_modules", "pkg", "./lib", "../dist/index.js"};
+
+// The join of the earlier path module: a std::filesystem::path per segment.
+std::string JoinWithFsPath(span<const std::string_view> segments) {
+  fs::path path = fs::path{std::string(segments[0])};
+  for (size_t i = 1; i < segments.size(); ++i) {
+    path /= std::string(segments[i]);
+  }
+  return path.string();
+}
+
+void BM_Path_JoinFsPath(benchmark::State& state) {
+  span<const std::string_view> segments(kJoinSegments,
+                                        std::size(kJoinSegments));
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(JoinWithFsPath(segments));
+  }
+}
+BENCHMARK(BM_Path_JoinFsPath);
+
+// NodeLitePath::Join appends to a reused buffer.
+void BM_Path_Join(benchmark::State& state) {
+  span<const std::string_view> segments(kJoinSegments,
+                                        std::size(kJoinSegments));
+  std::string result;
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    result.clear();
+    NodeLitePath::Join(segments, result);
+    benchmark::DoNotOptimize(result.data());
+  }
+}
+BENCHMARK(BM_Path_Join);
+
+// Calls path.join from JS: range(0) is 0 for the fs::path callback of the
+// earlier module and 1 for the current module function.
+void BM_Path_JoinCall(benchmark::State& state) {
+  napi_env env = BenchmarkRuntime::Get().env();
+  NodeApiEnvScope env_scope{env};
+  NodeApiHandleScope handle_scope{env};
+  napi_value join{};
+  if (state.range(0) == 0) {
+    join = NodeApi::CreateFunction(
+        env, "join", [](napi_env env, span<napi_value> args) {
+          fs::path path = fs::path{NodeApi::ToStdString(env, args[0])};
+          for (size_t i = 1; i < args.size(); ++i) {
+            path /= NodeApi::ToStdString(env, args[i]);
+          }
+          return NodeApi::CreateString(env, path.string());
+        });
+  } else {
+    napi_value exports =
+        NodeLitePath::InitModule(env, NodeApi::CreateObject(env));
+    join = NodeApi::GetProperty(env, exports, "join");
+  }
+  std::vector<napi_value> args;
+  for (std::string_view segment : kJoinSegments) {
+    args.push_back(NodeApi::CreateString(env, segment));
+  }
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    NodeApiHandleScope scope{env};
+    benchmark::DoNotOptimize(NodeApi::CallFunction(
+        env, join, span<napi_value>(args.data(), args.size())));
+  }
+}
+BENCHMARK(BM_Path_JoinCall)->Arg(0)->Arg(1);
+
+//=============================================================================
+// Threadsafe functions
+//=============================================================================
+
+// Pushes range(0) items from the current thread and dispatches them on the
+// task runner.
+void BM_Tsfn_PushDispatch(benchmark::State& state) {
+  BenchmarkRuntime& bench_runtime = BenchmarkRuntime::Get();
+  napi_env env = bench_runtime.env();
+  NodeApiEnvScope env_scope{env};
+  NodeApiHandleScope handle_scope{env};
+  int64_t call_count = 0;
+  napi_threadsafe_function tsfn{};
+  NODE_LITE_CALL(napi_create_threadsafe_function(
+      env,
+      nullptr,
+      nullptr,
+      NodeApi::CreateString(env, "benchmark"),
+      0,
+      1,
+      nullptr,
+      nullptr,
+      &call_count,
+      [](napi_env /*env*/, napi_value /*js_cb*/, void* context, void* data) {
+        ++*static_cast<int64_t*>(context);
+      },
+      &tsfn));
+  int64_t batch_size = state.range(0);
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    for (int64_t i = 0; i < batch_size; ++i) {
+      napi_call_threadsafe_function(tsfn, nullptr, napi_tsfn_nonblocking);
+    }
+    bench_runtime.task_runner().DrainTaskQueue();
+  }
+  napi_release_threadsafe_function(tsfn, napi_tsfn_release);
+  benchmark::DoNotOptimize(call_count);
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_Tsfn_PushDispatch)->Arg(1)->Arg(64);
+
+//=============================================================================
+// String utilities
+//=============================================================================
+
+void BM_FormatString(benchmark::State& state) {
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FormatString(
+        "Failed to open file: %s. Error: %d", "module.js", 2));
+  }
+}
+BENCHMARK(BM_FormatString);
+
+void BM_ReplaceAll(benchmark::State& state) {
+  std::string text;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    text += "line of process output\r\n";
+  }
+  AllocationCounter allocation_counter{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ReplaceAll(text, "\r\n", "\n"));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_ReplaceAll)->Arg(1)->Arg(100)->Arg(10000);
+
+}  // namespace
+
+}  // namespace node_api_tests
+
+BENCHMARK_MAIN();
@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Line splitting benchmark for the "readline" module.
+// Usage: hermes-cli readline_lines.js <file> [iterations]
+//
+// Compares readline.readLinesSync, which maps the file and splits it
+// natively, with splitting the result of fs.readFileSync in JS. Both visit
+// every line. For example:
+//   seq 10000000 > lines.txt
+//   hermes-cli readline_lines.js lines.txt 5
+
+'use strict';
+
+const fs = require('fs');
+const readline = require('readline');
+
+const filePath = process.argv[2];
+const iterations = Number(process.argv[3]) || 5;
+if (!filePath) {
+  console.log('Usage: hermes-cli readline_lines.js <file> [iterations]');
+  process.exit(1);
+}
+
+function splitInJS() {
+  const lines = fs.readFileSync(filePath, 'utf8').split('\n');
+  if (lines[lines.length - 1] === '') {
+    lines.pop();
+  }
+  let count = 0;
+  let length = 0;
+  for (let i = 0; i < lines.length; ++i) {
+    let line = lines[i];
+    if (line.charCodeAt(line.length - 1) === 13) {
+      line = line.slice(0, -1);
+    }
+    ++count;
+    length += line.length;
+  }
+  return {count, length};
+}
+
+function readLinesSync() {
+  let count = 0;
+  let length = 0;
+  readline.readLinesSync(filePath, (lines) => {
+    for (let i = 0; i < lines.length; ++i) {
+      ++count;
+      length += lines[i].length;
+    }
+  });
+  return {count, length};
+}
+
+function measure(name, run) {
+  let best = Infinity;
+  let result;
+  for (let i = 0; i < iterations; ++i) {
+    const start = performance.now();
+    result = run();
+    best = Math.min(best, performance.now() - start);
+  }
+  console.log(
+      name.padEnd(24) + best.toFixed(1).padStart(9) + ' ms' +
+      Math.round(result.count / (best / 1000)).toString().padStart(14) +
+      ' lines/s');
+  return result;
+}
+
+const js = measure('fs.readFileSync+split', splitInJS);
+const native = measure('readline.readLinesSync', readLinesSync);
+console.log('lines: ' + native.count + ', characters: ' + native.length);
+if (js.count !== native.count || js.length !== native.length) {
+  console.log('Mismatch: the JS split found ' + js.count + ' lines and ' +
+              js.length + ' characters');
+  process.exit(1);
+}
@@ -0,0 +1,50 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Throughput test for process.stdin.
+// Usage: <producer> | hermes-cli stdin_throughput.js [expected_bytes]
+//
+// Counts the bytes read from the standard input and prints the throughput.
+// With expected_bytes it exits with code 1 if a different number of bytes
+// was read. For example, to pipe 4 GB through cat:
+//   head -c 4G /dev/zero | cat | hermes-cli stdin_throughput.js 4294967296
+
+'use strict';
+
+const expectedBytes = process.argv[2] ? Number(process.argv[2]) : -1;
+
+let bytes = 0;
+let chunks = 0;
+let maxChunkSize = 0;
+let startTime = 0;
+
+process.stdin.on('data', (chunk) => {
+  if (chunks === 0) {
+    startTime = performance.now();
+  }
+  bytes += chunk.length;
+  ++chunks;
+  maxChunkSize = Math.max(maxChunkSize, chunk.length);
+});
+
+process.stdin.on('end', () => {
+  const elapsedMs = performance.now() - startTime;
+  console.log('bytes:        ' + bytes);
+  console.log('chunks:       ' + chunks);
+  console.log('avg chunk:    ' + Math.round(bytes / Math.max(chunks, 1)));
+  console.log('max chunk:    ' + maxChunkSize);
+  console.log('elapsed:      ' + elapsedMs.toFixed(1) + ' ms');
+  console.log(
+      'throughput:   ' +
+      (bytes / 1048576 / (Math.max(elapsedMs, 1) / 1000)).toFixed(1) +
+      ' MB/s');
+  if (expectedBytes >= 0 && bytes !== expectedBytes) {
+    console.log('Expected ' + expectedBytes + ' bytes, but read ' + bytes);
+    process.exit(1);
+  }
+});
+
+process.stdin.on('error', (error) => {
+  console.log('stdin error: ' + error.message);
+  process.exit(1);
+});
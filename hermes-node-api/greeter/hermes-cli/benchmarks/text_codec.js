@@ -0,0 +1,145 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// UTF-8 encoding and decoding benchmark for TextEncoder and TextDecoder.
+// Usage: hermes-cli text_codec.js [textLength] [iterations]
+//
+// Builds texts of about textLength characters in several scripts and reports
+// the throughput of encode(), decode(), and fatal decode() in MB of UTF-8 per
+// second next to a UTF-8 codec in plain JS. Every round trip must return the
+// original text. It also runs in Node.js for comparison.
+//   hermes-cli text_codec.js 1048576 10
+
+'use strict';
+
+const textLength = Number(process.argv[2]) || 1 << 20;
+const iterations = Number(process.argv[3]) || 10;
+
+const corpora = {
+  english: 'The quick brown fox jumps over the lazy dog. ',
+  cyrillic: 'Съешь же ещё этих мягких французских булок, да выпей чаю. ',
+  cjk: '我能吞下玻璃而不伤身体。私はガラスを食べられます。',
+  emoji: '😀🚀🌍🎉👍🏽🔥✨ ',
+  mixed: 'Hello, мир! 你好 🌍 ĉu vi? ',
+};
+
+function repeatToLength(sample, length) {
+  return sample.repeat(Math.ceil(length / sample.length));
+}
+
+function encodeInJS(text) {
+  const bytes = [];
+  for (let i = 0; i < text.length; ++i) {
+    let c = text.charCodeAt(i);
+    if (c >= 0xd800 && c < 0xdc00 && i + 1 < text.length) {
+      const next = text.charCodeAt(i + 1);
+      if (next >= 0xdc00 && next < 0xe000) {
+        c = 0x10000 + ((c - 0xd800) << 10) + (next - 0xdc00);
+        ++i;
+      }
+    }
+    if (c < 0x80) {
+      bytes.push(c);
+    } else if (c < 0x800) {
+      bytes.push(0xc0 | (c >> 6), 0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+      bytes.push(0xe0 | (c >> 12), 0x80 | ((c >> 6) & 0x3f), 0x80 | (c & 0x3f));
+    } else {
+      bytes.push(0xf0 | (c >> 18), 0x80 | ((c >> 12) & 0x3f),
+                 0x80 | ((c >> 6) & 0x3f), 0x80 | (c & 0x3f));
+    }
+  }
+  return new Uint8Array(bytes);
+}
+
+// Decodes valid UTF-8 only.
+function decodeInJS(bytes) {
+  let text = '';
+  const units = [];
+  for (let i = 0; i < bytes.length;) {
+    const c = bytes[i];
+    let code;
+    if (c < 0x80) {
+      code = c;
+      i += 1;
+    } else if (c < 0xe0) {
+      code = ((c & 0x1f) << 6) | (bytes[i + 1] & 0x3f);
+      i += 2;
+    } else if (c < 0xf0) {
+      code = ((c & 0x0f) << 12) | ((bytes[i + 1] & 0x3f) << 6) |
+             (bytes[i + 2] & 0x3f);
+      i += 3;
+    } else {
+      code = ((c & 0x07) << 18) | ((bytes[i + 1] & 0x3f) << 12) |
+             ((bytes[i + 2] & 0x3f) << 6) | (bytes[i + 3] & 0x3f);
+      i += 4;
+    }
+    if (code >= 0x10000) {
+      code -= 0x10000;
+      units.push(0xd800 + (code >> 10), 0xdc00 + (code & 0x3ff));
+    } else {
+      units.push(code);
+    }
+    if (units.length >= 4096) {
+      text += String.fromCharCode.apply(null, units);
+      units.length = 0;
+    }
+  }
+  return text + String.fromCharCode.apply(null, units);
+}
+
+// Returns the best throughput in MB/s.
+function measure(byteLength, count, run) {
+  let best = Infinity;
+  for (let i = 0; i < count; ++i) {
+    const start = performance.now();
+    run();
+    best = Math.min(best, performance.now() - start);
+  }
+  return byteLength / (1 << 20) / (best / 1000);
+}
+
+function format(value) {
+  return value.toFixed(0).padStart(10);
+}
+
+const encoder = new TextEncoder();
+const decoder = new TextDecoder();
+const fatalDecoder = new TextDecoder('utf-8', {fatal: true});
+
+console.log('corpus'.padEnd(10) + 'MB'.padStart(6) +
+            'encode'.padStart(10) + 'JS'.padStart(10) +
+            'decode'.padStart(10) + 'fatal'.padStart(10) + 'JS'.padStart(10));
+let failed = false;
+for (const [name, sample] of Object.entries(corpora)) {
+  const text = repeatToLength(sample, textLength);
+  const bytes = encoder.encode(text);
+  const jsBytes = encodeInJS(text);
+  if (bytes.length !== jsBytes.length ||
+      bytes.some((value, i) => value !== jsBytes[i]) ||
+      decoder.decode(bytes) !== text || fatalDecoder.decode(bytes) !== text ||
+      decodeInJS(bytes) !== text) {
+    console.log(`${name}: the round trip does not return the text`);
+    failed = true;
+    continue;
+  }
+  // The JS codec is much slower, so it runs fewer times.
+  const jsIterations = Math.max(1, iterations >> 2);
+  const encodeRate =
+      measure(bytes.length, iterations, () => encoder.encode(text));
+  const decodeRate =
+      measure(bytes.length, iterations, () => decoder.decode(bytes));
+  const fatalRate =
+      measure(bytes.length, iterations, () => fatalDecoder.decode(bytes));
+  const jsEncodeRate =
+      measure(bytes.length, jsIterations, () => encodeInJS(text));
+  const jsDecodeRate =
+      measure(bytes.length, jsIterations, () => decodeInJS(bytes));
+  console.log(name.padEnd(10) +
+              (bytes.length / (1 << 20)).toFixed(1).padStart(6) +
+              format(encodeRate) + format(jsEncodeRate) +
+              format(decodeRate) + format(fatalRate) + format(jsDecodeRate));
+}
+if (failed) {
+  process.exit(1);
+}
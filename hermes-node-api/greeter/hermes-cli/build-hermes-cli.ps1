@@ -3,7 +3,8 @@
 
 param(
     [switch]$Verbose,
-    [switch]$Clean
+    [switch]$Clean,
+    [switch]$Benchmarks
 )
 
 # Function to write verbose output
@@ -87,7 +88,12 @@ try {
     
     # Run CMake configuration
     Write-Host "Running CMake configuration..." -ForegroundColor Yellow
-    & cmake .. -G "Visual Studio 17 2022" -A x64
+    $cmakeArgs = @("..", "-G", "Visual Studio 17 2022", "-A", "x64")
+    if ($Benchmarks) {
+        $cmakeArgs += "-DHERMES_CLI_BUILD_BENCHMARKS=ON"
+        Write-VerboseOutput "Benchmarks are enabled"
+    }
+    & cmake @cmakeArgs
     if ($LASTEXITCODE -ne 0) {
         Write-Error "CMake configuration failed with exit code $LASTEXITCODE"
         exit 1
@@ -0,0 +1,169 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// POSIX implementation of the `spawnSync` function. The child process is
+// started with posix_spawnp and its standard output and error streams are
+// redirected to pipes. Both pipes are read with poll() while the child runs,
+// so a child that fills one of the pipe buffers does not block forever.
+//
+
+#include "child_process.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+extern char** environ;
+
+#ifndef VerifyElseExit
+#define VerifyElseExit(condition)                                              \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      ExitOnError(#condition, errno);                                          \
+    }                                                                          \
+  } while (false)
+#endif
+
+namespace node_api_tests {
+
+namespace {
+
+void ExitOnError(const char* message, int error_code);
+
+struct AutoFd {
+  int fd{-1};
+
+  AutoFd() = default;
+  ~AutoFd() { Close(); }
+
+  AutoFd(const AutoFd&) = delete;
+  AutoFd& operator=(const AutoFd&) = delete;
+
+  void Close() {
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+};
+
+// Creates a pipe whose ends are not inherited by the child process.
+// The child gets the write end through the dup2 file action.
+bool CreatePipe(AutoFd& read_end, AutoFd& write_end) {
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    return false;
+  }
+  read_end.fd = fds[0];
+  write_end.fd = fds[1];
+  return ::fcntl(fds[0], F_SETFD, FD_CLOEXEC) == 0 &&
+         ::fcntl(fds[1], F_SETFD, FD_CLOEXEC) == 0;
+}
+
+// Reads both pipes until the child closes them.
+void ReadFromPipes(AutoFd& out_read,
+                   std::string& out,
+                   AutoFd& err_read,
+                   std::string& err) {
+  constexpr size_t bufferSize = 4096;
+  char buffer[bufferSize];
+  while (out_read.fd >= 0 || err_read.fd >= 0) {
+    pollfd poll_fds[2] = {{out_read.fd, POLLIN, 0}, {err_read.fd, POLLIN, 0}};
+    if (::poll(poll_fds, 2, -1) < 0) {
+      VerifyElseExit(errno == EINTR);
+      continue;
+    }
+    auto read_ready = [&](const pollfd& poll_fd,
+                          AutoFd& pipe_fd,
+                          std::string& output) {
+      if (pipe_fd.fd < 0 || poll_fd.revents == 0) {
+        return;
+      }
+      ssize_t bytes_read = ::read(pipe_fd.fd, buffer, bufferSize);
+      if (bytes_read > 0) {
+        output.append(buffer, static_cast<size_t>(bytes_read));
+      } else if (bytes_read == 0 || errno != EINTR) {
+        pipe_fd.Close();
+      }
+    };
+    read_ready(poll_fds[0], out_read, out);
+    read_ready(poll_fds[1], err_read, err);
+  }
+}
+
+}  // namespace
+
+ProcessResult SpawnSync(std::string_view command,
+                        std::vector<std::string> args) {
+  ProcessResult result{};
+
+  AutoFd out_read, out_write;
+  VerifyElseExit(CreatePipe(out_read, out_write));
+  AutoFd err_read, err_write;
+  VerifyElseExit(CreatePipe(err_read, err_write));
+
+  // The child inherits stdin and gets the write ends of the pipes as its
+  // stdout and stderr.
+  posix_spawn_file_actions_t file_actions;
+  VerifyElseExit(posix_spawn_file_actions_init(&file_actions) == 0);
+  VerifyElseExit(posix_spawn_file_actions_adddup2(
+                     &file_actions, out_write.fd, STDOUT_FILENO) == 0);
+  VerifyElseExit(posix_spawn_file_actions_adddup2(
+                     &file_actions, err_write.fd, STDERR_FILENO) == 0);
+
+  // The command is looked up in PATH like the Windows version does.
+  std::string program(command);
+  std::vector<char*> argv;
+  argv.reserve(args.size() + 2);
+  argv.push_back(program.data());
+  for (std::string& arg : args) {
+    argv.push_back(arg.data());
+  }
+  argv.push_back(nullptr);
+
+  pid_t pid{};
+  int spawn_error = ::posix_spawnp(
+      &pid, program.c_str(), &file_actions, nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&file_actions);
+  if (spawn_error != 0) {
+    ExitOnError("posix_spawnp", spawn_error);
+  }
+
+  // Close the write ends owned by the parent process. Otherwise the reads
+  // never see the end of the streams.
+  out_write.Close();
+  err_write.Close();
+  ReadFromPipes(out_read, result.std_output, err_read, result.std_error);
+
+  int status{};
+  while (::waitpid(pid, &status, 0) < 0) {
+    VerifyElseExit(errno == EINTR);
+  }
+  // A child killed by a signal reports 128 + signal number like the shells.
+  result.status = WIFEXITED(status)
+                      ? static_cast<uint32_t>(WEXITSTATUS(status))
+                      : 128u + static_cast<uint32_t>(WTERMSIG(status));
+  return result;
+}
+
+namespace {
+
+// Prints a readable error message and exits from the application.
+void ExitOnError(const char* message, int error_code) {
+  fprintf(stderr,
+          "%s failed with error %d: %s\n",
+          message,
+          error_code,
+          std::strerror(error_code));
+  std::exit(1);
+}
+
+}  // namespace
+
+}  // namespace node_api_tests
@@ -0,0 +1,9 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite.h"
+
+int main(int argc, char* argv[]) {
+  node_api_tests::NodeLiteRuntime::Run(
+      std::vector<std::string>(argv, argv + argc));
+}
@@ -6,13 +6,28 @@
 #include <algorithm>
 #include <array>
 #include <cstdarg>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <regex>
 #include <sstream>
+#include <utility>
 #include "child_process.h"
+#include "node_lite_buffer.h"
+#include "node_lite_crypto.h"
+#include "node_lite_json.h"
+#include "node_lite_path.h"
+#include "node_lite_readline.h"
+#include "node_lite_stdin.h"
+#include "node_lite_text.h"
+#ifdef __linux__
+#include "node_lite_http.h"
+#include "node_lite_net.h"
+#endif
 
 namespace fs = std::filesystem;
 
@@ -22,44 +37,20 @@ namespace node_api_tests {
 
 namespace {
 
+// The runtime that saves its --resolution-cache file on exit.
+NodeLiteRuntime* g_resolution_cache_runtime{};
+
+// Set by the watch mode. See ReportOnException.
+bool g_keep_running_on_error{};
+
+}  // namespace
+
 NodeApiRef MakeNodeApiRef(napi_env env, napi_value value) {
   napi_ref ref{};
   NODE_LITE_CALL(napi_create_reference(env, value, 1, &ref));
   return NodeApiRef(ref, NodeApiRefDeleter(env));
 }
 
-template <typename TCallback>
-void ThrowJSErrorOnException(napi_env env, TCallback&& callback) noexcept {
-  try {
-    callback();
-  } catch (const NodeLiteException& e) {
-    if (e.error_status() == napi_pending_exception) {
-      napi_value error = NodeApi::GetAndClearLastException(env);
-      NodeApi::ThrowError(env, error);
-    } else {
-      NodeApi::ThrowError(env, e.what());
-    }
-  } catch (const std::exception& e) {
-    NodeApi::ThrowError(env, e.what());
-  }
-}
-
-template <typename TCallback>
-void ExitOnException(napi_env env, TCallback&& callback) noexcept {
-  try {
-    callback();
-  } catch (const NodeLiteException& e) {
-    if (e.error_status() == napi_pending_exception) {
-      napi_value error = NodeApi::GetAndClearLastException(env);
-      NodeLiteErrorHandler::ExitWithJSError(env, error);
-    } else {
-      NodeLiteErrorHandler::ExitWithMessage(e.what());
-    }
-  } catch (const std::exception& e) {
-    NodeLiteErrorHandler::ExitWithMessage(e.what());
-  }
-}
-
 std::string ReadFileText(napi_env env, fs::path file_path) {
   std::ifstream file_stream(file_path.string());
   NODE_LITE_ASSERT(file_stream.is_open(),
@@ -71,6 +62,8 @@ std::string ReadFileText(napi_env env, fs::path file_path) {
   return ss.str();
 }
 
+namespace {
+
 class NodeApiCallbackInfo {
  public:
   NodeApiCallbackInfo(napi_env env, napi_callback_info info) {
@@ -99,6 +92,192 @@ class NodeApiCallbackInfo {
   void* data_{};
 };
 
+// Defines a writable, enumerable, and configurable global data property
+// like an assignment to the global object does.
+void DefineGlobalValue(napi_env env,
+                       const std::string& name,
+                       napi_value value) {
+  napi_property_descriptor descriptor{};
+  descriptor.utf8name = name.c_str();
+  descriptor.value = value;
+  descriptor.attributes = napi_default_jsproperty;
+  NODE_LITE_CALL(
+      napi_define_properties(env, NodeApi::GetGlobal(env), 1, &descriptor));
+}
+
+// The "events" module. The emitter stores a single listener as a function
+// and several listeners as an array, like Node.js does.
+constexpr std::string_view kEventsModuleSource = R"JS(
+(function (binding, require) {
+  'use strict';
+  function EventEmitter() {
+    EventEmitter.init.call(this);
+  }
+
+  EventEmitter.defaultMaxListeners = 10;
+
+  EventEmitter.init = function () {
+    if (this._events === undefined ||
+        this._events === Object.getPrototypeOf(this)._events) {
+      this._events = Object.create(null);
+    }
+    this._maxListeners = this._maxListeners || undefined;
+  };
+
+  function addListener(target, type, listener, prepend) {
+    if (typeof listener !== 'function') {
+      throw new TypeError('The "listener" argument must be of type function');
+    }
+    let events = target._events;
+    if (events === undefined) {
+      events = target._events = Object.create(null);
+    } else if (events.newListener !== undefined) {
+      target.emit('newListener', type, listener.listener || listener);
+    }
+    const existing = events[type];
+    if (existing === undefined) {
+      events[type] = listener;
+    } else if (typeof existing === 'function') {
+      events[type] = prepend ? [listener, existing] : [existing, listener];
+    } else if (prepend) {
+      existing.unshift(listener);
+    } else {
+      existing.push(listener);
+    }
+    return target;
+  }
+
+  function onceWrapper(target, type, listener) {
+    const wrapper = function () {
+      target.removeListener(type, wrapper);
+      return listener.apply(target, arguments);
+    };
+    wrapper.listener = listener;
+    return wrapper;
+  }
+
+  EventEmitter.prototype.setMaxListeners = function (n) {
+    this._maxListeners = n;
+    return this;
+  };
+
+  EventEmitter.prototype.getMaxListeners = function () {
+    return this._maxListeners === undefined ? EventEmitter.defaultMaxListeners
+                                            : this._maxListeners;
+  };
+
+  EventEmitter.prototype.on = EventEmitter.prototype.addListener =
+      function (type, listener) {
+        return addListener(this, type, listener, false);
+      };
+
+  EventEmitter.prototype.prependListener = function (type, listener) {
+    return addListener(this, type, listener, true);
+  };
+
+  EventEmitter.prototype.once = function (type, listener) {
+    return addListener(this, type, onceWrapper(this, type, listener), false);
+  };
+
+  EventEmitter.prototype.prependOnceListener = function (type, listener) {
+    return addListener(this, type, onceWrapper(this, type, listener), true);
+  };
+
+  EventEmitter.prototype.off = EventEmitter.prototype.removeListener =
+      function (type, listener) {
+        const events = this._events;
+        const list = events !== undefined ? events[type] : undefined;
+        if (list === undefined) {
+          return this;
+        }
+        if (list === listener || list.listener === listener) {
+          delete events[type];
+        } else if (typeof list !== 'function') {
+          for (let i = list.length - 1; i >= 0; --i) {
+            if (list[i] === listener || list[i].listener === listener) {
+              list.splice(i, 1);
+              break;
+            }
+          }
+          if (list.length === 1) {
+            events[type] = list[0];
+          } else if (list.length === 0) {
+            delete events[type];
+          }
+        }
+        return this;
+      };
+
+  EventEmitter.prototype.removeAllListeners = function (type) {
+    if (this._events !== undefined) {
+      if (type === undefined) {
+        this._events = Object.create(null);
+      } else {
+        delete this._events[type];
+      }
+    }
+    return this;
+  };
+
+  EventEmitter.prototype.emit = function (type) {
+    const events = this._events;
+    const handler = events !== undefined ? events[type] : undefined;
+    if (handler === undefined) {
+      if (type === 'error') {
+        const error = arguments[1];
+        throw error instanceof Error ? error
+                                     : new Error('Unhandled error. ' + error);
+      }
+      return false;
+    }
+    // The common calls with up to two arguments avoid copying them.
+    const argc = arguments.length;
+    if (typeof handler === 'function') {
+      if (argc === 1) {
+        handler.call(this);
+      } else if (argc === 2) {
+        handler.call(this, arguments[1]);
+      } else if (argc === 3) {
+        handler.call(this, arguments[1], arguments[2]);
+      } else {
+        handler.apply(this, Array.prototype.slice.call(arguments, 1));
+      }
+      return true;
+    }
+    const args = Array.prototype.slice.call(arguments, 1);
+    // The listeners are copied because they may remove themselves.
+    const listeners = handler.slice();
+    for (let i = 0; i < listeners.length; ++i) {
+      listeners[i].apply(this, args);
+    }
+    return true;
+  };
+
+  EventEmitter.prototype.listeners = function (type) {
+    const list = this._events !== undefined ? this._events[type] : undefined;
+    if (list === undefined) {
+      return [];
+    }
+    return typeof list === 'function'
+        ? [list.listener || list]
+        : list.map((l) => l.listener || l);
+  };
+
+  EventEmitter.prototype.listenerCount = function (type) {
+    const list = this._events !== undefined ? this._events[type] : undefined;
+    return list === undefined ? 0 : typeof list === 'function' ? 1
+                                                                : list.length;
+  };
+
+  EventEmitter.prototype.eventNames = function () {
+    return this._events !== undefined ? Object.keys(this._events) : [];
+  };
+
+  EventEmitter.EventEmitter = EventEmitter;
+  return EventEmitter;
+})
+)JS";
+
 }  // namespace
 
 //=============================================================================
@@ -107,6 +286,7 @@ class NodeApiCallbackInfo {
 
 std::unique_ptr<IEnvHolder> CreateEnvHolder(
     std::shared_ptr<NodeLiteTaskRunner> taskRunner,
+    const NodeLiteOptions& options,
     std::function<void(napi_env, napi_value)> onUnhandledError);
 
 //=============================================================================
@@ -130,7 +310,9 @@ napi_value NodeLiteModule::LoadModule(napi_env env) {
     return NodeApi::GetReferenceValue(env, exports_.get());
   }
   if (state_ == State::kLoading) {
-    return NodeApi::GetUndefined(env);
+    // ES modules in an import cycle see the namespace of the loading module.
+    return exports_ ? NodeApi::GetReferenceValue(env, exports_.get())
+                    : NodeApi::GetUndefined(env);
   }
   NODE_LITE_ASSERT(state_ == State::kNotLoaded,
                    "Unexpected module '%s' state: %d",
@@ -154,11 +336,34 @@ napi_value NodeLiteModule::LoadModule(napi_env env) {
       exports = init_exports;
     }
     exports_ = MakeNodeApiRef(env, exports);
+  } else if (const NodeLiteArchive* archive =
+                 NodeLiteRuntime::GetRuntime(env)->archive();
+             archive != nullptr && archive->GetEntryName(module_path_)) {
+    const NodeLiteArchive::Entry* entry =
+        archive->Find(*archive->GetEntryName(module_path_));
+    NODE_LITE_ASSERT(entry != nullptr,
+                     "Cannot find module '%s' in the archive",
+                     module_path_.string().c_str());
+    if (entry->kind == NodeLiteArchive::EntryKind::kEsModule) {
+      // The ES module loader reads the source from the archive.
+      LoadEsModule(env);
+    } else if (entry->kind == NodeLiteArchive::EntryKind::kJson) {
+      exports_ = MakeNodeApiRef(
+          env,
+          NodeLiteJson::Parse(
+              env, archive->GetData(*entry), module_path_.string()));
+    } else {
+      exports_ = MakeNodeApiRef(env, LoadArchiveModule(env, *archive, *entry));
+    }
   } else if (module_path_.extension() == ".js" ||
              module_path_.extension() == ".cjs") {
     exports_ = MakeNodeApiRef(env, LoadScriptModule(env));
+  } else if (NodeLiteEsmLoader::IsEsmPath(module_path_)) {
+    LoadEsModule(env);
+  } else if (module_path_.extension() == ".json") {
+    exports_ = MakeNodeApiRef(env, NodeLiteJson::ParseFile(env, module_path_));
   } else if (module_path_.extension() == ".node") {
-    exports_ = MakeNodeApiRef(env, LoadNativeModule(env));
+    exports_ = MakeNodeApiRef(env, LoadNativeModule(env, module_path_));
   } else {
     NODE_LITE_ASSERT(
         false, "Unsupported module type: %s", module_path_.string().c_str());
@@ -168,9 +373,24 @@ napi_value NodeLiteModule::LoadModule(napi_env env) {
 }
 
 napi_value NodeLiteModule::LoadScriptModule(napi_env env) {
+  return RunScriptModule(env, CompileScriptModule(env));
+}
+
+napi_value NodeLiteModule::CompileScriptModule(napi_env env) {
+  napi_value module_func =
+      NodeApi::RunScript(env,
+                         WrapCommonJSSource(ReadModuleFileText(env)),
+                         module_path_.string().c_str());
+
+  NODE_LITE_ASSERT(NodeApi::TypeOf(env, module_func) == napi_function);
+  return module_func;
+}
+
+/*static*/ std::string NodeLiteModule::WrapCommonJSSource(
+    std::string_view source) {
   std::string module_func_wrapper =
       "(function(module, exports, require, __filename, __dirname) {";
-  module_func_wrapper += ReadModuleFileText(env);
+  module_func_wrapper += source;
 
   size_t source_map_index = module_func_wrapper.find("//# sourceMappingURL");
   constexpr const char* module_suffix = "\nreturn module.exports; })\n";
@@ -179,12 +399,11 @@ napi_value NodeLiteModule::LoadScriptModule(napi_env env) {
   } else {
     module_func_wrapper += module_suffix;
   }
+  return module_func_wrapper;
+}
 
-  napi_value module_func = NodeApi::RunScript(
-      env, module_func_wrapper, module_path_.string().c_str());
-
-  NODE_LITE_ASSERT(NodeApi::TypeOf(env, module_func) == napi_function);
-
+napi_value NodeLiteModule::RunScriptModule(napi_env env,
+                                           napi_value module_func) {
   napi_value exports = NodeApi::CreateObject(env);
   napi_value file_name = NodeApi::CreateString(env, module_path_.string());
   napi_value dir_name =
@@ -196,32 +415,130 @@ napi_value NodeLiteModule::LoadScriptModule(napi_env env) {
   NodeApi::SetProperty(env, module_obj, "__dirname", dir_name);
 
   napi_value require = NodeApi::CreateFunction(
-      env, "require", [this](napi_env env, span<napi_value> args) {
+      env,
+      "require",
+      [parent_path = module_path_](napi_env env, span<napi_value> args) {
         NODE_LITE_ASSERT(args.size() >= 1, "Expected at least one argument");
         std::string module_path = NodeApi::ToStdString(env, args[0]);
         NodeLiteRuntime* runtime = NodeLiteRuntime::GetRuntime(env);
-        return runtime
-            ->ResolveModule(module_path_.parent_path().string(), module_path)
-            .LoadModule(env);
+        return runtime->Require(parent_path, module_path);
       });
 
   return NodeApi::CallFunction(
       env, module_func, {module_obj, exports, require, file_name, dir_name});
 }
 
-napi_value NodeLiteModule::LoadNativeModule(napi_env env) {
+napi_value NodeLiteModule::LoadEsModule(napi_env env) {
+  NodeLiteRuntime* runtime = NodeLiteRuntime::GetRuntime(env);
+  // The whole static import graph is read and resolved before the
+  // evaluation starts. The modules loaded by earlier imports are reused.
+  const NodeLiteEsmModule& esm = runtime->esm_loader().LoadGraph(module_path_);
+  NODE_LITE_ASSERT(esm.error.empty(), "%s", esm.error.c_str());
+
+  // The namespace is created first to be visible to the import cycles.
+  napi_value ns = NodeApi::CreateObject(env);
+  exports_ = MakeNodeApiRef(env, ns);
+
+  // The imported modules are evaluated in the import order.
+  napi_value imports{};
+  NODE_LITE_CALL(napi_create_array_with_length(
+      env, esm.resolved_paths.size(), &imports));
+  for (size_t i = 0; i < esm.resolved_paths.size(); ++i) {
+    NodeLiteModule& imported_module = runtime->GetModule(esm.resolved_paths[i]);
+    runtime->AddModuleDependency(module_path_, imported_module);
+    napi_value imported = imported_module.LoadModule(env);
+    NODE_LITE_CALL(
+        napi_set_element(env, imports, static_cast<uint32_t>(i), imported));
+  }
+
+  napi_value import_meta = NodeApi::CreateObject(env);
+  std::string url;
+  NodeLitePath::ToFileUrl(module_path_.u8string(), url);
+  NodeApi::SetPropertyString(env, import_meta, "url", url);
+  NodeApi::SetPropertyString(
+      env, import_meta, "filename", module_path_.string());
+  NodeApi::SetPropertyString(
+      env, import_meta, "dirname", module_path_.parent_path().string());
+
+  napi_value import_dynamic = NodeApi::CreateFunction(
+      env,
+      "import",
+      [parent_path = module_path_](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least one argument");
+        std::string specifier = NodeApi::ToStdString(env, args[0]);
+        napi_deferred deferred{};
+        napi_value promise{};
+        NODE_LITE_CALL(napi_create_promise(env, &deferred, &promise));
+        ThrowJSErrorOnException(env, [&]() {
+          napi_value result =
+              NodeLiteRuntime::GetRuntime(env)->Import(parent_path, specifier);
+          NODE_LITE_CALL(napi_resolve_deferred(env, deferred, result));
+        });
+        if (NodeApi::IsExceptionPending(env)) {
+          NODE_LITE_CALL(napi_reject_deferred(
+              env, deferred, NodeApi::GetAndClearLastException(env)));
+        }
+        return promise;
+      });
+
+  napi_value module_func = NodeApi::RunScript(
+      env, esm.function_source, module_path_.string().c_str());
+  NODE_LITE_ASSERT(NodeApi::TypeOf(env, module_func) == napi_function);
+  NodeApi::CallFunction(
+      env, module_func, {ns, imports, import_meta, import_dynamic});
+  return ns;
+}
+
+napi_value NodeLiteModule::LoadArchiveModule(
+    napi_env env,
+    const NodeLiteArchive& archive,
+    const NodeLiteArchive::Entry& entry) {
+  if (entry.kind == NodeLiteArchive::EntryKind::kNativeAddon) {
+    return LoadNativeModule(env, archive.ExtractNativeAddon(entry));
+  }
+  NODE_LITE_ASSERT(entry.kind == NodeLiteArchive::EntryKind::kScript ||
+                       entry.kind == NodeLiteArchive::EntryKind::kBytecode,
+                   "Unexpected archive entry kind %u for module '%s'",
+                   static_cast<uint32_t>(entry.kind),
+                   module_path_.string().c_str());
+
+  // The source or bytecode is used in place. The archive is unmapped only
+  // after the runtime is deleted, so no delete callback is needed.
+  std::string_view data = archive.GetData(entry);
+  jsr_prepared_script prepared_script{};
+  NODE_LITE_CALL(jsr_create_prepared_script(
+      env,
+      reinterpret_cast<const uint8_t*>(data.data()),
+      data.size(),
+      nullptr,
+      nullptr,
+      module_path_.string().c_str(),
+      &prepared_script));
+  napi_value module_func{};
+  napi_status status =
+      jsr_prepared_script_run(env, prepared_script, &module_func);
+  NODE_LITE_CALL(jsr_delete_prepared_script(env, prepared_script));
+  NODE_LITE_CALL(status);
+  NODE_LITE_ASSERT(NodeApi::TypeOf(env, module_func) == napi_function);
+  return RunScriptModule(env, module_func);
+}
+
+napi_value NodeLiteModule::LoadNativeModule(napi_env env,
+                                            const fs::path& lib_path) {
+  void* lib_handle =
+      NodeLiteRuntime::GetRuntime(env)->native_libraries().Load(env, lib_path);
+
   ModuleApiVersionCallback getModuleApiVersion =
-      reinterpret_cast<ModuleApiVersionCallback>(NodeLitePlatform::LoadFunction(
-          env, module_path_.c_str(), "node_api_module_get_api_version_v1"));
+      reinterpret_cast<ModuleApiVersionCallback>(NodeLitePlatform::FindFunction(
+          lib_handle, "node_api_module_get_api_version_v1"));
   int32_t moduleApiVersion = getModuleApiVersion ? getModuleApiVersion() : 8;
 
   ModuleRegisterFuncCallback moduleRegisterFunc =
       reinterpret_cast<ModuleRegisterFuncCallback>(
-          NodeLitePlatform::LoadFunction(
-              env, module_path_.c_str(), "napi_register_module_v1"));
+          NodeLitePlatform::FindFunction(lib_handle, "napi_register_module_v1"));
   NODE_LITE_ASSERT(moduleRegisterFunc != nullptr,
                    "Failed to find 'napi_register_module_v1' in module: %s",
-                   module_path_.c_str());
+                   lib_path.string().c_str());
 
   napi_value exports{};
   NODE_LITE_CALL(jsr_initialize_native_module(
@@ -233,29 +550,64 @@ std::string NodeLiteModule::ReadModuleFileText(napi_env env) {
   return ReadFileText(env, module_path_);
 }
 
+//=============================================================================
+// NodeLiteNativeLibraries implementation
+//=============================================================================
+
+NodeLiteNativeLibraries::~NodeLiteNativeLibraries() {
+  for (auto& [lib_path, library] : libraries_) {
+    // It waits for the unfinished background loads.
+    const LoadResult& result = library.get();
+    if (result.handle != nullptr) {
+      NodeLitePlatform::CloseLibrary(result.handle);
+    }
+  }
+}
+
+void NodeLiteNativeLibraries::Preload(const fs::path& lib_path) {
+  GetOrStartLoad(lib_path, std::launch::async);
+}
+
+void* NodeLiteNativeLibraries::Load(napi_env env, const fs::path& lib_path) {
+  // The deferred load runs on this thread inside of the get() call.
+  const LoadResult& result =
+      GetOrStartLoad(lib_path, std::launch::deferred).get();
+  NODE_LITE_ASSERT(result.handle != nullptr,
+                   "Failed to load native library: %s. Error: %s",
+                   lib_path.string().c_str(),
+                   result.error.c_str());
+  return result.handle;
+}
+
+std::shared_future<NodeLiteNativeLibraries::LoadResult>
+NodeLiteNativeLibraries::GetOrStartLoad(const fs::path& lib_path,
+                                        std::launch policy) {
+  std::string key = fs::weakly_canonical(lib_path).string();
+  std::scoped_lock lock{mutex_};
+  if (auto it = libraries_.find(key); it != libraries_.end()) {
+    return it->second;
+  }
+  std::shared_future<LoadResult> result =
+      std::async(policy, [key]() {
+        LoadResult load_result{};
+        load_result.handle =
+            NodeLitePlatform::OpenLibrary(key, load_result.error);
+        return load_result;
+      }).share();
+  libraries_.try_emplace(std::move(key), result);
+  return result;
+}
+
 //=============================================================================
 // NodeLiteRuntime implementation
 //=============================================================================
 
 /*static*/ void NodeLiteRuntime::Run(std::vector<std::string> argv) {
-  // Convert arguments to vector of strings and skip all options before the JS
-  // file name.
-  std::vector<std::string> args;
-  args.reserve(argv.size());
-  bool skipOptions = true;
-  if (argv.size() < 2) {
-    NodeLiteErrorHandler::ExitWithMessage("", [&](std::ostream& os) {
-      os << "Usage: " << argv[0] << " <js_file>";
-    });
-  }
-  args.push_back(argv[0]);
-  for (int i = 1; i < argv.size(); i++) {
-    if (skipOptions && std::string_view(argv[i]).find("--") == 0) {
-      continue;
-    }
-    skipOptions = false;
-    args.push_back(argv[i]);
+  if (argv.size() >= 2 && argv[1] == "pack") {
+    NodeLiteArchive::Pack(argv);
+    return;
   }
+  NodeLiteOptions options = ParseCommandLine(argv);
 
   std::shared_ptr<NodeLiteTaskRunner> taskRunner =
       std::make_shared<NodeLiteTaskRunner>();
@@ -276,21 +628,34 @@ std::string NodeLiteModule::ReadModuleFileText(napi_env env) {
   // }
 
   fs::path js_root = fs::current_path();
-  std::string jsFilePath = args[1];
+  std::string jsFilePath = options.script_path;
   std::unique_ptr<NodeLiteRuntime> runtime = NodeLiteRuntime::Create(
-      std::move(taskRunner), js_root.string(), std::move(args));
-  runtime->RunTestScript(jsFilePath);
+      std::move(taskRunner), js_root.string(), std::move(options));
+  if (runtime->archive_ != nullptr) {
+    jsFilePath =
+        runtime->archive_
+            ->GetModulePath(
+                runtime->archive_->GetName(runtime->archive_->main_entry()))
+            .string();
+  }
+  if (runtime->options_.bench) {
+    runtime->RunBenchmark(jsFilePath);
+  } else if (runtime->options_.watch) {
+    runtime->RunWatchMode(jsFilePath);
+  } else {
+    runtime->RunTestScript(jsFilePath);
+  }
 }
 
 /*static*/ std::unique_ptr<NodeLiteRuntime> NodeLiteRuntime::Create(
     std::shared_ptr<NodeLiteTaskRunner> task_runner,
     std::string js_root,
-    std::vector<std::string> args) {
+    NodeLiteOptions options) {
   std::unique_ptr<NodeLiteRuntime> runtime =
       std::make_unique<NodeLiteRuntime>(PrivateTag{},
                                         std::move(task_runner),
                                         std::move(js_root),
-                                        std::move(args));
+                                        std::move(options));
   runtime->Initialize();
   return runtime;
 }
@@ -299,14 +664,83 @@ NodeLiteRuntime::NodeLiteRuntime(
     PrivateTag,
     std::shared_ptr<NodeLiteTaskRunner> task_runner,
     std::string js_root,
-    std::vector<std::string> args)
-    : js_root_(std::move(js_root)),
-      task_runner_(std::move(task_runner)),
-      args_(std::move(args)) {}
+    NodeLiteOptions options)
+    : task_runner_(std::move(task_runner)),
+      js_root_(std::move(js_root)),
+      options_(std::move(options)),
+      esm_loader_([this](const fs::path& parent_dir,
+                         const std::string& specifier) {
+        return ResolveImportPath(parent_dir, specifier);
+      }) {
+  // process.argv: [exe_path, script_path, ...script_args]
+  args_.reserve(options_.script_args.size() + 2);
+  args_.push_back(options_.exe_path);
+  args_.push_back(options_.script_path);
+  args_.insert(
+      args_.end(), options_.script_args.begin(), options_.script_args.end());
+}
+
+NodeLiteRuntime::~NodeLiteRuntime() {
+  SaveResolutionCache();
+}
 
 void NodeLiteRuntime::Initialize() {
-  env_holder_ =
-      CreateEnvHolder(task_runner_, [this](napi_env env, napi_value error) {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point start_time = Clock::now();
+  PreloadNativeLibraries();
+  if (NodeLiteArchive::IsArchivePath(options_.script_path)) {
+    std::string error;
+    fs::path archive_path = fs::absolute(options_.script_path);
+    archive_ = NodeLiteArchive::Open(archive_path, error);
+    if (archive_ == nullptr) {
+      NodeLiteErrorHandler::ExitWithMessage("", [&](std::ostream& os) {
+        os << "Failed to open archive " << archive_path.string() << ": "
+           << error;
+      });
+    }
+    esm_loader_.SetArchive(archive_.get());
+  }
+  if (!options_.resolution_cache.empty()) {
+    module_resolver_.LoadCache(options_.resolution_cache);
+    // process.exit() and the error handlers call exit() without destroying
+    // the runtime, so the cache is also saved by an atexit handler.
+    [[maybe_unused]] static const bool is_atexit_registered = []() {
+      std::atexit([]() {
+        if (g_resolution_cache_runtime != nullptr) {
+          g_resolution_cache_runtime->SaveResolutionCache();
+        }
+      });
+      return true;
+    }();
+    g_resolution_cache_runtime = this;
+  }
+  if (options_.watch) {
+    file_watcher_ = NodeLiteFileWatcher::Create();
+    NodeLiteErrorHandler::SetKeepRunningOnError(true);
+    // A package.json change may resolve the same specifiers to other files.
+    module_resolver_.SetPackageJsonCallback(
+        [watcher = file_watcher_.get()](const fs::path& package_json_path) {
+          watcher->Watch(package_json_path);
+        });
+  }
+  if (options_.idle_gc_delay_ms) {
+    // Collections done while the loop waits for the async work or threadsafe
+    // functions do not delay the tasks that would trigger them otherwise.
+    task_runner_->SetIdleCallback(
+        std::chrono::milliseconds(*options_.idle_gc_delay_ms), [this]() {
+          napi_env env = env_;
+          ExitOnException(env, [this, env]() {
+            std::chrono::steady_clock::time_point start_time =
+                std::chrono::steady_clock::now();
+            NODE_LITE_CALL(jsr_collect_garbage(env));
+            ++startup_stats_.idle_gc_count;
+            startup_stats_.idle_gc_time +=
+                std::chrono::steady_clock::now() - start_time;
+          });
+        });
+  }
+  env_holder_ = CreateEnvHolder(
+      task_runner_, options_, [this](napi_env env, napi_value error) {
         NODE_LITE_ASSERT(env == env_,
                          "Unhandled error in different napi_env: %p != %p",
                          env,
@@ -314,25 +748,90 @@ void NodeLiteRuntime::Initialize() {
         OnUncaughtException(error);
       });
   env_ = env_holder_->getEnv();
-  NodeApiEnvScope env_scope{env_};
-  NodeApiHandleScope handle_scope{env_};
-  DefineBuiltInModules();
-  DefineGlobalFunctions();
+  Clock::time_point runtime_created_time = Clock::now();
+  startup_stats_.runtime_create = runtime_created_time - start_time;
+  {
+    NodeApiEnvScope env_scope{env_};
+    NodeApiHandleScope handle_scope{env_};
+    DefineBuiltInModules();
+    DefineGlobalFunctions();
+  }
+  startup_stats_.builtin_setup = Clock::now() - runtime_created_time;
+}
+
+void NodeLiteRuntime::PreloadNativeLibraries() {
+  if (options_.preload_manifest.empty()) {
+    return;
+  }
+  fs::path manifest_path = fs::absolute(options_.preload_manifest);
+  std::ifstream manifest_stream(manifest_path);
+  if (!manifest_stream.is_open()) {
+    NodeLiteErrorHandler::ExitWithMessage("", [&](std::ostream& os) {
+      os << "Failed to open preload manifest: " << manifest_path.string();
+    });
+  }
+  std::string line;
+  while (std::getline(manifest_stream, line)) {
+    line.erase(0, line.find_first_not_of(" \t"));
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    fs::path lib_path = fs::path(line);
+    if (lib_path.is_relative()) {
+      lib_path = manifest_path.parent_path() / lib_path;
+    }
+    if (!fs::is_regular_file(lib_path)) {
+      NodeLiteErrorHandler::ExitWithMessage("", [&](std::ostream& os) {
+        os << "Preload manifest " << manifest_path.string()
+           << " refers to a missing file: " << lib_path.string();
+      });
+    }
+    native_libraries_.Preload(lib_path);
+  }
 }
 
 NodeLiteModule& NodeLiteRuntime::ResolveModule(
     const std::string& parent_module_path, const std::string& module_path) {
+  return GetModule(ResolveModulePath(parent_module_path, module_path));
+}
+
+// Native addons cannot be unloaded, so only the scripts and the JSON files
+// are watched.
+bool NodeLiteRuntime::IsWatchedModulePath(const fs::path& module_path) const {
+  return module_path.is_absolute() &&
+         (module_path.extension() == ".js" ||
+          module_path.extension() == ".cjs" ||
+          module_path.extension() == ".json" ||
+          NodeLiteEsmLoader::IsEsmPath(module_path)) &&
+         (archive_ == nullptr || !archive_->GetEntryName(module_path));
+}
+
+NodeLiteModule& NodeLiteRuntime::GetModule(const fs::path& fs_module_path) {
   napi_env env = env_;
-  fs::path fs_module_path = ResolveModulePath(parent_module_path, module_path);
   if (auto it = registered_modules_.find(fs_module_path.string());
       it != registered_modules_.end()) {
     return *it->second;
   }
 
+  // The native modules are only registered by AddNativeModule.
+  // Their NodeLiteModule instances are created on the first use.
+  std::unique_ptr<NodeLiteModule> module;
+  if (auto it = native_module_inits_.find(fs_module_path.string());
+      it != native_module_inits_.end()) {
+    module = std::make_unique<NodeLiteModule>(fs_module_path.string(),
+                                              std::move(it->second));
+    native_module_inits_.erase(it);
+  } else {
+    module = std::make_unique<NodeLiteModule>(fs_module_path.string());
+  }
+
   if (auto [it, succeeded] = registered_modules_.try_emplace(
-          fs_module_path.string(),
-          std::make_unique<NodeLiteModule>(fs_module_path.string()));
+          fs_module_path.string(), std::move(module));
       succeeded) {
+    if (file_watcher_ != nullptr && IsWatchedModulePath(fs_module_path)) {
+      file_watcher_->Watch(fs_module_path);
+    }
     return *it->second;
   }
 
@@ -342,13 +841,53 @@ NodeLiteModule& NodeLiteRuntime::ResolveModule(
 
 fs::path NodeLiteRuntime::ResolveModulePath(
     const std::string& parent_module_path, const std::string& module_path) {
-  napi_env env = env_;
   // 1. See if it is an embedded module such as "assert".
   auto it = node_js_modules_.find(module_path);
   if (it != node_js_modules_.end()) {
     return fs::path(it->second);
   }
 
+  // 2. Modules inside of the application archive are resolved from its
+  // index without the file system access.
+  if (archive_ != nullptr) {
+    if (std::optional<std::string> parent_name =
+            archive_->GetEntryName(parent_module_path)) {
+      if (std::optional<std::string_view> name =
+              archive_->Resolve(*parent_name, module_path)) {
+        return archive_->GetModulePath(*name);
+      }
+    }
+    if (std::optional<std::string> name = archive_->GetEntryName(module_path);
+        name && archive_->Find(*name) != nullptr) {
+      return fs::path(module_path);
+    }
+  }
+
+  // 3. See if it was already resolved from the same folder.
+  if (std::optional<fs::path> cached_path =
+          module_resolver_.FindCachedPath(parent_module_path, module_path)) {
+    return *cached_path;
+  }
+
+  fs::path result = ResolveModuleFilePath(parent_module_path, module_path);
+  module_resolver_.AddCachedPath(parent_module_path, module_path, result);
+  return result;
+}
+
+fs::path NodeLiteRuntime::ResolveModuleFilePath(
+    const std::string& parent_module_path, const std::string& module_path) {
+  napi_env env = env_;
+  // 1. Bare specifiers such as "pkg" or "pkg/sub/path" are looked up in the
+  // node_modules folders first.
+  if (NodeLiteModuleResolver::IsBareSpecifier(module_path)) {
+    if (std::optional<fs::path> result = module_resolver_.ResolvePackage(
+            parent_module_path,
+            module_path,
+            NodeLiteModuleResolver::RequireConditions())) {
+      return *result;
+    }
+  }
+
   // 2. Check if it is a relative or an absolute path to a module.
   {
     fs::path fs_module_path = fs::path(module_path);
@@ -372,12 +911,19 @@ fs::path NodeLiteRuntime::ResolveModulePath(
         fs::exists(result)) {
       return result;
     }
+    if (fs::path result = fs::path(fs_module_path).replace_extension(".json");
+        fs::exists(result)) {
+      return result;
+    }
     if (fs::path result = fs_module_path / "index.js"; fs::exists(result)) {
       return result;
     }
     if (fs::path result = fs_module_path / "index.cjs"; fs::exists(result)) {
       return result;
     }
+    if (fs::path result = fs_module_path / "index.json"; fs::exists(result)) {
+      return result;
+    }
     // See if it is a native module.
     fs::path node_module_path =
         fs::path(fs_module_path).replace_extension(".node");
@@ -394,36 +940,137 @@ fs::path NodeLiteRuntime::ResolveModulePath(
     }
   }
 
-  // 3. Check if it is in the node_modules folder.
-  {
-    // fs::path fs_module_path = fs::weakly_canonical(
-    //     fs::path(js_root_) / "node_modules" / fs::path(module_path));
-
-    // if (fs::exists(fs_module_path) && fs::is_regular_file(fs_module_path)) {
-    //   return fs_module_path;
-    // }
-    // if (fs::path result = fs::path(fs_module_path).replace_extension(".js");
-    //     fs::exists(result)) {
-    //   return result;
-    // }
-    // if (fs::path result = fs_module_path / "index.js"; fs::exists(result)) {
-    //   return result;
-    // }
-  }
-
   NODE_LITE_ASSERT(
       false, "Cannot resolve module path '%s'", module_path.c_str());
 }
 
+std::string NodeLiteRuntime::ResolveImportPath(const fs::path& parent_dir,
+                                               const std::string& specifier) {
+  // The built-in modules are registered before any script runs, so the map
+  // is not changed while the loader threads read it.
+  if (auto it = node_js_modules_.find(specifier);
+      it != node_js_modules_.end()) {
+    return it->second;
+  }
+  // The imports of the archive modules are resolved from its index.
+  if (archive_ != nullptr) {
+    if (std::optional<std::string> parent_name =
+            archive_->GetEntryName(parent_dir)) {
+      if (std::optional<std::string_view> name =
+              archive_->Resolve(*parent_name, specifier)) {
+        return archive_->GetModulePath(*name).string();
+      }
+      throw NodeLiteException(
+          napi_generic_failure,
+          ("Cannot find module '" + specifier + "'").c_str());
+    }
+  }
+  std::optional<fs::path> result;
+  if (NodeLitePath::IsFileUrl(specifier)) {
+    std::string file_path;
+    if (!NodeLitePath::FromFileUrl(specifier, file_path)) {
+      throw NodeLiteException(
+          napi_generic_failure,
+          ("Invalid file URL '" + specifier + "'").c_str());
+    }
+    result = module_resolver_.ResolveFileOrDirectory(
+        fs::weakly_canonical(fs::u8path(file_path)));
+  } else if (NodeLiteModuleResolver::IsBareSpecifier(specifier)) {
+    result = module_resolver_.ResolvePackage(
+        parent_dir, specifier, NodeLiteModuleResolver::ImportConditions());
+  } else {
+    fs::path path = fs::path(specifier);
+    if (path.is_relative()) {
+      path = parent_dir / path;
+    }
+    result = module_resolver_.ResolveFileOrDirectory(fs::weakly_canonical(path));
+  }
+  if (!result) {
+    throw NodeLiteException(
+        napi_generic_failure,
+        ("Cannot find module '" + specifier + "'").c_str());
+  }
+  return result->string();
+}
+
 void NodeLiteRuntime::AddNativeModule(
     const std::string& module_name,
     std::function<napi_value(napi_env, napi_value)> initModule) {
   napi_env env = env_;
-  auto [_, succeeded] = registered_modules_.try_emplace(
+  auto [_, succeeded] =
+      native_module_inits_.try_emplace(module_name, std::move(initModule));
+  NODE_LITE_ASSERT(succeeded && registered_modules_.count(module_name) == 0,
+                   "Failed to register module: %s",
+                   module_name.c_str());
+}
+
+void NodeLiteRuntime::AddScriptModule(
+    const std::string& module_name,
+    std::string_view source,
+    std::function<napi_value(napi_env)> create_binding) {
+  node_js_modules_.try_emplace(module_name, module_name);
+  node_js_modules_.try_emplace("node:" + module_name, module_name);
+  AddNativeModule(
       module_name,
-      std::make_unique<NodeLiteModule>(module_name, std::move(initModule)));
-  NODE_LITE_ASSERT(
-      succeeded, "Failed to register module: %s", module_name.c_str());
+      [this, module_name, source, create_binding = std::move(create_binding)](
+          napi_env env, napi_value /*exports*/) {
+        napi_value binding = create_binding ? create_binding(env)
+                                            : NodeApi::GetUndefined(env);
+        return RunBuiltinScript(env, source, "node:" + module_name, binding);
+      });
+}
+
+napi_value NodeLiteRuntime::RunBuiltinScript(napi_env env,
+                                             std::string_view source,
+                                             const std::string& source_url,
+                                             napi_value binding) {
+  napi_value script_func =
+      NodeApi::RunScript(env, std::string(source), source_url.c_str());
+  // The built-in scripts may only require the built-in modules.
+  napi_value require = NodeApi::CreateFunction(
+      env, "require", [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        return ResolveModule(js_root_, NodeApi::ToStdString(env, args[0]))
+            .LoadModule(env);
+      });
+  return NodeApi::CallFunction(env, script_func, {binding, require});
+}
+
+napi_value NodeLiteRuntime::Import(const fs::path& parent_path,
+                                   const std::string& specifier) {
+  NodeLiteModule& module =
+      GetModule(ResolveImportPath(parent_path.parent_path(), specifier));
+  AddModuleDependency(parent_path, module);
+  return module.LoadModule(env_);
+}
+
+napi_value NodeLiteRuntime::Require(const fs::path& parent_path,
+                                    const std::string& module_path) {
+  auto load_module = [&]() {
+    NodeLiteModule& module =
+        ResolveModule(parent_path.parent_path().string(), module_path);
+    AddModuleDependency(parent_path, module);
+    return module.LoadModule(env_);
+  };
+  if (!is_first_require_) {
+    return load_module();
+  }
+  is_first_require_ = false;
+  std::chrono::steady_clock::time_point start_time =
+      std::chrono::steady_clock::now();
+  napi_value result = load_module();
+  startup_stats_.first_require = std::chrono::steady_clock::now() - start_time;
+  startup_stats_.first_require_module = module_path;
+  return result;
+}
+
+void NodeLiteRuntime::AddModuleDependency(const fs::path& parent_path,
+                                          const NodeLiteModule& module) {
+  if (file_watcher_ == nullptr) {
+    return;
+  }
+  module_dependents_[module.module_path().string()].insert(
+      parent_path.string());
 }
 
 void NodeLiteRuntime::RunTestScript(const std::string& script_path) {
@@ -432,16 +1079,293 @@ void NodeLiteRuntime::RunTestScript(const std::string& script_path) {
   {
     ExitOnException(env_, [this, &script_path]() {
       NodeApiHandleScope scope{env_};
+      std::chrono::steady_clock::time_point start_time =
+          std::chrono::steady_clock::now();
       NodeLiteModule& main_module = ResolveModule(js_root_, script_path);
       main_module.LoadModule(env_);
+      startup_stats_.main_module_load =
+          std::chrono::steady_clock::now() - start_time;
+      DrainMicrotasks();
     });
     ExitOnException(env_, [this]() {
-      task_runner_->DrainTaskQueue();
+      task_runner_->DrainTaskQueue([this]() { DrainMicrotasks(); });
       OnExit();
       on_exit_callbacks_.clear();
       on_uncaughtException_callbacks_.clear();
     });
   }
+  if (options_.startup_stats) {
+    PrintStartupStats();
+  }
+  if (options_.tsfn_stats) {
+    PrintTsfnStats();
+  }
+}
+
+void NodeLiteRuntime::RunWatchMode(const std::string& script_path) {
+  NodeApiEnvScope env_scope{env_};
+  NodeApiHandleScope handle_scope{env_};
+  std::cerr << "[watch] Running " << script_path << std::endl;
+  bool succeeded = PrintOnException(env_, [this, &script_path]() {
+    NodeApiHandleScope scope{env_};
+    ResolveModule(js_root_, script_path).LoadModule(env_);
+    DrainMicrotasks();
+  });
+  if (!succeeded) {
+    std::cerr << "[watch] Waiting for file changes before restarting"
+              << std::endl;
+  }
+
+  // The watcher thread keeps the event loop alive and posts the reloads to
+  // the JS thread. The loop runs until the process exits.
+  task_runner_->Ref();
+  std::thread watcher_thread([this, &script_path]() {
+    for (;;) {
+      std::vector<fs::path> changed = file_watcher_->WaitForChanges();
+      if (changed.empty()) {
+        return;
+      }
+      task_runner_->PostTask([this, &script_path, changed]() {
+        ReloadChangedModules(script_path, changed);
+      });
+    }
+  });
+  ExitOnException(env_, [this]() {
+    task_runner_->DrainTaskQueue([this]() { DrainMicrotasks(); });
+    OnExit();
+  });
+  file_watcher_->Stop();
+  watcher_thread.join();
+}
+
+void NodeLiteRuntime::ReloadChangedModules(
+    const std::string& script_path, const std::vector<fs::path>& changed) {
+  napi_env env = env_;
+  NodeApiHandleScope scope{env};
+  // The changed modules and all modules that depend on them are evicted.
+  // The main module is always reloaded to run the application again.
+  // Other modules keep their exports. A package.json change may redirect
+  // any resolution, so it evicts all watched modules.
+  module_resolver_.ClearCaches();
+  std::vector<std::string> pending;
+  pending.reserve(changed.size() + 1);
+  for (const fs::path& file_path : changed) {
+    if (file_path.filename() == "package.json") {
+      for (const auto& [module_path, module] : registered_modules_) {
+        if (IsWatchedModulePath(module_path)) {
+          pending.push_back(module_path);
+        }
+      }
+    }
+    pending.push_back(file_path.string());
+  }
+  pending.push_back(ResolveModulePath(js_root_, script_path).string());
+  std::unordered_set<std::string> evicted;
+  while (!pending.empty()) {
+    std::string module_path = std::move(pending.back());
+    pending.pop_back();
+    if (!evicted.insert(module_path).second) {
+      continue;
+    }
+    if (auto it = module_dependents_.find(module_path);
+        it != module_dependents_.end()) {
+      pending.insert(pending.end(), it->second.begin(), it->second.end());
+      module_dependents_.erase(it);
+    }
+  }
+  // The JS functions of the evicted modules refer to them only by their
+  // paths, so the modules are deleted once the new run completes.
+  std::vector<std::unique_ptr<NodeLiteModule>> retired_modules;
+  for (const std::string& module_path : evicted) {
+    if (auto it = registered_modules_.find(module_path);
+        it != registered_modules_.end()) {
+      retired_modules.push_back(std::move(it->second));
+      registered_modules_.erase(it);
+    }
+    esm_loader_.Evict(module_path);
+  }
+
+  std::cerr << "[watch] " << changed.size() << " changed file(s), reloading "
+            << retired_modules.size() << " module(s)" << std::endl;
+  // The process event listeners are registered again by the new run.
+  // The timers, immediates, servers, and sockets of the previous run are
+  // closed, so that the new run can listen on the same ports.
+  on_exit_callbacks_.clear();
+  on_uncaughtException_callbacks_.clear();
+  ++run_id_;
+  bool succeeded = PrintOnException(env, [this, &script_path]() {
+#ifdef __linux__
+    if (net_ != nullptr) {
+      net_->CloseAllHandles();
+    }
+#endif
+    ResolveModule(js_root_, script_path).LoadModule(env_);
+  });
+  if (!succeeded) {
+    std::cerr << "[watch] Waiting for file changes before restarting"
+              << std::endl;
+  }
+}
+
+void NodeLiteRuntime::PrintStartupStats() {
+  auto to_ms = [](std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+  std::cerr << std::fixed << std::setprecision(3) << "Startup stats:\n"
+            << "  Runtime create: "
+            << to_ms(startup_stats_.runtime_create) << " ms\n"
+            << "  Built-in setup: " << to_ms(startup_stats_.builtin_setup)
+            << " ms\n"
+            << "   First require: ";
+  if (!is_first_require_) {
+    std::cerr << to_ms(startup_stats_.first_require) << " ms ('"
+              << startup_stats_.first_require_module << "')\n";
+  } else {
+    std::cerr << "n/a\n";
+  }
+  std::cerr << "     Main module: " << to_ms(startup_stats_.main_module_load)
+            << " ms" << std::endl;
+  const NodeLiteTaskRunner::FinalizerStats& finalizer_stats =
+      task_runner_->finalizer_stats();
+  if (finalizer_stats.finalizer_count > 0) {
+    std::cerr << "      Finalizers: " << finalizer_stats.finalizer_count
+              << " in " << finalizer_stats.batch_count
+              << " batches (max " << finalizer_stats.max_batch_size
+              << "), run " << to_ms(finalizer_stats.run_time)
+              << " ms, latency avg "
+              << to_ms(finalizer_stats.total_latency /
+                       finalizer_stats.finalizer_count)
+              << " ms, max " << to_ms(finalizer_stats.max_latency) << " ms"
+              << std::endl;
+  }
+  if (options_.idle_gc_delay_ms) {
+    std::cerr << "         Idle GC: " << startup_stats_.idle_gc_count
+              << " collections in " << to_ms(startup_stats_.idle_gc_time)
+              << " ms" << std::endl;
+  }
+}
+
+void NodeLiteRuntime::PrintTsfnStats() {
+  auto to_ms = [](std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+  std::vector<NodeLiteTsfnMetrics> all_metrics = GetThreadSafeFunctionMetrics();
+  std::cerr << std::fixed << std::setprecision(3)
+            << "Threadsafe function stats:\n";
+  if (all_metrics.empty()) {
+    std::cerr << "  n/a\n";
+  }
+  for (const NodeLiteTsfnMetrics& metrics : all_metrics) {
+    std::cerr << "  '" << metrics.resource_name << "'";
+    if (metrics.released_count > 0) {
+      std::cerr << " (" << metrics.released_count << " released)";
+    }
+    std::cerr << ": pushed " << metrics.items_pushed << ", dispatched "
+              << metrics.items_dispatched << ", queue max "
+              << metrics.queue_high_water_mark << ", latency p50 <"
+              << metrics.GetLatencyPercentileUs(0.5) << " us, p99 <"
+              << metrics.GetLatencyPercentileUs(0.99) << " us, max "
+              << to_ms(metrics.max_latency) << " ms, JS callbacks "
+              << to_ms(metrics.js_callback_time) << " ms\n";
+  }
+  std::cerr << std::flush;
+}
+
+void NodeLiteRuntime::DrainMicrotasks() {
+  // The tick queue runs before the promise jobs as in Node.js. Each side may
+  // add to the other one, so they are drained until both are empty.
+  do {
+    DrainTickQueue();
+    // The engine drains microtasks on its own unless they are explicit.
+    if (options_.explicit_microtasks) {
+      napi_env env = env_;
+      ReportOnException(env, [env]() {
+        NodeApiHandleScope scope{env};
+        bool is_drained{};
+        do {
+          NODE_LITE_CALL(jsr_drain_microtasks(env, -1, &is_drained));
+        } while (!is_drained);
+      });
+    }
+  } while (tick_queue_size_ != 0);
+}
+
+void NodeLiteRuntime::EnqueueTick(napi_value callback, span<napi_value> args) {
+  napi_env env = env_;
+  NODE_LITE_ASSERT(NodeApi::TypeOf(env, callback) == napi_function,
+                   "The callback must be a function");
+  napi_value queue{};
+  if (tick_queue_) {
+    queue = NodeApi::GetReferenceValue(env, tick_queue_.get());
+  } else {
+    NODE_LITE_CALL(napi_create_array(env, &queue));
+    tick_queue_ = MakeNodeApiRef(env, queue);
+  }
+  napi_value callback_args{};
+  if (args.size() == 0) {
+    callback_args = NodeApi::GetUndefined(env);
+  } else {
+    NODE_LITE_CALL(
+        napi_create_array_with_length(env, args.size(), &callback_args));
+    for (uint32_t i = 0; i < args.size(); ++i) {
+      NODE_LITE_CALL(napi_set_element(env, callback_args, i, args[i]));
+    }
+  }
+  NODE_LITE_CALL(napi_set_element(env, queue, tick_queue_size_, callback));
+  NODE_LITE_CALL(
+      napi_set_element(env, queue, tick_queue_size_ + 1, callback_args));
+  tick_queue_size_ += 2;
+}
+
+void NodeLiteRuntime::DrainTickQueue() {
+  if (tick_queue_size_ == 0) {
+    return;
+  }
+  napi_env env = env_;
+  ReportOnException(env, [this, env]() {
+    // The handles are released in batches instead of per callback.
+    constexpr uint32_t kBatchSize = 256;
+    NodeApiHandleScope scope{env};
+    napi_value queue = NodeApi::GetReferenceValue(env, tick_queue_.get());
+    std::vector<napi_value> args;
+    // The callbacks may add new entries while the queue is drained.
+    for (uint32_t index = 0; index < tick_queue_size_;) {
+      NodeApiHandleScope batch_scope{env};
+      for (uint32_t batch_end = index + 2 * kBatchSize;
+           index < tick_queue_size_ && index < batch_end;
+           index += 2) {
+        napi_value callback{};
+        napi_value callback_args{};
+        NODE_LITE_CALL(napi_get_element(env, queue, index, &callback));
+        NODE_LITE_CALL(napi_get_element(env, queue, index + 1, &callback_args));
+        args.clear();
+        if (NodeApi::TypeOf(env, callback_args) != napi_undefined) {
+          uint32_t arg_count{};
+          NODE_LITE_CALL(
+              napi_get_array_length(env, callback_args, &arg_count));
+          args.resize(arg_count);
+          for (uint32_t i = 0; i < arg_count; ++i) {
+            NODE_LITE_CALL(napi_get_element(env, callback_args, i, &args[i]));
+          }
+        }
+        NodeApi::CallFunction(
+            env, callback, span<napi_value>(args.data(), args.size()));
+      }
+    }
+    // The array keeps its storage for the next ticks.
+    tick_queue_size_ = 0;
+    NodeApi::SetProperty(env, queue, "length", NodeApi::CreateUInt32(env, 0));
+  });
+  // A callback error in the watch mode drops the rest of the queue.
+  tick_queue_size_ = 0;
+}
+
+void NodeLiteRuntime::SaveResolutionCache() noexcept {
+  if (g_resolution_cache_runtime != this) {
+    return;
+  }
+  g_resolution_cache_runtime = nullptr;
+  module_resolver_.SaveCache(options_.resolution_cache);
 }
 
 void NodeLiteRuntime::OnExit() {
@@ -467,7 +1391,10 @@ void NodeLiteRuntime::OnUncaughtException(napi_value error) {
     shouldExit = false;
   }
 
-  if (shouldExit) {
+  if (shouldExit && file_watcher_ != nullptr) {
+    // The watch mode keeps running until the next file change.
+    NodeLiteErrorHandler::PrintJSError(env_, error);
+  } else if (shouldExit) {
     NodeLiteErrorHandler::ExitWithJSError(env_, error);
   }
 }
@@ -571,27 +1498,69 @@ void NodeLiteRuntime::DefineBuiltInModules() {
             fs::path path = fs::path{NodeApi::ToStdString(env, args[0])};
             return NodeApi::CreateString(env, ReadFileText(env, path));
           });
+      // Parses the file natively without reading it into a JS string.
+      NodeApi::SetMethod(
+          env_,
+          exports,
+          "readJSONSync",
+          [](napi_env env, span<napi_value> args) {
+            NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+            fs::path path = fs::path{NodeApi::ToStdString(env, args[0])};
+            return NodeLiteJson::ParseFile(env, path);
+          });
       return exports;
     });
   }
 
+  // Define "events" module
+  AddScriptModule("events", kEventsModuleSource);
+
+  // Define "readline" module
+  AddScriptModule(
+      "readline", NodeLiteReadline::kModuleSource, [](napi_env env) {
+        return NodeLiteReadline::CreateBinding(env);
+      });
+
+  // Define "buffer" module
+  AddScriptModule("buffer", NodeLiteBuffer::kModuleSource, [](napi_env env) {
+    return NodeLiteBuffer::CreateBinding(env);
+  });
+
+  // Define "crypto" module
+  AddScriptModule("crypto", NodeLiteCrypto::kModuleSource, [](napi_env env) {
+    return NodeLiteCrypto::CreateBinding(env);
+  });
+
+  // Define "util" module with TextEncoder and TextDecoder
+  AddScriptModule("util", NodeLiteText::kModuleSource, [](napi_env env) {
+    return NodeLiteText::CreateBinding(env);
+  });
+
+#ifdef __linux__
+  // Define "net" module. Its reactor is attached to the event loop on the
+  // first require of "net" or "http".
+  AddScriptModule("net", NodeLiteNet::kModuleSource, [this](napi_env env) {
+    if (net_ == nullptr) {
+      net_ = NodeLiteNet::Create(env, task_runner_);
+    }
+    return net_->CreateBinding(env);
+  });
+
+  // Define "http" module. It shares the reactor with the "net" module.
+  AddScriptModule("http", NodeLiteHttp::kModuleSource, [this](napi_env env) {
+    if (net_ == nullptr) {
+      net_ = NodeLiteNet::Create(env, task_runner_);
+    }
+    return net_->http().CreateBinding(env);
+  });
+#endif
+
   // Define "path" module
   {
     node_js_modules_.try_emplace("path", "path");
     node_js_modules_.try_emplace("node:path", "path");
-    AddNativeModule("path", [this](napi_env env, napi_value exports) {
-      NodeApi::SetMethod(
-          env_, exports, "join", [](napi_env env, span<napi_value> args) {
-            NODE_LITE_ASSERT(args.size() >= 2,
-                             "Expected at least 2 arguments, but got: %zu",
-                             args.size());
-            fs::path path = fs::path{NodeApi::ToStdString(env, args[0])};
-            for (size_t i = 1; i < args.size(); ++i) {
-              path /= NodeApi::ToStdString(env, args[i]);
-            }
-            return NodeApi::CreateString(env, path.string());
-          });
-      return exports;
+    AddNativeModule("path", [](napi_env env, napi_value exports) {
+      return NodeLitePath::InitModule(env, exports);
     });
   }
 }
@@ -623,9 +1592,16 @@ void NodeLiteRuntime::DefineGlobalFunctions() {
                      args.size());
     std::shared_ptr<NodeApiRef> callback_ref =
         std::make_shared<NodeApiRef>(MakeNodeApiRef(env, args[0]));
-    uint32_t task_id = GetRuntime(env)->task_runner_->PostTask(
-        [env, callback_ref = std::move(callback_ref)]() {
-          ExitOnException(env, [env, &callback_ref]() {
+    NodeLiteRuntime* runtime = GetRuntime(env);
+    uint32_t task_id = runtime->task_runner_->PostTask(
+        [env,
+         runtime,
+         run_id = runtime->run_id_,
+         callback_ref = std::move(callback_ref)]() {
+          if (run_id != runtime->run_id_) {
+            return;
+          }
+          ReportOnException(env, [env, &callback_ref]() {
             NodeApiHandleScope scope{env};
             napi_value callback =
                 NodeApi::GetReferenceValue(env, callback_ref->get());
@@ -638,6 +1614,16 @@ void NodeLiteRuntime::DefineGlobalFunctions() {
   // global.setImmediate()
   NodeApi::SetMethod(env_, global, "setImmediate", set_immediate_cb);
 
+  // global.queueMicrotask()
+  NodeApi::SetMethod(
+      env_, global, "queueMicrotask", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1,
+                         "Expected at least 1 argument, but got: %zu",
+                         args.size());
+        GetRuntime(env)->EnqueueTick(args[0], span<napi_value>(nullptr, 0));
+        return nullptr;
+      });
+
   // global.setTimeout()
   NodeApi::SetMethod(env_, global, "setTimeout", set_immediate_cb);
 
@@ -652,96 +1638,296 @@ void NodeLiteRuntime::DefineGlobalFunctions() {
         return nullptr;
       });
 
-  // global.process
-  {
-    napi_value process_obj = NodeApi::CreateObject(env_);
-    NodeApi::SetProperty(env_, global, "process", process_obj);
+  // global.process and global.console are created on first access.
+  DefineLazyGlobal(global, "process", [this](napi_env env) {
+    return CreateProcessObject(env);
+  });
+  DefineLazyGlobal(global, "console", [this](napi_env env) {
+    return CreateConsoleObject(env);
+  });
+  DefineLazyGlobal(global, "performance", [](napi_env env) {
+    napi_value performance_obj = NodeApi::CreateObject(env);
+    // performance.now() returns the milliseconds since the first access.
+    NodeApi::SetMethod(
+        env,
+        performance_obj,
+        "now",
+        [start_time = std::chrono::steady_clock::now()](
+            napi_env env, span<napi_value> /*args*/) {
+          std::chrono::duration<double, std::milli> elapsed =
+              std::chrono::steady_clock::now() - start_time;
+          return NodeApi::CreateDouble(env, elapsed.count());
+        });
+    return performance_obj;
+  });
+  // These globals are the exports of the built-in modules.
+  for (const auto& global_export : {std::pair{"Buffer", "buffer"},
+                                    std::pair{"TextEncoder", "util"},
+                                    std::pair{"TextDecoder", "util"}}) {
+    DefineLazyGlobal(
+        global, global_export.first, [this, global_export](napi_env env) {
+          napi_value exports =
+              ResolveModule(js_root_, global_export.second).LoadModule(env);
+          return NodeApi::GetProperty(env, exports, global_export.first);
+        });
+  }
+}
 
-    // process.argv
-    NodeApi::SetPropertyStringArray(env_, process_obj, "argv", args_);
+void NodeLiteRuntime::DefineLazyGlobal(
+    napi_value global,
+    std::string name,
+    std::function<napi_value(napi_env)> create) {
+  LazyGlobal& lazy_global =
+      lazy_globals_.emplace_back(
+          LazyGlobal{std::move(name), std::move(create), NodeApiRef{}});
+  napi_property_descriptor descriptor{};
+  descriptor.utf8name = lazy_global.name.c_str();
+  // The getter creates the value and replaces the accessor with it.
+  descriptor.getter = [](napi_env env, napi_callback_info info) {
+    napi_value result{};
+    ThrowJSErrorOnException(env, [env, info, &result]() {
+      NodeApiCallbackInfo callback_info{env, info};
+      LazyGlobal* lazy_global = static_cast<LazyGlobal*>(callback_info.data());
+      if (lazy_global->value) {
+        result = NodeApi::GetReferenceValue(env, lazy_global->value.get());
+        return;
+      }
+      result = lazy_global->create(env);
+      lazy_global->value = MakeNodeApiRef(env, result);
+      lazy_global->create = nullptr;
+      DefineGlobalValue(env, lazy_global->name, result);
+    });
+    return result;
+  };
+  // Assigning the global before its first access skips its creation.
+  descriptor.setter = [](napi_env env, napi_callback_info info) -> napi_value {
+    ThrowJSErrorOnException(env, [env, info]() {
+      NodeApiCallbackInfo callback_info{env, info};
+      LazyGlobal* lazy_global = static_cast<LazyGlobal*>(callback_info.data());
+      napi_value value = callback_info.args().size() > 0
+                             ? callback_info.args()[0]
+                             : NodeApi::GetUndefined(env);
+      lazy_global->value = MakeNodeApiRef(env, value);
+      lazy_global->create = nullptr;
+      DefineGlobalValue(env, lazy_global->name, value);
+    });
+    return nullptr;
+  };
+  descriptor.attributes = static_cast<napi_property_attributes>(
+      napi_enumerable | napi_configurable);
+  descriptor.data = &lazy_global;
+  napi_env env = env_;
+  NODE_LITE_CALL(napi_define_properties(env, global, 1, &descriptor));
+}
+
+napi_value NodeLiteRuntime::CreateProcessObject(napi_env env) {
+  napi_value process_obj = NodeApi::CreateObject(env);
+
+  // process.argv
+  NodeApi::SetPropertyStringArray(env, process_obj, "argv", args_);
 
-    // process.execPath
-    NodeApi::SetPropertyString(env_, process_obj, "execPath", args_[0]);
+  // process.execPath
+  NodeApi::SetPropertyString(env, process_obj, "execPath", args_[0]);
 
 // process.target_config
 #ifdef NDEBUG
-    NodeApi::SetPropertyString(env_, process_obj, "target_config", "Release");
+  NodeApi::SetPropertyString(env, process_obj, "target_config", "Release");
 #else
-    NodeApi::SetPropertyString(env_, process_obj, "target_config", "Debug");
+  NodeApi::SetPropertyString(env, process_obj, "target_config", "Debug");
 #endif
 
 // process.platform
 #ifdef WIN32
-    NodeApi::SetPropertyString(env_, process_obj, "platform", "win32");
+  NodeApi::SetPropertyString(env, process_obj, "platform", "win32");
+#elif defined(__linux__)
+  NodeApi::SetPropertyString(env, process_obj, "platform", "linux");
+#elif defined(__APPLE__)
+  NodeApi::SetPropertyString(env, process_obj, "platform", "darwin");
 #else
-    // TODO: (vmoroz) Add support for other platforms.
-    NodeApi::SetPropertyString(env_, process_obj, "platform", "other");
+  // TODO: (vmoroz) Add support for other platforms.
+  NodeApi::SetPropertyString(env, process_obj, "platform", "other");
 #endif
 
-    // process.exit(exit_code)
-    NodeApi::SetMethod(
-        env_, process_obj, "exit", [](napi_env env, span<napi_value> args) {
-          NODE_LITE_ASSERT(args.size() >= 1,
-                           "Expected at least 1 argument, but got: "
-                           "%zu",
-                           args.size());
-          int32_t exit_code = NodeApi::GetValueInt32(env, args[0]);
-          exit(exit_code);
-          return nullptr;
-        });
+  // process.stdin is created on first access. Its reader thread starts when
+  // the stream starts flowing.
+  napi_property_descriptor stdin_descriptor{};
+  stdin_descriptor.utf8name = "stdin";
+  stdin_descriptor.getter = [](napi_env env, napi_callback_info info) {
+    napi_value result{};
+    ThrowJSErrorOnException(env, [env, info, &result]() {
+      NodeApiCallbackInfo callback_info{env, info};
+      result = GetRuntime(env)->CreateStdinStream(env);
+      napi_property_descriptor descriptor{};
+      descriptor.utf8name = "stdin";
+      descriptor.value = result;
+      descriptor.attributes = static_cast<napi_property_attributes>(
+          napi_enumerable | napi_configurable);
+      NODE_LITE_CALL(napi_define_properties(
+          env, callback_info.this_arg(), 1, &descriptor));
+    });
+    return result;
+  };
+  stdin_descriptor.attributes = static_cast<napi_property_attributes>(
+      napi_enumerable | napi_configurable);
+  NODE_LITE_CALL(
+      napi_define_properties(env, process_obj, 1, &stdin_descriptor));
 
-    // process.on('event_name', callback)
-    NodeApi::SetMethod(
-        env_, process_obj, "on", [](napi_env env, span<napi_value> args) {
-          NODE_LITE_ASSERT(args.size() >= 2,
-                           "Expected at least 2 arguments, but got: %zu",
-                           args.size());
-          std::string event_name = NodeApi::ToStdString(env, args[0]);
-          if (event_name == "exit") {
-            NODE_LITE_ASSERT(NodeApi::TypeOf(env, args[1]) == napi_function,
-                             "Expected function as second argument");
-            GetRuntime(env)->on_exit_callbacks_.push_back(
-                MakeNodeApiRef(env, args[1]));
-          } else if (event_name == "uncaughtException") {
-            NODE_LITE_ASSERT(NodeApi::TypeOf(env, args[1]) == napi_function,
-                             "Expected function as second argument");
-            GetRuntime(env)->on_uncaughtException_callbacks_.push_back(
-                MakeNodeApiRef(env, args[1]));
-          } else {
-            NODE_LITE_ASSERT(false,
-                             "Unsupported process event name: %s",
-                             event_name.c_str());
+  // process.exit(exit_code)
+  NodeApi::SetMethod(
+      env, process_obj, "exit", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1,
+                         "Expected at least 1 argument, but got: "
+                         "%zu",
+                         args.size());
+        int32_t exit_code = NodeApi::GetValueInt32(env, args[0]);
+        exit(exit_code);
+        return nullptr;
+      });
+
+  // process.nextTick(callback, ...args)
+  NodeApi::SetMethod(
+      env, process_obj, "nextTick", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1,
+                         "Expected at least 1 argument, but got: %zu",
+                         args.size());
+        GetRuntime(env)->EnqueueTick(
+            args[0], span<napi_value>(args.data() + 1, args.size() - 1));
+        return nullptr;
+      });
+
+  // process.getThreadsafeFunctionStats()
+  NodeApi::SetMethod(
+      env,
+      process_obj,
+      "getThreadsafeFunctionStats",
+      [](napi_env env, span<napi_value> /*args*/) {
+        auto to_ms = [](std::chrono::nanoseconds duration) {
+          return std::chrono::duration<double, std::milli>(duration).count();
+        };
+        std::vector<NodeLiteTsfnMetrics> all_metrics =
+            GetThreadSafeFunctionMetrics();
+        napi_value result{};
+        NODE_LITE_CALL(
+            napi_create_array_with_length(env, all_metrics.size(), &result));
+        for (uint32_t i = 0; i < all_metrics.size(); ++i) {
+          const NodeLiteTsfnMetrics& metrics = all_metrics[i];
+          napi_value item = NodeApi::CreateObject(env);
+          NodeApi::SetPropertyString(
+              env, item, "resourceName", metrics.resource_name);
+          NodeApi::SetProperty(
+              env,
+              item,
+              "releasedCount",
+              NodeApi::CreateUInt32(env, metrics.released_count));
+          NodeApi::SetProperty(
+              env,
+              item,
+              "itemsPushed",
+              NodeApi::CreateDouble(
+                  env, static_cast<double>(metrics.items_pushed)));
+          NodeApi::SetProperty(
+              env,
+              item,
+              "itemsDispatched",
+              NodeApi::CreateDouble(
+                  env, static_cast<double>(metrics.items_dispatched)));
+          NodeApi::SetProperty(
+              env,
+              item,
+              "queueHighWaterMark",
+              NodeApi::CreateDouble(
+                  env, static_cast<double>(metrics.queue_high_water_mark)));
+          // Bucket i counts the latencies below 2^i microseconds.
+          napi_value histogram{};
+          NODE_LITE_CALL(napi_create_array_with_length(
+              env, metrics.latency_histogram.size(), &histogram));
+          for (uint32_t j = 0; j < metrics.latency_histogram.size(); ++j) {
+            NODE_LITE_CALL(napi_set_element(
+                env,
+                histogram,
+                j,
+                NodeApi::CreateDouble(
+                    env, static_cast<double>(metrics.latency_histogram[j]))));
           }
-          return nullptr;
-        });
-  }
+          NodeApi::SetProperty(env, item, "latencyHistogramUs", histogram);
+          NodeApi::SetProperty(
+              env,
+              item,
+              "maxLatencyMs",
+              NodeApi::CreateDouble(env, to_ms(metrics.max_latency)));
+          NodeApi::SetProperty(
+              env,
+              item,
+              "callbackTimeMs",
+              NodeApi::CreateDouble(env, to_ms(metrics.js_callback_time)));
+          NODE_LITE_CALL(napi_set_element(env, result, i, item));
+        }
+        return result;
+      });
 
-  // global.console
-  {
-    napi_value console_obj = NodeApi::CreateObject(env_);
-    NodeApi::SetProperty(env_, global, "console", console_obj);
+  // process.on('event_name', callback)
+  NodeApi::SetMethod(
+      env, process_obj, "on", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2,
+                         "Expected at least 2 arguments, but got: %zu",
+                         args.size());
+        std::string event_name = NodeApi::ToStdString(env, args[0]);
+        if (event_name == "exit") {
+          NODE_LITE_ASSERT(NodeApi::TypeOf(env, args[1]) == napi_function,
+                           "Expected function as second argument");
+          GetRuntime(env)->on_exit_callbacks_.push_back(
+              MakeNodeApiRef(env, args[1]));
+        } else if (event_name == "uncaughtException") {
+          NODE_LITE_ASSERT(NodeApi::TypeOf(env, args[1]) == napi_function,
+                           "Expected function as second argument");
+          GetRuntime(env)->on_uncaughtException_callbacks_.push_back(
+              MakeNodeApiRef(env, args[1]));
+        } else {
+          NODE_LITE_ASSERT(false,
+                           "Unsupported process event name: %s",
+                           event_name.c_str());
+        }
+        return nullptr;
+      });
 
-    // console.log()
-    NodeApi::SetMethod(
-        env_, console_obj, "log", [](napi_env env, span<napi_value> args) {
-          NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
-          std::string message = NodeApi::ToStdString(env, args[0]);
-          std::cout << message << std::endl;
-          return nullptr;
-        });
+  return process_obj;
+}
 
-    // console.error()
-    NodeApi::SetMethod(
-        env_,
-        console_obj,
-        "error",
-        [](napi_env env, span<napi_value> args) -> napi_value {
-          NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
-          std::string message = NodeApi::ToStdString(env, args[0]);
-          std::cerr << message << std::endl;
-          return nullptr;
-        });
+napi_value NodeLiteRuntime::CreateStdinStream(napi_env env) {
+  if (stdin_ == nullptr) {
+    stdin_ = std::make_unique<NodeLiteStdin>(env, task_runner_);
   }
+  return RunBuiltinScript(env,
+                          NodeLiteStdin::kStreamSource,
+                          "node:internal/stdin",
+                          stdin_->CreateBinding(env));
+}
+
+napi_value NodeLiteRuntime::CreateConsoleObject(napi_env env) {
+  napi_value console_obj = NodeApi::CreateObject(env);
+
+  // console.log()
+  NodeApi::SetMethod(
+      env, console_obj, "log", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+        std::string message = NodeApi::ToStdString(env, args[0]);
+        std::cout << message << std::endl;
+        return nullptr;
+      });
+
+  // console.error()
+  NodeApi::SetMethod(
+      env,
+      console_obj,
+      "error",
+      [](napi_env env, span<napi_value> args) -> napi_value {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+        std::string message = NodeApi::ToStdString(env, args[0]);
+        std::cerr << message << std::endl;
+        return nullptr;
+      });
+
+  return console_obj;
 }
 
 std::string NodeLiteRuntime::ProcessStack(std::string const& stack,
@@ -818,24 +2004,191 @@ void NodeApiRefDeleter::operator()(napi_ref ref) noexcept {
 //=============================================================================
 
 uint32_t NodeLiteTaskRunner::PostTask(std::function<void()>&& task) noexcept {
-  uint32_t task_id = next_task_id_++;
-  task_queue_.emplace_back(task_id, std::move(task));
+  uint32_t task_id{};
+  {
+    std::scoped_lock lock{mutex_};
+    task_id = next_task_id_++;
+    task_queue_.emplace_back(task_id, std::move(task));
+    WakeLocked();
+  }
+  task_posted_.notify_one();
   return task_id;
 }
 
 void NodeLiteTaskRunner::RemoveTask(uint32_t task_id) noexcept {
+  std::scoped_lock lock{mutex_};
   task_queue_.remove_if(
       [task_id](const std::pair<uint32_t, std::function<void()>>& entry) {
         return entry.first == task_id;
       });
 }
 
-void NodeLiteTaskRunner::DrainTaskQueue() noexcept {
-  while (!task_queue_.empty()) {
-    std::pair<uint32_t, std::function<void()>> task =
-        std::move(task_queue_.front());
-    task_queue_.pop_front();
-    task.second();
+void NodeLiteTaskRunner::Ref() noexcept {
+  std::scoped_lock lock{mutex_};
+  ++ref_count_;
+}
+
+void NodeLiteTaskRunner::Unref() noexcept {
+  {
+    std::scoped_lock lock{mutex_};
+    --ref_count_;
+  }
+  task_posted_.notify_one();
+}
+
+void NodeLiteTaskRunner::SetIoPoller(IoPoller* io_poller) noexcept {
+  std::scoped_lock lock{mutex_};
+  io_poller_ = io_poller;
+}
+
+void NodeLiteTaskRunner::WakeLocked() noexcept {
+  if (is_polling_) {
+    io_poller_->Wake();
+  }
+}
+
+void NodeLiteTaskRunner::DrainTaskQueue(
+    const std::function<void()>& on_task_completed) noexcept {
+  for (;;) {
+    std::pair<uint32_t, std::function<void()>> task;
+    bool has_io{};
+    {
+      std::unique_lock lock{mutex_};
+      has_io = io_poller_ != nullptr && io_poller_->HasActiveHandles();
+      auto has_task = [this]() {
+        return !task_queue_.empty() || !finalizer_queue_.empty();
+      };
+      auto has_task_or_done = [this, &has_task]() {
+        return has_task() || ref_count_ == 0;
+      };
+      if (has_io && !has_task()) {
+        // The I/O handles keep the loop alive. The posted tasks wake the
+        // poller.
+        bool run_idle = on_idle_ && !is_idle_handled_;
+        is_polling_ = true;
+        lock.unlock();
+        bool has_events = io_poller_->Poll(
+            run_idle ? static_cast<int32_t>(idle_delay_.count()) : -1);
+        lock.lock();
+        is_polling_ = false;
+        if (has_events) {
+          is_idle_handled_ = false;
+        } else if (run_idle && !has_task()) {
+          is_idle_handled_ = true;
+          lock.unlock();
+          on_idle_();
+          continue;
+        }
+        lock.unlock();
+        if (has_events && on_task_completed) {
+          on_task_completed();
+        }
+        continue;
+      }
+      // Wait for the idle period first to run the idle callback when no
+      // task comes.
+      if (!has_io && on_idle_ && !is_idle_handled_ &&
+          !task_posted_.wait_for(lock, idle_delay_, has_task_or_done)) {
+        is_idle_handled_ = true;
+        lock.unlock();
+        on_idle_();
+        continue;
+      }
+      if (!has_io) {
+        task_posted_.wait(lock, has_task_or_done);
+      }
+      if (!has_task()) {
+        return;
+      }
+      is_idle_handled_ = false;
+      if (!finalizer_queue_.empty()) {
+        finalizer_batch_.swap(finalizer_queue_);
+      }
+      if (!task_queue_.empty()) {
+        task = std::move(task_queue_.front());
+        task_queue_.pop_front();
+      }
+    }
+    if (!finalizer_batch_.empty()) {
+      RunFinalizers();
+    }
+    if (task.second) {
+      task.second();
+      if (on_task_completed) {
+        on_task_completed();
+      }
+    }
+    // The I/O events are handled between the tasks, so that a stream of
+    // tasks does not starve the sockets.
+    if (has_io && io_poller_->Poll(0) && on_task_completed) {
+      on_task_completed();
+    }
+  }
+}
+
+void NodeLiteTaskRunner::SetIdleCallback(
+    std::chrono::milliseconds idle_delay,
+    std::function<void()> on_idle) noexcept {
+  std::scoped_lock lock{mutex_};
+  idle_delay_ = idle_delay;
+  on_idle_ = std::move(on_idle);
+  // The main module load counts as work done before the first idle period.
+  is_idle_handled_ = false;
+}
+
+void NodeLiteTaskRunner::RunFinalizers() noexcept {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point start_time = Clock::now();
+  Clock::time_point deadline = start_time + kFinalizerBudget;
+  Clock::time_point now = start_time;
+  uint64_t batch_size = 0;
+  // At least one finalizer runs per batch to make progress.
+  while (!finalizer_batch_.empty() && (batch_size == 0 || now < deadline)) {
+    Finalizer finalizer = finalizer_batch_.front();
+    finalizer_batch_.pop_front();
+    std::chrono::nanoseconds latency = now - finalizer.post_time;
+    finalizer_stats_.total_latency += latency;
+    finalizer_stats_.max_latency =
+        std::max(finalizer_stats_.max_latency, latency);
+    if (finalizer.run_cb != nullptr) {
+      finalizer.run_cb(finalizer.task_data);
+    }
+    if (finalizer.delete_cb != nullptr) {
+      finalizer.delete_cb(finalizer.task_data, finalizer.deleter_data);
+    }
+    ++batch_size;
+    now = Clock::now();
+  }
+  finalizer_stats_.finalizer_count += batch_size;
+  finalizer_stats_.batch_count += 1;
+  finalizer_stats_.max_batch_size =
+      std::max(finalizer_stats_.max_batch_size, batch_size);
+  finalizer_stats_.run_time += now - start_time;
+
+  // The rest runs after the next task. They stay ahead of the finalizers
+  // posted since the batch was taken.
+  if (!finalizer_batch_.empty()) {
+    std::scoped_lock lock{mutex_};
+    finalizer_queue_.insert(finalizer_queue_.begin(),
+                            finalizer_batch_.begin(),
+                            finalizer_batch_.end());
+    finalizer_batch_.clear();
+  }
+}
+
+void NodeLiteTaskRunner::PostFinalizer(const Finalizer& finalizer) noexcept {
+  bool was_empty{};
+  {
+    std::scoped_lock lock{mutex_};
+    was_empty = finalizer_queue_.empty();
+    finalizer_queue_.push_back(finalizer);
+    if (was_empty) {
+      WakeLocked();
+    }
+  }
+  // The loop is already awake if there were pending finalizers.
+  if (was_empty) {
+    task_posted_.notify_one();
   }
 }
 
@@ -848,15 +2201,11 @@ void NodeLiteTaskRunner::DrainTaskQueue() noexcept {
   NodeLiteTaskRunner* taskRunnerPtr =
       static_cast<std::shared_ptr<NodeLiteTaskRunner>*>(task_runner_data)
           ->get();
-  taskRunnerPtr->PostTask(
-      [task_run_cb, task_data, task_data_delete_cb, deleter_data]() {
-        if (task_run_cb != nullptr) {
-          task_run_cb(task_data);
-        }
-        if (task_data_delete_cb != nullptr) {
-          task_data_delete_cb(task_data, deleter_data);
-        }
-      });
+  taskRunnerPtr->PostFinalizer(Finalizer{task_run_cb,
+                                         task_data,
+                                         task_data_delete_cb,
+                                         deleter_data,
+                                         std::chrono::steady_clock::now()});
 }
 
 /*static*/ void NodeLiteTaskRunner::DeleteCallback(void* data,
@@ -943,18 +2292,47 @@ NodeApiEnvScope& NodeApiEnvScope::operator=(NodeApiEnvScope&& other) noexcept {
   throw NodeLiteException(error_code, error_message.c_str());
 }
 
+/*static*/ void NodeLiteErrorHandler::SetKeepRunningOnError(
+    bool keep_running) noexcept {
+  g_keep_running_on_error = keep_running;
+}
+
+/*static*/ bool NodeLiteErrorHandler::keep_running_on_error() noexcept {
+  return g_keep_running_on_error;
+}
+
 /*static*/ [[noreturn]] void NodeLiteErrorHandler::ExitWithJSError(
     napi_env env, napi_value error) noexcept {
+  PrintJSError(env, error);
+  exit(1);
+}
+
+/*static*/ [[noreturn]] void NodeLiteErrorHandler::ExitWithJSAssertError(
+    napi_env env, napi_value error) noexcept {
+  PrintJSAssertError(env, error);
+  exit(1);
+}
+
+/*static*/ [[noreturn]] void NodeLiteErrorHandler::ExitWithMessage(
+    const std::string& message,
+    std::function<void(std::ostream&)> get_error_details) noexcept {
+  PrintMessage(message, std::move(get_error_details));
+  exit(1);
+}
+
+/*static*/ void NodeLiteErrorHandler::PrintJSError(napi_env env,
+                                                   napi_value error) noexcept {
   // TODO: protect from stack overflow
   napi_valuetype error_value_type = NodeApi::TypeOf(env, error);
   if (error_value_type == napi_object) {
     std::string name = NodeApi::GetPropertyString(env, error, "name");
     if (name == "AssertionError") {
-      ExitWithJSAssertError(env, error);
+      PrintJSAssertError(env, error);
+      return;
     }
     std::string message = NodeApi::GetPropertyString(env, error, "message");
     std::string stack = NodeApi::GetPropertyString(env, error, "stack");
-    ExitWithMessage("JavaScript error", [&](std::ostream& os) {
+    PrintMessage("JavaScript error", [&](std::ostream& os) {
       os << "Exception: " << name << '\n'
          << "  Message: " << message << '\n'
          << "Callstack: " << '\n'
@@ -962,12 +2340,12 @@ NodeApiEnvScope& NodeApiEnvScope::operator=(NodeApiEnvScope&& other) noexcept {
     });
   } else {
     std::string message = NodeApi::CoerceToString(env, error);
-    ExitWithMessage("JavaScript error",
-                    [&](std::ostream& os) { os << "  Message: " << message; });
+    PrintMessage("JavaScript error",
+                 [&](std::ostream& os) { os << "  Message: " << message; });
   }
 }
 
-/*static*/ [[noreturn]] void NodeLiteErrorHandler::ExitWithJSAssertError(
+/*static*/ void NodeLiteErrorHandler::PrintJSAssertError(
     napi_env env, napi_value error) noexcept {
   std::string message = NodeApi::GetPropertyString(env, error, "message");
   std::string method = NodeApi::GetPropertyString(env, error, "method");
@@ -988,7 +2366,7 @@ NodeApiEnvScope& NodeApiEnvScope::operator=(NodeApiEnvScope&& other) noexcept {
                   << "   Actual: " << actual << '\n';
   }
 
-  ExitWithMessage("JavaScript assertion error", [&](std::ostream& os) {
+  PrintMessage("JavaScript assertion error", [&](std::ostream& os) {
     os << "Exception: " << "AssertionError" << '\n'
        << "   Method: " << method_name << '\n'
        << "  Message: " << message << '\n'
@@ -998,11 +2376,13 @@ NodeApiEnvScope& NodeApiEnvScope::operator=(NodeApiEnvScope&& other) noexcept {
   });
 }
 
-/*static*/ [[noreturn]] void NodeLiteErrorHandler::ExitWithMessage(
+/*static*/ void NodeLiteErrorHandler::PrintMessage(
     const std::string& message,
     std::function<void(std::ostream&)> get_error_details) noexcept {
   std::ostringstream details_stream;
-  get_error_details(details_stream);
+  if (get_error_details) {
+    get_error_details(details_stream);
+  }
   std::string details = details_stream.str();
   if (!message.empty()) {
     std::cerr << message;
@@ -1014,7 +2394,6 @@ NodeApiEnvScope& NodeApiEnvScope::operator=(NodeApiEnvScope&& other) noexcept {
     std::cerr << details;
   }
   std::cerr << std::endl;
-  exit(1);
 }
 
 //=============================================================================
@@ -1077,6 +2456,12 @@ NodeApiEnvScope& NodeApiEnvScope::operator=(NodeApiEnvScope&& other) noexcept {
   return result;
 }
 
+/*static*/ napi_value NodeApi::CreateDouble(napi_env env, double value) {
+  napi_value result{};
+  NODE_LITE_CALL(napi_create_double(env, value, &result));
+  return result;
+}
+
 /*static*/ napi_value NodeApi::CreateString(napi_env env,
                                             std::string_view value) {
   napi_value result{};
@@ -1128,6 +2513,20 @@ NodeApiEnvScope& NodeApiEnvScope::operator=(NodeApiEnvScope&& other) noexcept {
   return result;
 }
 
+/*static*/ span<uint8_t> NodeApi::GetUint8ArrayBytes(napi_env env,
+                                                    napi_value value) {
+  bool is_typedarray{};
+  NODE_LITE_CALL(napi_is_typedarray(env, value, &is_typedarray));
+  NODE_LITE_ASSERT(is_typedarray, "Expected a Uint8Array");
+  napi_typedarray_type type{};
+  size_t length{};
+  void* data{};
+  NODE_LITE_CALL(napi_get_typedarray_info(
+      env, value, &type, &length, &data, nullptr, nullptr));
+  NODE_LITE_ASSERT(type == napi_uint8_array, "Expected a Uint8Array");
+  return span<uint8_t>(static_cast<uint8_t*>(data), length);
+}
+
 /*static*/ bool NodeApi::HasProperty(napi_env env,
                                      napi_value obj,
                                      std::string_view utf8_name) {
@@ -1304,7 +2703,3 @@ NodeApiEnvScope& NodeApiEnvScope::operator=(NodeApiEnvScope&& other) noexcept {
 
 }  // namespace node_api_tests
 
-int main(int argc, char* argv[]) {
-  node_api_tests::NodeLiteRuntime::Run(
-      std::vector<std::string>(argv, argv + argc));
-}
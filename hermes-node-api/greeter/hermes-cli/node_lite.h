@@ -7,16 +7,28 @@
 #define NODE_API_TEST_NODE_LITE_H
 
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
 #include <functional>
+#include <future>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "compat.h"
+#include "node_lite_archive.h"
+#include "node_lite_esm.h"
+#include "node_lite_options.h"
+#include "node_lite_resolver.h"
+#include "node_lite_watcher.h"
 #include "string_utils.h"
 
 #define NAPI_EXPERIMENTAL
@@ -48,6 +60,8 @@ class NodeApiRefDeleter;
 class NodeApiHandleScope;
 class NodeApiEnvScope;
 class NodeLiteErrorHandler;
+class NodeLiteNet;
+class NodeLiteStdin;
 
 struct IEnvHolder {
   virtual ~IEnvHolder() {}
@@ -58,9 +72,60 @@ class NodeLiteTaskRunner {
  public:
   using QueueEntry = std::pair<uint32_t, std::function<void()>>;
 
+  // Counters of the tasks posted by the engine. They are mostly the Node-API
+  // finalizers that run after a garbage collection.
+  struct FinalizerStats {
+    uint64_t finalizer_count{};
+    uint64_t batch_count{};
+    uint64_t max_batch_size{};
+    std::chrono::nanoseconds run_time{};
+    // The time between posting a finalizer and running it.
+    std::chrono::nanoseconds total_latency{};
+    std::chrono::nanoseconds max_latency{};
+  };
+
+  // Finalizers run in batches up to this time before the next task runs.
+  static constexpr std::chrono::microseconds kFinalizerBudget{2000};
+
+  // An I/O event source integrated into the event loop. While it has active
+  // handles, DrainTaskQueue waits in Poll instead of the condition variable
+  // and polls it without waiting after each task.
+  class IoPoller {
+   public:
+    virtual ~IoPoller() = default;
+
+    // Runs the callbacks of the ready I/O events on the JS thread. Waits for
+    // the events up to the timeout or without a limit if it is negative.
+    // Returns true if any callbacks ran.
+    virtual bool Poll(int32_t timeout_ms) = 0;
+
+    // Interrupts the Poll wait. Can be called from any thread.
+    virtual void Wake() noexcept = 0;
+
+    // Called on the JS thread.
+    virtual bool HasActiveHandles() const noexcept = 0;
+  };
+
+  // Tasks can be posted from any thread. They are run on the JS thread.
   uint32_t PostTask(std::function<void()>&& task) noexcept;
   void RemoveTask(uint32_t task_id) noexcept;
-  void DrainTaskQueue() noexcept;
+
+  // Keeps DrainTaskQueue waiting for new tasks while the ref count is not
+  // zero. It is used by the work completed on other threads such as
+  // threadsafe functions and async work. Can be called from any thread.
+  void Ref() noexcept;
+  void Unref() noexcept;
+
+  // Runs tasks until the queue is empty and the ref count is zero.
+  // The optional on_task_completed is called after each task.
+  void DrainTaskQueue(
+      const std::function<void()>& on_task_completed = nullptr) noexcept;
+
+  // Sets the callback that DrainTaskQueue calls on the JS thread when it
+  // waits for new tasks for longer than the idle_delay. It is called once
+  // per idle period, and only if some tasks ran since the previous call.
+  void SetIdleCallback(std::chrono::milliseconds idle_delay,
+                       std::function<void()> on_idle) noexcept;
 
   static void PostTaskCallback(void* task_runner_data,
                                void* task_data,
@@ -70,9 +135,47 @@ class NodeLiteTaskRunner {
 
   static void DeleteCallback(void* data, void* /*deleter_data*/);
 
+  // Sets the I/O poller or removes it if it is nullptr. Must be called on the
+  // JS thread.
+  void SetIoPoller(IoPoller* io_poller) noexcept;
+
+  // Must be called on the JS thread.
+  const FinalizerStats& finalizer_stats() const noexcept {
+    return finalizer_stats_;
+  }
+
+ private:
+  struct Finalizer {
+    jsr_task_run_cb run_cb;
+    void* task_data;
+    jsr_data_delete_cb delete_cb;
+    void* deleter_data;
+    std::chrono::steady_clock::time_point post_time;
+  };
+
+  void PostFinalizer(const Finalizer& finalizer) noexcept;
+  void RunFinalizers() noexcept;
+  void WakeLocked() noexcept;
+
  private:
+  std::mutex mutex_;
+  std::condition_variable task_posted_;
   std::list<QueueEntry> task_queue_;
   uint32_t next_task_id_{1};
+  uint32_t ref_count_{0};
+  std::chrono::milliseconds idle_delay_{};
+  std::function<void()> on_idle_;
+  bool is_idle_handled_{true};
+  // The engine tasks are kept apart from the std::function tasks, so that a
+  // finalizer costs no allocation and all pending ones run in one iteration.
+  std::deque<Finalizer> finalizer_queue_;
+  // Used only by the JS thread.
+  std::deque<Finalizer> finalizer_batch_;
+  FinalizerStats finalizer_stats_;
+  // The poller is set and used on the JS thread. The other threads wake it
+  // while is_polling_ is set.
+  IoPoller* io_poller_{};
+  bool is_polling_{false};
 };
 
 class NodeLiteException : public std::runtime_error {
@@ -105,6 +208,20 @@ class NodeLiteErrorHandler {
   [[noreturn]] static void ExitWithMessage(
       const std::string& message,
       std::function<void(std::ostream&)> get_error_details = nullptr) noexcept;
+
+  // The same reports as above without exiting the process.
+  static void PrintJSError(napi_env env, napi_value error) noexcept;
+
+  static void PrintJSAssertError(napi_env env, napi_value error) noexcept;
+
+  static void PrintMessage(
+      const std::string& message,
+      std::function<void(std::ostream&)> get_error_details = nullptr) noexcept;
+
+  // The watch mode keeps the process running after the errors of the event
+  // loop callbacks. See ReportOnException.
+  static void SetKeepRunningOnError(bool keep_running) noexcept;
+  static bool keep_running_on_error() noexcept;
 };
 
 // Define NodeApiRef "smart pointer" for napi_ref as unique_ptr with a custom
@@ -160,12 +277,31 @@ class NodeLiteModule {
 
   napi_value LoadModule(napi_env env);
 
+  // Compiles the CommonJS function wrapper of a script module.
+  napi_value CompileScriptModule(napi_env env);
+
+  // Wraps the module source into the CommonJS function wrapper.
+  static std::string WrapCommonJSSource(std::string_view source);
+
+  // Runs the compiled CommonJS function wrapper with new module and exports
+  // objects and returns the module.exports.
+  napi_value RunScriptModule(napi_env env, napi_value module_func);
+
+  const std::filesystem::path& module_path() const noexcept {
+    return module_path_;
+  }
+
   NodeLiteModule(const NodeLiteModule&) = delete;
   NodeLiteModule& operator=(const NodeLiteModule&) = delete;
 
  private:
   napi_value LoadScriptModule(napi_env env);
-  napi_value LoadNativeModule(napi_env env);
+  napi_value LoadEsModule(napi_env env);
+  napi_value LoadArchiveModule(napi_env env,
+                               const NodeLiteArchive& archive,
+                               const NodeLiteArchive::Entry& entry);
+  napi_value LoadNativeModule(napi_env env,
+                              const std::filesystem::path& lib_path);
   std::string ReadModuleFileText(napi_env env);
 
  private:
@@ -182,6 +318,82 @@ class NodeLiteModule {
   NodeApiRef exports_;
 };
 
+// Cache of the native libraries loaded by the runtime.
+// Each library is loaded once and freed when the cache is deleted.
+// Libraries can be preloaded on background threads to overlap their loading
+// with the runtime startup. A later Load call waits for the preload.
+class NodeLiteNativeLibraries {
+ public:
+  NodeLiteNativeLibraries() = default;
+  ~NodeLiteNativeLibraries();
+
+  NodeLiteNativeLibraries(const NodeLiteNativeLibraries&) = delete;
+  NodeLiteNativeLibraries& operator=(const NodeLiteNativeLibraries&) = delete;
+
+  // Starts loading the library on a background thread.
+  void Preload(const std::filesystem::path& lib_path);
+
+  // Returns the library handle. Loads the library on first use.
+  void* Load(napi_env env, const std::filesystem::path& lib_path);
+
+ private:
+  struct LoadResult {
+    void* handle{};
+    std::string error;
+  };
+
+  std::shared_future<LoadResult> GetOrStartLoad(
+      const std::filesystem::path& lib_path, std::launch policy);
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_future<LoadResult>> libraries_;
+};
+
+// Metrics of a threadsafe function or of all released threadsafe functions
+// with the same async resource name. See --tsfn-stats.
+struct NodeLiteTsfnMetrics {
+  // Bucket i counts the latencies below 2^i microseconds. The last bucket
+  // counts all longer latencies.
+  static constexpr size_t kLatencyBucketCount = 24;
+
+  std::string resource_name;
+  // The number of released threadsafe functions merged into the metrics.
+  uint32_t released_count{};
+  uint64_t items_pushed{};
+  uint64_t items_dispatched{};
+  size_t queue_high_water_mark{};
+  // The time between napi_call_threadsafe_function and the JS callback call.
+  std::array<uint64_t, kLatencyBucketCount> latency_histogram{};
+  std::chrono::nanoseconds max_latency{};
+  // The time spent in the call_js callbacks.
+  std::chrono::nanoseconds js_callback_time{};
+
+  // Returns the upper bound of the latency percentile in microseconds
+  // using the histogram buckets.
+  uint64_t GetLatencyPercentileUs(double percentile) const noexcept;
+};
+
+// Returns the metrics of the live threadsafe functions followed by the
+// merged metrics of the released ones. Must be called on the JS thread.
+std::vector<NodeLiteTsfnMetrics> GetThreadSafeFunctionMetrics();
+
+// Durations of the runtime startup phases.
+struct NodeLiteStartupStats {
+  // Creation of the JS engine runtime and its napi_env.
+  std::chrono::nanoseconds runtime_create{};
+  // Registration of the built-in modules and global properties.
+  std::chrono::nanoseconds builtin_setup{};
+  // The first require() call made by JS code including its module loading.
+  std::chrono::nanoseconds first_require{};
+  std::string first_require_module;
+  // Loading of the main script module including all its require() calls.
+  std::chrono::nanoseconds main_module_load{};
+  // Garbage collections done by --idle-gc while the event loop was idle.
+  uint32_t idle_gc_count{};
+  std::chrono::nanoseconds idle_gc_time{};
+};
+
 // The Node.js-like runtime that is enough to run Node-API tests.
 class NodeLiteRuntime {
   struct PrivateTag {};
@@ -190,12 +402,14 @@ class NodeLiteRuntime {
   static std::unique_ptr<NodeLiteRuntime> Create(
       std::shared_ptr<NodeLiteTaskRunner> task_runner,
       std::string js_root,
-      std::vector<std::string> args);
+      NodeLiteOptions options);
 
   explicit NodeLiteRuntime(PrivateTag tag,
                            std::shared_ptr<NodeLiteTaskRunner> task_runner,
                            std::string js_root,
-                           std::vector<std::string> args);
+                           NodeLiteOptions options);
+
+  ~NodeLiteRuntime();
 
   static void Run(std::vector<std::string> args);
 
@@ -205,13 +419,61 @@ class NodeLiteRuntime {
   std::filesystem::path ResolveModulePath(const std::string& parent_module_path,
                                           const std::string& module_path);
 
+  // Returns the module of the resolved path or built-in module name.
+  NodeLiteModule& GetModule(const std::filesystem::path& module_path);
+
+  // Implements the JS require() function: resolves and loads the module
+  // relative to the parent module path.
+  napi_value Require(const std::filesystem::path& parent_path,
+                     const std::string& module_path);
+
+  // Implements the import() expression of ES modules: resolves the specifier
+  // with the "import" conditions and loads the module.
+  napi_value Import(const std::filesystem::path& parent_path,
+                    const std::string& specifier);
+
+  // Records that the parent module requires or imports the module, so that
+  // the parent is reloaded with it in the watch mode.
+  void AddModuleDependency(const std::filesystem::path& parent_path,
+                           const NodeLiteModule& module);
+
   void RunTestScript(const std::string& script_path);
 
+  // Runs the script and runs it again after the loaded module files change.
+  // See the --watch option.
+  void RunWatchMode(const std::string& script_path);
+
+  // Loads the script once and then measures either calls to its exported
+  // function or re-runs of the module code. See the --bench options.
+  void RunBenchmark(const std::string& script_path);
+
   void AddNativeModule(
       const std::string& module_name,
       std::function<napi_value(napi_env, napi_value)> initModule);
 
+  // Adds a built-in module implemented in JS. The source evaluates to a
+  // function that receives the native binding object and the require
+  // function and returns the module exports.
+  void AddScriptModule(
+      const std::string& module_name,
+      std::string_view source,
+      std::function<napi_value(napi_env)> create_binding = nullptr);
+
+  // Runs the source of a built-in script and calls the resulting function
+  // with the binding and the require function of the built-in modules.
+  napi_value RunBuiltinScript(napi_env env,
+                              std::string_view source,
+                              const std::string& source_url,
+                              napi_value binding);
+
   void HandleUnhandledPromiseRejections();
+
+  // Drains the process.nextTick and queueMicrotask callbacks and then the
+  // engine microtasks until both queues are empty.
+  void DrainMicrotasks();
+
+  // Adds the callback and its arguments to the tick queue.
+  void EnqueueTick(napi_value callback, span<napi_value> args);
   void OnExit();
   void OnUncaughtException(napi_value error);
 
@@ -220,29 +482,153 @@ class NodeLiteRuntime {
 
   static NodeLiteRuntime* GetRuntime(napi_env env);
 
+  napi_env GetEnv() const noexcept { return env_; }
+
+  const NodeLiteStartupStats& startup_stats() const noexcept {
+    return startup_stats_;
+  }
+
+  NodeLiteNativeLibraries& native_libraries() noexcept {
+    return native_libraries_;
+  }
+
+  NodeLiteEsmLoader& esm_loader() noexcept { return esm_loader_; }
+
+  // The mapped application archive or nullptr if the runtime does not run
+  // an archive.
+  const NodeLiteArchive* archive() const noexcept { return archive_.get(); }
+
  private:
+  // A global property that is created on first access.
+  // The value is kept after creation because a getter captured with
+  // Object.getOwnPropertyDescriptor can be called again.
+  struct LazyGlobal {
+    std::string name;
+    std::function<napi_value(napi_env)> create;
+    NodeApiRef value;
+  };
+
   void Initialize();
+  void PreloadNativeLibraries();
+  std::filesystem::path ResolveModuleFilePath(
+      const std::string& parent_module_path, const std::string& module_path);
+  // Resolves the ES module imports. It is called on the ES module loader
+  // threads and must not use the napi_env.
+  std::string ResolveImportPath(const std::filesystem::path& parent_dir,
+                                const std::string& specifier);
   void DefineGlobalFunctions();
   void DefineBuiltInModules();
+  void DefineLazyGlobal(napi_value global,
+                        std::string name,
+                        std::function<napi_value(napi_env)> create);
+  napi_value CreateProcessObject(napi_env env);
+  napi_value CreateStdinStream(napi_env env);
+  napi_value CreateConsoleObject(napi_env env);
+  void PrintStartupStats();
+  void PrintTsfnStats();
+  // Saves the --resolution-cache file once. It is called by the destructor
+  // and by an atexit handler for the exit() calls that skip the destructor.
+  void SaveResolutionCache() noexcept;
+  void DrainTickQueue();
+  bool IsWatchedModulePath(const std::filesystem::path& module_path) const;
+  void ReloadChangedModules(const std::string& script_path,
+                            const std::vector<std::filesystem::path>& changed);
 
  private:
   std::shared_ptr<NodeLiteTaskRunner> task_runner_;
   std::string js_root_;
+  NodeLiteOptions options_;
   std::vector<std::string> args_;
+  // Must be deleted after the env_holder_ to keep the addon code loaded
+  // while the runtime is being deleted.
+  NodeLiteNativeLibraries native_libraries_;
+  // The engine compiles the archive modules from the mapped memory, so the
+  // archive must be unmapped after the env_holder_ is deleted.
+  std::unique_ptr<NodeLiteArchive> archive_;
+  NodeLiteModuleResolver module_resolver_;
+  NodeLiteEsmLoader esm_loader_;
   std::unique_ptr<IEnvHolder> env_holder_;
   napi_env env_{};
+#ifdef __linux__
+  // The "net" module state is created on its first require. It holds
+  // references to JS values and must be deleted before the env_holder_.
+  std::unique_ptr<NodeLiteNet> net_;
+#endif
+  // The process.stdin state is created on its first access. It holds
+  // references to JS values and must be deleted before the env_holder_.
+  std::unique_ptr<NodeLiteStdin> stdin_;
   std::unordered_map<std::string, std::unique_ptr<NodeLiteModule>>
       registered_modules_;
+  // The watch mode state. Modules map to the modules that depend on them.
+  std::unique_ptr<NodeLiteFileWatcher> file_watcher_;
+  std::unordered_map<std::string, std::unordered_set<std::string>>
+      module_dependents_;
+  std::unordered_map<std::string, NodeLiteModule::InitModuleCallback>
+      native_module_inits_;
   std::unordered_map<std::string, std::string> node_js_modules_;
+  std::list<LazyGlobal> lazy_globals_;
+  // The process.nextTick and queueMicrotask callbacks are kept in one JS
+  // array as [callback, args or undefined] pairs instead of a persistent
+  // reference and an event loop task per callback.
+  NodeApiRef tick_queue_;
+  uint32_t tick_queue_size_{0};
+  NodeLiteStartupStats startup_stats_;
+  bool is_first_require_{true};
+  // Incremented by each watch mode reload. The timers and immediates posted
+  // by the previous runs do not call their callbacks.
+  uint32_t run_id_{0};
   std::vector<NodeApiRef> on_exit_callbacks_;
   std::vector<NodeApiRef> on_uncaughtException_callbacks_;
 };
 
+// Platform-specific functions to work with the native libraries.
 class NodeLitePlatform {
  public:
-  static void* LoadFunction(napi_env env,
-                            const std::filesystem::path& lib_path,
-                            const std::string& function_name) noexcept;
+  // Returns nullptr and sets the error message on failure.
+  static void* OpenLibrary(const std::filesystem::path& lib_path,
+                           std::string& error) noexcept;
+
+  static void* FindFunction(void* lib_handle,
+                            const char* function_name) noexcept;
+
+  static void CloseLibrary(void* lib_handle) noexcept;
+
+  // Maps the whole file into memory for reading.
+  // Returns nullptr and sets the error message on failure.
+  static const void* MapFile(const std::filesystem::path& file_path,
+                             size_t& size,
+                             std::string& error) noexcept;
+
+  static void UnmapFile(const void* data, size_t size) noexcept;
+
+  // Reads the standard input. Blocks until some data is available.
+  // Returns the number of read bytes or 0 at the end of the input.
+  // Returns -1 and sets the error message on failure.
+  static int64_t ReadStdin(char* buffer,
+                           size_t size,
+                           std::string& error) noexcept;
+
+  // Creates a new folder in the temporary folder that only the current user
+  // can access. Its name starts with the prefix.
+  // Returns an empty path and sets the error message on failure.
+  static std::filesystem::path CreatePrivateTempDirectory(
+      std::string_view prefix, std::string& error) noexcept;
+
+  // Runs the program with the arguments and waits for it to exit.
+  // The arguments are passed as an array without a shell.
+  // Returns the exit code or -1 and sets the error message on failure.
+  static int32_t RunProcess(const std::filesystem::path& program,
+                            const std::vector<std::string>& args,
+                            std::string& error) noexcept;
+};
+
+// Unmaps a file mapped by NodeLitePlatform::MapFile when it is owned by a
+// std::unique_ptr.
+struct NodeLiteMappedFileDeleter {
+  size_t size;
+  void operator()(const void* data) const noexcept {
+    NodeLitePlatform::UnmapFile(data, size);
+  }
 };
 
 using NodeApiCallback =
@@ -272,6 +658,8 @@ class NodeApi {
 
   static napi_value CreateUInt32(napi_env env, std::uint32_t value);
 
+  static napi_value CreateDouble(napi_env env, double value);
+
   static napi_value CreateString(napi_env env, std::string_view value);
 
   static napi_value CreateStringArray(napi_env env,
@@ -287,6 +675,9 @@ class NodeApi {
 
   static void* GetValueExternal(napi_env env, napi_value value);
 
+  // Returns the bytes of a Uint8Array. Throws for the other values.
+  static span<uint8_t> GetUint8ArrayBytes(napi_env env, napi_value value);
+
   static bool HasProperty(napi_env env,
                           napi_value obj,
                           std::string_view utf8_name);
@@ -360,6 +751,75 @@ class NodeApi {
                                    NodeApiCallback cb);
 };
 
+NodeApiRef MakeNodeApiRef(napi_env env, napi_value value);
+
+std::string ReadFileText(napi_env env, std::filesystem::path file_path);
+
+// Converts C++ exceptions thrown by the callback to JS errors.
+template <typename TCallback>
+void ThrowJSErrorOnException(napi_env env, TCallback&& callback) noexcept {
+  try {
+    callback();
+  } catch (const NodeLiteException& e) {
+    if (e.error_status() == napi_pending_exception) {
+      napi_value error = NodeApi::GetAndClearLastException(env);
+      NodeApi::ThrowError(env, error);
+    } else {
+      NodeApi::ThrowError(env, e.what());
+    }
+  } catch (const std::exception& e) {
+    NodeApi::ThrowError(env, e.what());
+  }
+}
+
+// Prints the error if the callback throws a C++ exception.
+// Returns false if the callback has failed.
+template <typename TCallback>
+bool PrintOnException(napi_env env, TCallback&& callback) noexcept {
+  try {
+    callback();
+    return true;
+  } catch (const NodeLiteException& e) {
+    if (e.error_status() == napi_pending_exception) {
+      napi_value error = NodeApi::GetAndClearLastException(env);
+      NodeLiteErrorHandler::PrintJSError(env, error);
+    } else {
+      NodeLiteErrorHandler::PrintMessage(e.what());
+    }
+  } catch (const std::exception& e) {
+    NodeLiteErrorHandler::PrintMessage(e.what());
+  }
+  return false;
+}
+
+// Exits the process if the callback throws a C++ exception.
+template <typename TCallback>
+void ExitOnException(napi_env env, TCallback&& callback) noexcept {
+  try {
+    callback();
+  } catch (const NodeLiteException& e) {
+    if (e.error_status() == napi_pending_exception) {
+      napi_value error = NodeApi::GetAndClearLastException(env);
+      NodeLiteErrorHandler::ExitWithJSError(env, error);
+    } else {
+      NodeLiteErrorHandler::ExitWithMessage(e.what());
+    }
+  } catch (const std::exception& e) {
+    NodeLiteErrorHandler::ExitWithMessage(e.what());
+  }
+}
+
+// Reports the C++ exception thrown by an event loop callback such as a task,
+// a tick, a timer, or an I/O event. The process exits unless the watch mode
+// keeps it running until the next file change.
+template <typename TCallback>
+void ReportOnException(napi_env env, TCallback&& callback) noexcept {
+  if (!PrintOnException(env, std::forward<TCallback>(callback)) &&
+      !NodeLiteErrorHandler::keep_running_on_error()) {
+    exit(1);
+  }
+}
+
 }  // namespace node_api_tests
 
 #endif  // !NODE_API_TEST_NODE_LITE_H
\ No newline at end of file
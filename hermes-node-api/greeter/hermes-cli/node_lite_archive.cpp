@@ -0,0 +1,508 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_archive.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+#include "node_lite.h"
+
+namespace fs = std::filesystem;
+
+namespace node_api_tests {
+
+namespace {
+
+using EntryKind = NodeLiteArchive::EntryKind;
+
+static_assert(sizeof(NodeLiteArchive::Header) == 48);
+static_assert(sizeof(NodeLiteArchive::Entry) == 32);
+
+constexpr std::string_view kArchiveExtension = ".hpak";
+
+constexpr std::string_view kPackUsage =
+    "Usage: hermes-cli pack [--main=<file>] [--hermesc=<path>] <app_dir> "
+    "<archive.hpak>\n"
+    "  --main=<file>     The main module relative to the app_dir. Default: "
+    "the package.json \"main\" or index.js.\n"
+    "  --hermesc=<path>  Compile the scripts to bytecode with hermesc.";
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) noexcept {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+bool ReadWholeFile(const fs::path& path, std::string& result) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::streamsize size = file.tellg();
+  if (size < 0) {
+    return false;
+  }
+  result.resize(static_cast<size_t>(size));
+  file.seekg(0);
+  return static_cast<bool>(file.read(result.data(), size));
+}
+
+// Writes the file next to its final path and renames it, so that the
+// concurrent readers never see a partially written file.
+bool WriteFileAtomically(const fs::path& path,
+                         const std::function<bool(std::ofstream&)>& write) {
+  fs::path temp_path = path;
+  temp_path += ".tmp" + std::to_string(std::random_device{}());
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open() || !write(file) || !file.flush()) {
+      file.close();
+      std::error_code ec;
+      fs::remove(temp_path, ec);
+      return false;
+    }
+  }
+  std::error_code ec;
+  fs::rename(temp_path, path, ec);
+  if (ec) {
+    fs::remove(temp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+[[noreturn]] void ExitWithPackError(const std::string& message) {
+  NodeLiteErrorHandler::ExitWithMessage(
+      message, [](std::ostream& os) { os << kPackUsage; });
+}
+
+// Compiles the wrapped module source with the hermesc compiler.
+// The files are written to a private temporary folder, and hermesc gets its
+// arguments as an array without a shell.
+std::string CompileBytecode(const fs::path& hermesc,
+                            const std::string& source,
+                            const std::string& name) {
+  std::string error;
+  fs::path temp_dir =
+      NodeLitePlatform::CreatePrivateTempDirectory("hermes-cli-pack-", error);
+  if (temp_dir.empty()) {
+    ExitWithPackError("Failed to create a temporary folder: " + error);
+  }
+  fs::path js_path = temp_dir / "module.js";
+  fs::path hbc_path = temp_dir / "module.hbc";
+  std::string bytecode;
+  bool succeeded = false;
+  if (WriteFileAtomically(js_path, [&source](std::ofstream& file) {
+        return static_cast<bool>(file.write(source.data(), source.size()));
+      })) {
+    succeeded =
+        NodeLitePlatform::RunProcess(hermesc,
+                                     {"-O",
+                                      "-emit-binary",
+                                      "-out",
+                                      hbc_path.string(),
+                                      js_path.string()},
+                                     error) == 0 &&
+        ReadWholeFile(hbc_path, bytecode);
+  }
+  std::error_code ec;
+  fs::remove_all(temp_dir, ec);
+  if (!succeeded) {
+    ExitWithPackError("Failed to compile " + name + " with " +
+                      hermesc.string() + (error.empty() ? "" : ": " + error));
+  }
+  return bytecode;
+}
+
+}  // namespace
+
+NodeLiteArchive::NodeLiteArchive(fs::path archive_path,
+                                 const void* data,
+                                 size_t size) noexcept
+    : archive_path_(std::move(archive_path)),
+      archive_prefix_(archive_path_.string() + fs::path::preferred_separator),
+      data_(static_cast<const char*>(data)),
+      size_(size),
+      header_(reinterpret_cast<const Header*>(data)),
+      entries_(reinterpret_cast<const Entry*>(data_ +
+                                              header_->entries_offset)) {}
+
+NodeLiteArchive::~NodeLiteArchive() {
+  NodeLitePlatform::UnmapFile(data_, size_);
+  if (!extract_dir_.empty()) {
+    // The loaded addons are not unloaded. Their files stay on Windows.
+    std::error_code ec;
+    fs::remove_all(extract_dir_, ec);
+  }
+}
+
+/*static*/ std::unique_ptr<NodeLiteArchive> NodeLiteArchive::Open(
+    const fs::path& archive_path, std::string& error) {
+  size_t size{};
+  const void* data = NodeLitePlatform::MapFile(archive_path, size, error);
+  if (data == nullptr) {
+    return nullptr;
+  }
+  const Header* header = static_cast<const Header*>(data);
+  if (size < sizeof(Header) ||
+      std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->version != kVersion) {
+    NodeLitePlatform::UnmapFile(data, size);
+    error = "Not a hermes-cli archive or an unsupported archive version";
+    return nullptr;
+  }
+  std::unique_ptr<NodeLiteArchive> archive{
+      new NodeLiteArchive(archive_path, data, size)};
+
+  // Only the index is validated here. The entry data is not touched until
+  // the module is loaded.
+  auto is_in_file = [size](uint64_t offset, uint64_t length) {
+    return offset <= size && length <= size - offset;
+  };
+  bool is_valid =
+      header->entries_offset % alignof(Entry) == 0 &&
+      is_in_file(header->entries_offset,
+                 uint64_t{header->entry_count} * sizeof(Entry)) &&
+      is_in_file(header->names_offset, header->names_size) &&
+      header->main_entry < header->entry_count;
+  for (uint32_t i = 0; is_valid && i < header->entry_count; ++i) {
+    const Entry& entry = archive->entries_[i];
+    is_valid = uint64_t{entry.name_offset} + entry.name_size <=
+                   header->names_size &&
+               is_in_file(entry.data_offset, entry.data_size) &&
+               (i == 0 || archive->GetName(archive->entries_[i - 1]) <
+                              archive->GetName(entry));
+  }
+  if (!is_valid) {
+    error = "Corrupted archive index";
+    return nullptr;
+  }
+  return archive;
+}
+
+/*static*/ bool NodeLiteArchive::IsArchivePath(const fs::path& path) {
+  return path.extension() == kArchiveExtension;
+}
+
+const NodeLiteArchive::Entry& NodeLiteArchive::main_entry() const noexcept {
+  return entries_[header_->main_entry];
+}
+
+const NodeLiteArchive::Entry* NodeLiteArchive::Find(
+    std::string_view name) const noexcept {
+  const Entry* end = entries_ + header_->entry_count;
+  const Entry* it = std::lower_bound(
+      entries_, end, name, [this](const Entry& entry, std::string_view name) {
+        return GetName(entry) < name;
+      });
+  return it != end && GetName(*it) == name ? it : nullptr;
+}
+
+std::optional<std::string_view> NodeLiteArchive::Resolve(
+    std::string_view parent_dir, std::string_view specifier) const {
+  // Same candidates as the file system resolution: the exact name, the
+  // module extensions, and the folder alias.
+  auto find_module = [this](const std::string& base) -> const Entry* {
+    for (std::string_view suffix :
+         {"", ".js", ".cjs", ".mjs", ".json", ".node"}) {
+      const Entry* entry = Find(base + std::string(suffix));
+      if (entry != nullptr && entry->kind == EntryKind::kAlias) {
+        entry = Find(GetData(*entry));
+      }
+      if (entry != nullptr) {
+        return entry;
+      }
+    }
+    return nullptr;
+  };
+
+  const Entry* entry{};
+  if (NodeLiteModuleResolver::IsBareSpecifier(specifier)) {
+    std::string dir{parent_dir};
+    for (;;) {
+      size_t slash = dir.rfind('/');
+      std::string_view dir_name =
+          slash == std::string::npos ? dir : dir.substr(slash + 1);
+      if (dir_name != "node_modules") {
+        entry = find_module((dir.empty() ? "" : dir + "/") + "node_modules/" +
+                            std::string(specifier));
+        if (entry != nullptr || dir.empty()) {
+          break;
+        }
+      }
+      dir.resize(slash == std::string::npos ? 0 : slash);
+    }
+  } else if (specifier.substr(0, 1) == ".") {
+    std::string name = (fs::path(std::string(parent_dir)) /
+                        fs::path(std::string(specifier)))
+                           .lexically_normal()
+                           .generic_string();
+    while (!name.empty() && name.back() == '/') {
+      name.pop_back();
+    }
+    if (name == ".." || name.compare(0, 3, "../") == 0) {
+      return std::nullopt;
+    }
+    entry = find_module(name == "." ? std::string() : name);
+  }
+  if (entry == nullptr) {
+    return std::nullopt;
+  }
+  return GetName(*entry);
+}
+
+std::optional<std::string> NodeLiteArchive::GetEntryName(
+    const fs::path& module_path) const {
+  const std::string& path = module_path.native();
+  if (path == archive_path_.native()) {
+    return std::string();
+  }
+  if (path.compare(0, archive_prefix_.size(), archive_prefix_) != 0) {
+    return std::nullopt;
+  }
+  return fs::path(path.substr(archive_prefix_.size())).generic_string();
+}
+
+fs::path NodeLiteArchive::GetModulePath(std::string_view name) const {
+  return archive_path_ / fs::path(std::string(name));
+}
+
+std::string_view NodeLiteArchive::GetName(const Entry& entry) const noexcept {
+  return std::string_view(data_ + header_->names_offset + entry.name_offset,
+                          entry.name_size);
+}
+
+std::string_view NodeLiteArchive::GetData(const Entry& entry) const noexcept {
+  return std::string_view(data_ + entry.data_offset,
+                          static_cast<size_t>(entry.data_size));
+}
+
+fs::path NodeLiteArchive::ExtractNativeAddon(const Entry& entry) const {
+  if (extract_dir_.empty()) {
+    std::string error;
+    extract_dir_ =
+        NodeLitePlatform::CreatePrivateTempDirectory("hermes-cli-", error);
+    if (extract_dir_.empty()) {
+      throw NodeLiteException(
+          napi_generic_failure,
+          ("Failed to create a folder for the native addons: " + error)
+              .c_str());
+    }
+  }
+  fs::path result = extract_dir_ / fs::path(std::string(GetName(entry)));
+  std::string_view data = GetData(entry);
+  std::error_code ec;
+  fs::create_directories(result.parent_path(), ec);
+  if (!WriteFileAtomically(result, [data](std::ofstream& file) {
+        return static_cast<bool>(file.write(data.data(), data.size()));
+      })) {
+    throw NodeLiteException(
+        napi_generic_failure,
+        ("Failed to extract the native addon " + result.string()).c_str());
+  }
+  return result;
+}
+
+/*static*/ void NodeLiteArchive::Pack(const std::vector<std::string>& args) {
+  std::string main_name;
+  fs::path hermesc;
+  std::vector<std::string> paths;
+  for (size_t i = 2; i < args.size(); ++i) {
+    std::string_view arg = args[i];
+    if (arg.substr(0, 7) == "--main=") {
+      main_name = arg.substr(7);
+    } else if (arg.substr(0, 10) == "--hermesc=") {
+      hermesc = arg.substr(10);
+    } else if (arg.substr(0, 2) == "--") {
+      ExitWithPackError("Unknown pack option: " + std::string(arg));
+    } else {
+      paths.emplace_back(arg);
+    }
+  }
+  if (paths.size() != 2) {
+    ExitWithPackError("Expected the app folder and the archive file");
+  }
+  std::error_code ec;
+  fs::path app_dir = fs::weakly_canonical(paths[0], ec);
+  fs::path archive_path = paths[1];
+  if (!fs::is_directory(app_dir, ec)) {
+    ExitWithPackError("Not a folder: " + paths[0]);
+  }
+  if (!IsArchivePath(archive_path)) {
+    ExitWithPackError("The archive file must have the " +
+                      std::string(kArchiveExtension) + " extension");
+  }
+
+  struct PackEntry {
+    std::string name;
+    EntryKind kind;
+    std::string data;
+  };
+  std::vector<PackEntry> entries;
+  std::unordered_set<std::string> module_names;
+  std::vector<fs::path> dirs;
+  for (const fs::directory_entry& item : fs::recursive_directory_iterator(
+           app_dir, fs::directory_options::skip_permission_denied)) {
+    if (item.is_directory(ec)) {
+      dirs.push_back(item.path());
+      continue;
+    }
+    fs::path extension = item.path().extension();
+    if (extension != ".js" && extension != ".cjs" && extension != ".mjs" &&
+        extension != ".json" && extension != ".node") {
+      continue;
+    }
+    PackEntry entry{item.path().lexically_relative(app_dir).generic_string(),
+                    EntryKind::kScript,
+                    std::string{}};
+    if (!ReadWholeFile(item.path(), entry.data)) {
+      ExitWithPackError("Failed to read " + item.path().string());
+    }
+    if (extension == ".node") {
+      entry.kind = EntryKind::kNativeAddon;
+    } else if (extension == ".json") {
+      entry.kind = EntryKind::kJson;
+    } else if (extension == ".mjs") {
+      // The ES modules are transformed by the loader, so they are packed as
+      // the source even with hermesc.
+      entry.kind = EntryKind::kEsModule;
+    } else {
+      entry.data = NodeLiteModule::WrapCommonJSSource(entry.data);
+      if (!hermesc.empty()) {
+        entry.data = CompileBytecode(hermesc, entry.data, entry.name);
+        entry.kind = EntryKind::kBytecode;
+      }
+    }
+    module_names.insert(entry.name);
+    entries.push_back(std::move(entry));
+  }
+
+  // The folders are resolved at pack time with the same rules as require():
+  // packages by their "exports" or "main", other folders by package.json
+  // "main" or the index file.
+  NodeLiteModuleResolver resolver;
+  auto get_module_name =
+      [&](const std::optional<fs::path>& path) -> std::optional<std::string> {
+    if (!path) {
+      return std::nullopt;
+    }
+    std::string name = path->lexically_relative(app_dir).generic_string();
+    return module_names.count(name) != 0 ? std::optional(name) : std::nullopt;
+  };
+  for (const fs::path& dir : dirs) {
+    std::string dir_name = dir.lexically_relative(app_dir).generic_string();
+    if (module_names.count(dir_name) != 0) {
+      continue;
+    }
+    std::optional<fs::path> target;
+    try {
+      fs::path parent = dir.parent_path();
+      if (parent.filename() == "node_modules") {
+        target = resolver.ResolvePackage(
+            parent.parent_path(),
+            dir.filename().string(),
+            NodeLiteModuleResolver::RequireConditions());
+      } else if (parent.parent_path().filename() == "node_modules" &&
+                 parent.filename().string().compare(0, 1, "@") == 0) {
+        target = resolver.ResolvePackage(
+            parent.parent_path().parent_path(),
+            parent.filename().string() + "/" + dir.filename().string(),
+            NodeLiteModuleResolver::RequireConditions());
+      } else {
+        target = resolver.ResolveFileOrDirectory(dir);
+      }
+    } catch (const NodeLiteException&) {
+      // Folders with invalid package.json cannot be required.
+    }
+    if (std::optional<std::string> target_name = get_module_name(target)) {
+      entries.push_back(
+          PackEntry{std::move(dir_name), EntryKind::kAlias, *target_name});
+    }
+  }
+
+  std::optional<std::string> main_module;
+  try {
+    main_module = get_module_name(resolver.ResolveFileOrDirectory(
+        main_name.empty() ? app_dir : app_dir / fs::path(main_name)));
+  } catch (const NodeLiteException& e) {
+    ExitWithPackError(e.what());
+  }
+  if (!main_module) {
+    ExitWithPackError("Cannot find the main module in " + app_dir.string());
+  }
+
+  std::sort(entries.begin(),
+            entries.end(),
+            [](const PackEntry& left, const PackEntry& right) {
+              return left.name < right.name;
+            });
+
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.entry_count = static_cast<uint32_t>(entries.size());
+  header.page_size = kPageSize;
+  header.entries_offset = sizeof(Header);
+  header.names_offset = header.entries_offset + entries.size() * sizeof(Entry);
+  std::vector<Entry> index(entries.size());
+  std::string names;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    index[i].name_offset = static_cast<uint32_t>(names.size());
+    index[i].name_size = static_cast<uint32_t>(entries[i].name.size());
+    index[i].kind = entries[i].kind;
+    index[i].data_size = entries[i].data.size();
+    names += entries[i].name;
+    if (entries[i].name == *main_module) {
+      header.main_entry = static_cast<uint32_t>(i);
+    }
+  }
+  header.names_size = names.size();
+  uint64_t offset = header.names_offset + names.size();
+  for (size_t i = 0; i < entries.size(); ++i) {
+    // Aliases are small and never mapped on their own.
+    if (entries[i].kind != EntryKind::kAlias) {
+      offset = AlignUp(offset, kPageSize);
+    }
+    index[i].data_offset = offset;
+    offset += entries[i].data.size();
+    // The engine expects the source text to end with a zero byte.
+    if (entries[i].kind == EntryKind::kScript) {
+      ++offset;
+    }
+  }
+
+  bool succeeded = WriteFileAtomically(archive_path, [&](std::ofstream& file) {
+    uint64_t position = 0;
+    auto write = [&](const void* data, size_t size) {
+      file.write(static_cast<const char*>(data), size);
+      position += size;
+    };
+    auto pad_to = [&](uint64_t target) {
+      static const char zeros[kPageSize]{};
+      while (position < target) {
+        write(zeros, static_cast<size_t>(
+                         std::min<uint64_t>(target - position, kPageSize)));
+      }
+    };
+    write(&header, sizeof(header));
+    write(index.data(), index.size() * sizeof(Entry));
+    write(names.data(), names.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+      pad_to(index[i].data_offset);
+      write(entries[i].data.data(), entries[i].data.size());
+    }
+    pad_to(offset);
+    return static_cast<bool>(file);
+  });
+  if (!succeeded) {
+    ExitWithPackError("Failed to write " + archive_path.string());
+  }
+  std::cout << "Packed " << module_names.size() << " modules into "
+            << archive_path.string() << " (" << offset << " bytes). Main: "
+            << *main_module << std::endl;
+}
+
+}  // namespace node_api_tests
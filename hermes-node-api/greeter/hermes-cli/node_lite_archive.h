@@ -0,0 +1,134 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Single-file application archives for the Node.js-like runtime.
+
+#ifndef NODE_API_TEST_NODE_LITE_ARCHIVE_H
+#define NODE_API_TEST_NODE_LITE_ARCHIVE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace node_api_tests {
+
+// An application archive created by "hermes-cli pack".
+// The file layout:
+//   Header
+//   Entry[entry_count] sorted by the entry name
+//   Entry names as one UTF-8 blob
+//   Entry data. All entries except for the aliases start at page
+//   boundaries. Scripts are followed by a zero byte.
+// Entry names are paths relative to the packed folder with '/' separators.
+// Folders that can be required have alias entries with the name of the
+// resolved module, so that require() is served from the index without
+// probing the file system.
+// The archive is mapped into memory. Modules are compiled directly from
+// the mapped pages, so a run reads only the pages of the loaded modules.
+class NodeLiteArchive {
+ public:
+  static constexpr char kMagic[8] = {'H', 'C', 'L', 'I', 'P', 'A', 'K', '\0'};
+  static constexpr uint32_t kVersion = 1;
+  static constexpr uint32_t kPageSize = 4096;
+
+  enum class EntryKind : uint32_t {
+    // CommonJS module source in the function wrapper.
+    kScript = 1,
+    // Hermes bytecode of the wrapped CommonJS module.
+    kBytecode = 2,
+    kNativeAddon = 3,
+    // The data is the name of the entry this folder resolves to.
+    kAlias = 4,
+    // JSON text of a .json file.
+    kJson = 5,
+    // ES module source of a .mjs file. It is transformed when it is loaded.
+    kEsModule = 6,
+  };
+
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t main_entry;
+    uint32_t page_size;
+    uint64_t entries_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+  };
+
+  struct Entry {
+    uint64_t data_offset;
+    uint64_t data_size;
+    uint32_t name_offset;
+    uint32_t name_size;
+    EntryKind kind;
+    uint32_t reserved;
+  };
+
+  // Maps the archive file. Returns nullptr and sets the error on failure.
+  static std::unique_ptr<NodeLiteArchive> Open(
+      const std::filesystem::path& archive_path, std::string& error);
+
+  ~NodeLiteArchive();
+
+  NodeLiteArchive(const NodeLiteArchive&) = delete;
+  NodeLiteArchive& operator=(const NodeLiteArchive&) = delete;
+
+  static bool IsArchivePath(const std::filesystem::path& path);
+
+  const Entry& main_entry() const noexcept;
+
+  // Finds the entry by its exact name.
+  const Entry* Find(std::string_view name) const noexcept;
+
+  // Resolves the relative or bare specifier required from the parent folder
+  // entry name. Returns std::nullopt if there is no such module.
+  std::optional<std::string_view> Resolve(std::string_view parent_dir,
+                                          std::string_view specifier) const;
+
+  // Returns the entry name of the module path under the archive path or
+  // std::nullopt if the path is not inside of the archive.
+  std::optional<std::string> GetEntryName(
+      const std::filesystem::path& module_path) const;
+
+  // Module paths of the archive entries are "<archive_path>/<entry_name>".
+  std::filesystem::path GetModulePath(std::string_view name) const;
+
+  std::string_view GetName(const Entry& entry) const noexcept;
+
+  std::string_view GetData(const Entry& entry) const noexcept;
+
+  // Native addons are loaded from files. The addon is written to a private
+  // temporary folder of this process that only the current user can access,
+  // so other users cannot replace the file before it is loaded.
+  // It must be called on the JS thread.
+  std::filesystem::path ExtractNativeAddon(const Entry& entry) const;
+
+  // Implements "hermes-cli pack [options] <app_dir> <archive_file>".
+  // It exits the process with an error message on failure.
+  static void Pack(const std::vector<std::string>& args);
+
+ private:
+  NodeLiteArchive(std::filesystem::path archive_path,
+                  const void* data,
+                  size_t size) noexcept;
+
+ private:
+  std::filesystem::path archive_path_;
+  std::string archive_prefix_;
+  const char* data_;
+  size_t size_;
+  const Header* header_;
+  const Entry* entries_;
+  // Created by the first ExtractNativeAddon call and removed with the
+  // archive.
+  mutable std::filesystem::path extract_dir_;
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_ARCHIVE_H
@@ -0,0 +1,245 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Implementation of the hermes-cli benchmark mode (--bench).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchmarkResult {
+  uint64_t min_ns{};
+  uint64_t median_ns{};
+  uint64_t p99_ns{};
+  uint64_t max_ns{};
+  double mean_ns{};
+  double ops_per_sec{};
+  std::optional<double> gc_count;
+};
+
+// Returns the number of GCs reported by HermesInternal.getInstrumentedStats()
+// or std::nullopt if the engine does not provide it.
+std::optional<double> GetGCCount(napi_env env) {
+  NodeApiHandleScope scope{env};
+  napi_value global = NodeApi::GetGlobal(env);
+  if (!NodeApi::HasProperty(env, global, "HermesInternal")) {
+    return std::nullopt;
+  }
+  napi_value hermes_internal =
+      NodeApi::GetProperty(env, global, "HermesInternal");
+  if (NodeApi::TypeOf(env, hermes_internal) != napi_object ||
+      !NodeApi::HasProperty(env, hermes_internal, "getInstrumentedStats")) {
+    return std::nullopt;
+  }
+  napi_value get_stats =
+      NodeApi::GetProperty(env, hermes_internal, "getInstrumentedStats");
+  if (NodeApi::TypeOf(env, get_stats) != napi_function) {
+    return std::nullopt;
+  }
+  napi_value stats = NodeApi::CallFunction(env, get_stats, {});
+  if (NodeApi::TypeOf(env, stats) != napi_object ||
+      !NodeApi::HasProperty(env, stats, "js_numGCs")) {
+    return std::nullopt;
+  }
+  double result{};
+  NODE_LITE_CALL(napi_get_value_double(
+      env, NodeApi::GetProperty(env, stats, "js_numGCs"), &result));
+  return result;
+}
+
+uint64_t GetPercentile(const std::vector<uint64_t>& sorted_samples,
+                       double percentile) {
+  size_t index = static_cast<size_t>(
+      std::ceil(percentile / 100.0 * sorted_samples.size()));
+  return sorted_samples[std::clamp<size_t>(
+      index, 1, sorted_samples.size()) - 1];
+}
+
+BenchmarkResult ComputeResult(std::vector<uint64_t> samples) {
+  BenchmarkResult result{};
+  std::sort(samples.begin(), samples.end());
+  uint64_t total_ns{};
+  for (uint64_t sample : samples) {
+    total_ns += sample;
+  }
+  result.min_ns = samples.front();
+  result.max_ns = samples.back();
+  result.median_ns = GetPercentile(samples, 50);
+  result.p99_ns = GetPercentile(samples, 99);
+  result.mean_ns = static_cast<double>(total_ns) / samples.size();
+  result.ops_per_sec =
+      total_ns > 0 ? samples.size() * 1e9 / static_cast<double>(total_ns) : 0;
+  return result;
+}
+
+std::string EscapeJsonString(std::string_view value) {
+  std::string result;
+  result.reserve(value.size());
+  for (char ch : value) {
+    switch (ch) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(ch) < 0x20) {
+          result += FormatString("\\u%04x", ch);
+        } else {
+          result += ch;
+        }
+    }
+  }
+  return result;
+}
+
+void PrintResult(std::ostream& os,
+                 const NodeLiteOptions& options,
+                 const BenchmarkResult& result) {
+  std::string target =
+      options.bench_function.empty() ? "<module>" : options.bench_function;
+  if (options.bench_json) {
+    os << "{\"script\":\"" << EscapeJsonString(options.script_path) << "\","
+       << "\"target\":\"" << EscapeJsonString(target) << "\","
+       << "\"warmup\":" << options.bench_warmup << ","
+       << "\"iterations\":" << options.bench_iterations << ","
+       << "\"min_ns\":" << result.min_ns << ","
+       << "\"median_ns\":" << result.median_ns << ","
+       << "\"p99_ns\":" << result.p99_ns << ","
+       << "\"max_ns\":" << result.max_ns << ","
+       << "\"mean_ns\":" << std::fixed << std::setprecision(1)
+       << result.mean_ns << ","
+       << "\"ops_per_sec\":" << result.ops_per_sec << ","
+       << "\"gc_count\":";
+    if (result.gc_count) {
+      os << std::setprecision(0) << *result.gc_count;
+    } else {
+      os << "null";
+    }
+    os << "}" << std::endl;
+    return;
+  }
+
+  os << "Benchmark: " << options.script_path << " [" << target << "]\n"
+     << "   Warmup: " << options.bench_warmup << " iterations\n"
+     << " Measured: " << options.bench_iterations << " iterations\n"
+     << "      Min: " << result.min_ns << " ns\n"
+     << "   Median: " << result.median_ns << " ns\n"
+     << "      P99: " << result.p99_ns << " ns\n"
+     << "      Max: " << result.max_ns << " ns\n"
+     << std::fixed << std::setprecision(1) << "     Mean: " << result.mean_ns
+     << " ns\n"
+     << "  Ops/sec: " << result.ops_per_sec << '\n'
+     << "      GCs: ";
+  if (result.gc_count) {
+    os << std::setprecision(0) << *result.gc_count;
+  } else {
+    os << "n/a";
+  }
+  os << std::endl;
+}
+
+}  // namespace
+
+void NodeLiteRuntime::RunBenchmark(const std::string& script_path) {
+  NodeApiEnvScope env_scope{env_};
+  NodeApiHandleScope handle_scope{env_};
+  ExitOnException(env_, [this, &script_path]() {
+    napi_env env = env_;
+    NodeLiteModule& main_module = ResolveModule(js_root_, script_path);
+
+    // The measured operation is either a call to the exported function with
+    // the script arguments, or a re-run of the compiled module function.
+    NodeApiRef target_ref;
+    std::vector<NodeApiRef> arg_refs;
+    if (!options_.bench_function.empty()) {
+      napi_value exports = main_module.LoadModule(env);
+      DrainMicrotasks();
+      NODE_LITE_ASSERT(
+          NodeApi::TypeOf(env, exports) == napi_object ||
+              NodeApi::TypeOf(env, exports) == napi_function,
+          "Module '%s' does not export an object",
+          script_path.c_str());
+      napi_value func =
+          NodeApi::GetProperty(env, exports, options_.bench_function);
+      NODE_LITE_ASSERT(NodeApi::TypeOf(env, func) == napi_function,
+                       "Module '%s' does not export function '%s'",
+                       script_path.c_str(),
+                       options_.bench_function.c_str());
+      target_ref = MakeNodeApiRef(env, func);
+      for (const std::string& arg : options_.script_args) {
+        arg_refs.push_back(MakeNodeApiRef(env, NodeApi::CreateString(env, arg)));
+      }
+    } else {
+      NODE_LITE_ASSERT(main_module.module_path().extension() == ".js" ||
+                           main_module.module_path().extension() == ".cjs",
+                       "Only script modules can be re-run. Use "
+                       "--bench-function to benchmark '%s'",
+                       script_path.c_str());
+      target_ref = MakeNodeApiRef(env, main_module.CompileScriptModule(env));
+    }
+
+    bool is_module_run = options_.bench_function.empty();
+    auto run_iteration = [&]() -> uint64_t {
+      NodeApiHandleScope scope{env};
+      napi_value target = NodeApi::GetReferenceValue(env, target_ref.get());
+      std::vector<napi_value> args;
+      args.reserve(arg_refs.size());
+      for (const NodeApiRef& arg_ref : arg_refs) {
+        args.push_back(NodeApi::GetReferenceValue(env, arg_ref.get()));
+      }
+      Clock::time_point start = Clock::now();
+      if (is_module_run) {
+        main_module.RunScriptModule(env, target);
+      } else {
+        NodeApi::CallFunction(
+            env, target, span<napi_value>(args.data(), args.size()));
+      }
+      DrainMicrotasks();
+      Clock::time_point end = Clock::now();
+      return static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+              .count());
+    };
+
+    for (uint32_t i = 0; i < options_.bench_warmup; ++i) {
+      run_iteration();
+    }
+
+    std::vector<uint64_t> samples;
+    samples.reserve(options_.bench_iterations);
+    std::optional<double> gc_count_before = GetGCCount(env);
+    for (uint32_t i = 0; i < options_.bench_iterations; ++i) {
+      samples.push_back(run_iteration());
+    }
+    std::optional<double> gc_count_after = GetGCCount(env);
+
+    BenchmarkResult result = ComputeResult(std::move(samples));
+    if (gc_count_before && gc_count_after) {
+      result.gc_count = *gc_count_after - *gc_count_before;
+    }
+    PrintResult(std::cout, options_, result);
+  });
+  ExitOnException(env_, [this]() {
+    task_runner_->DrainTaskQueue([this]() { DrainMicrotasks(); });
+    OnExit();
+    on_exit_callbacks_.clear();
+    on_uncaughtException_callbacks_.clear();
+  });
+}
+
+}  // namespace node_api_tests
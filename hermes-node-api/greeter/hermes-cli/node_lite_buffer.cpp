@@ -0,0 +1,691 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_buffer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "node_lite_text.h"
+
+namespace node_api_tests {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+constexpr char kBase64Digits[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+constexpr char kBase64UrlDigits[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// Returns the value of a hex digit or -1.
+inline int32_t GetHexDigitValue(char c) noexcept {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Returns the value of a base64 or base64url digit or -1.
+inline int32_t GetBase64DigitValue(char c) noexcept {
+  if (c >= 'A' && c <= 'Z') {
+    return c - 'A';
+  }
+  if (c >= 'a' && c <= 'z') {
+    return c - 'a' + 26;
+  }
+  if (c >= '0' && c <= '9') {
+    return c - '0' + 52;
+  }
+  if (c == '+' || c == '-') {
+    return 62;
+  }
+  if (c == '/' || c == '_') {
+    return 63;
+  }
+  return -1;
+}
+
+size_t GetSize(napi_env env, napi_value value) {
+  double size{};
+  NODE_LITE_CALL(napi_get_value_double(env, value, &size));
+  NODE_LITE_ASSERT(size >= 0, "The size must not be negative");
+  return static_cast<size_t>(size);
+}
+
+// Creates an ArrayBuffer outside of the JS heap and reports its size to the
+// GC as external memory. The size is released when the GC finalizes it.
+napi_value CreateSlab(napi_env env, size_t size) {
+  void* data = std::malloc(size);
+  NODE_LITE_ASSERT(data != nullptr, "Out of memory");
+  napi_value result{};
+  napi_status status = napi_create_external_arraybuffer(
+      env,
+      data,
+      size,
+      [](auto finalize_env, void* finalize_data, void* finalize_hint) {
+        std::free(finalize_data);
+        int64_t external_memory{};
+        napi_adjust_external_memory(
+            finalize_env,
+            -static_cast<int64_t>(reinterpret_cast<size_t>(finalize_hint)),
+            &external_memory);
+      },
+      reinterpret_cast<void*>(size),
+      &result);
+  if (status == napi_no_external_buffers_allowed) {
+    // The engine requires all ArrayBuffers to be in its own memory.
+    std::free(data);
+    NODE_LITE_CALL(napi_create_arraybuffer(env, size, &data, &result));
+    return result;
+  }
+  if (status != napi_ok) {
+    std::free(data);
+  }
+  NODE_LITE_CALL(status);
+  int64_t external_memory{};
+  NODE_LITE_CALL(napi_adjust_external_memory(
+      env, static_cast<int64_t>(size), &external_memory));
+  return result;
+}
+
+// Writes the string to the output in the encoding until the output is full.
+// Returns the number of written bytes.
+size_t WriteString(const char16_t* text,
+                   size_t size,
+                   uint8_t* output,
+                   size_t capacity,
+                   NodeLiteBuffer::Encoding encoding) {
+  using Encoding = NodeLiteBuffer::Encoding;
+  switch (encoding) {
+    case Encoding::kUtf8: {
+      size_t read{};
+      return NodeLiteUtf8::EncodeFromUtf16(
+          text, size, reinterpret_cast<char*>(output), capacity, read);
+    }
+    case Encoding::kUtf16Le: {
+      // A code unit is written only if both of its bytes fit.
+      size_t length = std::min(size, capacity / 2);
+      for (size_t i = 0; i < length; ++i) {
+        output[2 * i] = static_cast<uint8_t>(text[i]);
+        output[2 * i + 1] = static_cast<uint8_t>(text[i] >> 8);
+      }
+      return length * 2;
+    }
+    case Encoding::kLatin1:
+    case Encoding::kAscii: {
+      // Only the low byte of each code unit is kept.
+      size_t length = std::min(size, capacity);
+      for (size_t i = 0; i < length; ++i) {
+        output[i] = static_cast<uint8_t>(text[i]);
+      }
+      return length;
+    }
+    case Encoding::kBase64:
+    case Encoding::kBase64Url: {
+      // Both alphabets are accepted. The other characters such as spaces are
+      // skipped. The decoding stops at the first '='. Like in Node.js, only
+      // the low byte of each code unit is used here and in the hex strings.
+      size_t written = 0;
+      uint32_t bits = 0;
+      uint32_t bit_count = 0;
+      for (size_t i = 0; i < size && written < capacity; ++i) {
+        char c = static_cast<char>(text[i]);
+        if (c == '=') {
+          break;
+        }
+        int32_t value = GetBase64DigitValue(c);
+        if (value < 0) {
+          continue;
+        }
+        bits = (bits << 6) | static_cast<uint32_t>(value);
+        bit_count += 6;
+        if (bit_count >= 8) {
+          bit_count -= 8;
+          output[written++] = static_cast<uint8_t>(bits >> bit_count);
+        }
+      }
+      return written;
+    }
+    case Encoding::kHex: {
+      // The decoding stops at the first pair that is not a hex number.
+      size_t length = std::min(size / 2, capacity);
+      for (size_t i = 0; i < length; ++i) {
+        int32_t high = GetHexDigitValue(static_cast<char>(text[2 * i]));
+        int32_t low = GetHexDigitValue(static_cast<char>(text[2 * i + 1]));
+        if (high < 0 || low < 0) {
+          return i;
+        }
+        output[i] = static_cast<uint8_t>((high << 4) | low);
+      }
+      return length;
+    }
+  }
+  return 0;
+}
+
+napi_value CreateBase64String(napi_env env,
+                              const uint8_t* data,
+                              size_t size,
+                              bool is_url) {
+  const char* digits = is_url ? kBase64UrlDigits : kBase64Digits;
+  std::string text;
+  text.reserve((size + 2) / 3 * 4);
+  size_t i = 0;
+  for (; i + 3 <= size; i += 3) {
+    uint32_t bits = (uint32_t{data[i]} << 16) |
+                    (uint32_t{data[i + 1]} << 8) | data[i + 2];
+    text.push_back(digits[bits >> 18]);
+    text.push_back(digits[(bits >> 12) & 0x3F]);
+    text.push_back(digits[(bits >> 6) & 0x3F]);
+    text.push_back(digits[bits & 0x3F]);
+  }
+  if (i < size) {
+    uint32_t bits = uint32_t{data[i]} << 16;
+    if (i + 1 < size) {
+      bits |= uint32_t{data[i + 1]} << 8;
+    }
+    text.push_back(digits[bits >> 18]);
+    text.push_back(digits[(bits >> 12) & 0x3F]);
+    if (i + 1 < size) {
+      text.push_back(digits[(bits >> 6) & 0x3F]);
+    }
+    // The base64url strings have no padding.
+    if (!is_url) {
+      text.append(i + 1 < size ? 1 : 2, '=');
+    }
+  }
+  napi_value result{};
+  NODE_LITE_CALL(
+      napi_create_string_latin1(env, text.data(), text.size(), &result));
+  return result;
+}
+
+// Creates a string from the bytes in the encoding.
+napi_value CreateString(napi_env env,
+                        const uint8_t* data,
+                        size_t size,
+                        NodeLiteBuffer::Encoding encoding) {
+  using Encoding = NodeLiteBuffer::Encoding;
+  napi_value result{};
+  switch (encoding) {
+    case Encoding::kUtf8:
+      return NodeLiteText::CreateString(
+          env, reinterpret_cast<const char*>(data), size);
+    case Encoding::kUtf16Le: {
+      // The bytes may be unaligned. An odd last byte is ignored.
+      std::u16string text(size / 2, u'\0');
+      for (size_t i = 0; i < text.size(); ++i) {
+        text[i] = static_cast<char16_t>(data[2 * i] | (data[2 * i + 1] << 8));
+      }
+      NODE_LITE_CALL(
+          napi_create_string_utf16(env, text.data(), text.size(), &result));
+      return result;
+    }
+    case Encoding::kLatin1:
+      NODE_LITE_CALL(napi_create_string_latin1(
+          env, reinterpret_cast<const char*>(data), size, &result));
+      return result;
+    case Encoding::kAscii: {
+      // The high bit of each byte is cleared.
+      if (NodeLiteUtf8::FindNonAscii(reinterpret_cast<const char*>(data),
+                                     size) == size) {
+        return CreateString(env, data, size, Encoding::kLatin1);
+      }
+      std::string text(size, '\0');
+      for (size_t i = 0; i < size; ++i) {
+        text[i] = static_cast<char>(data[i] & 0x7F);
+      }
+      NODE_LITE_CALL(
+          napi_create_string_latin1(env, text.data(), text.size(), &result));
+      return result;
+    }
+    case Encoding::kBase64:
+    case Encoding::kBase64Url:
+      return CreateBase64String(
+          env, data, size, encoding == Encoding::kBase64Url);
+    case Encoding::kHex: {
+      std::string text(size * 2, '\0');
+      for (size_t i = 0; i < size; ++i) {
+        text[2 * i] = kHexDigits[data[i] >> 4];
+        text[2 * i + 1] = kHexDigits[data[i] & 0xF];
+      }
+      NODE_LITE_CALL(
+          napi_create_string_latin1(env, text.data(), text.size(), &result));
+      return result;
+    }
+  }
+  NODE_LITE_ASSERT(false, "Unknown encoding");
+  return result;
+}
+
+NodeLiteBuffer::Encoding GetEncoding(napi_env env, napi_value value) {
+  uint32_t encoding = NodeApi::GetValueUInt32(env, value);
+  NODE_LITE_ASSERT(encoding <= static_cast<uint32_t>(
+                                   NodeLiteBuffer::Encoding::kHex),
+                   "Unknown encoding: %u",
+                   encoding);
+  return static_cast<NodeLiteBuffer::Encoding>(encoding);
+}
+
+}  // namespace
+
+/*static*/ napi_value NodeLiteBuffer::CreateBinding(napi_env env) {
+  napi_value binding = NodeApi::CreateObject(env);
+  NodeApi::SetProperty(
+      env, binding, "slabSize", NodeApi::CreateUInt32(env, kSlabSize));
+
+  // createSlab(size) -> ArrayBuffer
+  NodeApi::SetMethod(
+      env, binding, "createSlab", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        return CreateSlab(env, GetSize(env, args[0]));
+      });
+
+  // byteLengthUtf8(string) -> number
+  NodeApi::SetMethod(
+      env, binding, "byteLengthUtf8", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        NodeLiteStringUtf16 text{env, args[0]};
+        return NodeApi::CreateDouble(
+            env, NodeLiteUtf8::GetEncodedLength(text.data(), text.size()));
+      });
+
+  // write(uint8Array, string, offset, length, encoding) -> written bytes
+  NodeApi::SetMethod(
+      env, binding, "write", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 5, "Expected 5 arguments");
+        span<uint8_t> bytes = NodeApi::GetUint8ArrayBytes(env, args[0]);
+        NodeLiteStringUtf16 text{env, args[1]};
+        size_t offset = std::min(GetSize(env, args[2]), bytes.size());
+        size_t length =
+            std::min(GetSize(env, args[3]), bytes.size() - offset);
+        size_t written = WriteString(text.data(),
+                                     text.size(),
+                                     bytes.data() + offset,
+                                     length,
+                                     GetEncoding(env, args[4]));
+        return NodeApi::CreateDouble(env, written);
+      });
+
+  // toString(uint8Array, encoding, start, end) -> string
+  NodeApi::SetMethod(
+      env, binding, "toString", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 4, "Expected 4 arguments");
+        span<uint8_t> bytes = NodeApi::GetUint8ArrayBytes(env, args[0]);
+        size_t end = std::min(GetSize(env, args[3]), bytes.size());
+        size_t start = std::min(GetSize(env, args[2]), end);
+        return CreateString(env,
+                            bytes.data() + start,
+                            end - start,
+                            GetEncoding(env, args[1]));
+      });
+
+  // compare(a, b) -> -1, 0, or 1
+  NodeApi::SetMethod(
+      env, binding, "compare", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        span<uint8_t> a = NodeApi::GetUint8ArrayBytes(env, args[0]);
+        span<uint8_t> b = NodeApi::GetUint8ArrayBytes(env, args[1]);
+        size_t size = std::min(a.size(), b.size());
+        int32_t result = size > 0 ? std::memcmp(a.data(), b.data(), size) : 0;
+        if (result == 0) {
+          result = a.size() < b.size() ? -1 : a.size() > b.size() ? 1 : 0;
+        }
+        return NodeApi::CreateDouble(env, result < 0 ? -1 : result > 0);
+      });
+
+  return binding;
+}
+
+/*static*/ const std::string_view NodeLiteBuffer::kModuleSource = R"JS(
+(function (binding, require) {
+  'use strict';
+  const kMaxLength = 0x7fffffff;
+  // The buffers up to this size are carved from the shared slab.
+  const kPoolThreshold = binding.slabSize >>> 1;
+
+  const kUtf8 = 0;
+  const kUtf16Le = 1;
+  const kLatin1 = 2;
+  const kAscii = 3;
+  const kBase64 = 4;
+  const kBase64Url = 5;
+  const kHex = 6;
+
+  const kEncodings = {
+    'utf8': kUtf8, 'utf-8': kUtf8,
+    'ucs2': kUtf16Le, 'ucs-2': kUtf16Le,
+    'utf16le': kUtf16Le, 'utf-16le': kUtf16Le,
+    'latin1': kLatin1, 'binary': kLatin1,
+    'ascii': kAscii,
+    'base64': kBase64, 'base64url': kBase64Url,
+    'hex': kHex,
+  };
+
+  function getEncoding(encoding) {
+    if (encoding === undefined || encoding === null || encoding === 'utf8') {
+      return kUtf8;
+    }
+    const result = kEncodings[String(encoding).toLowerCase()];
+    if (result === undefined) {
+      throw new TypeError(`Unknown encoding: ${encoding}`);
+    }
+    return result;
+  }
+
+  function base64ByteLength(string) {
+    let length = string.length;
+    if (length > 0 && string.charCodeAt(length - 1) === 0x3d) {
+      --length;
+      if (length > 0 && string.charCodeAt(length - 1) === 0x3d) {
+        --length;
+      }
+    }
+    return (length * 3) >>> 2;
+  }
+
+  function stringByteLength(string, encoding) {
+    switch (encoding) {
+      case kUtf8:
+        return binding.byteLengthUtf8(string);
+      case kUtf16Le:
+        return string.length * 2;
+      case kLatin1:
+      case kAscii:
+        return string.length;
+      case kBase64:
+      case kBase64Url:
+        return base64ByteLength(string);
+      default:
+        return string.length >>> 1;
+    }
+  }
+
+  function checkSize(size) {
+    if (typeof size !== 'number' || !(size >= 0 && size <= kMaxLength)) {
+      throw new RangeError(
+          `The "size" argument must be a number from 0 to ${kMaxLength}`);
+    }
+  }
+
+  // The Buffer objects are Uint8Arrays with Buffer.prototype. The
+  // TypedArray methods like subarray() create Buffers by calling Buffer
+  // with (arrayBuffer, byteOffset, length).
+  function createBuffer(arrayBuffer, byteOffset, length) {
+    const buffer = new Uint8Array(arrayBuffer, byteOffset, length);
+    Object.setPrototypeOf(buffer, Buffer.prototype);
+    return buffer;
+  }
+
+  // The slab of the small unsafe buffers. Each buffer keeps its slab alive.
+  let slab = null;
+  let slabBytes = null;
+  let slabOffset = 0;
+
+  function createSlab() {
+    slab = binding.createSlab(binding.slabSize);
+    slabBytes = new Uint8Array(slab);
+    slabOffset = 0;
+  }
+
+  // Returns a view of the slab. The size must not exceed kPoolThreshold.
+  function allocFromSlab(size) {
+    if (slab === null || binding.slabSize - slabOffset < size) {
+      createSlab();
+    }
+    const buffer = createBuffer(slab, slabOffset, size);
+    // The next buffers start at 8-byte boundaries.
+    slabOffset += (size + 7) & ~7;
+    return buffer;
+  }
+
+  function allocUnsafe(size) {
+    if (size > 0 && size <= kPoolThreshold) {
+      return allocFromSlab(size);
+    }
+    return createBuffer(new ArrayBuffer(size), 0, size);
+  }
+
+  // The deprecated Buffer(arg, encodingOrOffset, length) works like
+  // Buffer.alloc or Buffer.from.
+  function Buffer(arg, encodingOrOffset, length) {
+    if (typeof arg === 'number') {
+      return Buffer.alloc(arg);
+    }
+    return Buffer.from(arg, encodingOrOffset, length);
+  }
+
+  Object.setPrototypeOf(Buffer.prototype, Uint8Array.prototype);
+  Object.setPrototypeOf(Buffer, Uint8Array);
+
+  Buffer.poolSize = binding.slabSize;
+
+  Buffer.alloc = function (size, fill, encoding) {
+    checkSize(size);
+    const buffer = createBuffer(new ArrayBuffer(size), 0, size);
+    if (fill !== undefined && fill !== 0 && size > 0) {
+      buffer.fill(fill, 0, size, encoding);
+    }
+    return buffer;
+  };
+
+  Buffer.allocUnsafe = function (size) {
+    checkSize(size);
+    return allocUnsafe(size);
+  };
+
+  Buffer.allocUnsafeSlow = function (size) {
+    checkSize(size);
+    return createBuffer(new ArrayBuffer(size), 0, size);
+  };
+
+  function fromString(string, encoding) {
+    const encodingId = getEncoding(encoding);
+    // A UTF-8 string that surely fits into the slab is written without
+    // computing its length first.
+    if (encodingId === kUtf8 && string.length * 3 <= kPoolThreshold) {
+      if (slab === null || binding.slabSize - slabOffset < string.length * 3) {
+        createSlab();
+      }
+      const written = binding.write(
+          slabBytes, string, slabOffset, string.length * 3, kUtf8);
+      return allocFromSlab(written);
+    }
+    const length = stringByteLength(string, encodingId);
+    const buffer = allocUnsafe(length);
+    const written = binding.write(buffer, string, 0, length, encodingId);
+    return written === length ? buffer : buffer.subarray(0, written);
+  }
+
+  Buffer.from = function (value, encodingOrOffset, length) {
+    if (typeof value === 'string') {
+      return fromString(value, encodingOrOffset);
+    }
+    if (value instanceof ArrayBuffer ||
+        (typeof SharedArrayBuffer !== 'undefined' &&
+         value instanceof SharedArrayBuffer)) {
+      const byteOffset = encodingOrOffset === undefined ?
+          0 : Number(encodingOrOffset);
+      if (byteOffset > value.byteLength) {
+        throw new RangeError('The "offset" is outside of the buffer bounds');
+      }
+      const byteLength = length === undefined ?
+          value.byteLength - byteOffset : Number(length);
+      return createBuffer(value, byteOffset, byteLength);
+    }
+    if (ArrayBuffer.isView(value)) {
+      // The elements of the other typed arrays are truncated to bytes.
+      const buffer = allocUnsafe(value.length);
+      buffer.set(value);
+      return buffer;
+    }
+    if (value !== null && typeof value === 'object') {
+      if (value.type === 'Buffer' && Array.isArray(value.data)) {
+        value = value.data;
+      }
+      if (typeof value.length === 'number') {
+        const buffer = allocUnsafe(value.length);
+        for (let i = 0; i < value.length; ++i) {
+          buffer[i] = value[i];
+        }
+        return buffer;
+      }
+    }
+    throw new TypeError('The first argument must be a string, Buffer, ' +
+                        'ArrayBuffer, Array, or Array-like Object');
+  };
+
+  Buffer.isBuffer = function (value) {
+    return value instanceof Buffer;
+  };
+
+  Buffer.isEncoding = function (encoding) {
+    return typeof encoding === 'string' &&
+           kEncodings[encoding.toLowerCase()] !== undefined;
+  };
+
+  Buffer.byteLength = function (value, encoding) {
+    if (typeof value === 'string') {
+      return stringByteLength(value, getEncoding(encoding));
+    }
+    if (ArrayBuffer.isView(value) || value instanceof ArrayBuffer) {
+      return value.byteLength;
+    }
+    throw new TypeError(
+        'The "string" argument must be a string, Buffer, or ArrayBuffer');
+  };
+
+  Buffer.compare = function (a, b) {
+    return binding.compare(a, b);
+  };
+
+  Buffer.concat = function (list, totalLength) {
+    if (totalLength === undefined) {
+      totalLength = 0;
+      for (let i = 0; i < list.length; ++i) {
+        totalLength += list[i].length;
+      }
+    }
+    const result = allocUnsafe(totalLength);
+    let offset = 0;
+    for (let i = 0; i < list.length && offset < totalLength; ++i) {
+      const item = list[i];
+      const size = Math.min(item.length, totalLength - offset);
+      result.set(size === item.length ? item : item.subarray(0, size), offset);
+      offset += size;
+    }
+    if (offset < totalLength) {
+      result.fill(0, offset);
+    }
+    return result;
+  };
+
+  function clampIndex(value, length, defaultValue) {
+    if (value === undefined) {
+      return defaultValue;
+    }
+    value = Math.trunc(Number(value)) || 0;
+    if (value < 0) {
+      return Math.max(length + value, 0);
+    }
+    return Math.min(value, length);
+  }
+
+  Buffer.prototype.toString = function (encoding, start, end) {
+    if (arguments.length === 0) {
+      return binding.toString(this, kUtf8, 0, this.length);
+    }
+    start = start === undefined ? 0 : Math.max(Math.trunc(start) || 0, 0);
+    end = end === undefined ? this.length : Math.trunc(end) || 0;
+    return binding.toString(this, getEncoding(encoding), start,
+                            Math.max(end, start));
+  };
+
+  Buffer.prototype.write = function (string, offset, length, encoding) {
+    if (typeof offset === 'string') {
+      encoding = offset;
+      offset = 0;
+      length = this.length;
+    } else if (typeof length === 'string') {
+      encoding = length;
+      length = this.length - (offset >>> 0);
+    }
+    offset = offset === undefined ? 0 : offset >>> 0;
+    if (offset > this.length) {
+      throw new RangeError('The "offset" is outside of the buffer bounds');
+    }
+    length = length === undefined ? this.length - offset :
+        Math.min(length >>> 0, this.length - offset);
+    return binding.write(this, String(string), offset, length,
+                         getEncoding(encoding));
+  };
+
+  // Unlike TypedArray.prototype.slice, it returns a view without a copy.
+  Buffer.prototype.slice = function (start, end) {
+    const length = this.length;
+    start = clampIndex(start, length, 0);
+    end = clampIndex(end, length, length);
+    return this.subarray(start, Math.max(start, end));
+  };
+
+  Buffer.prototype.fill = function (value, offset, end, encoding) {
+    if (typeof offset === 'string') {
+      encoding = offset;
+      offset = 0;
+      end = this.length;
+    } else if (typeof end === 'string') {
+      encoding = end;
+      end = this.length;
+    }
+    offset = offset === undefined ? 0 : offset >>> 0;
+    end = end === undefined ? this.length : Math.min(end >>> 0, this.length);
+    if (offset >= end) {
+      return this;
+    }
+    if (typeof value === 'number' || typeof value === 'boolean') {
+      return Uint8Array.prototype.fill.call(this, value & 255, offset, end);
+    }
+    const pattern = typeof value === 'string' ?
+        fromString(value, encoding) : value;
+    if (pattern.length === 0) {
+      throw new TypeError('The "value" argument must not be empty');
+    }
+    // The pattern is copied once and then doubled within the buffer.
+    let filled = Math.min(pattern.length, end - offset);
+    this.set(pattern.subarray(0, filled), offset);
+    while (offset + filled < end) {
+      const size = Math.min(filled, end - offset - filled);
+      this.copyWithin(offset + filled, offset, offset + size);
+      filled += size;
+    }
+    return this;
+  };
+
+  Buffer.prototype.equals = function (other) {
+    return this === other || binding.compare(this, other) === 0;
+  };
+
+  Buffer.prototype.compare = function (other) {
+    return binding.compare(this, other);
+  };
+
+  Buffer.prototype.toJSON = function () {
+    return {type: 'Buffer', data: Array.from(this)};
+  };
+
+  return {Buffer, kMaxLength, constants: {MAX_LENGTH: kMaxLength}};
+})
+)JS";
+
+}  // namespace node_api_tests
@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// The "buffer" built-in module with the Buffer class.
+
+#ifndef NODE_API_TEST_NODE_LITE_BUFFER_H
+#define NODE_API_TEST_NODE_LITE_BUFFER_H
+
+#include <cstddef>
+#include <string_view>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+// The native part of the "buffer" module. The Buffer objects are Uint8Array
+// views with Buffer.prototype. The small allocUnsafe and from(string) buffers
+// share the views of 8 KB slabs allocated outside of the JS heap.
+class NodeLiteBuffer {
+ public:
+  // The size of the shared slabs. The buffers of up to half of this size are
+  // carved from them.
+  static constexpr size_t kSlabSize = 8 * 1024;
+
+  // The encodings of strings. The JS part passes them as numbers.
+  enum class Encoding : uint32_t {
+    kUtf8,
+    kUtf16Le,
+    kLatin1,
+    kAscii,
+    kBase64,
+    kBase64Url,
+    kHex,
+  };
+
+  // The JS source of the module function. It receives the binding object and
+  // the require function and returns the module exports.
+  static const std::string_view kModuleSource;
+
+  static napi_value CreateBinding(napi_env env);
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_BUFFER_H
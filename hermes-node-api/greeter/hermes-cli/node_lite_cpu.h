@@ -0,0 +1,79 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// CPU feature detection for the SIMD code paths.
+
+#ifndef NODE_API_TEST_NODE_LITE_CPU_H
+#define NODE_API_TEST_NODE_LITE_CPU_H
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NODE_LITE_X64 1
+#endif
+
+#ifdef NODE_LITE_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC compiles the intrinsics of any instruction set without options.
+#define NODE_LITE_TARGET(features)
+#else
+#include <cpuid.h>
+// Compiles the function for the instruction sets in addition to the
+// baseline. It must be called only if the CPU supports them.
+#define NODE_LITE_TARGET(features) __attribute__((target(features)))
+#endif
+#endif  // NODE_LITE_X64
+
+namespace node_api_tests {
+
+// The instruction set extensions beyond the baseline of the target
+// architecture. SSE2 is the x64 baseline.
+struct NodeLiteCpuFeatures {
+  bool has_ssse3{};
+  bool has_sse42{};
+  bool has_avx2{};
+  // The SHA-1 and SHA-256 instructions.
+  bool has_sha{};
+
+  static const NodeLiteCpuFeatures& Get() noexcept {
+    static const NodeLiteCpuFeatures features = Detect();
+    return features;
+  }
+
+ private:
+  static NodeLiteCpuFeatures Detect() noexcept {
+    NodeLiteCpuFeatures features;
+#if defined(NODE_LITE_X64) && defined(_MSC_VER)
+    int registers[4]{};
+    __cpuid(registers, 0);
+    int max_leaf = registers[0];
+    __cpuid(registers, 1);
+    features.has_ssse3 = (registers[2] & (1 << 9)) != 0;
+    features.has_sse42 = (registers[2] & (1 << 20)) != 0;
+    // The OS must save the AVX registers on context switches.
+    bool has_os_avx = (registers[2] & (1 << 27)) != 0 &&
+                      (registers[2] & (1 << 28)) != 0 &&
+                      (_xgetbv(0) & 0x6) == 0x6;
+    if (max_leaf >= 7) {
+      __cpuidex(registers, 7, 0);
+      features.has_avx2 = has_os_avx && (registers[1] & (1 << 5)) != 0;
+      features.has_sha = (registers[1] & (1 << 29)) != 0;
+    }
+#elif defined(NODE_LITE_X64)
+    __builtin_cpu_init();
+    features.has_ssse3 = __builtin_cpu_supports("ssse3");
+    features.has_sse42 = __builtin_cpu_supports("sse4.2");
+    features.has_avx2 = __builtin_cpu_supports("avx2");
+    // Older compilers do not know the "sha" feature name.
+    unsigned int eax{}, ebx{}, ecx{}, edx{};
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+      features.has_sha = (ebx & (1 << 29)) != 0;
+    }
+#endif
+    return features;
+  }
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_CPU_H
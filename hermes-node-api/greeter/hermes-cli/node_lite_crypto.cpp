@@ -0,0 +1,822 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_crypto.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include "node_lite_cpu.h"
+
+namespace fs = std::filesystem;
+
+namespace node_api_tests {
+
+namespace {
+
+constexpr size_t kBlockSize = 64;
+
+constexpr uint32_t kSha256RoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+// The reversed CRC-32C (Castagnoli) polynomial.
+constexpr uint32_t kCrc32cPolynomial = 0x82f63b78;
+
+inline uint32_t RotateLeft(uint32_t value, uint32_t bits) noexcept {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+inline uint32_t RotateRight(uint32_t value, uint32_t bits) noexcept {
+  return (value >> bits) | (value << (32 - bits));
+}
+
+inline uint32_t LoadBigEndian32(const uint8_t* data) noexcept {
+  return (uint32_t{data[0]} << 24) | (uint32_t{data[1]} << 16) |
+         (uint32_t{data[2]} << 8) | data[3];
+}
+
+inline uint32_t LoadLittleEndian32(const uint8_t* data) noexcept {
+  return (uint32_t{data[3]} << 24) | (uint32_t{data[2]} << 16) |
+         (uint32_t{data[1]} << 8) | data[0];
+}
+
+inline void StoreBigEndian32(uint8_t* output, uint32_t value) noexcept {
+  output[0] = static_cast<uint8_t>(value >> 24);
+  output[1] = static_cast<uint8_t>(value >> 16);
+  output[2] = static_cast<uint8_t>(value >> 8);
+  output[3] = static_cast<uint8_t>(value);
+}
+
+inline void StoreLittleEndian32(uint8_t* output, uint32_t value) noexcept {
+  output[0] = static_cast<uint8_t>(value);
+  output[1] = static_cast<uint8_t>(value >> 8);
+  output[2] = static_cast<uint8_t>(value >> 16);
+  output[3] = static_cast<uint8_t>(value >> 24);
+}
+
+//=============================================================================
+// SHA-256 kernels
+//=============================================================================
+
+void Sha256BlocksScalar(uint32_t* state,
+                        const uint8_t* data,
+                        size_t count) noexcept {
+  for (; count > 0; --count, data += kBlockSize) {
+    uint32_t w[64];
+    for (size_t i = 0; i < 16; ++i) {
+      w[i] = LoadBigEndian32(data + 4 * i);
+    }
+    for (size_t i = 16; i < 64; ++i) {
+      uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^
+                    (w[i - 15] >> 3);
+      uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^
+                    (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (size_t i = 0; i < 64; ++i) {
+      uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+      uint32_t choice = (e & f) ^ (~e & g);
+      uint32_t temp1 = h + s1 + choice + kSha256RoundConstants[i] + w[i];
+      uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+      uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+      h = g;
+      g = f;
+      f = e;
+      e = d + temp1;
+      d = c;
+      c = b;
+      b = a;
+      a = temp1 + s0 + majority;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+}
+
+#ifdef NODE_LITE_X64
+
+// Computes the message words of the next group of four rounds from the
+// words of the last four groups.
+NODE_LITE_TARGET("sha,sse4.1")
+inline __m128i Sha256Schedule(__m128i words4,
+                              __m128i words3,
+                              __m128i words2,
+                              __m128i words1) noexcept {
+  return _mm_sha256msg2_epu32(
+      _mm_add_epi32(_mm_sha256msg1_epu32(words4, words3),
+                    _mm_alignr_epi8(words1, words2, 4)),
+      words1);
+}
+
+// Runs four rounds of the group.
+NODE_LITE_TARGET("sha,sse4.1")
+inline void Sha256Rounds4(__m128i& abef,
+                          __m128i& cdgh,
+                          __m128i words,
+                          size_t group) noexcept {
+  __m128i input = _mm_add_epi32(
+      words,
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+          kSha256RoundConstants + 4 * group)));
+  cdgh = _mm_sha256rnds2_epu32(cdgh, abef, input);
+  abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(input, 0x0E));
+}
+
+NODE_LITE_TARGET("sha,sse4.1")
+inline __m128i LoadBigEndianWords(const uint8_t* data,
+                                  __m128i byte_swap_mask) noexcept {
+  return _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), byte_swap_mask);
+}
+
+// Based on the SHA extensions reference code by Intel. The state is kept in
+// the ABEF and CDGH order used by the sha256rnds2 instruction.
+NODE_LITE_TARGET("sha,sse4.1")
+void Sha256BlocksShaNi(uint32_t* state,
+                       const uint8_t* data,
+                       size_t count) noexcept {
+  const __m128i byte_swap_mask =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i dcba = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+  __m128i hgfe = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+  __m128i abef = _mm_alignr_epi8(dcba, hgfe, 8);
+  __m128i cdgh = _mm_blend_epi16(hgfe, dcba, 0xF0);
+
+  for (; count > 0; --count, data += kBlockSize) {
+    __m128i abef_save = abef;
+    __m128i cdgh_save = cdgh;
+    // The message words of the last four groups.
+    __m128i words0 = LoadBigEndianWords(data, byte_swap_mask);
+    __m128i words1 = LoadBigEndianWords(data + 16, byte_swap_mask);
+    __m128i words2 = LoadBigEndianWords(data + 32, byte_swap_mask);
+    __m128i words3 = LoadBigEndianWords(data + 48, byte_swap_mask);
+    Sha256Rounds4(abef, cdgh, words0, 0);
+    Sha256Rounds4(abef, cdgh, words1, 1);
+    Sha256Rounds4(abef, cdgh, words2, 2);
+    Sha256Rounds4(abef, cdgh, words3, 3);
+    for (size_t group = 4; group < 16; group += 4) {
+      words0 = Sha256Schedule(words0, words1, words2, words3);
+      Sha256Rounds4(abef, cdgh, words0, group);
+      words1 = Sha256Schedule(words1, words2, words3, words0);
+      Sha256Rounds4(abef, cdgh, words1, group + 1);
+      words2 = Sha256Schedule(words2, words3, words0, words1);
+      Sha256Rounds4(abef, cdgh, words2, group + 2);
+      words3 = Sha256Schedule(words3, words0, words1, words2);
+      Sha256Rounds4(abef, cdgh, words3, group + 3);
+    }
+    abef = _mm_add_epi32(abef, abef_save);
+    cdgh = _mm_add_epi32(cdgh, cdgh_save);
+  }
+
+  __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+  __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+                   _mm_blend_epi16(feba, dchg, 0xF0));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4),
+                   _mm_alignr_epi8(dchg, feba, 8));
+}
+
+#endif  // NODE_LITE_X64
+
+//=============================================================================
+// SHA-1 kernels
+//=============================================================================
+
+void Sha1BlocksScalar(uint32_t* state,
+                      const uint8_t* data,
+                      size_t count) noexcept {
+  for (; count > 0; --count, data += kBlockSize) {
+    uint32_t w[80];
+    for (size_t i = 0; i < 16; ++i) {
+      w[i] = LoadBigEndian32(data + 4 * i);
+    }
+    for (size_t i = 16; i < 80; ++i) {
+      w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4];
+    for (size_t i = 0; i < 80; ++i) {
+      uint32_t f{};
+      uint32_t k{};
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5a827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ed9eba1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8f1bbcdc;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xca62c1d6;
+      }
+      uint32_t temp = RotateLeft(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = RotateLeft(b, 30);
+      b = a;
+      a = temp;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+  }
+}
+
+#ifdef NODE_LITE_X64
+
+// Computes the message words of the next group of four rounds from the
+// words of the last four groups.
+NODE_LITE_TARGET("sha,sse4.1")
+inline __m128i Sha1Schedule(__m128i words4,
+                            __m128i words3,
+                            __m128i words2,
+                            __m128i words1) noexcept {
+  return _mm_sha1msg2_epu32(
+      _mm_xor_si128(_mm_sha1msg1_epu32(words4, words3), words2), words1);
+}
+
+// Runs four rounds with the round function. E is computed from the ABCD
+// value before the previous group, and the current ABCD is saved for the
+// next group.
+template <int kFunction>
+NODE_LITE_TARGET("sha,sse4.1")
+inline void Sha1Rounds4(__m128i& abcd,
+                        __m128i& e,
+                        __m128i& next_e,
+                        __m128i words) noexcept {
+  e = _mm_sha1nexte_epu32(e, words);
+  next_e = abcd;
+  abcd = _mm_sha1rnds4_epu32(abcd, e, kFunction);
+}
+
+// Based on the SHA extensions reference code by Intel. The E values of the
+// groups alternate between two registers.
+NODE_LITE_TARGET("sha,sse4.1")
+void Sha1BlocksShaNi(uint32_t* state,
+                     const uint8_t* data,
+                     size_t count) noexcept {
+  const __m128i byte_swap_mask =
+      _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+  __m128i abcd = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+  __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+  __m128i e1{};
+
+  for (; count > 0; --count, data += kBlockSize) {
+    __m128i abcd_save = abcd;
+    __m128i e0_save = e0;
+    // The message words of the last four groups.
+    __m128i words0 = LoadBigEndianWords(data, byte_swap_mask);
+    __m128i words1 = LoadBigEndianWords(data + 16, byte_swap_mask);
+    __m128i words2 = LoadBigEndianWords(data + 32, byte_swap_mask);
+    __m128i words3 = LoadBigEndianWords(data + 48, byte_swap_mask);
+
+    // Rounds 0-19
+    e0 = _mm_add_epi32(e0, words0);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    Sha1Rounds4<0>(abcd, e1, e0, words1);
+    Sha1Rounds4<0>(abcd, e0, e1, words2);
+    Sha1Rounds4<0>(abcd, e1, e0, words3);
+    words0 = Sha1Schedule(words0, words1, words2, words3);
+    Sha1Rounds4<0>(abcd, e0, e1, words0);
+    // Rounds 20-39
+    words1 = Sha1Schedule(words1, words2, words3, words0);
+    Sha1Rounds4<1>(abcd, e1, e0, words1);
+    words2 = Sha1Schedule(words2, words3, words0, words1);
+    Sha1Rounds4<1>(abcd, e0, e1, words2);
+    words3 = Sha1Schedule(words3, words0, words1, words2);
+    Sha1Rounds4<1>(abcd, e1, e0, words3);
+    words0 = Sha1Schedule(words0, words1, words2, words3);
+    Sha1Rounds4<1>(abcd, e0, e1, words0);
+    words1 = Sha1Schedule(words1, words2, words3, words0);
+    Sha1Rounds4<1>(abcd, e1, e0, words1);
+    // Rounds 40-59
+    words2 = Sha1Schedule(words2, words3, words0, words1);
+    Sha1Rounds4<2>(abcd, e0, e1, words2);
+    words3 = Sha1Schedule(words3, words0, words1, words2);
+    Sha1Rounds4<2>(abcd, e1, e0, words3);
+    words0 = Sha1Schedule(words0, words1, words2, words3);
+    Sha1Rounds4<2>(abcd, e0, e1, words0);
+    words1 = Sha1Schedule(words1, words2, words3, words0);
+    Sha1Rounds4<2>(abcd, e1, e0, words1);
+    words2 = Sha1Schedule(words2, words3, words0, words1);
+    Sha1Rounds4<2>(abcd, e0, e1, words2);
+    // Rounds 60-79
+    words3 = Sha1Schedule(words3, words0, words1, words2);
+    Sha1Rounds4<3>(abcd, e1, e0, words3);
+    words0 = Sha1Schedule(words0, words1, words2, words3);
+    Sha1Rounds4<3>(abcd, e0, e1, words0);
+    words1 = Sha1Schedule(words1, words2, words3, words0);
+    Sha1Rounds4<3>(abcd, e1, e0, words1);
+    words2 = Sha1Schedule(words2, words3, words0, words1);
+    Sha1Rounds4<3>(abcd, e0, e1, words2);
+    words3 = Sha1Schedule(words3, words0, words1, words2);
+    Sha1Rounds4<3>(abcd, e1, e0, words3);
+
+    e0 = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+                   _mm_shuffle_epi32(abcd, 0x1B));
+  state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+#endif  // NODE_LITE_X64
+
+//=============================================================================
+// MD5 kernel
+//=============================================================================
+
+void Md5Blocks(uint32_t* state, const uint8_t* data, size_t count) noexcept {
+  static constexpr uint32_t kShifts[64] = {
+      7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+      5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20,
+      4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+      6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
+  // The integer parts of abs(sin(i + 1)) * 2^32. They are exact in doubles.
+  static const std::array<uint32_t, 64> kConstants = []() {
+    std::array<uint32_t, 64> result{};
+    for (size_t i = 0; i < result.size(); ++i) {
+      result[i] = static_cast<uint32_t>(
+          std::floor(std::fabs(std::sin(static_cast<double>(i + 1))) *
+                     4294967296.0));
+    }
+    return result;
+  }();
+
+  for (; count > 0; --count, data += kBlockSize) {
+    uint32_t m[16];
+    for (size_t i = 0; i < 16; ++i) {
+      m[i] = LoadLittleEndian32(data + 4 * i);
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    auto step = [&](uint32_t f, size_t i, size_t g) {
+      f += a + kConstants[i] + m[g];
+      a = d;
+      d = c;
+      c = b;
+      b += RotateLeft(f, kShifts[i]);
+    };
+    for (size_t i = 0; i < 16; ++i) {
+      step((b & c) | (~b & d), i, i);
+    }
+    for (size_t i = 16; i < 32; ++i) {
+      step((d & b) | (~d & c), i, (5 * i + 1) % 16);
+    }
+    for (size_t i = 32; i < 48; ++i) {
+      step(b ^ c ^ d, i, (3 * i + 5) % 16);
+    }
+    for (size_t i = 48; i < 64; ++i) {
+      step(c ^ (b | ~d), i, (7 * i) % 16);
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+  }
+}
+
+//=============================================================================
+// CRC-32C kernels
+//=============================================================================
+
+// Processes 8 bytes per step with 8 lookup tables.
+uint32_t Crc32cScalar(uint32_t crc, const uint8_t* data, size_t size) noexcept {
+  static const auto kTables = []() {
+    std::array<std::array<uint32_t, 256>, 8> tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t value = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        value = (value >> 1) ^ ((value & 1) ? kCrc32cPolynomial : 0);
+      }
+      tables[0][i] = value;
+    }
+    for (size_t table = 1; table < tables.size(); ++table) {
+      for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t previous = tables[table - 1][i];
+        tables[table][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+      }
+    }
+    return tables;
+  }();
+
+  for (; size >= 8; size -= 8, data += 8) {
+    uint32_t low = LoadLittleEndian32(data) ^ crc;
+    uint32_t high = LoadLittleEndian32(data + 4);
+    crc = kTables[7][low & 0xFF] ^ kTables[6][(low >> 8) & 0xFF] ^
+          kTables[5][(low >> 16) & 0xFF] ^ kTables[4][low >> 24] ^
+          kTables[3][high & 0xFF] ^ kTables[2][(high >> 8) & 0xFF] ^
+          kTables[1][(high >> 16) & 0xFF] ^ kTables[0][high >> 24];
+  }
+  for (; size > 0; --size, ++data) {
+    crc = kTables[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#ifdef NODE_LITE_X64
+
+NODE_LITE_TARGET("sse4.2")
+uint32_t Crc32cSse42(uint32_t crc, const uint8_t* data, size_t size) noexcept {
+  uint64_t crc64 = crc;
+  for (; size >= 8; size -= 8, data += 8) {
+    uint64_t word{};
+    std::memcpy(&word, data, 8);
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  crc = static_cast<uint32_t>(crc64);
+  for (; size > 0; --size, ++data) {
+    crc = _mm_crc32_u8(crc, *data);
+  }
+  return crc;
+}
+
+#endif  // NODE_LITE_X64
+
+//=============================================================================
+// Hash classes
+//=============================================================================
+
+// The Merkle-Damgard hashes of 64-byte blocks. The last block is padded with
+// the message length in bits.
+class BlockHash : public NodeLiteHash {
+ public:
+  void Update(const uint8_t* data, size_t size) noexcept override {
+    total_size_ += size;
+    if (buffered_size_ > 0) {
+      size_t copied = std::min(kBlockSize - buffered_size_, size);
+      std::memcpy(buffer_ + buffered_size_, data, copied);
+      buffered_size_ += copied;
+      data += copied;
+      size -= copied;
+      if (buffered_size_ < kBlockSize) {
+        return;
+      }
+      ProcessBlocks(buffer_, 1);
+      buffered_size_ = 0;
+    }
+    // The whole blocks are hashed in place.
+    size_t block_count = size / kBlockSize;
+    if (block_count > 0) {
+      ProcessBlocks(data, block_count);
+      data += block_count * kBlockSize;
+      size -= block_count * kBlockSize;
+    }
+    std::memcpy(buffer_, data, size);
+    buffered_size_ = size;
+  }
+
+ protected:
+  virtual void ProcessBlocks(const uint8_t* data, size_t count) noexcept = 0;
+
+  void Pad(bool is_big_endian) noexcept {
+    uint64_t bit_length = total_size_ * 8;
+    buffer_[buffered_size_++] = 0x80;
+    if (buffered_size_ > kBlockSize - 8) {
+      std::memset(buffer_ + buffered_size_, 0, kBlockSize - buffered_size_);
+      ProcessBlocks(buffer_, 1);
+      buffered_size_ = 0;
+    }
+    std::memset(buffer_ + buffered_size_, 0, kBlockSize - 8 - buffered_size_);
+    for (size_t i = 0; i < 8; ++i) {
+      size_t shift = is_big_endian ? 56 - 8 * i : 8 * i;
+      buffer_[kBlockSize - 8 + i] = static_cast<uint8_t>(bit_length >> shift);
+    }
+    ProcessBlocks(buffer_, 1);
+  }
+
+ private:
+  uint8_t buffer_[kBlockSize];
+  size_t buffered_size_{};
+  uint64_t total_size_{};
+};
+
+class Sha256Hash : public BlockHash {
+ public:
+  size_t digest_size() const noexcept override { return 32; }
+
+  void Final(uint8_t* digest) noexcept override {
+    Pad(/*is_big_endian:*/ true);
+    for (size_t i = 0; i < 8; ++i) {
+      StoreBigEndian32(digest + 4 * i, state_[i]);
+    }
+  }
+
+ protected:
+  void ProcessBlocks(const uint8_t* data, size_t count) noexcept override {
+#ifdef NODE_LITE_X64
+    static const auto process_blocks = NodeLiteCpuFeatures::Get().has_sha
+                                           ? Sha256BlocksShaNi
+                                           : Sha256BlocksScalar;
+    process_blocks(state_, data, count);
+#else
+    Sha256BlocksScalar(state_, data, count);
+#endif
+  }
+
+ private:
+  uint32_t state_[8]{0x6a09e667,
+                     0xbb67ae85,
+                     0x3c6ef372,
+                     0xa54ff53a,
+                     0x510e527f,
+                     0x9b05688c,
+                     0x1f83d9ab,
+                     0x5be0cd19};
+};
+
+class Sha1Hash : public BlockHash {
+ public:
+  size_t digest_size() const noexcept override { return 20; }
+
+  void Final(uint8_t* digest) noexcept override {
+    Pad(/*is_big_endian:*/ true);
+    for (size_t i = 0; i < 5; ++i) {
+      StoreBigEndian32(digest + 4 * i, state_[i]);
+    }
+  }
+
+ protected:
+  void ProcessBlocks(const uint8_t* data, size_t count) noexcept override {
+#ifdef NODE_LITE_X64
+    static const auto process_blocks = NodeLiteCpuFeatures::Get().has_sha
+                                           ? Sha1BlocksShaNi
+                                           : Sha1BlocksScalar;
+    process_blocks(state_, data, count);
+#else
+    Sha1BlocksScalar(state_, data, count);
+#endif
+  }
+
+ private:
+  uint32_t state_[5]{
+      0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+};
+
+class Md5Hash : public BlockHash {
+ public:
+  size_t digest_size() const noexcept override { return 16; }
+
+  void Final(uint8_t* digest) noexcept override {
+    Pad(/*is_big_endian:*/ false);
+    for (size_t i = 0; i < 4; ++i) {
+      StoreLittleEndian32(digest + 4 * i, state_[i]);
+    }
+  }
+
+ protected:
+  void ProcessBlocks(const uint8_t* data, size_t count) noexcept override {
+    Md5Blocks(state_, data, count);
+  }
+
+ private:
+  uint32_t state_[4]{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+};
+
+class Crc32cHash : public NodeLiteHash {
+ public:
+  size_t digest_size() const noexcept override { return 4; }
+
+  void Update(const uint8_t* data, size_t size) noexcept override {
+#ifdef NODE_LITE_X64
+    static const auto crc32c =
+        NodeLiteCpuFeatures::Get().has_sse42 ? Crc32cSse42 : Crc32cScalar;
+    crc_ = crc32c(crc_, data, size);
+#else
+    crc_ = Crc32cScalar(crc_, data, size);
+#endif
+  }
+
+  void Final(uint8_t* digest) noexcept override {
+    StoreBigEndian32(digest, ~crc_);
+  }
+
+ private:
+  uint32_t crc_{0xffffffff};
+};
+
+NodeLiteHash& GetHash(napi_env env, napi_value value) {
+  return *static_cast<NodeLiteHash*>(NodeApi::GetValueExternal(env, value));
+}
+
+napi_value CreateDigest(napi_env env, NodeLiteHash& hash) {
+  void* data{};
+  napi_value array_buffer{};
+  NODE_LITE_CALL(napi_create_arraybuffer(
+      env, hash.digest_size(), &data, &array_buffer));
+  hash.Final(static_cast<uint8_t*>(data));
+  napi_value result{};
+  NODE_LITE_CALL(napi_create_typedarray(
+      env, napi_uint8_array, hash.digest_size(), array_buffer, 0, &result));
+  return result;
+}
+
+}  // namespace
+
+/*static*/ std::unique_ptr<NodeLiteHash> NodeLiteHash::Create(
+    std::string_view algorithm) {
+  if (algorithm == "sha256") {
+    return std::make_unique<Sha256Hash>();
+  }
+  if (algorithm == "sha1") {
+    return std::make_unique<Sha1Hash>();
+  }
+  if (algorithm == "md5") {
+    return std::make_unique<Md5Hash>();
+  }
+  if (algorithm == "crc32c") {
+    return std::make_unique<Crc32cHash>();
+  }
+  return nullptr;
+}
+
+/*static*/ napi_value NodeLiteCrypto::CreateBinding(napi_env env) {
+  napi_value binding = NodeApi::CreateObject(env);
+
+  // createHash(algorithm) -> external hash or undefined
+  NodeApi::SetMethod(
+      env, binding, "createHash", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        std::unique_ptr<NodeLiteHash> hash =
+            NodeLiteHash::Create(NodeApi::ToStdString(env, args[0]));
+        if (hash == nullptr) {
+          return NodeApi::GetUndefined(env);
+        }
+        napi_value result{};
+        NODE_LITE_CALL(napi_create_external(
+            env,
+            hash.get(),
+            [](auto /*env*/, void* finalize_data, void* /*finalize_hint*/) {
+              delete static_cast<NodeLiteHash*>(finalize_data);
+            },
+            nullptr,
+            &result));
+        hash.release();
+        return result;
+      });
+
+  // update(hash, uint8Array)
+  NodeApi::SetMethod(
+      env, binding, "update", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        span<uint8_t> bytes = NodeApi::GetUint8ArrayBytes(env, args[1]);
+        GetHash(env, args[0]).Update(bytes.data(), bytes.size());
+        return nullptr;
+      });
+
+  // digest(hash) -> Uint8Array
+  NodeApi::SetMethod(
+      env, binding, "digest", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        return CreateDigest(env, GetHash(env, args[0]));
+      });
+
+  // hashFile(algorithm, path) -> Uint8Array or undefined
+  // The file is mapped and hashed in one call without copying it to JS.
+  NodeApi::SetMethod(
+      env, binding, "hashFile", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        std::unique_ptr<NodeLiteHash> hash =
+            NodeLiteHash::Create(NodeApi::ToStdString(env, args[0]));
+        if (hash == nullptr) {
+          return NodeApi::GetUndefined(env);
+        }
+        fs::path file_path{NodeApi::ToStdString(env, args[1])};
+        std::error_code error_code;
+        uintmax_t file_size = fs::file_size(file_path, error_code);
+        NODE_LITE_ASSERT(!error_code,
+                         "Failed to read file %s: %s",
+                         file_path.string().c_str(),
+                         error_code.message().c_str());
+        if (file_size > 0) {
+          size_t size{};
+          std::string error;
+          const void* data = NodeLitePlatform::MapFile(file_path, size, error);
+          NODE_LITE_ASSERT(data != nullptr,
+                           "Failed to map file %s: %s",
+                           file_path.string().c_str(),
+                           error.c_str());
+          std::unique_ptr<const void, NodeLiteMappedFileDeleter> mapping{
+              data, NodeLiteMappedFileDeleter{size}};
+          hash->Update(static_cast<const uint8_t*>(data), size);
+        }
+        return CreateDigest(env, *hash);
+      });
+
+  return binding;
+}
+
+/*static*/ const std::string_view NodeLiteCrypto::kModuleSource = R"JS(
+(function (binding, require) {
+  'use strict';
+  const {Buffer} = require('buffer');
+  const kHashes = ['crc32c', 'md5', 'sha1', 'sha256'];
+
+  function createNativeHash(create, algorithm) {
+    const name = String(algorithm).toLowerCase().replace('-', '');
+    const result = create(name);
+    if (result === undefined) {
+      throw new Error(`Digest method not supported: ${algorithm}`);
+    }
+    return result;
+  }
+
+  function toBytes(data, encoding) {
+    if (typeof data === 'string') {
+      return Buffer.from(data, encoding);
+    }
+    if (data instanceof Uint8Array) {
+      return data;
+    }
+    if (ArrayBuffer.isView(data)) {
+      return new Uint8Array(data.buffer, data.byteOffset, data.byteLength);
+    }
+    if (data instanceof ArrayBuffer) {
+      return new Uint8Array(data);
+    }
+    throw new TypeError('The "data" argument must be a string, Buffer, ' +
+                        'TypedArray, DataView, or ArrayBuffer');
+  }
+
+  function toOutput(digest, encoding) {
+    const buffer = Buffer.from(digest.buffer, digest.byteOffset,
+                               digest.byteLength);
+    return encoding === undefined || encoding === 'buffer' ?
+        buffer : buffer.toString(encoding);
+  }
+
+  // An incremental hash. The data is hashed natively by each update().
+  function Hash(algorithm) {
+    this._handle = createNativeHash(binding.createHash, algorithm);
+    this._isFinalized = false;
+  }
+
+  Hash.prototype.update = function (data, encoding) {
+    if (this._isFinalized) {
+      throw new Error('Digest already called');
+    }
+    binding.update(this._handle, toBytes(data, encoding));
+    return this;
+  };
+
+  Hash.prototype.digest = function (encoding) {
+    if (this._isFinalized) {
+      throw new Error('Digest already called');
+    }
+    this._isFinalized = true;
+    return toOutput(binding.digest(this._handle), encoding);
+  };
+
+  function createHash(algorithm) {
+    return new Hash(algorithm);
+  }
+
+  function getHashes() {
+    return kHashes.slice();
+  }
+
+  // Hashes the data in one call.
+  function hash(algorithm, data, outputEncoding = 'hex') {
+    return createHash(algorithm).update(data).digest(outputEncoding);
+  }
+
+  // Hashes the file contents without reading them into JS.
+  function hashFileSync(algorithm, path, outputEncoding = 'hex') {
+    const digest = createNativeHash(
+        (name) => binding.hashFile(name, String(path)), algorithm);
+    return toOutput(digest, outputEncoding);
+  }
+
+  return {Hash, createHash, getHashes, hash, hashFileSync};
+})
+)JS";
+
+}  // namespace node_api_tests
@@ -0,0 +1,51 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Hash functions for the "crypto" built-in module.
+
+#ifndef NODE_API_TEST_NODE_LITE_CRYPTO_H
+#define NODE_API_TEST_NODE_LITE_CRYPTO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+// An incremental hash: SHA-256, SHA-1, MD5, or CRC-32C. On x64 SHA-256 and
+// SHA-1 use the SHA instructions and CRC-32C uses the SSE4.2 CRC32
+// instruction if the CPU supports them.
+class NodeLiteHash {
+ public:
+  static constexpr size_t kMaxDigestSize = 32;
+
+  virtual ~NodeLiteHash() = default;
+
+  // Creates the hash for the algorithm name: "sha256", "sha1", "md5", or
+  // "crc32c". Returns nullptr for the other names.
+  static std::unique_ptr<NodeLiteHash> Create(std::string_view algorithm);
+
+  virtual size_t digest_size() const noexcept = 0;
+
+  virtual void Update(const uint8_t* data, size_t size) noexcept = 0;
+
+  // Writes digest_size() bytes. The hash cannot be updated after it.
+  // The CRC-32C value is written in big-endian byte order.
+  virtual void Final(uint8_t* digest) noexcept = 0;
+};
+
+// The native part of the "crypto" module.
+class NodeLiteCrypto {
+ public:
+  // The JS source of the module function. It receives the binding object and
+  // the require function and returns the module exports.
+  static const std::string_view kModuleSource;
+
+  static napi_value CreateBinding(napi_env env);
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_CRYPTO_H
@@ -0,0 +1,1003 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_esm.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include "node_lite_archive.h"
+
+namespace fs = std::filesystem;
+
+namespace node_api_tests {
+
+namespace {
+
+// The number of threads that load one graph including the calling thread.
+constexpr size_t kMaxLoaderThreads = 8;
+
+constexpr std::string_view kFunctionPrefix =
+    "(function(__ns, __imports, __import_meta, __import_dynamic) {"
+    "\"use strict\";";
+constexpr std::string_view kFunctionSuffix = "\n})\n";
+
+// The keywords after which '/' starts a regular expression.
+constexpr std::string_view kRegExpKeywords[] = {
+    "return", "typeof", "instanceof", "in",   "of",    "new",   "delete",
+    "void",   "throw",  "case",       "do",   "else",  "yield", "await"};
+
+bool IsIdentifierStart(char c) noexcept {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+         c == '$' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+// Numbers are scanned as identifiers: it is enough to skip them.
+bool IsIdentifierPart(char c) noexcept {
+  return IsIdentifierStart(c) || (c >= '0' && c <= '9');
+}
+
+// The characters that end an expression: identifiers, literals, and closing
+// brackets. 'a' stands for identifiers and '"' for literals.
+bool IsExpressionEnd(char c) noexcept {
+  return c == 'a' || c == '"' || c == ')' || c == ']';
+}
+
+// Reads the whole file with one read call.
+bool ReadWholeFile(const fs::path& path, std::string& result) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::streamsize size = file.tellg();
+  if (size < 0) {
+    return false;
+  }
+  result.resize(static_cast<size_t>(size));
+  file.seekg(0);
+  return static_cast<bool>(file.read(result.data(), size));
+}
+
+std::string QuoteString(std::string_view str) {
+  std::string result;
+  result.reserve(str.size() + 2);
+  result += '"';
+  for (char c : str) {
+    switch (c) {
+      case '"':
+      case '\\':
+        result += '\\';
+        result += c;
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      case '\r':
+        result += "\\r";
+        break;
+      default:
+        result += c;
+    }
+  }
+  result += '"';
+  return result;
+}
+
+// The static imports and re-exports of one module specifier.
+struct ModuleRequest {
+  std::string specifier;
+  // Pairs of the imported name and the local name.
+  // The "*" imported name is the namespace import.
+  std::vector<std::pair<std::string, std::string>> imports;
+  // Pairs of the imported name and the exported name.
+  // The "*" imported name is the "export * as name" re-export.
+  std::vector<std::pair<std::string, std::string>> reexports;
+  // The "export * from" re-export.
+  bool reexport_all{false};
+};
+
+// Finds the static imports and exports of an ES module and rewrites the
+// module into the function described in NodeLiteEsmModule.
+// It is not a complete JS parser: it skips comments, strings, template
+// literals, and regular expressions to find the top-level import and export
+// statements and the import.meta and import() expressions.
+class EsmModuleParser {
+ public:
+  explicit EsmModuleParser(std::string_view source) noexcept
+      : source_(source) {}
+
+  bool Parse(std::string& error);
+
+  const std::vector<ModuleRequest>& requests() const noexcept {
+    return requests_;
+  }
+
+  // The is_esm has a flag for each request that tells if the imported module
+  // is an ES module or a CommonJS, native, or built-in module.
+  std::string GenerateFunction(const std::vector<bool>& is_esm) const;
+
+ private:
+  struct Token {
+    size_t begin{};
+    std::string_view word;
+    bool is_statement_start{};
+  };
+
+  struct Edit {
+    size_t begin{};
+    size_t end{};
+    std::string replacement;
+  };
+
+  Token ScanToken();
+  void ScanTemplateChars();
+  void SkipTrivia();
+  void SkipString();
+  void SkipRegExp();
+  void SkipExpression();
+  bool IsRegExpAllowed() const noexcept;
+  char Peek() const noexcept;
+  bool MatchChar(char c);
+  bool MatchWord(std::string_view word);
+  bool ReadIdentifier(std::string& name);
+  bool ReadString(std::string& value);
+  bool ReadExportName(std::string& name);
+  bool ParseImport(size_t begin);
+  bool ParseExport(size_t begin);
+  bool ParseNamedList(std::vector<std::pair<std::string, std::string>>& list);
+  bool ParseBindingNames(std::vector<std::string>& names);
+  bool ParseBindingTarget(std::vector<std::string>& names);
+  void SkipImportAttributes();
+  void EndStatement(size_t begin);
+  void ResumeAt(size_t pos, char last_char) noexcept;
+  void Replace(size_t begin, size_t end, std::string replacement);
+  ModuleRequest& GetRequest(const std::string& specifier);
+  bool Fail(std::string_view message);
+
+ private:
+  std::string_view source_;
+  size_t pos_{0};
+  // The nesting level of (), [], and {} including the "${" in templates.
+  size_t depth_{0};
+  // The depth of each open "${" in template literals.
+  std::vector<size_t> template_depths_;
+  // The last significant character and the last identifier.
+  char last_char_{0};
+  std::string_view last_word_;
+  bool newline_before_{false};
+  std::vector<ModuleRequest> requests_;
+  // Pairs of the exported name and the local name.
+  std::vector<std::pair<std::string, std::string>> local_exports_;
+  bool has_default_expression_{false};
+  std::vector<Edit> edits_;
+  std::string error_;
+};
+
+bool EsmModuleParser::Parse(std::string& error) {
+  if (source_.substr(0, 2) == "#!") {
+    Replace(0, std::min(source_.find('\n'), source_.size()), "");
+    pos_ = edits_.back().end;
+  }
+  while (pos_ < source_.size()) {
+    char prev_char = last_char_;
+    Token token = ScanToken();
+    if (token.word.empty() || prev_char == '.') {
+      continue;
+    }
+    if (token.word == "import") {
+      size_t word_end = pos_;
+      SkipTrivia();
+      char next = Peek();
+      if (next == '.') {
+        ++pos_;
+        if (MatchWord("meta")) {
+          Replace(token.begin, pos_, "__import_meta");
+        } else {
+          pos_ = word_end;
+        }
+      } else if (next == '(') {
+        Replace(token.begin, word_end, "__import_dynamic");
+        pos_ = word_end;
+      } else if (token.is_statement_start) {
+        if (!ParseImport(token.begin)) {
+          break;
+        }
+      } else {
+        pos_ = word_end;
+      }
+    } else if (token.word == "export" && token.is_statement_start) {
+      if (!ParseExport(token.begin)) {
+        break;
+      }
+    }
+  }
+  error = error_;
+  return error_.empty();
+}
+
+std::string EsmModuleParser::GenerateFunction(
+    const std::vector<bool>& is_esm) const {
+  std::string result{kFunctionPrefix};
+  auto define_getter = [&result](std::string_view name,
+                                 std::string_view value) {
+    result += "Object.defineProperty(__ns, ";
+    result += QuoteString(name);
+    result += ", {enumerable: true, get: () => ";
+    result += value;
+    result += "});";
+  };
+  // The namespace of a CommonJS module has its exports as the default.
+  auto get_namespace = [](const std::string& module, bool is_esm) {
+    return is_esm ? module
+                  : "Object.assign(Object.create(null), " + module +
+                        ", {default: " + module + "})";
+  };
+  auto get_binding = [](const std::string& module,
+                        bool is_esm,
+                        const std::string& name) {
+    return !is_esm && name == "default" ? module
+                                        : module + "[" + QuoteString(name) +
+                                              "]";
+  };
+
+  // The bindings are defined on the first line to keep the line numbers.
+  if (has_default_expression_) {
+    result += "let __default;";
+  }
+  for (const auto& [exported, local] : local_exports_) {
+    define_getter(exported, local);
+  }
+  for (size_t i = 0; i < requests_.size(); ++i) {
+    const ModuleRequest& request = requests_[i];
+    std::string module = "__imports[" + std::to_string(i) + "]";
+    for (const auto& [imported, local] : request.imports) {
+      result += "const ";
+      result += local;
+      result += " = ";
+      result += imported == "*" ? get_namespace(module, is_esm[i])
+                                : get_binding(module, is_esm[i], imported);
+      result += ';';
+    }
+    for (const auto& [imported, exported] : request.reexports) {
+      define_getter(exported,
+                    imported == "*" ? get_namespace(module, is_esm[i])
+                                    : get_binding(module, is_esm[i], imported));
+    }
+  }
+  // The local and named exports take precedence over "export *".
+  for (size_t i = 0; i < requests_.size(); ++i) {
+    if (!requests_[i].reexport_all) {
+      continue;
+    }
+    std::string module = "__imports[" + std::to_string(i) + "]";
+    result += "for (const __k of Object.keys(" + module +
+              ")) if (__k !== \"default\" && "
+              "!Object.prototype.hasOwnProperty.call(__ns, __k)) "
+              "Object.defineProperty(__ns, __k, "
+              "{enumerable: true, get: () => " +
+              module + "[__k]});";
+  }
+
+  size_t source_end = source_.size();
+  if (size_t source_map_index = source_.rfind("//# sourceMappingURL");
+      source_map_index != std::string_view::npos) {
+    source_end = source_map_index;
+  }
+  size_t copied = 0;
+  auto copy_source = [&](size_t end) {
+    end = std::max(end, copied);
+    result.append(source_.substr(copied, end - copied));
+    copied = end;
+  };
+  for (const Edit& edit : edits_) {
+    copy_source(edit.begin);
+    // The replaced text is padded with spaces to keep the columns and with
+    // its line breaks to keep the line numbers.
+    result += edit.replacement;
+    size_t skip = edit.replacement.size();
+    for (char c : source_.substr(edit.begin, edit.end - edit.begin)) {
+      if (c == '\n') {
+        result += '\n';
+      } else if (skip > 0) {
+        --skip;
+      } else {
+        result += ' ';
+      }
+    }
+    copied = edit.end;
+  }
+  copy_source(source_end);
+  result += kFunctionSuffix;
+  copy_source(source_.size());
+  return result;
+}
+
+EsmModuleParser::Token EsmModuleParser::ScanToken() {
+  SkipTrivia();
+  Token token{pos_, {}, false};
+  if (pos_ >= source_.size()) {
+    return token;
+  }
+  token.is_statement_start =
+      depth_ == 0 &&
+      (last_char_ == 0 || last_char_ == ';' || last_char_ == '}' ||
+       (newline_before_ && IsExpressionEnd(last_char_)));
+  newline_before_ = false;
+
+  char c = source_[pos_];
+  if (IsIdentifierPart(c)) {
+    while (pos_ < source_.size() && IsIdentifierPart(source_[pos_])) {
+      ++pos_;
+    }
+    token.word = source_.substr(token.begin, pos_ - token.begin);
+    last_word_ = token.word;
+    last_char_ = 'a';
+  } else if (c == '\'' || c == '"') {
+    SkipString();
+    last_char_ = '"';
+  } else if (c == '`') {
+    ++pos_;
+    ScanTemplateChars();
+  } else if (c == '/' && IsRegExpAllowed()) {
+    SkipRegExp();
+    last_char_ = '"';
+  } else if (c == '(' || c == '[' || c == '{') {
+    ++pos_;
+    ++depth_;
+    last_char_ = c;
+  } else if (c == ')' || c == ']' || c == '}') {
+    ++pos_;
+    depth_ = depth_ > 0 ? depth_ - 1 : 0;
+    if (c == '}' && !template_depths_.empty() &&
+        template_depths_.back() == depth_) {
+      template_depths_.pop_back();
+      ScanTemplateChars();
+    } else {
+      last_char_ = c;
+    }
+  } else {
+    ++pos_;
+    last_char_ = c;
+  }
+  return token;
+}
+
+// Scans the template literal characters up to the closing '`' or "${".
+void EsmModuleParser::ScanTemplateChars() {
+  while (pos_ < source_.size()) {
+    char c = source_[pos_];
+    if (c == '\\') {
+      pos_ += 2;
+    } else if (c == '`') {
+      ++pos_;
+      last_char_ = '"';
+      return;
+    } else if (c == '$' && pos_ + 1 < source_.size() &&
+               source_[pos_ + 1] == '{') {
+      pos_ += 2;
+      template_depths_.push_back(depth_);
+      ++depth_;
+      last_char_ = '{';
+      return;
+    } else {
+      ++pos_;
+    }
+  }
+  pos_ = source_.size();
+}
+
+// Skips whitespace and comments.
+void EsmModuleParser::SkipTrivia() {
+  while (pos_ < source_.size()) {
+    char c = source_[pos_];
+    char next = pos_ + 1 < source_.size() ? source_[pos_ + 1] : '\0';
+    if (c == '\n') {
+      newline_before_ = true;
+      ++pos_;
+    } else if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+      ++pos_;
+    } else if (c == '/' && next == '/') {
+      pos_ = std::min(source_.find('\n', pos_), source_.size());
+    } else if (c == '/' && next == '*') {
+      size_t end = source_.find("*/", pos_ + 2);
+      end = end == std::string_view::npos ? source_.size() : end + 2;
+      if (source_.substr(pos_, end - pos_).find('\n') !=
+          std::string_view::npos) {
+        newline_before_ = true;
+      }
+      pos_ = end;
+    } else {
+      break;
+    }
+  }
+}
+
+void EsmModuleParser::SkipString() {
+  char quote = source_[pos_++];
+  while (pos_ < source_.size()) {
+    char c = source_[pos_];
+    if (c == '\\') {
+      pos_ += 2;
+    } else if (c == quote) {
+      ++pos_;
+      return;
+    } else if (c == '\n') {
+      return;
+    } else {
+      ++pos_;
+    }
+  }
+  pos_ = source_.size();
+}
+
+void EsmModuleParser::SkipRegExp() {
+  bool in_class = false;
+  for (++pos_; pos_ < source_.size(); ++pos_) {
+    char c = source_[pos_];
+    if (c == '\\') {
+      ++pos_;
+    } else if (c == '[') {
+      in_class = true;
+    } else if (c == ']') {
+      in_class = false;
+    } else if (c == '/' && !in_class) {
+      ++pos_;
+      break;
+    } else if (c == '\n') {
+      break;
+    }
+  }
+  pos_ = std::min(pos_, source_.size());
+  while (pos_ < source_.size() && IsIdentifierPart(source_[pos_])) {
+    ++pos_;
+  }
+}
+
+// Skips an initializer up to the ',' or ';' at its nesting level, the closing
+// bracket of the enclosing pattern, or the line break that ends the statement.
+void EsmModuleParser::SkipExpression() {
+  size_t depth = depth_;
+  for (;;) {
+    SkipTrivia();
+    char c = Peek();
+    if (c == '\0') {
+      return;
+    }
+    if (depth_ == depth) {
+      if (c == ',' || c == ';' || c == ')' || c == ']' || c == '}') {
+        return;
+      }
+      if (newline_before_ && IsExpressionEnd(last_char_) &&
+          std::string_view(".?:+-*/%&|^=<>([`").find(c) ==
+              std::string_view::npos) {
+        return;
+      }
+    }
+    ScanToken();
+  }
+}
+
+bool EsmModuleParser::IsRegExpAllowed() const noexcept {
+  if (last_char_ == 'a') {
+    return std::find(std::begin(kRegExpKeywords),
+                     std::end(kRegExpKeywords),
+                     last_word_) != std::end(kRegExpKeywords);
+  }
+  return !IsExpressionEnd(last_char_);
+}
+
+char EsmModuleParser::Peek() const noexcept {
+  return pos_ < source_.size() ? source_[pos_] : '\0';
+}
+
+bool EsmModuleParser::MatchChar(char c) {
+  SkipTrivia();
+  if (Peek() != c) {
+    return false;
+  }
+  ++pos_;
+  return true;
+}
+
+bool EsmModuleParser::MatchWord(std::string_view word) {
+  SkipTrivia();
+  if (source_.compare(pos_, word.size(), word) != 0 ||
+      (pos_ + word.size() < source_.size() &&
+       IsIdentifierPart(source_[pos_ + word.size()]))) {
+    return false;
+  }
+  pos_ += word.size();
+  return true;
+}
+
+bool EsmModuleParser::ReadIdentifier(std::string& name) {
+  SkipTrivia();
+  if (!IsIdentifierStart(Peek())) {
+    return false;
+  }
+  size_t begin = pos_;
+  while (pos_ < source_.size() && IsIdentifierPart(source_[pos_])) {
+    ++pos_;
+  }
+  name.assign(source_.substr(begin, pos_ - begin));
+  return true;
+}
+
+// Reads a string literal. Only the single character escapes are decoded.
+bool EsmModuleParser::ReadString(std::string& value) {
+  SkipTrivia();
+  char quote = Peek();
+  if (quote != '\'' && quote != '"') {
+    return false;
+  }
+  value.clear();
+  for (++pos_; pos_ < source_.size(); ++pos_) {
+    char c = source_[pos_];
+    if (c == quote) {
+      ++pos_;
+      return true;
+    }
+    if (c == '\n') {
+      break;
+    }
+    if (c == '\\' && pos_ + 1 < source_.size()) {
+      c = source_[++pos_];
+      c = c == 'n' ? '\n' : c == 't' ? '\t' : c == 'r' ? '\r' : c;
+    }
+    value += c;
+  }
+  return false;
+}
+
+bool EsmModuleParser::ReadExportName(std::string& name) {
+  return ReadIdentifier(name) || ReadString(name);
+}
+
+// Parses the import statement after the "import" keyword.
+bool EsmModuleParser::ParseImport(size_t begin) {
+  std::string specifier;
+  if (ReadString(specifier)) {
+    GetRequest(specifier);
+    SkipImportAttributes();
+    EndStatement(begin);
+    return true;
+  }
+
+  std::vector<std::pair<std::string, std::string>> imports;
+  std::string name;
+  bool has_default = false;
+  if (Peek() != '{' && Peek() != '*') {
+    if (!ReadIdentifier(name)) {
+      return Fail("Invalid import statement");
+    }
+    imports.emplace_back("default", std::move(name));
+    has_default = true;
+  }
+  if (!has_default || MatchChar(',')) {
+    if (MatchChar('*')) {
+      if (!MatchWord("as") || !ReadIdentifier(name)) {
+        return Fail("Expected 'as' and a name after 'import *'");
+      }
+      imports.emplace_back("*", std::move(name));
+    } else if (!MatchChar('{') || !ParseNamedList(imports)) {
+      return Fail("Invalid import statement");
+    }
+  }
+  if (!MatchWord("from") || !ReadString(specifier)) {
+    return Fail("Expected 'from' and a module specifier");
+  }
+  ModuleRequest& request = GetRequest(specifier);
+  request.imports.insert(request.imports.end(),
+                         std::make_move_iterator(imports.begin()),
+                         std::make_move_iterator(imports.end()));
+  SkipImportAttributes();
+  EndStatement(begin);
+  return true;
+}
+
+// Parses the export statement after the "export" keyword.
+// The re-exports and export lists are removed. The "export" keyword is
+// removed from the declarations, and the declarations are scanned as the
+// regular code.
+bool EsmModuleParser::ParseExport(size_t begin) {
+  size_t keyword_end = pos_;
+  std::string specifier;
+  if (MatchChar('*')) {
+    std::string exported;
+    if (MatchWord("as") && !ReadExportName(exported)) {
+      return Fail("Expected a name after 'export * as'");
+    }
+    if (!MatchWord("from") || !ReadString(specifier)) {
+      return Fail("Expected 'from' and a module specifier");
+    }
+    ModuleRequest& request = GetRequest(specifier);
+    if (exported.empty()) {
+      request.reexport_all = true;
+    } else {
+      request.reexports.emplace_back("*", std::move(exported));
+    }
+    SkipImportAttributes();
+    EndStatement(begin);
+    return true;
+  }
+
+  if (MatchChar('{')) {
+    std::vector<std::pair<std::string, std::string>> names;
+    if (!ParseNamedList(names)) {
+      return Fail("Invalid export list");
+    }
+    size_t list_end = pos_;
+    if (MatchWord("from")) {
+      if (!ReadString(specifier)) {
+        return Fail("Expected a module specifier after 'from'");
+      }
+      ModuleRequest& request = GetRequest(specifier);
+      request.reexports.insert(request.reexports.end(),
+                               std::make_move_iterator(names.begin()),
+                               std::make_move_iterator(names.end()));
+      SkipImportAttributes();
+    } else {
+      pos_ = list_end;
+      for (auto& [local, exported] : names) {
+        local_exports_.emplace_back(std::move(exported), std::move(local));
+      }
+    }
+    EndStatement(begin);
+    return true;
+  }
+
+  std::string name;
+  auto read_declaration_name = [this, &name]() {
+    if (MatchWord("async") && !MatchWord("function")) {
+      return false;
+    }
+    if (MatchWord("function")) {
+      MatchChar('*');
+      return ReadIdentifier(name);
+    }
+    return MatchWord("class") && ReadIdentifier(name) && name != "extends";
+  };
+
+  if (MatchWord("default")) {
+    SkipTrivia();
+    size_t declaration_begin = pos_;
+    if (read_declaration_name()) {
+      Replace(begin, declaration_begin, "");
+      local_exports_.emplace_back("default", std::move(name));
+      ResumeAt(declaration_begin, ';');
+    } else {
+      Replace(begin, declaration_begin, "__default =");
+      local_exports_.emplace_back("default", "__default");
+      has_default_expression_ = true;
+      ResumeAt(declaration_begin, '=');
+    }
+    return true;
+  }
+
+  SkipTrivia();
+  size_t declaration_begin = pos_;
+  std::vector<std::string> names;
+  if (MatchWord("var") || MatchWord("let") || MatchWord("const")) {
+    if (!ParseBindingNames(names)) {
+      return Fail("Invalid exported declaration");
+    }
+  } else if (read_declaration_name()) {
+    names.push_back(std::move(name));
+  } else {
+    return Fail("Unexpected token after 'export'");
+  }
+  Replace(begin, keyword_end, "");
+  for (std::string& local : names) {
+    local_exports_.emplace_back(local, local);
+  }
+  ResumeAt(declaration_begin, ';');
+  return true;
+}
+
+// Parses "a, b as c, "d" as e }" after the '{'.
+bool EsmModuleParser::ParseNamedList(
+    std::vector<std::pair<std::string, std::string>>& list) {
+  while (!MatchChar('}')) {
+    std::string name;
+    if (!ReadExportName(name)) {
+      return false;
+    }
+    std::string alias = name;
+    if (MatchWord("as") && !ReadExportName(alias)) {
+      return false;
+    }
+    list.emplace_back(std::move(name), std::move(alias));
+    if (!MatchChar(',')) {
+      return MatchChar('}');
+    }
+  }
+  return true;
+}
+
+// Parses the declarators of var, let, or const and collects their names.
+bool EsmModuleParser::ParseBindingNames(std::vector<std::string>& names) {
+  do {
+    if (!ParseBindingTarget(names)) {
+      return false;
+    }
+    if (MatchChar('=')) {
+      SkipExpression();
+    }
+  } while (MatchChar(','));
+  return true;
+}
+
+// Parses an identifier or a destructuring pattern and collects its names.
+bool EsmModuleParser::ParseBindingTarget(std::vector<std::string>& names) {
+  auto parse_rest = [this, &names]() {
+    return MatchChar('.') && MatchChar('.') && MatchChar('.') &&
+           ParseBindingTarget(names);
+  };
+  if (MatchChar('{')) {
+    while (!MatchChar('}')) {
+      if (Peek() == '.') {
+        if (!parse_rest()) {
+          return false;
+        }
+      } else {
+        std::string key;
+        if (MatchChar('[')) {
+          SkipExpression();
+          if (!MatchChar(']')) {
+            return false;
+          }
+        } else if (!ReadExportName(key)) {
+          return false;
+        }
+        if (MatchChar(':')) {
+          if (!ParseBindingTarget(names)) {
+            return false;
+          }
+        } else if (!key.empty()) {
+          names.push_back(std::move(key));
+        } else {
+          return false;
+        }
+        if (MatchChar('=')) {
+          SkipExpression();
+        }
+      }
+      if (!MatchChar(',')) {
+        return MatchChar('}');
+      }
+    }
+    return true;
+  }
+  if (MatchChar('[')) {
+    while (!MatchChar(']')) {
+      if (MatchChar(',')) {
+        continue;
+      }
+      if (Peek() == '.') {
+        if (!parse_rest()) {
+          return false;
+        }
+      } else if (!ParseBindingTarget(names)) {
+        return false;
+      }
+      if (MatchChar('=')) {
+        SkipExpression();
+      }
+      if (!MatchChar(',')) {
+        return MatchChar(']');
+      }
+    }
+    return true;
+  }
+  std::string name;
+  if (!ReadIdentifier(name)) {
+    return false;
+  }
+  names.push_back(std::move(name));
+  return true;
+}
+
+// Skips the "with { type: 'json' }" import attributes.
+void EsmModuleParser::SkipImportAttributes() {
+  size_t start = pos_;
+  if ((MatchWord("with") || MatchWord("assert")) && MatchChar('{')) {
+    size_t end = source_.find('}', pos_);
+    pos_ = end == std::string_view::npos ? source_.size() : end + 1;
+  } else {
+    pos_ = start;
+  }
+}
+
+// Removes the statement with its optional ';'.
+void EsmModuleParser::EndStatement(size_t begin) {
+  size_t end = pos_;
+  if (MatchChar(';')) {
+    end = pos_;
+  }
+  Replace(begin, end, "");
+  ResumeAt(end, ';');
+}
+
+// Continues the scan after the import or export statement.
+// The statements are top-level, so there are no open brackets.
+void EsmModuleParser::ResumeAt(size_t pos, char last_char) noexcept {
+  pos_ = pos;
+  depth_ = 0;
+  template_depths_.clear();
+  last_char_ = last_char;
+  newline_before_ = false;
+}
+
+void EsmModuleParser::Replace(size_t begin,
+                              size_t end,
+                              std::string replacement) {
+  edits_.push_back(Edit{begin, end, std::move(replacement)});
+}
+
+ModuleRequest& EsmModuleParser::GetRequest(const std::string& specifier) {
+  auto it = std::find_if(requests_.begin(),
+                         requests_.end(),
+                         [&specifier](const ModuleRequest& request) {
+                           return request.specifier == specifier;
+                         });
+  if (it != requests_.end()) {
+    return *it;
+  }
+  ModuleRequest& request = requests_.emplace_back();
+  request.specifier = specifier;
+  return request;
+}
+
+bool EsmModuleParser::Fail(std::string_view message) {
+  size_t end = std::min(pos_, source_.size());
+  size_t line = std::count(source_.begin(), source_.begin() + end, '\n') + 1;
+  error_ = std::string(message) + " at line " + std::to_string(line);
+  return false;
+}
+
+}  // namespace
+
+NodeLiteEsmLoader::NodeLiteEsmLoader(ResolveCallback resolve) noexcept
+    : resolve_(std::move(resolve)) {}
+
+const NodeLiteEsmModule& NodeLiteEsmLoader::LoadGraph(
+    const fs::path& entry_path) {
+  std::deque<NodeLiteEsmModule*> queue;
+  {
+    std::scoped_lock lock{mutex_};
+    auto [it, is_new] = modules_.try_emplace(entry_path.string());
+    if (!is_new) {
+      return *it->second;
+    }
+    it->second = std::make_unique<NodeLiteEsmModule>();
+    it->second->path = entry_path;
+    queue.push_back(it->second.get());
+  }
+
+  // The calling thread loads modules too. It starts helper threads while
+  // there are more queued modules than helpers, so that small graphs are
+  // loaded without starting threads.
+  size_t pending = 1;
+  std::condition_variable queue_changed;
+  std::vector<std::thread> helpers;
+  const std::thread::id caller_id = std::this_thread::get_id();
+  const size_t max_helpers =
+      std::clamp<size_t>(
+          std::thread::hardware_concurrency(), 1, kMaxLoaderThreads) -
+      1;
+  std::function<void()> run_loader = [&]() {
+    std::unique_lock lock{mutex_};
+    for (;;) {
+      queue_changed.wait(
+          lock, [&]() { return !queue.empty() || pending == 0; });
+      if (queue.empty()) {
+        return;
+      }
+      NodeLiteEsmModule* module = queue.front();
+      queue.pop_front();
+      lock.unlock();
+      LoadModule(*module);
+      lock.lock();
+
+      for (const std::string& resolved_path : module->resolved_paths) {
+        if (!IsEsmPath(resolved_path)) {
+          continue;
+        }
+        auto [it, is_new] = modules_.try_emplace(resolved_path);
+        if (is_new) {
+          it->second = std::make_unique<NodeLiteEsmModule>();
+          it->second->path = resolved_path;
+          queue.push_back(it->second.get());
+          ++pending;
+          queue_changed.notify_one();
+        }
+      }
+      if (std::this_thread::get_id() == caller_id) {
+        while (helpers.size() < max_helpers && helpers.size() < queue.size()) {
+          helpers.emplace_back(run_loader);
+        }
+      }
+      if (--pending == 0) {
+        queue_changed.notify_all();
+      }
+    }
+  };
+  run_loader();
+  for (std::thread& helper : helpers) {
+    helper.join();
+  }
+
+  std::scoped_lock lock{mutex_};
+  return *modules_.at(entry_path.string());
+}
+
+void NodeLiteEsmLoader::Evict(const fs::path& path) {
+  std::scoped_lock lock{mutex_};
+  modules_.erase(path.string());
+}
+
+/*static*/ bool NodeLiteEsmLoader::IsEsmPath(const fs::path& path) {
+  return path.extension() == ".mjs";
+}
+
+void NodeLiteEsmLoader::SetArchive(const NodeLiteArchive* archive) noexcept {
+  archive_ = archive;
+}
+
+void NodeLiteEsmLoader::LoadModule(NodeLiteEsmModule& module) {
+  std::string source;
+  if (std::optional<std::string> name =
+          archive_ != nullptr ? archive_->GetEntryName(module.path)
+                              : std::nullopt) {
+    const NodeLiteArchive::Entry* entry = archive_->Find(*name);
+    if (entry == nullptr ||
+        entry->kind != NodeLiteArchive::EntryKind::kEsModule) {
+      module.error = "Cannot find module in the archive: " +
+                     module.path.string();
+      return;
+    }
+    source = archive_->GetData(*entry);
+  } else if (!ReadWholeFile(module.path, source)) {
+    module.error = "Cannot read module file: " + module.path.string();
+    return;
+  }
+  std::string_view text = source;
+  if (text.substr(0, 3) == "\xEF\xBB\xBF") {
+    text.remove_prefix(3);
+  }
+
+  EsmModuleParser parser(text);
+  std::string error;
+  if (!parser.Parse(error)) {
+    module.error =
+        "SyntaxError: " + error + " in module " + module.path.string();
+    return;
+  }
+
+  std::vector<bool> is_esm;
+  is_esm.reserve(parser.requests().size());
+  module.specifiers.reserve(parser.requests().size());
+  module.resolved_paths.reserve(parser.requests().size());
+  for (const ModuleRequest& request : parser.requests()) {
+    std::string resolved_path;
+    try {
+      resolved_path = resolve_(module.path.parent_path(), request.specifier);
+    } catch (const std::exception& e) {
+      module.error = std::string(e.what()) + " imported from " +
+                     module.path.string();
+      return;
+    }
+    is_esm.push_back(IsEsmPath(resolved_path));
+    module.specifiers.push_back(request.specifier);
+    module.resolved_paths.push_back(std::move(resolved_path));
+  }
+  module.function_source = parser.GenerateFunction(is_esm);
+}
+
+}  // namespace node_api_tests
@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Loading of ECMAScript modules (.mjs) for the Node.js-like runtime.
+
+#ifndef NODE_API_TEST_NODE_LITE_ESM_H
+#define NODE_API_TEST_NODE_LITE_ESM_H
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace node_api_tests {
+
+class NodeLiteArchive;
+
+// An ES module of the static import graph prepared for the evaluation.
+// The engine does not support the module syntax. The module code is
+// transformed into a function that receives the module namespace object,
+// the array of imported module namespaces or CommonJS exports, the
+// import.meta object, and the dynamic import() function:
+//   (function(__ns, __imports, __import_meta, __import_dynamic) { ... })
+// The transformation keeps the line numbers of the original code.
+// Imported bindings are copied when the module starts, so they are not live
+// and cyclic imports see the bindings that are initialized at that time.
+struct NodeLiteEsmModule {
+  std::filesystem::path path;
+  std::string function_source;
+  // Static import and re-export specifiers in the evaluation order and their
+  // resolved paths or built-in module names.
+  std::vector<std::string> specifiers;
+  std::vector<std::string> resolved_paths;
+  // The loading error. The error is reported when the module is evaluated.
+  std::string error;
+};
+
+// Loads the static import graph of ES modules before its evaluation.
+// Module files are read, parsed, resolved, and transformed on a pool of
+// threads, so that the loading time of deep import graphs is bounded by the
+// longest import chain instead of the sum of all file reads. Compilation and
+// evaluation are done later on the JS thread in the import order.
+class NodeLiteEsmLoader {
+ public:
+  // Resolves the specifier imported from the parent folder to a file path or
+  // a built-in module name. It is called on the pool threads and must be
+  // thread-safe. It reports errors by throwing exceptions.
+  using ResolveCallback = std::function<std::string(
+      const std::filesystem::path& parent_dir, const std::string& specifier)>;
+
+  explicit NodeLiteEsmLoader(ResolveCallback resolve) noexcept;
+
+  NodeLiteEsmLoader(const NodeLiteEsmLoader&) = delete;
+  NodeLiteEsmLoader& operator=(const NodeLiteEsmLoader&) = delete;
+
+  // Loads the entry module and all ES modules it statically imports.
+  // Modules loaded by previous calls are not loaded again.
+  const NodeLiteEsmModule& LoadGraph(const std::filesystem::path& entry_path);
+
+  // Removes the loaded module, so that the next LoadGraph reads it again.
+  void Evict(const std::filesystem::path& path);
+
+  // Sets the application archive. The sources of the modules inside of it
+  // are read from the archive instead of the file system.
+  void SetArchive(const NodeLiteArchive* archive) noexcept;
+
+  static bool IsEsmPath(const std::filesystem::path& path);
+
+ private:
+  void LoadModule(NodeLiteEsmModule& module);
+
+ private:
+  ResolveCallback resolve_;
+  const NodeLiteArchive* archive_{};
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::unique_ptr<NodeLiteEsmModule>> modules_;
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_ESM_H
@@ -6,15 +6,33 @@
 
 namespace node_api_tests {
 
+namespace {
+
+// Maps the command line options onto the jsr_config.
+void ApplyOptions(jsr_config config, const NodeLiteOptions& options) {
+  jsr_config_enable_gc_api(config, true);
+  jsr_config_set_explicit_microtasks(config, options.explicit_microtasks);
+  if (options.inspect) {
+    jsr_config_enable_inspector(config, true);
+    jsr_config_set_inspector_runtime_name(config, "hermes-cli");
+    jsr_config_set_inspector_port(config, options.inspect_port);
+    jsr_config_set_inspector_break_on_start(config,
+                                            options.inspect_break_on_start);
+  }
+}
+
+}  // namespace
+
 class HermesRuntimeHolder : public IEnvHolder {
  public:
   HermesRuntimeHolder(
       std::shared_ptr<NodeLiteTaskRunner> taskRunner,
+      const NodeLiteOptions& options,
       std::function<void(napi_env, napi_value)> onUnhandledError) noexcept
       : onUnhandledError_(std::move(onUnhandledError)) {
     jsr_config config{};
     jsr_create_config(&config);
-    jsr_config_enable_gc_api(config, true);
+    ApplyOptions(config, options);
     std::shared_ptr<NodeLiteTaskRunner>* taskRunnerPtr =
         new std::shared_ptr<NodeLiteTaskRunner>(std::move(taskRunner));
     jsr_config_set_task_runner(config,
@@ -52,9 +70,10 @@ class HermesRuntimeHolder : public IEnvHolder {
 
 std::unique_ptr<IEnvHolder> CreateEnvHolder(
     std::shared_ptr<NodeLiteTaskRunner> taskRunner,
+    const NodeLiteOptions& options,
     std::function<void(napi_env, napi_value)> onUnhandledError) {
   return std::unique_ptr<IEnvHolder>(new HermesRuntimeHolder(
-      std::move(taskRunner), std::move(onUnhandledError)));
+      std::move(taskRunner), options, std::move(onUnhandledError)));
 }
 
 }  // namespace node_api_tests
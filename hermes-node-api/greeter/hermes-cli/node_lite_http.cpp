@@ -0,0 +1,1212 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_http.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "node_lite_net.h"
+
+namespace node_api_tests {
+
+namespace {
+
+// The flags passed to the onRequest callback.
+constexpr uint32_t kRequestVersion11 = 1;
+constexpr uint32_t kRequestKeepAlive = 2;
+constexpr uint32_t kRequestComplete = 4;
+
+constexpr std::string_view kCommonMethods[] = {
+    "GET", "POST", "PUT", "DELETE", "HEAD", "OPTIONS", "PATCH"};
+
+char ToLowerAscii(char c) noexcept {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool EqualsIgnoreCase(std::string_view value, std::string_view lower) noexcept {
+  if (value.size() != lower.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < value.size(); ++i) {
+    if (ToLowerAscii(value[i]) != lower[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if the comma-separated list contains the token.
+bool HasToken(std::string_view list, std::string_view lower_token) noexcept {
+  while (!list.empty()) {
+    size_t comma = list.find(',');
+    std::string_view token = list.substr(0, comma);
+    while (!token.empty() && (token.front() == ' ' || token.front() == '\t')) {
+      token.remove_prefix(1);
+    }
+    while (!token.empty() && (token.back() == ' ' || token.back() == '\t')) {
+      token.remove_suffix(1);
+    }
+    if (EqualsIgnoreCase(token, lower_token)) {
+      return true;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    list.remove_prefix(comma + 1);
+  }
+  return false;
+}
+
+bool IsTokenChar(char c) noexcept {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') ||
+         std::string_view("!#$%&'*+-.^_`|~").find(c) != std::string_view::npos;
+}
+
+bool IsToken(std::string_view value) noexcept {
+  return !value.empty() && std::all_of(value.begin(), value.end(), IsTokenChar);
+}
+
+bool ParseContentLength(std::string_view value, uint64_t& result) noexcept {
+  if (value.empty()) {
+    return false;
+  }
+  uint64_t length = 0;
+  for (char c : value) {
+    if (c < '0' || c > '9' ||
+        length > (std::numeric_limits<uint64_t>::max() - 9) / 10) {
+      return false;
+    }
+    length = length * 10 + static_cast<uint64_t>(c - '0');
+  }
+  result = length;
+  return true;
+}
+
+int32_t HexDigitValue(char c) noexcept {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = ToLowerAscii(c);
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+}  // namespace
+
+//=============================================================================
+// NodeLiteHttpParser implementation
+//=============================================================================
+
+/*static*/ NodeLiteHttpParser::Result NodeLiteHttpParser::ParseRequestHead(
+    std::string_view data, RequestHead& head) {
+  // Empty lines before the request line are ignored.
+  size_t start = 0;
+  while (start + 1 < data.size() && data[start] == '\r' &&
+         data[start + 1] == '\n') {
+    start += 2;
+  }
+  size_t end = data.substr(0, kMaxHeadSize).find("\r\n\r\n", start);
+  if (end == std::string_view::npos) {
+    return data.size() < kMaxHeadSize ? Result::kIncomplete
+                                      : Result::kTooLarge;
+  }
+  head = RequestHead{};
+  head.header_block = data.substr(start, end - start);
+  head.size = end + 4;
+
+  // The request line: <method> SP <target> SP HTTP/1.<minor>
+  std::string_view line =
+      head.header_block.substr(0, head.header_block.find("\r\n"));
+  size_t method_end = line.find(' ');
+  if (method_end == std::string_view::npos) {
+    return Result::kError;
+  }
+  head.method = line.substr(0, method_end);
+  size_t target_end = line.find(' ', method_end + 1);
+  if (target_end == std::string_view::npos || !IsToken(head.method)) {
+    return Result::kError;
+  }
+  head.target = line.substr(method_end + 1, target_end - method_end - 1);
+  std::string_view version = line.substr(target_end + 1);
+  if (head.target.empty() || version.size() != 8 ||
+      version.substr(0, 7) != "HTTP/1." ||
+      (version[7] != '0' && version[7] != '1')) {
+    return Result::kError;
+  }
+  head.version_minor = static_cast<uint8_t>(version[7] - '0');
+
+  bool is_valid = true;
+  bool has_content_length = false;
+  bool has_transfer_encoding = false;
+  bool has_close = false;
+  bool has_keep_alive = false;
+  size_t line_start = line.size() + 2;
+  while (is_valid && line_start < head.header_block.size()) {
+    size_t line_end = head.header_block.find("\r\n", line_start);
+    if (line_end == std::string_view::npos) {
+      line_end = head.header_block.size();
+    }
+    std::string_view header =
+        head.header_block.substr(line_start, line_end - line_start);
+    line_start = line_end + 2;
+    size_t colon = header.find(':');
+    if (colon == std::string_view::npos ||
+        !IsToken(header.substr(0, colon))) {
+      is_valid = false;
+      break;
+    }
+    std::string_view name = header.substr(0, colon);
+    std::string_view value = header.substr(colon + 1);
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+      value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+      value.remove_suffix(1);
+    }
+    // Only the headers that frame the messages are interpreted here.
+    switch (ToLowerAscii(name[0])) {
+      case 'c':
+        if (EqualsIgnoreCase(name, "content-length")) {
+          uint64_t length{};
+          is_valid = ParseContentLength(value, length) &&
+                     (!has_content_length || length == head.content_length);
+          head.content_length = length;
+          has_content_length = true;
+        } else if (EqualsIgnoreCase(name, "connection")) {
+          has_close |= HasToken(value, "close");
+          has_keep_alive |= HasToken(value, "keep-alive");
+        }
+        break;
+      case 't':
+        if (EqualsIgnoreCase(name, "transfer-encoding")) {
+          has_transfer_encoding = true;
+          // The chunked coding must be the last one.
+          size_t last_comma = value.rfind(',');
+          head.is_chunked = HasToken(
+              last_comma == std::string_view::npos
+                  ? value
+                  : value.substr(last_comma + 1),
+              "chunked");
+        }
+        break;
+    }
+  }
+  // A message with both framings may be used to smuggle requests.
+  if (!is_valid || (has_transfer_encoding && has_content_length) ||
+      (has_transfer_encoding && !head.is_chunked)) {
+    return Result::kError;
+  }
+  head.keep_alive =
+      head.version_minor == 1 ? !has_close : has_keep_alive && !has_close;
+  return Result::kComplete;
+}
+
+NodeLiteHttpParser::Result NodeLiteHttpParser::ChunkedDecoder::Decode(
+    std::string_view input,
+    std::string_view& chunk,
+    size_t& consumed) noexcept {
+  chunk = {};
+  size_t i = 0;
+  while (i < input.size()) {
+    char c = input[i];
+    switch (state_) {
+      case State::kSize: {
+        int32_t digit = HexDigitValue(c);
+        if (digit >= 0) {
+          if (remaining_ > (std::numeric_limits<uint64_t>::max() >> 4)) {
+            consumed = i;
+            return Result::kError;
+          }
+          remaining_ = (remaining_ << 4) | static_cast<uint64_t>(digit);
+          has_size_digits_ = true;
+        } else if (has_size_digits_ && (c == ';' || c == ' ' || c == '\t')) {
+          state_ = State::kSizeExtension;
+        } else if (has_size_digits_ && c == '\r') {
+          state_ = State::kSizeLf;
+        } else {
+          consumed = i;
+          return Result::kError;
+        }
+        ++i;
+        break;
+      }
+      case State::kSizeExtension:
+        if (c == '\r') {
+          state_ = State::kSizeLf;
+        }
+        ++i;
+        break;
+      case State::kSizeLf:
+        if (c != '\n') {
+          consumed = i;
+          return Result::kError;
+        }
+        has_size_digits_ = false;
+        state_ = remaining_ == 0 ? State::kTrailer : State::kData;
+        ++i;
+        break;
+      case State::kData: {
+        size_t size = static_cast<size_t>(
+            std::min<uint64_t>(remaining_, input.size() - i));
+        chunk = input.substr(i, size);
+        i += size;
+        remaining_ -= size;
+        if (remaining_ == 0) {
+          state_ = State::kDataCr;
+        }
+        consumed = i;
+        return Result::kIncomplete;
+      }
+      case State::kDataCr:
+      case State::kDataLf:
+        if (c != (state_ == State::kDataCr ? '\r' : '\n')) {
+          consumed = i;
+          return Result::kError;
+        }
+        state_ = state_ == State::kDataCr ? State::kDataLf : State::kSize;
+        ++i;
+        break;
+      case State::kTrailer:
+        // The trailer fields are skipped until the empty line.
+        state_ = c == '\r' ? State::kTrailerLf : State::kTrailerLine;
+        ++i;
+        break;
+      case State::kTrailerLine:
+        if (c == '\n') {
+          state_ = State::kTrailer;
+        }
+        ++i;
+        break;
+      case State::kTrailerLf:
+        if (c != '\n') {
+          consumed = i;
+          return Result::kError;
+        }
+        *this = ChunkedDecoder{};
+        consumed = i + 1;
+        return Result::kComplete;
+    }
+  }
+  consumed = i;
+  return Result::kIncomplete;
+}
+
+//=============================================================================
+// NodeLiteHttpConnection implementation
+//=============================================================================
+
+NodeLiteHttpConnection::NodeLiteHttpConnection(NodeLiteNet& net,
+                                               uint32_t socket_id) noexcept
+    : net_(net), socket_id_(socket_id) {}
+
+void NodeLiteHttpConnection::OnData(const char* data, size_t size) {
+  napi_env env = net_.env();
+  while (size > 0 && IsOpen()) {
+    // Pipelined requests may arrive in one read.
+    NodeApiHandleScope scope{env};
+    switch (state_) {
+      case State::kHead: {
+        NodeLiteHttpParser::RequestHead head;
+        if (pending_head_.empty()) {
+          NodeLiteHttpParser::Result result =
+              NodeLiteHttpParser::ParseRequestHead({data, size}, head);
+          if (result == NodeLiteHttpParser::Result::kIncomplete) {
+            pending_head_.assign(data, size);
+            return;
+          }
+          if (result == NodeLiteHttpParser::Result::kTooLarge) {
+            OnError(431);
+            return;
+          }
+          if (result == NodeLiteHttpParser::Result::kError) {
+            OnError(400);
+            return;
+          }
+          napi_value head_view = net_.CreateReadView(
+              head.header_block.data(), head.header_block.size());
+          data += head.size;
+          size -= head.size;
+          if (!OnHead(head, head_view, data, size)) {
+            return;
+          }
+          break;
+        }
+
+        // The head was split between reads. It is completed in the pending
+        // buffer and copied to its own ArrayBuffer.
+        size_t pending_size = pending_head_.size();
+        size_t append_size =
+            std::min(size, NodeLiteHttpParser::kMaxHeadSize - pending_size);
+        pending_head_.append(data, append_size);
+        NodeLiteHttpParser::Result result =
+            NodeLiteHttpParser::ParseRequestHead(pending_head_, head);
+        if (result == NodeLiteHttpParser::Result::kIncomplete) {
+          return;
+        }
+        if (result == NodeLiteHttpParser::Result::kTooLarge) {
+          OnError(431);
+          return;
+        }
+        if (result == NodeLiteHttpParser::Result::kError) {
+          OnError(400);
+          return;
+        }
+        size_t head_size = head.header_block.size();
+        void* head_data{};
+        napi_value head_buffer{};
+        NODE_LITE_CALL(
+            napi_create_arraybuffer(env, head_size, &head_data, &head_buffer));
+        std::memcpy(head_data, head.header_block.data(), head_size);
+        napi_value head_view{};
+        NODE_LITE_CALL(napi_create_typedarray(
+            env, napi_uint8_array, head_size, head_buffer, 0, &head_view));
+        size_t consumed = head.size - pending_size;
+        data += consumed;
+        size -= consumed;
+        bool is_open = OnHead(head, head_view, data, size);
+        pending_head_.clear();
+        if (!is_open) {
+          return;
+        }
+        break;
+      }
+      case State::kBody:
+        if (!OnBody(data, size)) {
+          return;
+        }
+        break;
+      case State::kChunkedBody:
+        if (!OnChunkedBody(data, size)) {
+          return;
+        }
+        break;
+      case State::kError:
+        return;
+    }
+  }
+}
+
+bool NodeLiteHttpConnection::OnHead(const NodeLiteHttpParser::RequestHead& head,
+                                    napi_value head_view,
+                                    const char*& data,
+                                    size_t& size) {
+  napi_env env = net_.env();
+  // The body received with the head is passed with it.
+  napi_value body = NodeApi::GetUndefined(env);
+  if (head.is_chunked) {
+    state_ = State::kChunkedBody;
+  } else {
+    size_t available =
+        static_cast<size_t>(std::min<uint64_t>(size, head.content_length));
+    if (available > 0) {
+      body = net_.CreateReadView(data, available);
+      data += available;
+      size -= available;
+    }
+    body_remaining_ = head.content_length - available;
+    state_ = body_remaining_ > 0 ? State::kBody : State::kHead;
+  }
+  uint32_t flags = (head.version_minor == 1 ? kRequestVersion11 : 0) |
+                   (head.keep_alive ? kRequestKeepAlive : 0) |
+                   (state_ == State::kHead ? kRequestComplete : 0);
+  net_.http().CallJS(
+      NodeLiteHttp::Callback::kOnRequest,
+      {NodeApi::CreateUInt32(env, socket_id_),
+       net_.http().GetMethodString(env, head.method),
+       NodeApi::CreateString(env, head.target),
+       head_view,
+       NodeApi::CreateUInt32(env, flags),
+       body});
+  return IsOpen();
+}
+
+bool NodeLiteHttpConnection::OnBody(const char*& data, size_t& size) {
+  napi_env env = net_.env();
+  size_t available =
+      static_cast<size_t>(std::min<uint64_t>(size, body_remaining_));
+  napi_value body = net_.CreateReadView(data, available);
+  data += available;
+  size -= available;
+  body_remaining_ -= available;
+  if (body_remaining_ == 0) {
+    state_ = State::kHead;
+  }
+  net_.http().CallJS(NodeLiteHttp::Callback::kOnBody,
+                     {NodeApi::CreateUInt32(env, socket_id_),
+                      body,
+                      NodeApi::GetBoolean(env, state_ == State::kHead)});
+  return IsOpen();
+}
+
+bool NodeLiteHttpConnection::OnChunkedBody(const char*& data, size_t& size) {
+  napi_env env = net_.env();
+  std::string_view chunk;
+  size_t consumed{};
+  NodeLiteHttpParser::Result result =
+      chunked_decoder_.Decode({data, size}, chunk, consumed);
+  if (result == NodeLiteHttpParser::Result::kError) {
+    OnError(400);
+    return false;
+  }
+  bool is_complete = result == NodeLiteHttpParser::Result::kComplete;
+  if (is_complete) {
+    state_ = State::kHead;
+  }
+  if (!chunk.empty() || is_complete) {
+    net_.http().CallJS(
+        NodeLiteHttp::Callback::kOnBody,
+        {NodeApi::CreateUInt32(env, socket_id_),
+         chunk.empty() ? NodeApi::GetUndefined(env)
+                       : net_.CreateReadView(chunk.data(), chunk.size()),
+         NodeApi::GetBoolean(env, is_complete)});
+  }
+  data += consumed;
+  size -= consumed;
+  return IsOpen();
+}
+
+void NodeLiteHttpConnection::OnError(uint32_t status_code) {
+  napi_env env = net_.env();
+  state_ = State::kError;
+  pending_head_.clear();
+  net_.http().CallJS(NodeLiteHttp::Callback::kOnError,
+                     {NodeApi::CreateUInt32(env, socket_id_),
+                      NodeApi::CreateUInt32(env, status_code)});
+}
+
+bool NodeLiteHttpConnection::IsOpen() noexcept {
+  return net_.GetHandle(socket_id_) != nullptr;
+}
+
+//=============================================================================
+// NodeLiteHttp implementation
+//=============================================================================
+
+NodeLiteHttp::NodeLiteHttp(NodeLiteNet& net) noexcept : net_(net) {}
+
+napi_value NodeLiteHttp::GetMethodString(napi_env env,
+                                         std::string_view method) {
+  for (uint32_t i = 0; i < std::size(kCommonMethods); ++i) {
+    if (method != kCommonMethods[i]) {
+      continue;
+    }
+    if (method_strings_ == nullptr) {
+      napi_value strings{};
+      NODE_LITE_CALL(napi_create_array(env, &strings));
+      for (uint32_t j = 0; j < std::size(kCommonMethods); ++j) {
+        NODE_LITE_CALL(napi_set_element(
+            env, strings, j, NodeApi::CreateString(env, kCommonMethods[j])));
+      }
+      method_strings_ = MakeNodeApiRef(env, strings);
+    }
+    napi_value result{};
+    NODE_LITE_CALL(napi_get_element(
+        env,
+        NodeApi::GetReferenceValue(env, method_strings_.get()),
+        i,
+        &result));
+    return result;
+  }
+  return NodeApi::CreateString(env, method);
+}
+
+void NodeLiteHttp::CallJS(Callback callback, span<napi_value> args) {
+  napi_env env = net_.env();
+  NodeApiRef& callback_ref = callbacks_[static_cast<size_t>(callback)];
+  NODE_LITE_ASSERT(callback_ref != nullptr, "The http callbacks are not set");
+  NodeApi::CallFunction(
+      env, NodeApi::GetReferenceValue(env, callback_ref.get()), args);
+}
+
+napi_value NodeLiteHttp::CreateBinding(napi_env env) {
+  napi_value binding = NodeApi::CreateObject(env);
+
+  // setCallbacks({onRequest, onBody, onError, onReset})
+  NodeApi::SetMethod(
+      env,
+      binding,
+      "setCallbacks",
+      [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+        constexpr const char* kCallbackNames[] = {
+            "onRequest", "onBody", "onError", "onReset"};
+        static_assert(std::size(kCallbackNames) ==
+                      static_cast<size_t>(Callback::kCount));
+        for (size_t i = 0; i < std::size(kCallbackNames); ++i) {
+          napi_value callback =
+              NodeApi::GetProperty(env, args[0], kCallbackNames[i]);
+          NODE_LITE_ASSERT(NodeApi::TypeOf(env, callback) == napi_function,
+                           "Expected function %s",
+                           kCallbackNames[i]);
+          callbacks_[i] = MakeNodeApiRef(env, callback);
+        }
+        return nullptr;
+      });
+
+  // enableHttp(serverId): the connections accepted by the server are parsed
+  // as HTTP requests instead of emitting the 'data' events.
+  NodeApi::SetMethod(
+      env, binding, "enableHttp", [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        net_.EnableHttp(NodeApi::GetValueUInt32(env, args[0]));
+        return nullptr;
+      });
+
+  // parseHeaders(headView) -> object with the lower case header names.
+  // The request headers are only parsed into an object on access.
+  NodeApi::SetMethod(
+      env, binding, "parseHeaders", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        size_t length{};
+        void* data{};
+        NODE_LITE_CALL(napi_get_typedarray_info(
+            env, args[0], nullptr, &length, &data, nullptr, nullptr));
+        std::string_view head(static_cast<const char*>(data), length);
+        napi_value headers = NodeApi::CreateObject(env);
+        std::string name;
+        NodeLiteHttpParser::ForEachHeader(
+            head, [env, headers, &name](std::string_view raw_name,
+                                        std::string_view raw_value) {
+              name.assign(raw_name);
+              std::transform(name.begin(), name.end(), name.begin(),
+                             ToLowerAscii);
+              napi_value value{};
+              NODE_LITE_CALL(napi_create_string_latin1(
+                  env, raw_value.data(), raw_value.size(), &value));
+              bool has_value{};
+              NODE_LITE_CALL(napi_has_named_property(
+                  env, headers, name.c_str(), &has_value));
+              if (!has_value) {
+                NodeApi::SetProperty(env, headers, name, value);
+                return;
+              }
+              // The repeated headers are joined like in Node.js, except
+              // set-cookie that is an array.
+              napi_value previous =
+                  NodeApi::GetProperty(env, headers, name);
+              if (name == "set-cookie") {
+                bool is_array{};
+                NODE_LITE_CALL(napi_is_array(env, previous, &is_array));
+                if (!is_array) {
+                  napi_value array{};
+                  NODE_LITE_CALL(napi_create_array(env, &array));
+                  NODE_LITE_CALL(napi_set_element(env, array, 0, previous));
+                  NodeApi::SetProperty(env, headers, name, array);
+                  previous = array;
+                }
+                uint32_t array_length{};
+                NODE_LITE_CALL(
+                    napi_get_array_length(env, previous, &array_length));
+                NODE_LITE_CALL(
+                    napi_set_element(env, previous, array_length, value));
+                return;
+              }
+              std::string joined = NodeApi::ToStdString(env, previous);
+              joined.append(", ").append(raw_value);
+              NODE_LITE_CALL(napi_create_string_latin1(
+                  env, joined.data(), joined.size(), &value));
+              NodeApi::SetProperty(env, headers, name, value);
+            });
+        return headers;
+      });
+
+  // byteLength(string) -> the UTF-8 length for the Content-Length header.
+  NodeApi::SetMethod(
+      env, binding, "byteLength", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        size_t length{};
+        NODE_LITE_CALL(
+            napi_get_value_string_utf8(env, args[0], nullptr, 0, &length));
+        return NodeApi::CreateDouble(env, static_cast<double>(length));
+      });
+
+  // decodeUtf8(view) -> string
+  NodeApi::SetMethod(
+      env, binding, "decodeUtf8", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        return NodeLiteNet::DecodeUtf8(env, args[0]);
+      });
+
+  return binding;
+}
+
+/*static*/ const std::string_view NodeLiteHttp::kModuleSource = R"JS(
+(function (binding, require) {
+  'use strict';
+  const EventEmitter = require('events');
+  const net = require('net');
+
+  const STATUS_CODES = {
+    100: 'Continue',
+    101: 'Switching Protocols',
+    200: 'OK',
+    201: 'Created',
+    202: 'Accepted',
+    204: 'No Content',
+    206: 'Partial Content',
+    301: 'Moved Permanently',
+    302: 'Found',
+    303: 'See Other',
+    304: 'Not Modified',
+    307: 'Temporary Redirect',
+    308: 'Permanent Redirect',
+    400: 'Bad Request',
+    401: 'Unauthorized',
+    403: 'Forbidden',
+    404: 'Not Found',
+    405: 'Method Not Allowed',
+    408: 'Request Timeout',
+    409: 'Conflict',
+    411: 'Length Required',
+    413: 'Payload Too Large',
+    414: 'URI Too Long',
+    415: 'Unsupported Media Type',
+    429: 'Too Many Requests',
+    431: 'Request Header Fields Too Large',
+    500: 'Internal Server Error',
+    501: 'Not Implemented',
+    502: 'Bad Gateway',
+    503: 'Service Unavailable',
+    504: 'Gateway Timeout',
+    505: 'HTTP Version Not Supported',
+  };
+
+  const METHODS = [
+    'CONNECT', 'DELETE', 'GET', 'HEAD', 'OPTIONS', 'PATCH', 'POST', 'PUT',
+    'TRACE',
+  ];
+
+  // The flags of the onRequest callback.
+  const kVersion11 = 1;
+  const kKeepAlive = 2;
+  const kComplete = 4;
+
+  // The HTTP connections by their socket ids.
+  const connections = new Map();
+
+  function inherits(ctor, superCtor) {
+    Object.setPrototypeOf(ctor.prototype, superCtor.prototype);
+    Object.setPrototypeOf(ctor, superCtor);
+  }
+
+  // The Date header changes once per second.
+  let dateHeader = '';
+  let dateHeaderTime = 0;
+  function getDateHeader() {
+    const now = Date.now();
+    if (now - dateHeaderTime >= 1000) {
+      dateHeaderTime = now - (now % 1000);
+      dateHeader = 'Date: ' + new Date(now).toUTCString() + '\r\n';
+    }
+    return dateHeader;
+  }
+
+  function byteLength(data) {
+    return typeof data === 'string' ? binding.byteLength(data)
+                                    : data.byteLength;
+  }
+
+  // The responses of the pipelined requests are sent in the request order.
+  // Only the first response writes to the socket. The others buffer their
+  // output until they become first.
+  function Connection(server, socket) {
+    this.server = server;
+    this.socket = socket;
+    this.request = null;
+    this.responses = [];
+    this.isClosing = false;
+    this.errorStatus = 0;
+  }
+
+  Connection.prototype.advance = function () {
+    const responses = this.responses;
+    while (responses.length > 0) {
+      const res = responses[0];
+      if (!res._isActive) {
+        res._isActive = true;
+        const output = res._output;
+        if (output !== null) {
+          res._output = null;
+          for (let i = 0; i < output.length; ++i) {
+            this.socket.write(output[i]);
+          }
+        }
+      }
+      if (!res.finished) {
+        return;
+      }
+      responses.shift();
+      if (!res._keepAlive) {
+        this.isClosing = true;
+        responses.length = 0;
+        this.socket.end();
+      }
+      res.emit('finish');
+    }
+    if (this.errorStatus !== 0 && !this.isClosing) {
+      const status = this.errorStatus;
+      this.isClosing = true;
+      this.socket.end(
+          'HTTP/1.1 ' + status + ' ' + STATUS_CODES[status] +
+          '\r\nConnection: close\r\n\r\n');
+    }
+  };
+
+  function IncomingMessage(socket, method, url, head, flags) {
+    EventEmitter.call(this);
+    this.socket = socket;
+    this.connection = socket;
+    this.method = method;
+    this.url = url;
+    this.httpVersionMajor = 1;
+    this.httpVersionMinor = flags & kVersion11 ? 1 : 0;
+    this.httpVersion = flags & kVersion11 ? '1.1' : '1.0';
+    this.complete = false;
+    this.readableEnded = false;
+    this._head = head;
+    this._headers = null;
+    this._encoding = null;
+    this._queue = null;
+  }
+  inherits(IncomingMessage, EventEmitter);
+
+  // The headers are parsed from the raw head on the first access.
+  Object.defineProperty(IncomingMessage.prototype, 'headers', {
+    get() {
+      if (this._headers === null) {
+        this._headers = binding.parseHeaders(this._head);
+      }
+      return this._headers;
+    },
+    set(value) {
+      this._headers = value;
+    },
+  });
+
+  IncomingMessage.prototype.setEncoding = function (encoding) {
+    this._encoding = encoding || 'utf8';
+    return this;
+  };
+
+  IncomingMessage.prototype.pause = function () {
+    this.socket.pause();
+    return this;
+  };
+
+  IncomingMessage.prototype.resume = function () {
+    this.socket.resume();
+    return this;
+  };
+
+  // The body chunks and the end (null) are emitted after the 'request'
+  // handler has added its listeners.
+  IncomingMessage.prototype._push = function (chunk) {
+    if (this._queue !== null) {
+      this._queue.push(chunk);
+      return;
+    }
+    this._queue = [chunk];
+    process.nextTick(() => this._flush());
+  };
+
+  IncomingMessage.prototype._flush = function () {
+    const queue = this._queue;
+    this._queue = null;
+    for (let i = 0; i < queue.length; ++i) {
+      const chunk = queue[i];
+      if (chunk === null) {
+        this.complete = true;
+        this.readableEnded = true;
+        this.emit('end');
+      } else {
+        this.emit(
+            'data', this._encoding ? binding.decodeUtf8(chunk) : chunk);
+      }
+    }
+  };
+
+  function ServerResponse(connection, req, keepAlive) {
+    EventEmitter.call(this);
+    this.statusCode = 200;
+    this.statusMessage = undefined;
+    this.headersSent = false;
+    this.finished = false;
+    this.writableEnded = false;
+    this.socket = connection.socket;
+    this.connection = connection.socket;
+    this.req = req;
+    this._connection = connection;
+    this._headers = null;
+    this._keepAlive = keepAlive;
+    this._isHttp11 = req.httpVersionMinor === 1;
+    this._hasBody = req.method !== 'HEAD';
+    this._isChunked = false;
+    this._isActive = false;
+    this._needDrain = false;
+    this._output = null;
+  }
+  inherits(ServerResponse, EventEmitter);
+
+  ServerResponse.prototype.setHeader = function (name, value) {
+    if (this.headersSent) {
+      throw new Error('Cannot set headers after they are sent');
+    }
+    if (this._headers === null) {
+      this._headers = Object.create(null);
+    }
+    this._headers[name.toLowerCase()] = [name, value];
+    return this;
+  };
+
+  ServerResponse.prototype.getHeader = function (name) {
+    const entry = this._headers && this._headers[name.toLowerCase()];
+    return entry ? entry[1] : undefined;
+  };
+
+  ServerResponse.prototype.hasHeader = function (name) {
+    return !!(this._headers && this._headers[name.toLowerCase()]);
+  };
+
+  ServerResponse.prototype.removeHeader = function (name) {
+    if (this._headers !== null) {
+      delete this._headers[name.toLowerCase()];
+    }
+  };
+
+  ServerResponse.prototype.getHeaders = function () {
+    const result = {};
+    for (const key in this._headers) {
+      result[key] = this._headers[key][1];
+    }
+    return result;
+  };
+
+  ServerResponse.prototype.writeHead = function (statusCode, reason, headers) {
+    if (typeof reason !== 'string') {
+      headers = reason;
+      reason = undefined;
+    }
+    this.statusCode = statusCode;
+    if (reason !== undefined) {
+      this.statusMessage = reason;
+    }
+    if (Array.isArray(headers)) {
+      for (let i = 0; i + 1 < headers.length; i += 2) {
+        this.setHeader(headers[i], headers[i + 1]);
+      }
+    } else if (headers) {
+      for (const name in headers) {
+        this.setHeader(name, headers[name]);
+      }
+    }
+    return this;
+  };
+
+  // Builds the head. The body length is -1 if it is not known yet.
+  ServerResponse.prototype._buildHead = function (bodyLength) {
+    const status = this.statusCode;
+    let head = 'HTTP/1.1 ' + status + ' ' +
+        (this.statusMessage || STATUS_CODES[status] || 'unknown') + '\r\n';
+    let hasLength = false;
+    let hasEncoding = false;
+    let hasDate = false;
+    let hasConnection = false;
+    for (const key in this._headers) {
+      const name = this._headers[key][0];
+      const value = this._headers[key][1];
+      if (key === 'content-length') {
+        hasLength = true;
+      } else if (key === 'transfer-encoding') {
+        hasEncoding = true;
+        this._isChunked = /chunked/i.test(value);
+      } else if (key === 'date') {
+        hasDate = true;
+      } else if (key === 'connection') {
+        hasConnection = true;
+        if (/close/i.test(value)) {
+          this._keepAlive = false;
+        }
+      }
+      if (Array.isArray(value)) {
+        for (let i = 0; i < value.length; ++i) {
+          head += name + ': ' + value[i] + '\r\n';
+        }
+      } else {
+        head += name + ': ' + value + '\r\n';
+      }
+    }
+    if (!hasDate) {
+      head += getDateHeader();
+    }
+    if (status === 204 || status === 304 || (status >= 100 && status < 200)) {
+      this._hasBody = false;
+    } else if (!hasLength && !hasEncoding) {
+      if (bodyLength >= 0) {
+        head += 'Content-Length: ' + bodyLength + '\r\n';
+      } else if (this._isHttp11) {
+        head += 'Transfer-Encoding: chunked\r\n';
+        this._isChunked = true;
+      } else {
+        // An HTTP/1.0 body of unknown length ends with the connection.
+        this._keepAlive = false;
+      }
+    }
+    if (!this._connection.server.listening) {
+      this._keepAlive = false;
+    }
+    if (!hasConnection) {
+      if (!this._keepAlive) {
+        head += 'Connection: close\r\n';
+      } else if (!this._isHttp11) {
+        head += 'Connection: keep-alive\r\n';
+      }
+    }
+    this.headersSent = true;
+    return head + '\r\n';
+  };
+
+  // Returns false if the socket buffers more data than its high water mark.
+  // The output of a response waiting for the previous pipelined responses
+  // is buffered without a limit.
+  ServerResponse.prototype._send = function (data) {
+    if (this._isActive) {
+      return this.socket.write(data);
+    }
+    if (this._output === null) {
+      this._output = [data];
+    } else {
+      this._output.push(data);
+    }
+    return true;
+  };
+
+  // Sends a body chunk with the chunked framing if it is used.
+  ServerResponse.prototype._sendBody = function (chunk) {
+    const length = byteLength(chunk);
+    if (length === 0) {
+      // An empty chunk would end the chunked body.
+      return true;
+    }
+    if (!this._isChunked) {
+      return this._send(chunk);
+    }
+    if (typeof chunk === 'string') {
+      return this._send(length.toString(16) + '\r\n' + chunk + '\r\n');
+    }
+    this._send(length.toString(16) + '\r\n');
+    this._send(chunk);
+    return this._send('\r\n');
+  };
+
+  ServerResponse.prototype.write = function (chunk, encoding, callback) {
+    if (typeof encoding === 'function') {
+      callback = encoding;
+    }
+    if (this.writableEnded) {
+      throw new Error('write after end');
+    }
+    let isFlushed = true;
+    if (!this.headersSent) {
+      isFlushed = this._send(this._buildHead(-1));
+    }
+    if (this._hasBody && chunk !== undefined && chunk !== null) {
+      isFlushed = this._sendBody(chunk);
+    }
+    if (typeof callback === 'function') {
+      process.nextTick(callback);
+    }
+    if (!isFlushed && !this._needDrain) {
+      this._needDrain = true;
+      this.socket.once('drain', () => {
+        this._needDrain = false;
+        this.emit('drain');
+      });
+    }
+    return isFlushed;
+  };
+
+  ServerResponse.prototype.end = function (data, encoding, callback) {
+    if (typeof data === 'function') {
+      callback = data;
+      data = undefined;
+    } else if (typeof encoding === 'function') {
+      callback = encoding;
+    }
+    if (this.writableEnded) {
+      return this;
+    }
+    if (typeof callback === 'function') {
+      this.once('finish', callback);
+    }
+    const hasData = data !== undefined && data !== null;
+    if (!this.headersSent) {
+      // The head and a string body are sent with one write. The head may
+      // set Transfer-Encoding: chunked, so the body is framed after it is
+      // built.
+      const head = this._buildHead(hasData ? byteLength(data) : 0);
+      if (!hasData || !this._hasBody) {
+        this._send(head);
+      } else if (this._isChunked) {
+        this._send(head);
+        this._sendBody(data);
+      } else if (typeof data === 'string') {
+        this._send(head + data);
+      } else {
+        this._send(head);
+        this._send(data);
+      }
+    } else if (hasData) {
+      this.write(data);
+    }
+    if (this._isChunked && this._hasBody) {
+      this._send('0\r\n\r\n');
+    }
+    this.writableEnded = true;
+    this.finished = true;
+    if (this._isActive) {
+      this._connection.advance();
+    }
+    return this;
+  };
+
+  function Server(options, requestListener) {
+    if (!(this instanceof Server)) {
+      return new Server(options, requestListener);
+    }
+    EventEmitter.call(this);
+    if (typeof options === 'function') {
+      requestListener = options;
+      options = undefined;
+    }
+    this._connections = new Set();
+    this._server = net.createServer(
+        {noDelay: true}, (socket) => this._onConnection(socket));
+    this._server.on('listening', () => this.emit('listening'));
+    this._server.on('error', (error) => this.emit('error', error));
+    this._server.on('close', () => this.emit('close'));
+    if (typeof requestListener === 'function') {
+      this.on('request', requestListener);
+    }
+  }
+  inherits(Server, EventEmitter);
+
+  Object.defineProperty(Server.prototype, 'listening', {
+    get() {
+      return this._server.listening;
+    },
+  });
+
+  Server.prototype.listen = function () {
+    this._server.listen.apply(this._server, arguments);
+    // The server id is known before any connection is accepted.
+    if (this._server._id !== 0) {
+      binding.enableHttp(this._server._id);
+    }
+    return this;
+  };
+
+  // Stops accepting connections and closes the idle keep-alive connections.
+  Server.prototype.close = function (callback) {
+    this._server.close(callback);
+    this._connections.forEach((connection) => {
+      if (connection.responses.length === 0) {
+        connection.isClosing = true;
+        connection.socket.end();
+      }
+    });
+    return this;
+  };
+
+  Server.prototype.address = function () {
+    return this._server.address();
+  };
+
+  Server.prototype.ref = function () {
+    this._server.ref();
+    return this;
+  };
+
+  Server.prototype.unref = function () {
+    this._server.unref();
+    return this;
+  };
+
+  Server.prototype._onConnection = function (socket) {
+    const id = socket._id;
+    const connection = new Connection(this, socket);
+    connections.set(id, connection);
+    this._connections.add(connection);
+    socket.on('close', () => {
+      connections.delete(id);
+      this._connections.delete(connection);
+    });
+    socket.on('error', (error) => this.emit('clientError', error, socket));
+    this.emit('connection', socket);
+  };
+
+  binding.setCallbacks({
+    onRequest(id, method, url, head, flags, body) {
+      const connection = connections.get(id);
+      if (connection === undefined || connection.isClosing) {
+        return;
+      }
+      const req = new IncomingMessage(
+          connection.socket, method, url, head, flags);
+      const res = new ServerResponse(
+          connection, req, (flags & kKeepAlive) !== 0);
+      connection.request = req;
+      connection.responses.push(res);
+      if (connection.responses.length === 1) {
+        res._isActive = true;
+      }
+      if (body !== undefined) {
+        req._push(body);
+      }
+      if (flags & kComplete) {
+        req._push(null);
+      }
+      connection.server.emit('request', req, res);
+    },
+    onBody(id, chunk, isLast) {
+      const connection = connections.get(id);
+      if (connection === undefined || connection.request === null) {
+        return;
+      }
+      if (chunk !== undefined) {
+        connection.request._push(chunk);
+      }
+      if (isLast) {
+        connection.request._push(null);
+      }
+    },
+    onError(id, statusCode) {
+      const connection = connections.get(id);
+      if (connection !== undefined) {
+        connection.errorStatus = statusCode;
+        connection.advance();
+      }
+    },
+    onReset() {
+      connections.clear();
+    },
+  });
+
+  function createServer(options, requestListener) {
+    return new Server(options, requestListener);
+  }
+
+  return {
+    METHODS,
+    STATUS_CODES,
+    IncomingMessage,
+    Server,
+    ServerResponse,
+    createServer,
+  };
+})
+)JS";
+
+}  // namespace node_api_tests
@@ -0,0 +1,186 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// HTTP/1.1 request parsing for the "http" built-in module.
+
+#ifndef NODE_API_TEST_NODE_LITE_HTTP_H
+#define NODE_API_TEST_NODE_LITE_HTTP_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+class NodeLiteNet;
+
+// An incremental HTTP/1.1 request parser that does not allocate. The parsed
+// fields are views of the parsed data.
+class NodeLiteHttpParser {
+ public:
+  // The requests with larger heads are rejected.
+  static constexpr size_t kMaxHeadSize = 64 * 1024;
+
+  enum class Result {
+    kComplete,
+    kIncomplete,
+    kError,
+    // The request head is longer than kMaxHeadSize.
+    kTooLarge,
+  };
+
+  struct RequestHead {
+    std::string_view method;
+    std::string_view target;
+    // The request line and the header lines without the final empty line.
+    std::string_view header_block;
+    // The size of the head including the final empty line.
+    size_t size{};
+    uint64_t content_length{};
+    uint8_t version_minor{};
+    bool keep_alive{};
+    bool is_chunked{};
+  };
+
+  // Parses a request head from the start of the data. Only the first
+  // kMaxHeadSize bytes are scanned for the end of the head.
+  static Result ParseRequestHead(std::string_view data, RequestHead& head);
+
+  // Calls the callback for each header line of the header block.
+  template <typename TCallback>
+  static void ForEachHeader(std::string_view header_block,
+                            TCallback&& callback);
+
+  // Decodes the chunked transfer coding incrementally. Returns the number of
+  // consumed bytes and sets the data of the next body chunk.
+  class ChunkedDecoder {
+   public:
+    Result Decode(std::string_view input,
+                  std::string_view& chunk,
+                  size_t& consumed) noexcept;
+
+   private:
+    enum class State {
+      kSize,
+      kSizeExtension,
+      kSizeLf,
+      kData,
+      kDataCr,
+      kDataLf,
+      kTrailer,
+      kTrailerLf,
+      kTrailerLine,
+    };
+
+    State state_{State::kSize};
+    uint64_t remaining_{};
+    bool has_size_digits_{};
+  };
+};
+
+// The HTTP state of a TCP connection accepted by an HTTP server. It parses
+// the received data in place and passes the requests to JS.
+class NodeLiteHttpConnection {
+ public:
+  NodeLiteHttpConnection(NodeLiteNet& net, uint32_t socket_id) noexcept;
+
+  // Parses the data of one read. The data is in the current read slab of the
+  // NodeLiteNet, so the JS views of the request heads and bodies refer to it
+  // without copying. Only an incomplete head is copied to be completed by
+  // the next read.
+  void OnData(const char* data, size_t size);
+
+ private:
+  enum class State {
+    kHead,
+    kBody,
+    kChunkedBody,
+    kError,
+  };
+
+  // Returns false if the socket was closed by JS.
+  bool OnHead(const NodeLiteHttpParser::RequestHead& head,
+              napi_value head_view,
+              const char*& data,
+              size_t& size);
+  bool OnBody(const char*& data, size_t& size);
+  bool OnChunkedBody(const char*& data, size_t& size);
+  void OnError(uint32_t status_code);
+  bool IsOpen() noexcept;
+
+ private:
+  NodeLiteNet& net_;
+  uint32_t socket_id_;
+  State state_{State::kHead};
+  uint64_t body_remaining_{};
+  NodeLiteHttpParser::ChunkedDecoder chunked_decoder_;
+  // The head of a request that is split between reads.
+  std::string pending_head_;
+};
+
+// The native part of the "http" module.
+class NodeLiteHttp {
+ public:
+  // The JS callbacks set by the http module.
+  enum class Callback : size_t {
+    kOnRequest,
+    kOnBody,
+    kOnError,
+    kOnReset,
+    kCount,
+  };
+
+  // The JS source of the module function. It receives the binding object and
+  // the require function and returns the module exports.
+  static const std::string_view kModuleSource;
+
+  explicit NodeLiteHttp(NodeLiteNet& net) noexcept;
+
+  napi_value CreateBinding(napi_env env);
+
+  // Returns the method string. The common methods are cached.
+  napi_value GetMethodString(napi_env env, std::string_view method);
+
+  void CallJS(Callback callback, span<napi_value> args);
+
+ private:
+  NodeLiteNet& net_;
+  NodeApiRef callbacks_[static_cast<size_t>(Callback::kCount)];
+  // An array with the strings of the common methods.
+  NodeApiRef method_strings_;
+};
+
+template <typename TCallback>
+/*static*/ void NodeLiteHttpParser::ForEachHeader(std::string_view header_block,
+                                                  TCallback&& callback) {
+  // Skip the request line.
+  size_t pos = header_block.find('\n');
+  while (pos != std::string_view::npos && pos + 1 < header_block.size()) {
+    size_t line_start = pos + 1;
+    pos = header_block.find('\n', line_start);
+    std::string_view line = header_block.substr(
+        line_start,
+        (pos == std::string_view::npos ? header_block.size() : pos) -
+            line_start);
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) {
+      continue;
+    }
+    std::string_view value = line.substr(colon + 1);
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+      value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+      value.remove_suffix(1);
+    }
+    callback(line.substr(0, colon), value);
+  }
+}
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_HTTP_H
@@ -0,0 +1,698 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_json.h"
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "node_lite_cpu.h"
+#include "node_lite_text.h"
+
+namespace fs = std::filesystem;
+
+namespace node_api_tests {
+
+namespace {
+
+// The object members are defined like JSON.parse does it.
+constexpr napi_property_attributes kMemberAttributes =
+    static_cast<napi_property_attributes>(napi_writable | napi_enumerable |
+                                          napi_configurable);
+
+// The integers with up to this number of digits are exact in a double.
+constexpr size_t kMaxExactDigits = 15;
+
+// The member names are cached in a direct-mapped table of this size.
+constexpr size_t kNameCacheSize = 1024;
+
+// The longer member names are not cached.
+constexpr size_t kMaxCachedNameLength = 64;
+
+constexpr std::string_view kUtf8Bom = "\xEF\xBB\xBF";
+
+inline bool IsDigit(char c) noexcept {
+  return c >= '0' && c <= '9';
+}
+
+// Returns the value of a hex digit or -1.
+inline int32_t GetHexDigitValue(char c) noexcept {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Appends UTF-8 text to UTF-16 text. Each maximal invalid subsequence is
+// replaced with U+FFFD like in TextDecoder.
+void AppendUtf8(const char* data,
+                size_t size,
+                bool has_non_ascii,
+                std::u16string& text) {
+  if (!has_non_ascii) {
+    text.append(data, data + size);
+    return;
+  }
+  size_t text_size = text.size();
+  text.resize(text_size + size);
+  text.resize(text_size +
+              NodeLiteUtf8::DecodeToUtf16(data, size, &text[text_size]));
+}
+
+// Returns the value of a valid JSON number that is out of the double range:
+// infinity for the large numbers and zero for the small ones.
+double GetOutOfRangeNumber(std::string_view number) noexcept {
+  bool is_negative = !number.empty() && number[0] == '-';
+  // The decimal exponent of the first non-zero digit.
+  int64_t exponent = 0;
+  bool has_point = false;
+  bool has_digit = false;
+  size_t i = is_negative ? 1 : 0;
+  for (; i < number.size() && number[i] != 'e' && number[i] != 'E'; ++i) {
+    if (number[i] == '.') {
+      has_point = true;
+    } else if (has_digit) {
+      exponent += has_point ? 0 : 1;
+    } else if (number[i] != '0') {
+      has_digit = true;
+      exponent -= has_point ? 1 : 0;
+    } else if (has_point) {
+      --exponent;
+    }
+  }
+  if (i < number.size()) {
+    int64_t exponent_part = 0;
+    bool is_negative_exponent = number[++i] == '-';
+    if (number[i] == '-' || number[i] == '+') {
+      ++i;
+    }
+    for (; i < number.size() && exponent_part < INT32_MAX; ++i) {
+      exponent_part = exponent_part * 10 + (number[i] - '0');
+    }
+    exponent += is_negative_exponent ? -exponent_part : exponent_part;
+  }
+  double result = has_digit && exponent > 0
+                      ? std::numeric_limits<double>::infinity()
+                      : 0.0;
+  return is_negative ? -result : result;
+}
+
+size_t FindStringEndScalar(const char* data,
+                           size_t size,
+                           size_t pos,
+                           bool& has_non_ascii) noexcept {
+  uint8_t all_bits = 0;
+  for (; pos < size; ++pos) {
+    uint8_t c = static_cast<uint8_t>(data[pos]);
+    if (c == '"' || c == '\\' || c < 0x20) {
+      break;
+    }
+    all_bits |= c;
+  }
+  has_non_ascii = has_non_ascii || (all_bits & 0x80) != 0;
+  return pos;
+}
+
+#ifdef NODE_LITE_X64
+
+inline uint32_t CountTrailingZeros(uint32_t value) noexcept {
+#ifdef _MSC_VER
+  unsigned long index{};
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+}
+
+// Adds the non-ASCII bytes of a block before its first string end.
+// Returns the string end position or SIZE_MAX if the block has no end.
+inline size_t FindBlockStringEnd(size_t block_pos,
+                                 uint32_t end_mask,
+                                 uint32_t non_ascii_mask,
+                                 bool& has_non_ascii) noexcept {
+  if (end_mask == 0) {
+    has_non_ascii = has_non_ascii || non_ascii_mask != 0;
+    return SIZE_MAX;
+  }
+  uint32_t bit = CountTrailingZeros(end_mask);
+  has_non_ascii =
+      has_non_ascii || (non_ascii_mask & ((uint32_t{1} << bit) - 1)) != 0;
+  return block_pos + bit;
+}
+
+size_t FindStringEndSse2(const char* data,
+                         size_t size,
+                         size_t pos,
+                         bool& has_non_ascii) noexcept {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i max_control = _mm_set1_epi8(0x1F);
+  for (; pos + 16 <= size; pos += 16) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+    // The bytes that are not above 0x1F as unsigned are control characters.
+    __m128i is_end = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                     _mm_cmpeq_epi8(block, backslash)),
+        _mm_cmpeq_epi8(_mm_max_epu8(block, max_control), max_control));
+    size_t end = FindBlockStringEnd(
+        pos,
+        static_cast<uint32_t>(_mm_movemask_epi8(is_end)),
+        static_cast<uint32_t>(_mm_movemask_epi8(block)),
+        has_non_ascii);
+    if (end != SIZE_MAX) {
+      return end;
+    }
+  }
+  return FindStringEndScalar(data, size, pos, has_non_ascii);
+}
+
+NODE_LITE_TARGET("avx2")
+size_t FindStringEndAvx2(const char* data,
+                         size_t size,
+                         size_t pos,
+                         bool& has_non_ascii) noexcept {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i max_control = _mm256_set1_epi8(0x1F);
+  for (; pos + 32 <= size; pos += 32) {
+    __m256i block =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+    __m256i is_end = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, quote),
+                        _mm256_cmpeq_epi8(block, backslash)),
+        _mm256_cmpeq_epi8(_mm256_max_epu8(block, max_control), max_control));
+    size_t end = FindBlockStringEnd(
+        pos,
+        static_cast<uint32_t>(_mm256_movemask_epi8(is_end)),
+        static_cast<uint32_t>(_mm256_movemask_epi8(block)),
+        has_non_ascii);
+    if (end != SIZE_MAX) {
+      return end;
+    }
+  }
+  return FindStringEndSse2(data, size, pos, has_non_ascii);
+}
+
+#endif  // NODE_LITE_X64
+
+// Parses JSON text without recursion. The members of the open objects and
+// the elements of the open arrays are kept in two stacks. Each object or
+// array is created when it ends. Each array has its own escapable handle
+// scope, so the handles of its items are released when it ends. The objects
+// use the scope of their array: the sibling objects such as the records of an
+// array share the cached strings of their member names.
+class JsonParser {
+ public:
+  JsonParser(napi_env env,
+             std::string_view text,
+             const std::string& source_name) noexcept
+      : env_(env),
+        data_(text.data()),
+        size_(text.size()),
+        source_name_(source_name) {}
+
+  // Closes the handle scopes left open by a syntax error.
+  ~JsonParser() {
+    for (auto it = containers_.rbegin(); it != containers_.rend(); ++it) {
+      if (it->scope != nullptr) {
+        napi_close_escapable_handle_scope(env_, it->scope);
+      }
+    }
+  }
+
+  JsonParser(const JsonParser&) = delete;
+  JsonParser& operator=(const JsonParser&) = delete;
+
+  napi_value Parse() {
+    for (;;) {
+      SkipWhitespace();
+      napi_value value{};
+      char c = Peek();
+      if (c == '{' || c == '[') {
+        ++pos_;
+        OpenContainer(c == '{');
+        SkipWhitespace();
+        if (c == '{' && !TryConsume('}')) {
+          ParseMemberName();
+          continue;
+        }
+        if (c == '[' && !TryConsume(']')) {
+          continue;
+        }
+        value = CloseContainer();
+      } else {
+        value = ParsePrimitive();
+      }
+
+      // Add the value to its container and close the containers that end
+      // after it.
+      for (;;) {
+        if (containers_.empty()) {
+          SkipWhitespace();
+          if (pos_ < size_) {
+            ThrowUnexpectedToken();
+          }
+          return value;
+        }
+        bool is_object = containers_.back().is_object;
+        if (is_object) {
+          members_.back().value = value;
+        } else {
+          elements_.push_back(value);
+        }
+        SkipWhitespace();
+        if (TryConsume(',')) {
+          if (is_object) {
+            SkipWhitespace();
+            ParseMemberName();
+          }
+          break;
+        }
+        if (!TryConsume(is_object ? '}' : ']')) {
+          ThrowUnexpectedToken();
+        }
+        value = CloseContainer();
+      }
+    }
+  }
+
+ private:
+  struct Container {
+    // The objects have no own scope.
+    napi_escapable_handle_scope scope;
+    // The index of the first member or element in its stack.
+    size_t first_item;
+    bool is_object;
+  };
+
+  struct CachedName {
+    std::string_view text;
+    napi_value value;
+    // The value is valid while its handle scope is open.
+    size_t scope_level;
+    uint64_t scope_id;
+  };
+
+  char Peek() const noexcept { return pos_ < size_ ? data_[pos_] : '\0'; }
+
+  bool TryConsume(char c) noexcept {
+    if (pos_ < size_ && data_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  void SkipWhitespace() noexcept {
+    for (; pos_ < size_; ++pos_) {
+      char c = data_[pos_];
+      if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+        return;
+      }
+    }
+  }
+
+  void OpenContainer(bool is_object) {
+    napi_env env = env_;
+    if (containers_.size() >= NodeLiteJson::kMaxDepth) {
+      ThrowSyntaxError("Maximum nesting depth exceeded", pos_ - 1);
+    }
+    napi_escapable_handle_scope scope{};
+    if (!is_object) {
+      NODE_LITE_CALL(napi_open_escapable_handle_scope(env, &scope));
+      scope_ids_.push_back(next_scope_id_++);
+    }
+    containers_.push_back(Container{
+        scope, is_object ? members_.size() : elements_.size(), is_object});
+  }
+
+  napi_value CloseContainer() {
+    napi_env env = env_;
+    Container container = containers_.back();
+    napi_value result{};
+    if (container.is_object) {
+      NODE_LITE_CALL(napi_create_object(env, &result));
+      size_t count = members_.size() - container.first_item;
+      if (count > 0) {
+        NODE_LITE_CALL(napi_define_properties(
+            env, result, count, members_.data() + container.first_item));
+      }
+      members_.resize(container.first_item);
+    } else {
+      size_t count = elements_.size() - container.first_item;
+      NODE_LITE_CALL(napi_create_array_with_length(env, count, &result));
+      for (size_t i = 0; i < count; ++i) {
+        NODE_LITE_CALL(napi_set_element(env,
+                                        result,
+                                        static_cast<uint32_t>(i),
+                                        elements_[container.first_item + i]));
+      }
+      elements_.resize(container.first_item);
+    }
+    containers_.pop_back();
+    if (container.scope == nullptr) {
+      return result;
+    }
+    napi_value escaped{};
+    napi_status status =
+        napi_escape_handle(env, container.scope, result, &escaped);
+    scope_ids_.pop_back();
+    NODE_LITE_CALL(napi_close_escapable_handle_scope(env, container.scope));
+    NODE_LITE_CALL(status);
+    return escaped;
+  }
+
+  // Parses the member name and the colon after it. Its value is set when it
+  // is parsed.
+  void ParseMemberName() {
+    if (!TryConsume('"')) {
+      ThrowUnexpectedToken();
+    }
+    napi_property_descriptor& member = members_.emplace_back();
+    member.attributes = kMemberAttributes;
+    member.name = ParseName();
+    SkipWhitespace();
+    if (!TryConsume(':')) {
+      ThrowUnexpectedToken();
+    }
+  }
+
+  // Parses a member name after its opening quote. The short names without
+  // escapes are reused while their handle scope is open.
+  napi_value ParseName() {
+    size_t start = pos_;
+    bool has_non_ascii = false;
+    size_t end =
+        NodeLiteJson::FindStringEnd(data_, size_, start, has_non_ascii);
+    if (end >= size_ || data_[end] != '"' ||
+        end - start > kMaxCachedNameLength) {
+      return ParseString();
+    }
+    std::string_view text(data_ + start, end - start);
+    CachedName& cached =
+        name_cache_[std::hash<std::string_view>{}(text) % kNameCacheSize];
+    if (cached.value == nullptr || cached.text != text ||
+        cached.scope_level >= scope_ids_.size() ||
+        scope_ids_[cached.scope_level] != cached.scope_id) {
+      cached = CachedName{text,
+                          CreateString(start, end, has_non_ascii),
+                          scope_ids_.size() - 1,
+                          scope_ids_.back()};
+    }
+    pos_ = end + 1;
+    return cached.value;
+  }
+
+  napi_value ParsePrimitive() {
+    napi_env env = env_;
+    napi_value result{};
+    switch (Peek()) {
+      case '"':
+        ++pos_;
+        return ParseString();
+      case 't':
+        ParseLiteral("true");
+        NODE_LITE_CALL(napi_get_boolean(env, true, &result));
+        return result;
+      case 'f':
+        ParseLiteral("false");
+        NODE_LITE_CALL(napi_get_boolean(env, false, &result));
+        return result;
+      case 'n':
+        ParseLiteral("null");
+        NODE_LITE_CALL(napi_get_null(env, &result));
+        return result;
+      default:
+        if (Peek() == '-' || IsDigit(Peek())) {
+          return ParseNumber();
+        }
+        ThrowUnexpectedToken();
+    }
+  }
+
+  void ParseLiteral(std::string_view literal) {
+    for (char c : literal) {
+      if (!TryConsume(c)) {
+        ThrowUnexpectedToken();
+      }
+    }
+  }
+
+  napi_value ParseNumber() {
+    napi_env env = env_;
+    size_t start = pos_;
+    bool is_negative = TryConsume('-');
+    uint64_t integer = 0;
+    size_t digits_start = pos_;
+    if (!TryConsume('0')) {
+      if (!IsDigit(Peek())) {
+        ThrowUnexpectedToken();
+      }
+      for (; IsDigit(Peek()); ++pos_) {
+        integer = integer * 10 + (data_[pos_] - '0');
+      }
+    }
+    size_t digit_count = pos_ - digits_start;
+    bool is_integer = true;
+    if (TryConsume('.')) {
+      is_integer = false;
+      SkipDigits();
+    }
+    if (Peek() == 'e' || Peek() == 'E') {
+      is_integer = false;
+      ++pos_;
+      if (Peek() == '+' || Peek() == '-') {
+        ++pos_;
+      }
+      SkipDigits();
+    }
+
+    double value{};
+    if (is_integer && digit_count <= kMaxExactDigits) {
+      value = static_cast<double>(integer);
+      value = is_negative ? -value : value;
+    } else {
+      auto [ptr, ec] =
+          std::from_chars(data_ + start, data_ + pos_, value);
+      if (ec == std::errc::result_out_of_range) {
+        value = GetOutOfRangeNumber(
+            std::string_view(data_ + start, pos_ - start));
+      } else if (ec != std::errc{} || ptr != data_ + pos_) {
+        ThrowSyntaxError("Invalid number", start);
+      }
+    }
+    napi_value result{};
+    NODE_LITE_CALL(napi_create_double(env, value, &result));
+    return result;
+  }
+
+  // Skips one or more digits.
+  void SkipDigits() {
+    if (!IsDigit(Peek())) {
+      ThrowUnexpectedToken();
+    }
+    while (IsDigit(Peek())) {
+      ++pos_;
+    }
+  }
+
+  // Parses a string after its opening quote. The strings without escapes
+  // are created from the input bytes: the ASCII strings as Latin-1 without
+  // UTF-8 decoding.
+  napi_value ParseString() {
+    size_t start = pos_;
+    bool has_non_ascii = false;
+    size_t end =
+        NodeLiteJson::FindStringEnd(data_, size_, start, has_non_ascii);
+    if (end >= size_ || data_[end] != '"') {
+      return ParseEscapedString(start, end, has_non_ascii);
+    }
+    pos_ = end + 1;
+    return CreateString(start, end, has_non_ascii);
+  }
+
+  napi_value CreateString(size_t start, size_t end, bool has_non_ascii) {
+    napi_env env = env_;
+    napi_value result{};
+    if (has_non_ascii) {
+      NODE_LITE_CALL(
+          napi_create_string_utf8(env, data_ + start, end - start, &result));
+    } else {
+      NODE_LITE_CALL(
+          napi_create_string_latin1(env, data_ + start, end - start, &result));
+    }
+    return result;
+  }
+
+  // Decodes a string with escapes to UTF-16. The \u escapes are copied as
+  // they are, so the unpaired surrogates are kept like in JSON.parse.
+  napi_value ParseEscapedString(size_t start, size_t end, bool has_non_ascii) {
+    napi_env env = env_;
+    escaped_text_.clear();
+    for (;;) {
+      AppendUtf8(data_ + start, end - start, has_non_ascii, escaped_text_);
+      pos_ = end;
+      if (TryConsume('"')) {
+        break;
+      }
+      if (!TryConsume('\\')) {
+        ThrowUnexpectedToken();
+      }
+      ParseEscape();
+      start = pos_;
+      has_non_ascii = false;
+      end = NodeLiteJson::FindStringEnd(data_, size_, start, has_non_ascii);
+    }
+    napi_value result{};
+    NODE_LITE_CALL(napi_create_string_utf16(
+        env, escaped_text_.data(), escaped_text_.size(), &result));
+    return result;
+  }
+
+  // Parses an escape sequence after its backslash.
+  void ParseEscape() {
+    switch (Peek()) {
+      case '"':
+      case '\\':
+      case '/':
+        escaped_text_.push_back(data_[pos_]);
+        break;
+      case 'b':
+        escaped_text_.push_back(u'\b');
+        break;
+      case 'f':
+        escaped_text_.push_back(u'\f');
+        break;
+      case 'n':
+        escaped_text_.push_back(u'\n');
+        break;
+      case 'r':
+        escaped_text_.push_back(u'\r');
+        break;
+      case 't':
+        escaped_text_.push_back(u'\t');
+        break;
+      case 'u': {
+        uint32_t code_unit = 0;
+        for (size_t i = 0; i < 4; ++i) {
+          ++pos_;
+          int32_t digit = GetHexDigitValue(Peek());
+          if (digit < 0) {
+            ThrowUnexpectedToken();
+          }
+          code_unit = (code_unit << 4) | static_cast<uint32_t>(digit);
+        }
+        escaped_text_.push_back(static_cast<char16_t>(code_unit));
+        break;
+      }
+      default:
+        ThrowUnexpectedToken();
+    }
+    ++pos_;
+  }
+
+  [[noreturn]] void ThrowUnexpectedToken() {
+    if (pos_ >= size_) {
+      ThrowError("Unexpected end of JSON input");
+    }
+    uint8_t c = static_cast<uint8_t>(data_[pos_]);
+    if (c >= 0x20 && c < 0x7F) {
+      ThrowSyntaxError(FormatString("Unexpected token '%c'", c), pos_);
+    }
+    ThrowSyntaxError(FormatString("Unexpected byte 0x%02X", c), pos_);
+  }
+
+  [[noreturn]] void ThrowSyntaxError(const std::string& message,
+                                     size_t position) {
+    ThrowError(message + " in JSON at position " + std::to_string(position));
+  }
+
+  [[noreturn]] void ThrowError(const std::string& message) {
+    std::string error_message =
+        source_name_.empty() ? message : source_name_ + ": " + message;
+    throw NodeLiteException(napi_generic_failure, error_message.c_str());
+  }
+
+ private:
+  napi_env env_;
+  const char* data_;
+  size_t size_;
+  size_t pos_{0};
+  const std::string& source_name_;
+  std::vector<Container> containers_;
+  std::vector<napi_property_descriptor> members_;
+  std::vector<napi_value> elements_;
+  std::u16string escaped_text_;
+  // The IDs of the open handle scopes. The first one is the caller scope.
+  std::vector<uint64_t> scope_ids_{0};
+  uint64_t next_scope_id_{1};
+  std::vector<CachedName> name_cache_ =
+      std::vector<CachedName>(kNameCacheSize);
+};
+
+}  // namespace
+
+//=============================================================================
+// NodeLiteJson implementation
+//=============================================================================
+
+/*static*/ napi_value NodeLiteJson::Parse(napi_env env,
+                                          std::string_view text,
+                                          const std::string& source_name) {
+  return JsonParser(env, text, source_name).Parse();
+}
+
+/*static*/ napi_value NodeLiteJson::ParseFile(napi_env env,
+                                              const fs::path& file_path) {
+  std::error_code error_code;
+  uintmax_t file_size = fs::file_size(file_path, error_code);
+  NODE_LITE_ASSERT(!error_code,
+                   "Failed to read file %s: %s",
+                   file_path.string().c_str(),
+                   error_code.message().c_str());
+  if (file_size == 0) {
+    return Parse(env, std::string_view{}, file_path.string());
+  }
+  size_t size{};
+  std::string error;
+  const void* data = NodeLitePlatform::MapFile(file_path, size, error);
+  NODE_LITE_ASSERT(data != nullptr,
+                   "Failed to map file %s: %s",
+                   file_path.string().c_str(),
+                   error.c_str());
+  std::unique_ptr<const void, NodeLiteMappedFileDeleter> mapping{
+      data, NodeLiteMappedFileDeleter{size}};
+  std::string_view text(static_cast<const char*>(data), size);
+  if (text.substr(0, kUtf8Bom.size()) == kUtf8Bom) {
+    text.remove_prefix(kUtf8Bom.size());
+  }
+  return Parse(env, text, file_path.string());
+}
+
+/*static*/ size_t NodeLiteJson::FindStringEnd(const char* data,
+                                              size_t size,
+                                              size_t position,
+                                              bool& has_non_ascii) noexcept {
+#ifdef NODE_LITE_X64
+  static const auto find_string_end = NodeLiteCpuFeatures::Get().has_avx2
+                                          ? FindStringEndAvx2
+                                          : FindStringEndSse2;
+  return find_string_end(data, size, position, has_non_ascii);
+#else
+  return FindStringEndScalar(data, size, position, has_non_ascii);
+#endif
+}
+
+}  // namespace node_api_tests
@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Native JSON parsing for fs.readJSONSync and the required .json files.
+
+#ifndef NODE_API_TEST_NODE_LITE_JSON_H
+#define NODE_API_TEST_NODE_LITE_JSON_H
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+// Parses UTF-8 JSON text straight into JS values. The text is never copied
+// into a JS string: the strings without escapes are created from the input
+// bytes, the arrays from their collected elements with one allocation, and
+// the objects with one napi_define_properties call per object.
+class NodeLiteJson {
+ public:
+  // Deeper JSON is rejected.
+  static constexpr size_t kMaxDepth = 1024;
+
+  // Parses the text. The source name prefixes the syntax error messages.
+  static napi_value Parse(napi_env env,
+                          std::string_view text,
+                          const std::string& source_name);
+
+  // Maps the file and parses it. A leading UTF-8 BOM is skipped.
+  static napi_value ParseFile(napi_env env,
+                              const std::filesystem::path& file_path);
+
+  // Returns the position of the first '"', '\\', or control character from
+  // the position, or the size if there is none. Uses SSE2 or AVX2 on x64.
+  // Sets has_non_ascii if any of the skipped bytes is not ASCII.
+  static size_t FindStringEnd(const char* data,
+                              size_t size,
+                              size_t position,
+                              bool& has_non_ascii) noexcept;
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_JSON_H
@@ -0,0 +1,1496 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_net.h"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <string>
+#include "node_lite_http.h"
+
+namespace node_api_tests {
+
+namespace {
+
+// The number of epoll events handled by one epoll_wait call.
+constexpr int kMaxEvents = 256;
+// A readable socket is read at most this many times per event, so that one
+// busy connection does not starve the others.
+constexpr int kMaxReadsPerEvent = 4;
+constexpr int kMaxAcceptsPerEvent = 128;
+// The queued writes are sent with one sendmsg call up to this many chunks.
+constexpr size_t kMaxWriteChunks = 64;
+// Small writes are appended to the last queued chunk up to this size.
+constexpr size_t kMaxCoalescedChunkSize = 64 * 1024;
+
+// Returns the errno name such as "ECONNREFUSED" for the error.code property.
+const char* GetErrorCode(int error_code) noexcept {
+  switch (error_code) {
+    case EADDRINUSE:
+      return "EADDRINUSE";
+    case EADDRNOTAVAIL:
+      return "EADDRNOTAVAIL";
+    case EACCES:
+      return "EACCES";
+    case ECONNREFUSED:
+      return "ECONNREFUSED";
+    case ECONNRESET:
+      return "ECONNRESET";
+    case ECONNABORTED:
+      return "ECONNABORTED";
+    case EHOSTUNREACH:
+      return "EHOSTUNREACH";
+    case ENETUNREACH:
+      return "ENETUNREACH";
+    case EPIPE:
+      return "EPIPE";
+    case ETIMEDOUT:
+      return "ETIMEDOUT";
+    case EMFILE:
+      return "EMFILE";
+    default:
+      return "EIO";
+  }
+}
+
+// Formats the error message like Node.js: "connect ECONNREFUSED: ...".
+std::string FormatSystemError(const char* syscall, int error_code) {
+  return std::string(syscall) + " " + GetErrorCode(error_code) + ": " +
+         std::strerror(error_code);
+}
+
+[[noreturn]] void ThrowSystemError(const char* syscall, int error_code) {
+  throw NodeLiteException(napi_generic_failure,
+                          FormatSystemError(syscall, error_code).c_str());
+}
+
+napi_value CreateAddressObject(napi_env env, const sockaddr_storage& address) {
+  char host[INET6_ADDRSTRLEN]{};
+  uint16_t port{};
+  const char* family = "IPv4";
+  if (address.ss_family == AF_INET6) {
+    const sockaddr_in6& address6 =
+        reinterpret_cast<const sockaddr_in6&>(address);
+    ::inet_ntop(AF_INET6, &address6.sin6_addr, host, sizeof(host));
+    port = ntohs(address6.sin6_port);
+    family = "IPv6";
+  } else {
+    const sockaddr_in& address4 = reinterpret_cast<const sockaddr_in&>(address);
+    ::inet_ntop(AF_INET, &address4.sin_addr, host, sizeof(host));
+    port = ntohs(address4.sin_port);
+  }
+  napi_value result = NodeApi::CreateObject(env);
+  NodeApi::SetPropertyString(env, result, "address", host);
+  NodeApi::SetPropertyString(env, result, "family", family);
+  NodeApi::SetPropertyUInt32(env, result, "port", port);
+  return result;
+}
+
+struct AddrInfoDeleter {
+  void operator()(addrinfo* info) const noexcept { ::freeaddrinfo(info); }
+};
+
+// Host names are resolved synchronously. It is fast for the IP addresses and
+// "localhost" used by the local services.
+std::unique_ptr<addrinfo, AddrInfoDeleter> ResolveAddress(
+    const std::string& host, uint16_t port, bool is_passive) {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_NUMERICSERV | (is_passive ? AI_PASSIVE : 0);
+  std::string port_str = std::to_string(port);
+  addrinfo* result{};
+  int status = ::getaddrinfo(host.empty() ? nullptr : host.c_str(),
+                             port_str.c_str(),
+                             &hints,
+                             &result);
+  if (status != 0) {
+    std::string message =
+        "getaddrinfo ENOTFOUND " + host + ": " + ::gai_strerror(status);
+    throw NodeLiteException(napi_generic_failure, message.c_str());
+  }
+  return std::unique_ptr<addrinfo, AddrInfoDeleter>(result);
+}
+
+}  // namespace
+
+//=============================================================================
+// NodeLiteReactor implementation
+//=============================================================================
+
+/*static*/ std::unique_ptr<NodeLiteReactor> NodeLiteReactor::Create() {
+  int epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    return nullptr;
+  }
+  int wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wake_fd < 0) {
+    ::close(epoll_fd);
+    return nullptr;
+  }
+  // The wake event has no handler.
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) != 0) {
+    ::close(wake_fd);
+    ::close(epoll_fd);
+    return nullptr;
+  }
+  return std::unique_ptr<NodeLiteReactor>(
+      new NodeLiteReactor(epoll_fd, wake_fd));
+}
+
+NodeLiteReactor::NodeLiteReactor(int epoll_fd, int wake_fd) noexcept
+    : epoll_fd_(epoll_fd), wake_fd_(wake_fd) {}
+
+NodeLiteReactor::~NodeLiteReactor() {
+  ::close(wake_fd_);
+  ::close(epoll_fd_);
+}
+
+bool NodeLiteReactor::Add(int fd, uint32_t events, Handler* handler) noexcept {
+  epoll_event event{};
+  event.events = events;
+  event.data.ptr = handler;
+  return ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+bool NodeLiteReactor::Modify(int fd,
+                             uint32_t events,
+                             Handler* handler) noexcept {
+  epoll_event event{};
+  event.events = events;
+  event.data.ptr = handler;
+  return ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void NodeLiteReactor::Remove(int fd) noexcept {
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void NodeLiteReactor::AddPendingHandler(Handler* handler) {
+  pending_handlers_.push_back(handler);
+}
+
+void NodeLiteReactor::RemovePendingHandler(Handler* handler) noexcept {
+  std::replace(pending_handlers_.begin(),
+               pending_handlers_.end(),
+               handler,
+               static_cast<Handler*>(nullptr));
+  std::replace(running_pending_handlers_.begin(),
+               running_pending_handlers_.end(),
+               handler,
+               static_cast<Handler*>(nullptr));
+}
+
+void NodeLiteReactor::DeleteLater(std::unique_ptr<Handler> handler) {
+  retired_handlers_.push_back(std::move(handler));
+}
+
+bool NodeLiteReactor::Poll(int32_t timeout_ms) {
+  bool has_callbacks = false;
+  // The writes queued by the previous JS code are sent before the wait.
+  if (!pending_handlers_.empty()) {
+    running_pending_handlers_.swap(pending_handlers_);
+    for (size_t i = 0; i < running_pending_handlers_.size(); ++i) {
+      if (Handler* handler = running_pending_handlers_[i]) {
+        handler->OnIoEvents(kPendingEvent);
+      }
+    }
+    running_pending_handlers_.clear();
+    has_callbacks = true;
+    timeout_ms = 0;
+  }
+
+  epoll_event events[kMaxEvents];
+  int event_count = ::epoll_wait(epoll_fd_, events, kMaxEvents, timeout_ms);
+  for (int i = 0; i < event_count; ++i) {
+    Handler* handler = static_cast<Handler*>(events[i].data.ptr);
+    if (handler == nullptr) {
+      uint64_t value{};
+      [[maybe_unused]] ssize_t result = ::read(wake_fd_, &value, sizeof(value));
+      continue;
+    }
+    handler->OnIoEvents(events[i].events);
+    has_callbacks = true;
+  }
+  retired_handlers_.clear();
+  return has_callbacks;
+}
+
+void NodeLiteReactor::Wake() noexcept {
+  uint64_t value = 1;
+  [[maybe_unused]] ssize_t result = ::write(wake_fd_, &value, sizeof(value));
+}
+
+//=============================================================================
+// NodeLiteTcpHandle implementation
+//=============================================================================
+
+// A listening TCP server or a TCP connection.
+class NodeLiteTcpHandle : public NodeLiteReactor::Handler {
+ public:
+  enum class Kind {
+    kServer,
+    kSocket,
+  };
+
+  NodeLiteTcpHandle(NodeLiteNet& net, int fd, Kind kind) noexcept
+      : net_(net), fd_(fd), kind_(kind) {}
+
+  ~NodeLiteTcpHandle() override {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  uint32_t id() const noexcept { return id_; }
+  void set_id(uint32_t id) noexcept { id_ = id; }
+  Kind kind() const noexcept { return kind_; }
+
+  // Starts receiving the events of an accepted, connecting, or listening
+  // socket. Reports the error asynchronously if the connect failed.
+  void Start(bool is_connecting, int connect_error) {
+    is_connecting_ = is_connecting;
+    pending_error_ = connect_error;
+    if (fd_ >= 0) {
+      net_.reactor().Add(fd_, GetEvents(), this);
+    }
+    net_.reactor().RefHandle();
+    if (pending_error_ != 0) {
+      SchedulePending();
+    }
+  }
+
+  void OnIoEvents(uint32_t events) override {
+    napi_env env = net_.env();
+    ReportOnException(env, [this, env, events]() {
+      // The handle may be closed by an earlier event of the same Poll.
+      if (is_closed_) {
+        return;
+      }
+      NodeApiHandleScope scope{env};
+      if (events == NodeLiteReactor::kPendingEvent) {
+        is_pending_ = false;
+        if (pending_error_ != 0) {
+          CloseWithError("connect", pending_error_);
+        } else {
+          Flush();
+        }
+        return;
+      }
+      if (kind_ == Kind::kServer) {
+        Accept();
+        return;
+      }
+      if (is_connecting_) {
+        OnConnected(events);
+        return;
+      }
+      if ((events & EPOLLERR) != 0) {
+        int error_code{};
+        socklen_t length = sizeof(error_code);
+        ::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error_code, &length);
+        CloseWithError("read", error_code != 0 ? error_code : EIO);
+        return;
+      }
+      // A hang-up is read even if the socket is paused to learn its end.
+      if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0) {
+        Read();
+      }
+      if (!is_closed_ && (events & EPOLLOUT) != 0) {
+        Flush();
+      }
+    });
+  }
+
+  // Returns false if the queued data exceeds the high water mark.
+  bool Write(napi_env env, napi_value data, bool notify_flushed) {
+    if (is_closed_ || is_end_requested_) {
+      return false;
+    }
+    AppendToWriteQueue(env, data);
+    notify_flushed_ |= notify_flushed;
+    SchedulePending();
+    if (queued_size_ < NodeLiteNet::kWriteHighWaterMark) {
+      return true;
+    }
+    need_drain_ = true;
+    return false;
+  }
+
+  // Shuts down the sending side after the queued data is sent.
+  void End() {
+    if (is_closed_ || is_end_requested_) {
+      return;
+    }
+    is_end_requested_ = true;
+    SchedulePending();
+  }
+
+  void SetReading(bool is_reading) {
+    if (is_reading_ != is_reading && !is_closed_) {
+      is_reading_ = is_reading;
+      UpdateEvents();
+    }
+  }
+
+  void SetRef(bool is_refed) {
+    if (is_refed_ != is_refed && !is_closed_) {
+      is_refed_ = is_refed;
+      if (is_refed) {
+        net_.reactor().RefHandle();
+      } else {
+        net_.reactor().UnrefHandle();
+      }
+    }
+  }
+
+  // Connects the socket created without a file descriptor to the resolved
+  // addresses in their order. The next address is tried when the connect
+  // to the previous one fails, e.g. when "localhost" resolves to ::1 first
+  // and the server listens on 127.0.0.1 only.
+  void Connect(std::unique_ptr<addrinfo, AddrInfoDeleter> addresses) {
+    addresses_ = std::move(addresses);
+    next_address_ = addresses_.get();
+    int connect_error = ConnectNext();
+    Start(/*is_connecting:*/ connect_error == 0, connect_error);
+  }
+
+  void EnableHttp() noexcept { is_http_server_ = true; }
+
+  void SetOption(int level, int option, bool value) noexcept {
+    int int_value = value ? 1 : 0;
+    ::setsockopt(fd_, level, option, &int_value, sizeof(int_value));
+  }
+
+  napi_value GetAddress(napi_env env, bool is_remote) {
+    sockaddr_storage address{};
+    socklen_t length = sizeof(address);
+    int result = is_remote ? ::getpeername(fd_, reinterpret_cast<sockaddr*>(
+                                                    &address),
+                                           &length)
+                           : ::getsockname(fd_, reinterpret_cast<sockaddr*>(
+                                                    &address),
+                                           &length);
+    if (is_closed_ || result != 0) {
+      return NodeApi::GetUndefined(env);
+    }
+    return CreateAddressObject(env, address);
+  }
+
+  // Closes the socket without calling JS. The JS code that asked to close it
+  // emits the events.
+  void Close() {
+    if (is_closed_) {
+      return;
+    }
+    is_closed_ = true;
+    if (fd_ >= 0) {
+      net_.reactor().Remove(fd_);
+      ::close(fd_);
+      fd_ = -1;
+    }
+    net_.reactor().RemovePendingHandler(this);
+    if (is_refed_) {
+      net_.reactor().UnrefHandle();
+    }
+    net_.RemoveHandle(id_);
+  }
+
+ private:
+  // Starts the non-blocking connect to the next address that accepts it.
+  // Returns the error of the last attempt if no address is left.
+  int ConnectNext() {
+    int error_code = EADDRNOTAVAIL;
+    while (next_address_ != nullptr) {
+      const addrinfo* address = next_address_;
+      next_address_ = address->ai_next;
+      int fd = ::socket(address->ai_family,
+                        SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        0);
+      if (fd < 0) {
+        error_code = errno;
+        continue;
+      }
+      if (::connect(fd, address->ai_addr, address->ai_addrlen) != 0 &&
+          errno != EINPROGRESS) {
+        error_code = errno;
+        ::close(fd);
+        continue;
+      }
+      fd_ = fd;
+      return 0;
+    }
+    return error_code;
+  }
+
+  uint32_t GetEvents() const noexcept {
+    if (kind_ == Kind::kServer) {
+      return EPOLLIN;
+    }
+    if (is_connecting_) {
+      return EPOLLOUT;
+    }
+    uint32_t events = 0;
+    if (is_reading_ && !is_read_ended_) {
+      events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (is_write_blocked_) {
+      events |= EPOLLOUT;
+    }
+    return events;
+  }
+
+  void UpdateEvents() {
+    net_.reactor().Modify(fd_, GetEvents(), this);
+  }
+
+  void SchedulePending() {
+    if (!is_pending_) {
+      is_pending_ = true;
+      net_.reactor().AddPendingHandler(this);
+    }
+  }
+
+  void Accept() {
+    for (int i = 0; i < kMaxAcceptsPerEvent && !is_closed_; ++i) {
+      int fd = ::accept4(fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) {
+        if (errno == EINTR || errno == ECONNABORTED) {
+          continue;
+        }
+        // EAGAIN ends the accepted connections. Other errors such as EMFILE
+        // are retried on the next event.
+        return;
+      }
+      NodeLiteTcpHandle& socket = net_.AddHandle(
+          std::make_unique<NodeLiteTcpHandle>(net_, fd, Kind::kSocket));
+      if (is_http_server_) {
+        socket.http_connection_ =
+            std::make_unique<NodeLiteHttpConnection>(net_, socket.id());
+      }
+      socket.Start(/*is_connecting:*/ false, /*connect_error:*/ 0);
+      napi_env env = net_.env();
+      NodeApiHandleScope scope{env};
+      net_.CallJS(NodeLiteNet::Callback::kOnConnection,
+                  {NodeApi::CreateUInt32(env, id_),
+                   NodeApi::CreateUInt32(env, socket.id())});
+    }
+  }
+
+  void OnConnected(uint32_t events) {
+    int error_code{};
+    socklen_t length = sizeof(error_code);
+    if (::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error_code, &length) != 0) {
+      error_code = errno;
+    }
+    if (error_code == 0 && (events & EPOLLERR) != 0) {
+      error_code = ECONNREFUSED;
+    }
+    if (error_code != 0 && next_address_ != nullptr) {
+      net_.reactor().Remove(fd_);
+      ::close(fd_);
+      fd_ = -1;
+      error_code = ConnectNext();
+      if (error_code == 0) {
+        net_.reactor().Add(fd_, GetEvents(), this);
+        return;
+      }
+    }
+    if (error_code != 0) {
+      CloseWithError("connect", error_code);
+      return;
+    }
+    addresses_.reset();
+    next_address_ = nullptr;
+    is_connecting_ = false;
+    UpdateEvents();
+    net_.CallJS(NodeLiteNet::Callback::kOnConnect,
+                {NodeApi::CreateUInt32(net_.env(), id_)});
+    // The data written before the connection is sent now.
+    if (!is_closed_ && (!write_queue_.empty() || is_end_requested_)) {
+      Flush();
+    }
+  }
+
+  void Read() {
+    napi_env env = net_.env();
+    for (int i = 0; i < kMaxReadsPerEvent; ++i) {
+      size_t buffer_size{};
+      char* buffer = net_.GetReadBuffer(buffer_size);
+      ssize_t size = ::read(fd_, buffer, buffer_size);
+      if (size < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          CloseWithError("read", errno);
+        }
+        return;
+      }
+      if (size == 0) {
+        is_read_ended_ = true;
+        UpdateEvents();
+        net_.CallJS(NodeLiteNet::Callback::kOnEnd,
+                    {NodeApi::CreateUInt32(env, id_)});
+        if (!is_closed_ && is_write_shutdown_) {
+          CloseFromNative(/*had_error:*/ false);
+        }
+        return;
+      }
+      if (http_connection_ != nullptr) {
+        http_connection_->OnData(buffer, static_cast<size_t>(size));
+        net_.CommitRead(static_cast<size_t>(size));
+      } else {
+        NodeApiHandleScope scope{env};
+        napi_value view = net_.CommitReadBuffer(static_cast<size_t>(size));
+        net_.CallJS(NodeLiteNet::Callback::kOnData,
+                    {NodeApi::CreateUInt32(env, id_), view});
+      }
+      // The callback may pause or close the socket. A short read means that
+      // the socket has no more data for now.
+      if (is_closed_ || !is_reading_ ||
+          static_cast<size_t>(size) < buffer_size) {
+        return;
+      }
+    }
+  }
+
+  void AppendToWriteQueue(napi_env env, napi_value data) {
+    napi_valuetype type = NodeApi::TypeOf(env, data);
+    if (type == napi_string) {
+      size_t length{};
+      NODE_LITE_CALL(
+          napi_get_value_string_utf8(env, data, nullptr, 0, &length));
+      std::string& chunk = GetWriteChunk(length);
+      size_t offset = chunk.size();
+      // The string is written with its terminating zero, which is removed.
+      chunk.resize(offset + length + 1);
+      NODE_LITE_CALL(napi_get_value_string_utf8(
+          env, data, chunk.data() + offset, length + 1, &length));
+      chunk.resize(offset + length);
+      queued_size_ += length;
+      return;
+    }
+    void* bytes{};
+    size_t length{};
+    bool is_typed_array{};
+    NODE_LITE_CALL(napi_is_typedarray(env, data, &is_typed_array));
+    if (is_typed_array) {
+      napi_typedarray_type array_type{};
+      size_t element_count{};
+      napi_value array_buffer{};
+      size_t byte_offset{};
+      NODE_LITE_CALL(napi_get_typedarray_info(env,
+                                              data,
+                                              &array_type,
+                                              &element_count,
+                                              &bytes,
+                                              &array_buffer,
+                                              &byte_offset));
+      NODE_LITE_CALL(
+          napi_get_arraybuffer_info(env, array_buffer, nullptr, &length));
+      // The element size is derived from the view length in bytes.
+      length = element_count * GetElementSize(array_type);
+    } else {
+      bool is_array_buffer{};
+      NODE_LITE_CALL(napi_is_arraybuffer(env, data, &is_array_buffer));
+      NODE_LITE_ASSERT(is_array_buffer,
+                       "The data must be a string, TypedArray, or ArrayBuffer");
+      NODE_LITE_CALL(napi_get_arraybuffer_info(env, data, &bytes, &length));
+    }
+    std::string& chunk = GetWriteChunk(length);
+    chunk.append(static_cast<const char*>(bytes), length);
+    queued_size_ += length;
+  }
+
+  static size_t GetElementSize(napi_typedarray_type type) noexcept {
+    switch (type) {
+      case napi_int16_array:
+      case napi_uint16_array:
+        return 2;
+      case napi_int32_array:
+      case napi_uint32_array:
+      case napi_float32_array:
+        return 4;
+      case napi_float64_array:
+      case napi_bigint64_array:
+      case napi_biguint64_array:
+        return 8;
+      default:
+        return 1;
+    }
+  }
+
+  // Small writes are coalesced to send fewer chunks.
+  std::string& GetWriteChunk(size_t length) {
+    if (write_queue_.empty() ||
+        write_queue_.back().size() + length > kMaxCoalescedChunkSize) {
+      write_queue_.emplace_back();
+    }
+    return write_queue_.back();
+  }
+
+  void Flush() {
+    if (is_connecting_ || is_closed_) {
+      return;
+    }
+    bool has_written = false;
+    while (!write_queue_.empty()) {
+      iovec chunks[kMaxWriteChunks];
+      size_t chunk_count = 0;
+      for (auto it = write_queue_.begin();
+           it != write_queue_.end() && chunk_count < kMaxWriteChunks;
+           ++it) {
+        size_t offset = chunk_count == 0 ? front_offset_ : 0;
+        chunks[chunk_count].iov_base = it->data() + offset;
+        chunks[chunk_count].iov_len = it->size() - offset;
+        ++chunk_count;
+      }
+      msghdr message{};
+      message.msg_iov = chunks;
+      message.msg_iovlen = chunk_count;
+      ssize_t size = ::sendmsg(fd_, &message, MSG_NOSIGNAL);
+      if (size < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          if (!is_write_blocked_) {
+            is_write_blocked_ = true;
+            UpdateEvents();
+          }
+          return;
+        }
+        CloseWithError("write", errno);
+        return;
+      }
+      has_written = true;
+      queued_size_ -= static_cast<size_t>(size);
+      size_t remaining = static_cast<size_t>(size);
+      while (remaining > 0) {
+        size_t front_size = write_queue_.front().size() - front_offset_;
+        if (remaining < front_size) {
+          front_offset_ += remaining;
+          break;
+        }
+        remaining -= front_size;
+        write_queue_.pop_front();
+        front_offset_ = 0;
+      }
+    }
+    if (is_write_blocked_) {
+      is_write_blocked_ = false;
+      UpdateEvents();
+    }
+    bool is_finished = false;
+    if (is_end_requested_ && !is_write_shutdown_) {
+      ::shutdown(fd_, SHUT_WR);
+      is_write_shutdown_ = true;
+      is_finished = true;
+    }
+    if ((has_written && (need_drain_ || notify_flushed_)) || is_finished) {
+      need_drain_ = false;
+      notify_flushed_ = false;
+      napi_env env = net_.env();
+      net_.CallJS(NodeLiteNet::Callback::kOnDrain,
+                  {NodeApi::CreateUInt32(env, id_),
+                   NodeApi::GetBoolean(env, is_finished)});
+    }
+    if (!is_closed_ && is_write_shutdown_ && is_read_ended_) {
+      CloseFromNative(/*had_error:*/ false);
+    }
+  }
+
+  void CloseWithError(const char* syscall, int error_code) {
+    napi_env env = net_.env();
+    net_.CallJS(
+        NodeLiteNet::Callback::kOnError,
+        {NodeApi::CreateUInt32(env, id_),
+         NodeApi::CreateString(env, FormatSystemError(syscall, error_code)),
+         NodeApi::CreateString(env, GetErrorCode(error_code))});
+    if (!is_closed_) {
+      CloseFromNative(/*had_error:*/ true);
+    }
+  }
+
+  void CloseFromNative(bool had_error) {
+    uint32_t id = id_;
+    NodeLiteNet& net = net_;
+    // The handle is retired by Close and deleted after the Poll.
+    Close();
+    napi_env env = net.env();
+    net.CallJS(NodeLiteNet::Callback::kOnClose,
+               {NodeApi::CreateUInt32(env, id),
+                NodeApi::GetBoolean(env, had_error)});
+  }
+
+ private:
+  NodeLiteNet& net_;
+  int fd_;
+  Kind kind_;
+  uint32_t id_{};
+  bool is_connecting_{false};
+  // The addresses left to try while the socket is connecting.
+  std::unique_ptr<addrinfo, AddrInfoDeleter> addresses_;
+  const addrinfo* next_address_{};
+  int pending_error_{0};
+  bool is_pending_{false};
+  bool is_reading_{true};
+  bool is_http_server_{false};
+  std::unique_ptr<NodeLiteHttpConnection> http_connection_;
+  bool is_read_ended_{false};
+  bool is_refed_{true};
+  bool is_closed_{false};
+  bool is_write_blocked_{false};
+  bool is_end_requested_{false};
+  bool is_write_shutdown_{false};
+  bool need_drain_{false};
+  bool notify_flushed_{false};
+  std::deque<std::string> write_queue_;
+  size_t front_offset_{0};
+  size_t queued_size_{0};
+};
+
+//=============================================================================
+// NodeLiteNet implementation
+//=============================================================================
+
+/*static*/ std::unique_ptr<NodeLiteNet> NodeLiteNet::Create(
+    napi_env env, std::shared_ptr<NodeLiteTaskRunner> task_runner) {
+  std::unique_ptr<NodeLiteReactor> reactor = NodeLiteReactor::Create();
+  if (reactor == nullptr) {
+    ThrowSystemError("epoll_create", errno);
+  }
+  return std::make_unique<NodeLiteNet>(
+      env, std::move(task_runner), std::move(reactor));
+}
+
+NodeLiteNet::NodeLiteNet(napi_env env,
+                         std::shared_ptr<NodeLiteTaskRunner> task_runner,
+                         std::unique_ptr<NodeLiteReactor> reactor) noexcept
+    : env_(env),
+      task_runner_(std::move(task_runner)),
+      reactor_(std::move(reactor)) {
+  task_runner_->SetIoPoller(reactor_.get());
+}
+
+NodeLiteNet::~NodeLiteNet() {
+  task_runner_->SetIoPoller(nullptr);
+}
+
+char* NodeLiteNet::GetReadBuffer(size_t& size) {
+  if (kSlabSize - slab_offset_ < kMinReadSize) {
+    void* data{};
+    napi_value slab{};
+    napi_env env = env_;
+    NODE_LITE_CALL(napi_create_arraybuffer(env, kSlabSize, &data, &slab));
+    slab_ = MakeNodeApiRef(env, slab);
+    slab_data_ = static_cast<char*>(data);
+    slab_offset_ = 0;
+  }
+  size = kSlabSize - slab_offset_;
+  return slab_data_ + slab_offset_;
+}
+
+napi_value NodeLiteNet::CommitReadBuffer(size_t size) {
+  napi_value view = CreateReadView(slab_data_ + slab_offset_, size);
+  CommitRead(size);
+  return view;
+}
+
+napi_value NodeLiteNet::CreateReadView(const char* data, size_t size) {
+  napi_env env = env_;
+  napi_value view{};
+  NODE_LITE_CALL(
+      napi_create_typedarray(env,
+                             napi_uint8_array,
+                             size,
+                             NodeApi::GetReferenceValue(env, slab_.get()),
+                             static_cast<size_t>(data - slab_data_),
+                             &view));
+  return view;
+}
+
+void NodeLiteNet::CommitRead(size_t size) noexcept {
+  // The next reads start at 8-byte boundaries.
+  slab_offset_ += (size + 7) & ~size_t{7};
+}
+
+/*static*/ napi_value NodeLiteNet::DecodeUtf8(napi_env env, napi_value view) {
+  size_t length{};
+  void* data{};
+  NODE_LITE_CALL(napi_get_typedarray_info(
+      env, view, nullptr, &length, &data, nullptr, nullptr));
+  napi_value result{};
+  NODE_LITE_CALL(napi_create_string_utf8(
+      env, static_cast<const char*>(data), length, &result));
+  return result;
+}
+
+NodeLiteHttp& NodeLiteNet::http() {
+  if (http_ == nullptr) {
+    http_ = std::make_unique<NodeLiteHttp>(*this);
+  }
+  return *http_;
+}
+
+void NodeLiteNet::EnableHttp(uint32_t server_id) {
+  napi_env env = env_;
+  NodeLiteTcpHandle* server = GetHandle(server_id);
+  NODE_LITE_ASSERT(server != nullptr &&
+                       server->kind() == NodeLiteTcpHandle::Kind::kServer,
+                   "Expected a listening server");
+  server->EnableHttp();
+}
+
+NodeLiteTcpHandle& NodeLiteNet::AddHandle(
+    std::unique_ptr<NodeLiteTcpHandle> handle) {
+  uint32_t id = next_handle_id_++;
+  handle->set_id(id);
+  return *handles_.try_emplace(id, std::move(handle)).first->second;
+}
+
+NodeLiteTcpHandle* NodeLiteNet::GetHandle(uint32_t id) noexcept {
+  auto it = handles_.find(id);
+  return it != handles_.end() ? it->second.get() : nullptr;
+}
+
+void NodeLiteNet::RemoveHandle(uint32_t id) {
+  auto it = handles_.find(id);
+  if (it != handles_.end()) {
+    reactor_->DeleteLater(std::move(it->second));
+    handles_.erase(it);
+  }
+}
+
+void NodeLiteNet::CloseAllHandles() {
+  // Close removes the handle from the map.
+  while (!handles_.empty()) {
+    handles_.begin()->second->Close();
+  }
+  CallJS(Callback::kOnReset, span<napi_value>(nullptr, 0));
+  if (http_ != nullptr) {
+    http_->CallJS(NodeLiteHttp::Callback::kOnReset,
+                  span<napi_value>(nullptr, 0));
+  }
+}
+
+void NodeLiteNet::CallJS(Callback callback, span<napi_value> args) {
+  napi_env env = env_;
+  NodeApiRef& callback_ref = callbacks_[static_cast<size_t>(callback)];
+  NODE_LITE_ASSERT(callback_ref != nullptr, "The net callbacks are not set");
+  NodeApi::CallFunction(
+      env, NodeApi::GetReferenceValue(env, callback_ref.get()), args);
+}
+
+napi_value NodeLiteNet::CreateBinding(napi_env env) {
+  napi_value binding = NodeApi::CreateObject(env);
+  auto get_handle = [this](napi_env env, napi_value id) -> NodeLiteTcpHandle& {
+    NodeLiteTcpHandle* handle = GetHandle(NodeApi::GetValueUInt32(env, id));
+    NODE_LITE_ASSERT(handle != nullptr, "The socket is closed");
+    return *handle;
+  };
+
+  // setCallbacks({onConnection, onConnect, onData, ...})
+  NodeApi::SetMethod(
+      env,
+      binding,
+      "setCallbacks",
+      [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+        constexpr const char* kCallbackNames[] = {"onConnection",
+                                                  "onConnect",
+                                                  "onData",
+                                                  "onEnd",
+                                                  "onDrain",
+                                                  "onClose",
+                                                  "onError",
+                                                  "onReset"};
+        static_assert(std::size(kCallbackNames) ==
+                      static_cast<size_t>(Callback::kCount));
+        for (size_t i = 0; i < std::size(kCallbackNames); ++i) {
+          napi_value callback =
+              NodeApi::GetProperty(env, args[0], kCallbackNames[i]);
+          NODE_LITE_ASSERT(NodeApi::TypeOf(env, callback) == napi_function,
+                           "Expected function %s",
+                           kCallbackNames[i]);
+          callbacks_[i] = MakeNodeApiRef(env, callback);
+        }
+        return nullptr;
+      });
+
+  // listen(host, port, backlog) -> id
+  NodeApi::SetMethod(
+      env, binding, "listen", [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 3, "Expected 3 arguments");
+        std::string host = NodeApi::ToStdString(env, args[0]);
+        uint16_t port =
+            static_cast<uint16_t>(NodeApi::GetValueUInt32(env, args[1]));
+        int backlog = NodeApi::GetValueInt32(env, args[2]);
+        std::unique_ptr<addrinfo, AddrInfoDeleter> addresses =
+            ResolveAddress(host, port, /*is_passive:*/ true);
+        int error_code = 0;
+        for (addrinfo* address = addresses.get(); address != nullptr;
+             address = address->ai_next) {
+          int fd = ::socket(address->ai_family,
+                            SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                            0);
+          if (fd < 0) {
+            error_code = errno;
+            continue;
+          }
+          int reuse = 1;
+          ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+          if (::bind(fd, address->ai_addr, address->ai_addrlen) != 0 ||
+              ::listen(fd, backlog) != 0) {
+            error_code = errno;
+            ::close(fd);
+            continue;
+          }
+          NodeLiteTcpHandle& server =
+              AddHandle(std::make_unique<NodeLiteTcpHandle>(
+                  *this, fd, NodeLiteTcpHandle::Kind::kServer));
+          server.Start(/*is_connecting:*/ false, /*connect_error:*/ 0);
+          return NodeApi::CreateUInt32(env, server.id());
+        }
+        ThrowSystemError("listen",
+                         error_code != 0 ? error_code : EADDRNOTAVAIL);
+      });
+
+  // connect(host, port) -> id
+  NodeApi::SetMethod(
+      env, binding, "connect", [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        std::string host = NodeApi::ToStdString(env, args[0]);
+        uint16_t port =
+            static_cast<uint16_t>(NodeApi::GetValueUInt32(env, args[1]));
+        std::unique_ptr<addrinfo, AddrInfoDeleter> addresses =
+            ResolveAddress(host, port, /*is_passive:*/ false);
+        NodeLiteTcpHandle& socket =
+            AddHandle(std::make_unique<NodeLiteTcpHandle>(
+                *this, /*fd:*/ -1, NodeLiteTcpHandle::Kind::kSocket));
+        socket.Connect(std::move(addresses));
+        return NodeApi::CreateUInt32(env, socket.id());
+      });
+
+  // write(id, data, notifyFlushed) -> bool
+  NodeApi::SetMethod(
+      env,
+      binding,
+      "write",
+      [get_handle](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 3, "Expected 3 arguments");
+        bool notify_flushed{};
+        NODE_LITE_CALL(napi_get_value_bool(env, args[2], &notify_flushed));
+        return NodeApi::GetBoolean(
+            env, get_handle(env, args[0]).Write(env, args[1], notify_flushed));
+      });
+
+  // end(id)
+  NodeApi::SetMethod(
+      env, binding, "end", [get_handle](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        get_handle(env, args[0]).End();
+        return nullptr;
+      });
+
+  // close(id)
+  NodeApi::SetMethod(
+      env, binding, "close", [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        if (NodeLiteTcpHandle* handle =
+                GetHandle(NodeApi::GetValueUInt32(env, args[0]))) {
+          handle->Close();
+        }
+        return nullptr;
+      });
+
+  // setReading(id, isReading)
+  NodeApi::SetMethod(
+      env,
+      binding,
+      "setReading",
+      [get_handle](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        bool is_reading{};
+        NODE_LITE_CALL(napi_get_value_bool(env, args[1], &is_reading));
+        get_handle(env, args[0]).SetReading(is_reading);
+        return nullptr;
+      });
+
+  // setRef(id, isRefed)
+  NodeApi::SetMethod(
+      env,
+      binding,
+      "setRef",
+      [get_handle](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        bool is_refed{};
+        NODE_LITE_CALL(napi_get_value_bool(env, args[1], &is_refed));
+        get_handle(env, args[0]).SetRef(is_refed);
+        return nullptr;
+      });
+
+  // setNoDelay(id, noDelay)
+  NodeApi::SetMethod(
+      env,
+      binding,
+      "setNoDelay",
+      [get_handle](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        bool value{};
+        NODE_LITE_CALL(napi_get_value_bool(env, args[1], &value));
+        get_handle(env, args[0]).SetOption(IPPROTO_TCP, TCP_NODELAY, value);
+        return nullptr;
+      });
+
+  // setKeepAlive(id, enable)
+  NodeApi::SetMethod(
+      env,
+      binding,
+      "setKeepAlive",
+      [get_handle](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        bool value{};
+        NODE_LITE_CALL(napi_get_value_bool(env, args[1], &value));
+        get_handle(env, args[0]).SetOption(SOL_SOCKET, SO_KEEPALIVE, value);
+        return nullptr;
+      });
+
+  // address(id, isRemote) -> {address, family, port}
+  NodeApi::SetMethod(
+      env, binding, "address", [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        bool is_remote{};
+        NODE_LITE_CALL(napi_get_value_bool(env, args[1], &is_remote));
+        NodeLiteTcpHandle* handle =
+            GetHandle(NodeApi::GetValueUInt32(env, args[0]));
+        return handle != nullptr ? handle->GetAddress(env, is_remote)
+                                 : NodeApi::GetUndefined(env);
+      });
+
+  // decodeUtf8(view) -> string
+  NodeApi::SetMethod(
+      env, binding, "decodeUtf8", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        return DecodeUtf8(env, args[0]);
+      });
+
+  return binding;
+}
+
+/*static*/ const std::string_view NodeLiteNet::kModuleSource = R"JS(
+(function (binding, require) {
+  'use strict';
+  const EventEmitter = require('events');
+  // Servers and sockets by their native handle ids.
+  const handles = new Map();
+
+  function inherits(ctor, superCtor) {
+    Object.setPrototypeOf(ctor.prototype, superCtor.prototype);
+    Object.setPrototypeOf(ctor, superCtor);
+  }
+
+  function createError(message, code) {
+    const error = new Error(message);
+    if (code) {
+      error.code = code;
+    }
+    return error;
+  }
+
+  // The native errors are formatted as "<syscall> <code> ...".
+  function emitErrorLater(emitter, error) {
+    const match = /^\w+ (E[A-Z]+)\b/.exec(error.message);
+    if (match && !error.code) {
+      error.code = match[1];
+    }
+    process.nextTick(() => emitter.emit('error', error));
+  }
+
+  function Socket(options) {
+    if (!(this instanceof Socket)) {
+      return new Socket(options);
+    }
+    EventEmitter.call(this);
+    this._id = 0;
+    this._encoding = null;
+    this._writeCallbacks = [];
+    this._needDrain = false;
+    this._writableEnded = false;
+    this.destroyed = false;
+    this.connecting = false;
+    this.readableEnded = false;
+    this.bytesRead = 0;
+    this.bytesWritten = 0;
+    this.allowHalfOpen = !!(options && options.allowHalfOpen);
+  }
+  inherits(Socket, EventEmitter);
+
+  Socket.prototype._attach = function (id) {
+    this._id = id;
+    handles.set(id, this);
+  };
+
+  Socket.prototype.connect = function (port, host, listener) {
+    if (typeof port === 'object' && port !== null) {
+      listener = host;
+      host = port.host;
+      port = port.port;
+    }
+    if (typeof host === 'function') {
+      listener = host;
+      host = undefined;
+    }
+    if (typeof listener === 'function') {
+      this.once('connect', listener);
+    }
+    this.connecting = true;
+    try {
+      this._attach(binding.connect(host || 'localhost', Number(port)));
+    } catch (error) {
+      this.destroyed = true;
+      emitErrorLater(this, error);
+      process.nextTick(() => this.emit('close', true));
+    }
+    return this;
+  };
+
+  Socket.prototype.write = function (data, encoding, callback) {
+    if (typeof encoding === 'function') {
+      callback = encoding;
+    }
+    if (this._writableEnded || this.destroyed) {
+      emitErrorLater(this, createError('This socket has been ended', 'EPIPE'));
+      return false;
+    }
+    if (typeof callback === 'function') {
+      this._writeCallbacks.push(callback);
+    }
+    this.bytesWritten +=
+        typeof data === 'string' ? data.length : data.byteLength;
+    const ok = binding.write(this._id, data, this._writeCallbacks.length > 0);
+    if (!ok) {
+      this._needDrain = true;
+    }
+    return ok;
+  };
+
+  Socket.prototype.end = function (data, encoding, callback) {
+    if (typeof data === 'function') {
+      callback = data;
+      data = undefined;
+    } else if (typeof encoding === 'function') {
+      callback = encoding;
+    }
+    if (data !== undefined && data !== null) {
+      this.write(data);
+    }
+    if (typeof callback === 'function') {
+      this.once('finish', callback);
+    }
+    if (!this._writableEnded && !this.destroyed) {
+      this._writableEnded = true;
+      binding.end(this._id);
+    }
+    return this;
+  };
+
+  Socket.prototype.destroy = function (error) {
+    if (this.destroyed) {
+      return this;
+    }
+    this.destroyed = true;
+    if (this._id !== 0) {
+      binding.close(this._id);
+      handles.delete(this._id);
+    }
+    process.nextTick(() => {
+      if (error) {
+        this.emit('error', error);
+      }
+      this.emit('close', !!error);
+    });
+    return this;
+  };
+
+  Socket.prototype.pause = function () {
+    if (!this.destroyed) {
+      binding.setReading(this._id, false);
+    }
+    return this;
+  };
+
+  Socket.prototype.resume = function () {
+    if (!this.destroyed) {
+      binding.setReading(this._id, true);
+    }
+    return this;
+  };
+
+  Socket.prototype.setEncoding = function (encoding) {
+    this._encoding = encoding || 'utf8';
+    return this;
+  };
+
+  Socket.prototype.setNoDelay = function (noDelay) {
+    if (!this.destroyed) {
+      binding.setNoDelay(this._id, noDelay === undefined ? true : !!noDelay);
+    }
+    return this;
+  };
+
+  Socket.prototype.setKeepAlive = function (enable) {
+    if (!this.destroyed) {
+      binding.setKeepAlive(this._id, !!enable);
+    }
+    return this;
+  };
+
+  Socket.prototype.ref = function () {
+    if (!this.destroyed) {
+      binding.setRef(this._id, true);
+    }
+    return this;
+  };
+
+  Socket.prototype.unref = function () {
+    if (!this.destroyed) {
+      binding.setRef(this._id, false);
+    }
+    return this;
+  };
+
+  Socket.prototype.address = function () {
+    return binding.address(this._id, false) || {};
+  };
+
+  Object.defineProperty(Socket.prototype, 'remoteAddress', {
+    get() {
+      const address = binding.address(this._id, true);
+      return address && address.address;
+    },
+  });
+
+  Object.defineProperty(Socket.prototype, 'remotePort', {
+    get() {
+      const address = binding.address(this._id, true);
+      return address && address.port;
+    },
+  });
+
+  Object.defineProperty(Socket.prototype, 'remoteFamily', {
+    get() {
+      const address = binding.address(this._id, true);
+      return address && address.family;
+    },
+  });
+
+  function Server(options, connectionListener) {
+    if (!(this instanceof Server)) {
+      return new Server(options, connectionListener);
+    }
+    EventEmitter.call(this);
+    if (typeof options === 'function') {
+      connectionListener = options;
+      options = undefined;
+    }
+    this._id = 0;
+    this.listening = false;
+    this.allowHalfOpen = !!(options && options.allowHalfOpen);
+    this.noDelay = !!(options && options.noDelay);
+    if (typeof connectionListener === 'function') {
+      this.on('connection', connectionListener);
+    }
+  }
+  inherits(Server, EventEmitter);
+
+  // listen(port[, host][, backlog][, callback]) or listen(options[, callback])
+  Server.prototype.listen = function () {
+    let port = 0;
+    let host = '';
+    let backlog = 511;
+    let callback;
+    const args = Array.prototype.slice.call(arguments);
+    if (typeof args[args.length - 1] === 'function') {
+      callback = args.pop();
+    }
+    if (typeof args[0] === 'object' && args[0] !== null) {
+      port = args[0].port || 0;
+      host = args[0].host || '';
+      backlog = args[0].backlog || backlog;
+    } else {
+      port = args[0] || 0;
+      if (typeof args[1] === 'string') {
+        host = args[1];
+        backlog = args[2] || backlog;
+      } else if (typeof args[1] === 'number') {
+        backlog = args[1];
+      }
+    }
+    if (callback) {
+      this.once('listening', callback);
+    }
+    try {
+      this._id = binding.listen(host, Number(port), backlog);
+    } catch (error) {
+      emitErrorLater(this, error);
+      return this;
+    }
+    handles.set(this._id, this);
+    this.listening = true;
+    process.nextTick(() => this.emit('listening'));
+    return this;
+  };
+
+  // The close event is emitted after the listening socket is closed.
+  // The accepted connections stay open.
+  Server.prototype.close = function (callback) {
+    if (typeof callback === 'function') {
+      this.once('close', callback);
+    }
+    if (this._id !== 0) {
+      binding.close(this._id);
+      handles.delete(this._id);
+      this._id = 0;
+    }
+    this.listening = false;
+    process.nextTick(() => this.emit('close'));
+    return this;
+  };
+
+  Server.prototype.address = function () {
+    return this._id !== 0 ? binding.address(this._id, false) : null;
+  };
+
+  Server.prototype.ref = function () {
+    if (this._id !== 0) {
+      binding.setRef(this._id, true);
+    }
+    return this;
+  };
+
+  Server.prototype.unref = function () {
+    if (this._id !== 0) {
+      binding.setRef(this._id, false);
+    }
+    return this;
+  };
+
+  binding.setCallbacks({
+    onConnection(serverId, socketId) {
+      const server = handles.get(serverId);
+      const socket = new Socket({allowHalfOpen: server.allowHalfOpen});
+      socket._attach(socketId);
+      if (server.noDelay) {
+        socket.setNoDelay(true);
+      }
+      server.emit('connection', socket);
+    },
+    onConnect(id) {
+      const socket = handles.get(id);
+      socket.connecting = false;
+      socket.emit('connect');
+      socket.emit('ready');
+    },
+    onData(id, chunk) {
+      const socket = handles.get(id);
+      socket.bytesRead += chunk.length;
+      socket.emit(
+          'data', socket._encoding ? binding.decodeUtf8(chunk) : chunk);
+    },
+    onEnd(id) {
+      const socket = handles.get(id);
+      socket.readableEnded = true;
+      socket.emit('end');
+      if (!socket.allowHalfOpen) {
+        socket.end();
+      }
+    },
+    onDrain(id, isFinished) {
+      const socket = handles.get(id);
+      const callbacks = socket._writeCallbacks;
+      if (callbacks.length > 0) {
+        socket._writeCallbacks = [];
+        for (let i = 0; i < callbacks.length; ++i) {
+          callbacks[i]();
+        }
+      }
+      if (socket._needDrain) {
+        socket._needDrain = false;
+        socket.emit('drain');
+      }
+      if (isFinished) {
+        socket.emit('finish');
+      }
+    },
+    onClose(id, hadError) {
+      const socket = handles.get(id);
+      handles.delete(id);
+      socket.destroyed = true;
+      socket.emit('close', hadError);
+    },
+    onError(id, message, code) {
+      const handle = handles.get(id);
+      const error = createError(message, code);
+      if (handle instanceof Socket && handle.connecting) {
+        handle.connecting = false;
+      }
+      handle.emit('error', error);
+    },
+    onReset() {
+      handles.clear();
+    },
+  });
+
+  function createServer(options, connectionListener) {
+    return new Server(options, connectionListener);
+  }
+
+  function connect(port, host, listener) {
+    const options = typeof port === 'object' && port !== null ? port : {};
+    return new Socket(options).connect(port, host, listener);
+  }
+
+  function isIPv4(input) {
+    const octet = '(25[0-5]|2[0-4]\\d|1\\d\\d|[1-9]?\\d)';
+    return new RegExp('^' + octet + '(\\.' + octet + '){3}$').test(input);
+  }
+
+  function isIPv6(input) {
+    return typeof input === 'string' && input.indexOf(':') !== -1 &&
+        /^[0-9a-fA-F:.]+$/.test(input);
+  }
+
+  function isIP(input) {
+    return isIPv4(input) ? 4 : isIPv6(input) ? 6 : 0;
+  }
+
+  return {
+    Server,
+    Socket,
+    Stream: Socket,
+    createServer,
+    connect,
+    createConnection: connect,
+    isIP,
+    isIPv4,
+    isIPv6,
+  };
+})
+)JS";
+
+}  // namespace node_api_tests
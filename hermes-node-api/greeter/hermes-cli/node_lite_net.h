@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// TCP networking for the "net" built-in module.
+
+#ifndef NODE_API_TEST_NODE_LITE_NET_H
+#define NODE_API_TEST_NODE_LITE_NET_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+// An epoll reactor integrated into the NodeLiteTaskRunner wait.
+// All its methods are called on the JS thread except for Wake.
+class NodeLiteReactor : public NodeLiteTaskRunner::IoPoller {
+ public:
+  // Receives the epoll events of a file descriptor.
+  class Handler {
+   public:
+    virtual ~Handler() = default;
+    virtual void OnIoEvents(uint32_t events) = 0;
+  };
+
+  // Returns nullptr if the epoll or eventfd descriptors cannot be created.
+  static std::unique_ptr<NodeLiteReactor> Create();
+
+  ~NodeLiteReactor() override;
+
+  NodeLiteReactor(const NodeLiteReactor&) = delete;
+  NodeLiteReactor& operator=(const NodeLiteReactor&) = delete;
+
+  bool Add(int fd, uint32_t events, Handler* handler) noexcept;
+  bool Modify(int fd, uint32_t events, Handler* handler) noexcept;
+  void Remove(int fd) noexcept;
+
+  // Handlers that have the work to do before the next wait, such as the
+  // sockets with queued writes. They run once per Poll call.
+  void AddPendingHandler(Handler* handler);
+  void RemovePendingHandler(Handler* handler) noexcept;
+
+  // Deletes the handler after the current Poll, because its events may
+  // still be dispatched.
+  void DeleteLater(std::unique_ptr<Handler> handler);
+
+  // Active handles keep the event loop alive.
+  void RefHandle() noexcept { ++active_handle_count_; }
+  void UnrefHandle() noexcept { --active_handle_count_; }
+
+  bool Poll(int32_t timeout_ms) override;
+  void Wake() noexcept override;
+  bool HasActiveHandles() const noexcept override {
+    return active_handle_count_ > 0;
+  }
+
+  // Passed to the pending handlers instead of the epoll events.
+  static constexpr uint32_t kPendingEvent = 1u << 31;
+
+ private:
+  NodeLiteReactor(int epoll_fd, int wake_fd) noexcept;
+
+ private:
+  int epoll_fd_;
+  int wake_fd_;
+  uint32_t active_handle_count_{0};
+  std::vector<Handler*> pending_handlers_;
+  std::vector<Handler*> running_pending_handlers_;
+  std::vector<std::unique_ptr<Handler>> retired_handlers_;
+};
+
+class NodeLiteTcpHandle;
+class NodeLiteHttp;
+
+// The native part of the "net" module. It owns the reactor and the TCP
+// servers and sockets. The JS part refers to them by numeric ids.
+class NodeLiteNet {
+ public:
+  // Read buffers are carved from JS ArrayBuffer slabs of this size.
+  // Each read gets a Uint8Array view of the slab without copying.
+  static constexpr size_t kSlabSize = 64 * 1024;
+  static constexpr size_t kMinReadSize = 8 * 1024;
+  // write() returns false while the queued bytes exceed this size.
+  static constexpr size_t kWriteHighWaterMark = 16 * 1024;
+
+  // The JS callbacks set by the net module.
+  enum class Callback : size_t {
+    kOnConnection,
+    kOnConnect,
+    kOnData,
+    kOnEnd,
+    kOnDrain,
+    kOnClose,
+    kOnError,
+    kOnReset,
+    kCount,
+  };
+
+  // The JS source of the module function. It receives the binding object and
+  // the require function and returns the module exports.
+  static const std::string_view kModuleSource;
+
+  NodeLiteNet(napi_env env,
+              std::shared_ptr<NodeLiteTaskRunner> task_runner,
+              std::unique_ptr<NodeLiteReactor> reactor) noexcept;
+  ~NodeLiteNet();
+
+  NodeLiteNet(const NodeLiteNet&) = delete;
+  NodeLiteNet& operator=(const NodeLiteNet&) = delete;
+
+  // Creates the reactor and attaches it to the task runner.
+  static std::unique_ptr<NodeLiteNet> Create(
+      napi_env env, std::shared_ptr<NodeLiteTaskRunner> task_runner);
+
+  napi_value CreateBinding(napi_env env);
+
+  napi_env env() const noexcept { return env_; }
+  NodeLiteReactor& reactor() noexcept { return *reactor_; }
+
+  // Returns a Uint8Array view of the slab memory for the read.
+  // The read writes to the returned buffer before the view is created.
+  char* GetReadBuffer(size_t& size);
+  napi_value CommitReadBuffer(size_t size);
+
+  // Creates a view of a part of the read data before CommitRead is called.
+  napi_value CreateReadView(const char* data, size_t size);
+  void CommitRead(size_t size) noexcept;
+
+  static napi_value DecodeUtf8(napi_env env, napi_value view);
+
+  // The HTTP state is created by the first require('http').
+  NodeLiteHttp& http();
+
+  // The connections accepted by the server are parsed as HTTP requests.
+  void EnableHttp(uint32_t server_id);
+
+  NodeLiteTcpHandle& AddHandle(std::unique_ptr<NodeLiteTcpHandle> handle);
+  NodeLiteTcpHandle* GetHandle(uint32_t id) noexcept;
+  void RemoveHandle(uint32_t id);
+
+  // Closes all servers and sockets without emitting their events and drops
+  // them from the JS maps. The watch mode calls it before it runs the
+  // application again, so that the new run can listen on the same ports.
+  void CloseAllHandles();
+
+  void CallJS(Callback callback, span<napi_value> args);
+
+ private:
+  napi_env env_;
+  std::shared_ptr<NodeLiteTaskRunner> task_runner_;
+  std::unique_ptr<NodeLiteReactor> reactor_;
+  std::unordered_map<uint32_t, std::unique_ptr<NodeLiteTcpHandle>> handles_;
+  std::unique_ptr<NodeLiteHttp> http_;
+  uint32_t next_handle_id_{1};
+  NodeApiRef callbacks_[static_cast<size_t>(Callback::kCount)];
+  NodeApiRef slab_;
+  char* slab_data_{};
+  size_t slab_offset_{kSlabSize};
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_NET_H
@@ -0,0 +1,262 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_options.h"
+#include <charconv>
+#include <iomanip>
+#include <iostream>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+namespace {
+
+bool ParseUInt32(std::string_view value, uint32_t& result) {
+  const char* end = value.data() + value.size();
+  auto [ptr, ec] = std::from_chars(value.data(), end, result);
+  return ec == std::errc{} && ptr == end;
+}
+
+bool ParseUInt16(std::string_view value, uint16_t& result) {
+  uint32_t temp{};
+  if (!ParseUInt32(value, temp) || temp > UINT16_MAX) {
+    return false;
+  }
+  result = static_cast<uint16_t>(temp);
+  return true;
+}
+
+// Describes a command line option.
+// Options with a non-empty value_name require a value that can be passed as
+// "--name=value" or "--name value".
+struct OptionInfo {
+  std::string_view name;
+  std::string_view value_name;
+  std::string_view description;
+  bool (*apply)(NodeLiteOptions& options, std::string_view value);
+};
+
+const OptionInfo kOptions[] = {
+    {"--idle-gc",
+     "<ms>",
+     "Collect garbage when the event loop is idle for the given time.",
+     [](NodeLiteOptions& options, std::string_view value) {
+       uint32_t delay_ms{};
+       if (!ParseUInt32(value, delay_ms)) {
+         return false;
+       }
+       options.idle_gc_delay_ms = delay_ms;
+       return true;
+     }},
+    {"--explicit-microtasks",
+     "",
+     "Drain the microtask queue after each event loop task.",
+     [](NodeLiteOptions& options, std::string_view /*value*/) {
+       options.explicit_microtasks = true;
+       return true;
+     }},
+    {"--preload",
+     "<manifest>",
+     "Load the native addons listed in the manifest on background threads.",
+     [](NodeLiteOptions& options, std::string_view value) {
+       options.preload_manifest = std::string(value);
+       return !value.empty();
+     }},
+    {"--resolution-cache",
+     "<file>",
+     "Load the module resolution map from the file and save it on exit.",
+     [](NodeLiteOptions& options, std::string_view value) {
+       options.resolution_cache = std::string(value);
+       return !value.empty();
+     }},
+    {"--startup-stats",
+     "",
+     "Print the durations of the startup phases on exit.",
+     [](NodeLiteOptions& options, std::string_view /*value*/) {
+       options.startup_stats = true;
+       return true;
+     }},
+    {"--tsfn-stats",
+     "",
+     "Print the threadsafe function metrics on exit.",
+     [](NodeLiteOptions& options, std::string_view /*value*/) {
+       options.tsfn_stats = true;
+       return true;
+     }},
+    {"--watch",
+     "",
+     "Run the script again when the loaded module files change.",
+     [](NodeLiteOptions& options, std::string_view /*value*/) {
+       options.watch = true;
+       return true;
+     }},
+    {"--bench",
+     "",
+     "Benchmark the script instead of running it once.",
+     [](NodeLiteOptions& options, std::string_view /*value*/) {
+       options.bench = true;
+       return true;
+     }},
+    {"--bench-function",
+     "<name>",
+     "Benchmark the exported function instead of re-running the module.",
+     [](NodeLiteOptions& options, std::string_view value) {
+       options.bench = true;
+       options.bench_function = std::string(value);
+       return !value.empty();
+     }},
+    {"--bench-warmup",
+     "<count>",
+     "Number of benchmark warmup iterations. Default: 100.",
+     [](NodeLiteOptions& options, std::string_view value) {
+       options.bench = true;
+       return ParseUInt32(value, options.bench_warmup);
+     }},
+    {"--bench-iterations",
+     "<count>",
+     "Number of measured benchmark iterations. Default: 1000.",
+     [](NodeLiteOptions& options, std::string_view value) {
+       options.bench = true;
+       return ParseUInt32(value, options.bench_iterations) &&
+              options.bench_iterations > 0;
+     }},
+    {"--bench-json",
+     "",
+     "Print the benchmark results as JSON.",
+     [](NodeLiteOptions& options, std::string_view /*value*/) {
+       options.bench = true;
+       options.bench_json = true;
+       return true;
+     }},
+    {"--inspect",
+     "",
+     "Enable the inspector.",
+     [](NodeLiteOptions& options, std::string_view /*value*/) {
+       options.inspect = true;
+       return true;
+     }},
+    {"--inspect-brk",
+     "",
+     "Enable the inspector and break before the script starts.",
+     [](NodeLiteOptions& options, std::string_view /*value*/) {
+       options.inspect = true;
+       options.inspect_break_on_start = true;
+       return true;
+     }},
+    {"--inspect-port",
+     "<port>",
+     "Inspector port. Default: 9229.",
+     [](NodeLiteOptions& options, std::string_view value) {
+       return ParseUInt16(value, options.inspect_port);
+     }},
+};
+
+const OptionInfo* FindOption(std::string_view name) {
+  for (const OptionInfo& option : kOptions) {
+    if (option.name == name) {
+      return &option;
+    }
+  }
+  return nullptr;
+}
+
+[[noreturn]] void ExitWithUsageError(std::string_view exe_name,
+                                     const std::string& message) {
+  NodeLiteErrorHandler::ExitWithMessage(message, [&](std::ostream& os) {
+    os << "Run '" << exe_name << " --help' to see the supported options.";
+  });
+}
+
+}  // namespace
+
+NodeLiteOptions ParseCommandLine(const std::vector<std::string>& argv) {
+  NodeLiteOptions options;
+  std::string_view exe_name = !argv.empty() ? argv[0] : "hermes-cli";
+  options.exe_path = std::string(exe_name);
+
+  size_t index = 1;
+  for (; index < argv.size(); ++index) {
+    std::string_view arg = argv[index];
+    if (arg == "--") {
+      ++index;
+      break;
+    }
+    if (arg.substr(0, 2) != "--") {
+      break;
+    }
+    if (arg == "--help") {
+      PrintUsage(std::cout, exe_name);
+      std::cout << std::endl;
+      exit(0);
+    }
+
+    std::string_view name = arg;
+    std::optional<std::string_view> value;
+    if (size_t eq_pos = arg.find('='); eq_pos != std::string_view::npos) {
+      name = arg.substr(0, eq_pos);
+      value = arg.substr(eq_pos + 1);
+    }
+
+    const OptionInfo* option = FindOption(name);
+    if (option == nullptr) {
+      ExitWithUsageError(exe_name,
+                         "Unknown option: " + std::string(name));
+    }
+    if (option->value_name.empty()) {
+      if (value) {
+        ExitWithUsageError(
+            exe_name,
+            "Option " + std::string(name) + " does not accept a value");
+      }
+    } else if (!value) {
+      if (index + 1 >= argv.size()) {
+        ExitWithUsageError(exe_name,
+                           "Option " + std::string(name) + " requires " +
+                               std::string(option->value_name));
+      }
+      value = argv[++index];
+    }
+    if (!option->apply(options, value.value_or(std::string_view{}))) {
+      ExitWithUsageError(exe_name,
+                         "Invalid value '" + std::string(*value) +
+                             "' for option " + std::string(name) +
+                             ". Expected: " + std::string(option->value_name));
+    }
+  }
+
+  if (index >= argv.size()) {
+    NodeLiteErrorHandler::ExitWithMessage(
+        "", [&](std::ostream& os) { PrintUsage(os, exe_name); });
+  }
+
+  // Each benchmark iteration must include the promise jobs it queued, so the
+  // engine microtasks are drained by hermes-cli in the benchmark mode.
+  if (options.bench) {
+    options.explicit_microtasks = true;
+  }
+
+  options.script_path = argv[index];
+  options.script_args.assign(argv.begin() + index + 1, argv.end());
+  return options;
+}
+
+void PrintUsage(std::ostream& os, std::string_view exe_name) {
+  os << "Usage: " << exe_name
+     << " [options] <js_file|archive.hpak> [arguments]\n"
+     << "       " << exe_name
+     << " pack [--main=<file>] [--hermesc=<path>] <app_dir> <archive.hpak>\n"
+     << "\n"
+     << "Options:\n";
+  for (const OptionInfo& option : kOptions) {
+    std::string spelling = std::string(option.name);
+    if (!option.value_name.empty()) {
+      spelling += "=" + std::string(option.value_name);
+    }
+    os << "  " << std::left << std::setw(44) << spelling << option.description
+       << '\n';
+  }
+  os << "  " << std::left << std::setw(44) << "--help"
+     << "Print this help message.";
+}
+
+}  // namespace node_api_tests
@@ -0,0 +1,76 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Command line options of the Node.js-like runtime.
+
+#ifndef NODE_API_TEST_NODE_LITE_OPTIONS_H
+#define NODE_API_TEST_NODE_LITE_OPTIONS_H
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace node_api_tests {
+
+// Options parsed from the hermes-cli command line.
+struct NodeLiteOptions {
+  // Collect garbage when the event loop has no tasks for this time.
+  std::optional<uint32_t> idle_gc_delay_ms;
+
+  // Microtask queue is drained by hermes-cli instead of the engine.
+  bool explicit_microtasks{false};
+
+  // Inspector (debugger) options.
+  bool inspect{false};
+  bool inspect_break_on_start{false};
+  uint16_t inspect_port{9229};
+
+  // Manifest with the paths of native addons to load on background threads
+  // during startup. One path per line. Relative paths are resolved against
+  // the manifest directory. Lines starting with '#' are comments.
+  std::string preload_manifest;
+
+  // File with the module resolution map. It is loaded on start and updated
+  // on exit, so that later runs resolve modules without the node_modules
+  // lookup.
+  std::string resolution_cache;
+
+  // Print the durations of the startup phases on exit.
+  bool startup_stats{false};
+
+  // Print the threadsafe function metrics on exit.
+  bool tsfn_stats{false};
+
+  // Run the script again when the loaded module files change.
+  // See NodeLiteRuntime::RunWatchMode.
+  bool watch{false};
+
+  // Benchmark mode options. See NodeLiteRuntime::RunBenchmark.
+  bool bench{false};
+  std::string bench_function;
+  uint32_t bench_warmup{100};
+  uint32_t bench_iterations{1000};
+  bool bench_json{false};
+
+  // Path to the executable, the script, and the arguments passed to the
+  // script. They are exposed to JS as process.argv.
+  std::string exe_path;
+  std::string script_path;
+  std::vector<std::string> script_args;
+};
+
+// Parses the command line arguments.
+// All options must precede the script path. Arguments after the script path
+// are passed to the script as is. The "--" argument ends the option list.
+// It exits the process with an error message on unknown or invalid options.
+NodeLiteOptions ParseCommandLine(const std::vector<std::string>& argv);
+
+// Prints the command line usage and the list of supported options.
+void PrintUsage(std::ostream& os, std::string_view exe_name);
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_OPTIONS_H
@@ -0,0 +1,839 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_path.h"
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "node_lite_text.h"
+
+namespace fs = std::filesystem;
+
+namespace node_api_tests {
+
+namespace {
+
+// The initial capacity of the reused module buffers.
+constexpr size_t kInitialBufferSize = 1024;
+
+inline bool IsSeparator(char c) noexcept {
+#ifdef _WIN32
+  return c == '/' || c == '\\';
+#else
+  return c == '/';
+#endif
+}
+
+inline char ToLowerAscii(char c) noexcept {
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// The Windows paths are compared without case like in Node.js.
+inline bool IsSameChar(char left, char right) noexcept {
+#ifdef _WIN32
+  return ToLowerAscii(left) == ToLowerAscii(right);
+#else
+  return left == right;
+#endif
+}
+
+bool IsSamePath(std::string_view left, std::string_view right) noexcept {
+  if (left.size() != right.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < left.size(); ++i) {
+    if (!IsSameChar(left[i], right[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#ifdef _WIN32
+inline bool IsDriveLetter(char c) noexcept {
+  return ToLowerAscii(c) >= 'a' && ToLowerAscii(c) <= 'z';
+}
+
+inline bool HasDrive(std::string_view path) noexcept {
+  return path.size() >= 2 && IsDriveLetter(path[0]) && path[1] == ':';
+}
+
+size_t FindSeparator(std::string_view path, size_t index) noexcept {
+  while (index < path.size() && !IsSeparator(path[index])) {
+    ++index;
+  }
+  return index;
+}
+#endif
+
+// The root at the start of a path.
+struct PathRoot {
+  // The drive ("C:") or the UNC share ("\\server\share") on Windows.
+  std::string_view device;
+  // The number of path bytes taken by the device and the root separator.
+  size_t size{};
+  bool is_absolute{};
+};
+
+PathRoot ParseRoot(std::string_view path) noexcept {
+  PathRoot root;
+  if (path.empty()) {
+    return root;
+  }
+  if (IsSeparator(path[0])) {
+    root.size = 1;
+    root.is_absolute = true;
+#ifdef _WIN32
+    // A UNC root has two separators, the server name, separators, and the
+    // share name. Without the share name it is a plain root separator.
+    if (path.size() > 2 && IsSeparator(path[1]) && !IsSeparator(path[2])) {
+      size_t server_end = FindSeparator(path, 2);
+      size_t share_begin = server_end;
+      while (share_begin < path.size() && IsSeparator(path[share_begin])) {
+        ++share_begin;
+      }
+      size_t share_end = FindSeparator(path, share_begin);
+      if (share_end > share_begin) {
+        root.device = path.substr(0, share_end);
+        root.size = std::min(share_end + 1, path.size());
+      }
+    }
+  } else if (HasDrive(path)) {
+    root.device = path.substr(0, 2);
+    root.size = 2;
+    if (path.size() > 2 && IsSeparator(path[2])) {
+      root.size = 3;
+      root.is_absolute = true;
+    }
+#endif
+  }
+  return root;
+}
+
+// Appends the device and the root separator. The UNC device separators are
+// converted and not repeated.
+void AppendRoot(std::string_view device,
+                bool is_absolute,
+                std::string& result) {
+  for (size_t i = 0; i < device.size(); ++i) {
+    if (!IsSeparator(device[i])) {
+      result += device[i];
+    } else if (i < 2 || !IsSeparator(device[i - 1])) {
+      result += NodeLitePath::kSeparator;
+    }
+  }
+  if (is_absolute) {
+    result += NodeLitePath::kSeparator;
+  }
+}
+
+// Appends the segments of paths after the root in the result. The "."
+// segments and the repeated separators are skipped. A ".." segment removes
+// the previous segment. In relative paths the leading ".." are kept.
+class SegmentWriter {
+ public:
+  SegmentWriter(std::string& result, bool is_absolute) noexcept
+      : result_(result),
+        root_size_(result.size()),
+        is_absolute_(is_absolute) {}
+
+  void Append(std::string_view path) {
+    size_t index = 0;
+    while (index < path.size()) {
+      if (IsSeparator(path[index])) {
+        ++index;
+        continue;
+      }
+      size_t begin = index;
+      while (index < path.size() && !IsSeparator(path[index])) {
+        ++index;
+      }
+      AppendSegment(path.substr(begin, index - begin));
+    }
+  }
+
+  bool empty() const noexcept { return result_.size() == root_size_; }
+
+  // Adds "." to an empty relative path and the trailing separator of the
+  // source path.
+  void Finish(bool has_trailing_separator) {
+    if (empty()) {
+      if (is_absolute_) {
+        return;
+      }
+      result_ += '.';
+    }
+    if (has_trailing_separator) {
+      result_ += NodeLitePath::kSeparator;
+    }
+  }
+
+ private:
+  void AppendSegment(std::string_view segment) {
+    if (segment == ".") {
+      return;
+    }
+    if (segment == "..") {
+      if (depth_ > 0) {
+        size_t separator = result_.rfind(NodeLitePath::kSeparator);
+        result_.resize(separator != std::string::npos && separator >= root_size_
+                           ? separator
+                           : root_size_);
+        --depth_;
+        return;
+      }
+      if (is_absolute_) {
+        return;
+      }
+    } else {
+      ++depth_;
+    }
+    if (!empty()) {
+      result_ += NodeLitePath::kSeparator;
+    }
+    result_.append(segment);
+  }
+
+ private:
+  std::string& result_;
+  size_t root_size_;
+  bool is_absolute_;
+  // The number of the segments that a ".." can remove.
+  size_t depth_{0};
+};
+
+inline bool HasTrailingSeparator(std::string_view path) noexcept {
+  return !path.empty() && IsSeparator(path.back());
+}
+
+#ifdef _WIN32
+// Prefixes a relative path without a device with ".\" when Windows could
+// read its colon as a device like Node.js does (CVE-2024-36139): a colon at
+// the end of a segment or a result that starts with a drive. The paths are
+// the joined sources of the result that starts at the offset.
+void ProtectDeviceColon(span<const std::string_view> paths,
+                        size_t offset,
+                        std::string& result) {
+  bool has_colon = false;
+  for (std::string_view path : paths) {
+    for (size_t index = path.find(':'); index != std::string_view::npos;
+         index = path.find(':', index + 1)) {
+      if (index + 1 == path.size() || IsSeparator(path[index + 1])) {
+        result.insert(offset, ".\\");
+        return;
+      }
+      has_colon = true;
+    }
+  }
+  if (has_colon && HasDrive(std::string_view(result).substr(offset))) {
+    result.insert(offset, ".\\");
+  }
+}
+#endif
+
+// Returns the last segment without the trailing separators.
+std::string_view GetLastSegment(std::string_view path) noexcept {
+#ifdef _WIN32
+  // The drive of "C:name" is not a part of the name.
+  if (HasDrive(path)) {
+    path.remove_prefix(2);
+  }
+#endif
+  size_t end = path.size();
+  while (end > 0 && IsSeparator(path[end - 1])) {
+    --end;
+  }
+  size_t begin = end;
+  while (begin > 0 && !IsSeparator(path[begin - 1])) {
+    --begin;
+  }
+  return path.substr(begin, end - begin);
+}
+
+// Removes the leading and the trailing separators.
+std::string_view TrimSeparators(std::string_view path) noexcept {
+  while (!path.empty() && IsSeparator(path.front())) {
+    path.remove_prefix(1);
+  }
+  while (!path.empty() && IsSeparator(path.back())) {
+    path.remove_suffix(1);
+  }
+  return path;
+}
+
+// Returns the next segment of a normalized path and moves the index after it.
+std::string_view NextSegment(std::string_view path, size_t& index) noexcept {
+  size_t begin = index;
+  index = path.find(NodeLitePath::kSeparator, begin);
+  if (index == std::string_view::npos) {
+    index = path.size();
+  }
+  std::string_view segment = path.substr(begin, index - begin);
+  if (index < path.size()) {
+    ++index;
+  }
+  return segment;
+}
+
+// The buffers reused by the module functions. The arguments are copied back
+// to back to the input buffer and the results are built in the result
+// buffer, so the calls do not allocate after the buffers have grown to the
+// size of the longest paths.
+struct PathBuffers {
+  PathBuffers() {
+    input.reserve(kInitialBufferSize);
+    result.reserve(kInitialBufferSize);
+  }
+
+  std::string input;
+  std::string result;
+  std::vector<std::string_view> paths;
+};
+
+// Copies the UTF-8 of the string arguments to the input buffer. All path
+// syntax is ASCII, so the algorithms work on the UTF-8 bytes directly.
+span<const std::string_view> ReadPaths(napi_env env,
+                                       span<napi_value> args,
+                                       PathBuffers& buffers) {
+  buffers.input.clear();
+  buffers.paths.clear();
+  for (napi_value arg : args) {
+    NODE_LITE_ASSERT(NodeApi::TypeOf(env, arg) == napi_string,
+                     "The \"path\" argument must be of type string");
+    size_t size{};
+    NODE_LITE_CALL(napi_get_value_string_utf8(env, arg, nullptr, 0, &size));
+    size_t offset = buffers.input.size();
+    buffers.input.resize(offset + size + 1);
+    NODE_LITE_CALL(napi_get_value_string_utf8(
+        env, arg, &buffers.input[offset], size + 1, nullptr));
+    buffers.input.resize(offset + size);
+    // The data pointers are set after the input stops growing.
+    buffers.paths.emplace_back(nullptr, size);
+  }
+  const char* data = buffers.input.data();
+  for (std::string_view& path : buffers.paths) {
+    path = std::string_view(data, path.size());
+    data += path.size();
+  }
+  return span<const std::string_view>(buffers.paths.data(),
+                                      buffers.paths.size());
+}
+
+// Creates the result string. The ASCII paths are created as Latin-1 strings
+// without UTF-8 decoding.
+napi_value CreatePathString(napi_env env, std::string_view path) {
+  napi_value result{};
+  if (NodeLiteUtf8::FindNonAscii(path.data(), path.size()) == path.size()) {
+    NODE_LITE_CALL(
+        napi_create_string_latin1(env, path.data(), path.size(), &result));
+  } else {
+    NODE_LITE_CALL(
+        napi_create_string_utf8(env, path.data(), path.size(), &result));
+  }
+  return result;
+}
+
+// Returns true if the path is resolved without the current directory. On
+// Windows the path also needs a device.
+// The bytes encoded by url.pathToFileURL: the C0 controls, the space, the
+// non-ASCII bytes, the URL path percent-encode set, and '%'.
+inline bool IsUrlPathByte(char c) noexcept {
+  unsigned char byte = static_cast<unsigned char>(c);
+  if (byte <= 0x20 || byte >= 0x7F) {
+    return false;
+  }
+  switch (c) {
+    case '"':
+    case '#':
+    case '%':
+    case '<':
+    case '>':
+    case '?':
+    case '`':
+    case '{':
+    case '}':
+#ifndef _WIN32
+    // A POSIX file name may contain the Windows separator.
+    case '\\':
+#endif
+      return false;
+    default:
+      return true;
+  }
+}
+
+inline int HexDigitValue(char c) noexcept {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = ToLowerAscii(c);
+  return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+bool IsFullyQualified(std::string_view path) noexcept {
+  PathRoot root = ParseRoot(path);
+#ifdef _WIN32
+  return root.is_absolute && !root.device.empty();
+#else
+  return root.is_absolute;
+#endif
+}
+
+}  // namespace
+
+//=============================================================================
+// NodeLitePath implementation
+//=============================================================================
+
+/*static*/ bool NodeLitePath::IsAbsolute(std::string_view path) noexcept {
+  return ParseRoot(path).is_absolute;
+}
+
+/*static*/ void NodeLitePath::Normalize(std::string_view path,
+                                        std::string& result) {
+  [[maybe_unused]] size_t offset = result.size();
+  PathRoot root = ParseRoot(path);
+  AppendRoot(root.device, root.is_absolute, result);
+  SegmentWriter writer(result, root.is_absolute);
+  writer.Append(path.substr(root.size));
+  writer.Finish(HasTrailingSeparator(path.substr(root.size)));
+#ifdef _WIN32
+  if (root.device.empty() && !root.is_absolute) {
+    ProtectDeviceColon(span<const std::string_view>(&path, 1), offset, result);
+  }
+#endif
+}
+
+/*static*/ void NodeLitePath::Join(span<const std::string_view> paths,
+                                   std::string& result) {
+  size_t first = 0;
+  while (first < paths.size() && paths[first].empty()) {
+    ++first;
+  }
+  if (first == paths.size()) {
+    result += '.';
+    return;
+  }
+  size_t last = paths.size() - 1;
+  while (paths[last].empty()) {
+    --last;
+  }
+#ifdef _WIN32
+  // A first path that starts with exactly two separators is a UNC path whose
+  // root can span the joined paths. Node.js joins and then normalizes it.
+  std::string_view first_path = paths[first];
+  if (first_path.size() > 2 && IsSeparator(first_path[0]) &&
+      IsSeparator(first_path[1]) && !IsSeparator(first_path[2])) {
+    std::string joined{first_path};
+    for (size_t i = first + 1; i <= last; ++i) {
+      if (!paths[i].empty()) {
+        joined += kSeparator;
+        joined.append(paths[i]);
+      }
+    }
+    Normalize(joined, result);
+    return;
+  }
+#endif
+  [[maybe_unused]] size_t offset = result.size();
+  PathRoot root = ParseRoot(paths[first]);
+  // The separator joined after a bare drive makes it absolute: "C:" and "a"
+  // join to "C:\a".
+  if (!root.device.empty() && !root.is_absolute &&
+      root.size == paths[first].size() && last > first) {
+    root.is_absolute = true;
+  }
+  AppendRoot(root.device, root.is_absolute, result);
+  SegmentWriter writer(result, root.is_absolute);
+  writer.Append(paths[first].substr(root.size));
+  for (size_t i = first + 1; i <= last; ++i) {
+    writer.Append(paths[i]);
+  }
+  writer.Finish(last > first ? HasTrailingSeparator(paths[last])
+                             : HasTrailingSeparator(
+                                   paths[first].substr(root.size)));
+#ifdef _WIN32
+  if (root.device.empty() && !root.is_absolute) {
+    ProtectDeviceColon(
+        span<const std::string_view>(paths.data() + first, last - first + 1),
+        offset,
+        result);
+  }
+#endif
+}
+
+/*static*/ void NodeLitePath::Resolve(span<const std::string_view> paths,
+                                      std::string_view cwd,
+                                      std::string& result) {
+  // Find the paths that are used from right to left. On Windows the result
+  // also needs a device. The paths on other devices are skipped.
+  std::string_view device;
+  bool is_absolute = false;
+  size_t first = paths.size();
+  for (size_t i = paths.size(); i > 0; --i) {
+    std::string_view path = paths[i - 1];
+    if (path.empty()) {
+      continue;
+    }
+    PathRoot root = ParseRoot(path);
+    if (!root.device.empty()) {
+      if (device.empty()) {
+        device = root.device;
+      } else if (!IsSamePath(root.device, device)) {
+        continue;
+      }
+    }
+    if (!is_absolute) {
+      first = i - 1;
+      is_absolute = root.is_absolute;
+    }
+#ifdef _WIN32
+    if (is_absolute && !device.empty()) {
+      break;
+    }
+#else
+    if (is_absolute) {
+      break;
+    }
+#endif
+  }
+
+  // The current directory completes the path. On another drive the path is
+  // resolved against its root.
+  std::string_view base;
+  if (!is_absolute || device.empty()) {
+    PathRoot cwd_root = ParseRoot(cwd);
+    if (device.empty() || IsSamePath(cwd_root.device, device)) {
+      if (device.empty()) {
+        device = cwd_root.device;
+      }
+      if (!is_absolute) {
+        base = cwd.substr(cwd_root.size);
+      }
+    }
+    is_absolute = true;
+  }
+
+  AppendRoot(device, is_absolute, result);
+  SegmentWriter writer(result, is_absolute);
+  writer.Append(base);
+  for (size_t i = first; i < paths.size(); ++i) {
+    std::string_view path = paths[i];
+    PathRoot root = ParseRoot(path);
+    if (root.device.empty() || IsSamePath(root.device, device)) {
+      writer.Append(path.substr(root.size));
+    }
+  }
+  writer.Finish(/*has_trailing_separator:*/ false);
+}
+
+/*static*/ void NodeLitePath::Relative(std::string_view from,
+                                       std::string_view to,
+                                       std::string_view cwd,
+                                       std::string& result) {
+  // Both paths are resolved to the end of the result. The relative path is
+  // written after them and then moved to the start.
+  size_t start = result.size();
+  Resolve(span<const std::string_view>(&from, 1), cwd, result);
+  size_t from_end = result.size();
+  Resolve(span<const std::string_view>(&to, 1), cwd, result);
+  size_t to_end = result.size();
+  // Each segment of `from` takes at most three bytes as "..".
+  result.reserve(to_end + 2 * (from_end - start) + (to_end - from_end));
+  std::string_view from_path(result.data() + start, from_end - start);
+  std::string_view to_path(result.data() + from_end, to_end - from_end);
+
+  // The devices are compared as the first segments like in Node.js.
+  std::string_view from_tail = TrimSeparators(from_path);
+  std::string_view to_tail = TrimSeparators(to_path);
+  // The positions after the common segments.
+  size_t from_common = 0;
+  size_t to_common = 0;
+  while (from_common < from_tail.size() && to_common < to_tail.size()) {
+    size_t from_index = from_common;
+    size_t to_index = to_common;
+    if (!IsSamePath(NextSegment(from_tail, from_index),
+                    NextSegment(to_tail, to_index))) {
+      break;
+    }
+    from_common = from_index;
+    to_common = to_index;
+  }
+#ifdef _WIN32
+  // The paths on different drives have no relative path.
+  if (from_common == 0) {
+    result.append(to_path);
+    result.erase(start, to_end - start);
+    return;
+  }
+#endif
+  // Go up from each segment of `from` after the common ones.
+  while (from_common < from_tail.size()) {
+    NextSegment(from_tail, from_common);
+    if (result.size() > to_end) {
+      result += kSeparator;
+    }
+    result.append("..");
+  }
+  std::string_view rest = to_tail.substr(to_common);
+  if (!rest.empty()) {
+    if (result.size() > to_end) {
+      result += kSeparator;
+    }
+    result.append(rest);
+  }
+  result.erase(start, to_end - start);
+}
+
+/*static*/ std::string_view NodeLitePath::Dirname(
+    std::string_view path) noexcept {
+  if (path.empty()) {
+    return ".";
+  }
+  PathRoot root = ParseRoot(path);
+  if (root.size == path.size()) {
+    return path;
+  }
+  // Skip the trailing separators and the last segment.
+  size_t end = std::string_view::npos;
+  bool in_trailing_separators = true;
+  for (size_t i = path.size() - 1; i >= std::max<size_t>(root.size, 1); --i) {
+    if (!IsSeparator(path[i])) {
+      in_trailing_separators = false;
+    } else if (!in_trailing_separators) {
+      end = i;
+      break;
+    }
+  }
+  if (end == std::string_view::npos) {
+    return root.size > 0 ? path.substr(0, root.size) : ".";
+  }
+#ifndef _WIN32
+  // Node.js keeps the POSIX "//" root.
+  if (root.size == 1 && end == 1) {
+    return path.substr(0, 2);
+  }
+#endif
+  return path.substr(0, end);
+}
+
+/*static*/ std::string_view NodeLitePath::Basename(
+    std::string_view path, std::string_view suffix) noexcept {
+  // Like in Node.js a suffix that is the whole name is kept, unless it is
+  // also the whole path.
+  if (!suffix.empty() && path == suffix) {
+    return {};
+  }
+  std::string_view name = GetLastSegment(path);
+  if (!suffix.empty() && name.size() > suffix.size() &&
+      name.substr(name.size() - suffix.size()) == suffix) {
+    name.remove_suffix(suffix.size());
+  }
+  return name;
+}
+
+/*static*/ std::string_view NodeLitePath::Extname(
+    std::string_view path) noexcept {
+  std::string_view name = GetLastSegment(path);
+  size_t dot = name.rfind('.');
+  // The leading dot of names like ".profile" and ".." does not start an
+  // extension.
+  if (dot == std::string_view::npos || dot == 0 || name == "..") {
+    return {};
+  }
+  return name.substr(dot);
+}
+
+/*static*/ void NodeLitePath::ToFileUrl(std::string_view path,
+                                        std::string& result) {
+  constexpr char kHexDigits[] = "0123456789ABCDEF";
+  result += "file://";
+#ifdef _WIN32
+  if (path.size() >= 2 && IsSeparator(path[0]) && IsSeparator(path[1])) {
+    // The server of the UNC path "\\server\share" is the URL host.
+    path.remove_prefix(2);
+  } else {
+    result += '/';
+  }
+#endif
+  for (char c : path) {
+    if (IsSeparator(c)) {
+      result += '/';
+    } else if (IsUrlPathByte(c)) {
+      result += c;
+    } else {
+      unsigned char byte = static_cast<unsigned char>(c);
+      result += '%';
+      result += kHexDigits[byte >> 4];
+      result += kHexDigits[byte & 0xF];
+    }
+  }
+}
+
+/*static*/ bool NodeLitePath::FromFileUrl(std::string_view url,
+                                          std::string& result) {
+  if (!IsFileUrl(url)) {
+    return false;
+  }
+  url.remove_prefix(7);
+  url = url.substr(0, url.find_first_of("?#"));
+  size_t path_start = url.find('/');
+  if (path_start == std::string_view::npos) {
+    return false;
+  }
+  std::string_view host = url.substr(0, path_start);
+  std::string_view path = url.substr(path_start);
+  if (host == "localhost") {
+    host = {};
+  }
+#ifdef _WIN32
+  if (!host.empty()) {
+    result += "\\\\";
+    result += host;
+  } else if (path.size() >= 3 && IsDriveLetter(path[1]) && path[2] == ':') {
+    // "/C:/dir" is the path "C:\dir".
+    path.remove_prefix(1);
+  } else {
+    return false;
+  }
+#else
+  if (!host.empty()) {
+    return false;
+  }
+#endif
+  for (size_t i = 0; i < path.size(); ++i) {
+    char c = path[i];
+    if (c == '%') {
+      int high = i + 2 < path.size() ? HexDigitValue(path[i + 1]) : -1;
+      int low = high >= 0 ? HexDigitValue(path[i + 2]) : -1;
+      if (low < 0) {
+        return false;
+      }
+      c = static_cast<char>(high * 16 + low);
+      if (IsSeparator(c)) {
+        return false;
+      }
+      i += 2;
+    } else if (c == '/') {
+      c = kSeparator;
+    }
+    result += c;
+  }
+  return true;
+}
+
+/*static*/ bool NodeLitePath::IsFileUrl(std::string_view specifier) noexcept {
+  return specifier.size() >= 7 && specifier.compare(0, 7, "file://") == 0;
+}
+
+/*static*/ napi_value NodeLitePath::InitModule(napi_env env,
+                                               napi_value exports) {
+  auto buffers = std::make_shared<PathBuffers>();
+
+  NodeApi::SetPropertyString(env, exports, "sep", {&kSeparator, 1});
+  NodeApi::SetPropertyString(env, exports, "delimiter", {&kDelimiter, 1});
+
+  NodeApi::SetMethod(
+      env,
+      exports,
+      "isAbsolute",
+      [buffers](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+        span<const std::string_view> paths =
+            ReadPaths(env, span<napi_value>(args.data(), 1), *buffers);
+        return NodeApi::GetBoolean(env, IsAbsolute(paths[0]));
+      });
+
+  NodeApi::SetMethod(
+      env,
+      exports,
+      "normalize",
+      [buffers](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+        span<const std::string_view> paths =
+            ReadPaths(env, span<napi_value>(args.data(), 1), *buffers);
+        buffers->result.clear();
+        Normalize(paths[0], buffers->result);
+        return CreatePathString(env, buffers->result);
+      });
+
+  NodeApi::SetMethod(
+      env, exports, "join", [buffers](napi_env env, span<napi_value> args) {
+        span<const std::string_view> paths = ReadPaths(env, args, *buffers);
+        buffers->result.clear();
+        Join(paths, buffers->result);
+        return CreatePathString(env, buffers->result);
+      });
+
+  NodeApi::SetMethod(
+      env, exports, "resolve", [buffers](napi_env env, span<napi_value> args) {
+        span<const std::string_view> paths = ReadPaths(env, args, *buffers);
+        // The current directory is only read when it is needed.
+        std::string cwd;
+        bool is_qualified = false;
+        for (std::string_view path : paths) {
+          is_qualified = is_qualified || IsFullyQualified(path);
+        }
+        if (!is_qualified) {
+          cwd = fs::current_path().string();
+        }
+        buffers->result.clear();
+        Resolve(paths, cwd, buffers->result);
+        return CreatePathString(env, buffers->result);
+      });
+
+  NodeApi::SetMethod(
+      env,
+      exports,
+      "relative",
+      [buffers](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2,
+                         "Expected at least 2 arguments, but got: %zu",
+                         args.size());
+        span<const std::string_view> paths =
+            ReadPaths(env, span<napi_value>(args.data(), 2), *buffers);
+        std::string cwd;
+        if (!IsFullyQualified(paths[0]) || !IsFullyQualified(paths[1])) {
+          cwd = fs::current_path().string();
+        }
+        buffers->result.clear();
+        Relative(paths[0], paths[1], cwd, buffers->result);
+        return CreatePathString(env, buffers->result);
+      });
+
+  NodeApi::SetMethod(
+      env, exports, "dirname", [buffers](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+        span<const std::string_view> paths =
+            ReadPaths(env, span<napi_value>(args.data(), 1), *buffers);
+        return CreatePathString(env, Dirname(paths[0]));
+      });
+
+  NodeApi::SetMethod(
+      env,
+      exports,
+      "basename",
+      [buffers](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+        bool has_suffix = args.size() >= 2 &&
+                          NodeApi::TypeOf(env, args[1]) != napi_undefined;
+        span<const std::string_view> paths = ReadPaths(
+            env, span<napi_value>(args.data(), has_suffix ? 2 : 1), *buffers);
+        return CreatePathString(
+            env, Basename(paths[0], has_suffix ? paths[1] : ""));
+      });
+
+  NodeApi::SetMethod(
+      env, exports, "extname", [buffers](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+        span<const std::string_view> paths =
+            ReadPaths(env, span<napi_value>(args.data(), 1), *buffers);
+        return CreatePathString(env, Extname(paths[0]));
+      });
+
+  return exports;
+}
+
+}  // namespace node_api_tests
@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// The "path" built-in module.
+
+#ifndef NODE_API_TEST_NODE_LITE_PATH_H
+#define NODE_API_TEST_NODE_LITE_PATH_H
+
+#include <string>
+#include <string_view>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+// The path functions of Node.js: path.posix on POSIX and path.win32 on
+// Windows. They work on the UTF-8 bytes of the paths without splitting them
+// into segment strings. The functions that build a path append it to a
+// result string, so a caller can reuse one buffer for all calls.
+class NodeLitePath {
+ public:
+#ifdef _WIN32
+  static constexpr char kSeparator = '\\';
+  static constexpr char kDelimiter = ';';
+#else
+  static constexpr char kSeparator = '/';
+  static constexpr char kDelimiter = ':';
+#endif
+
+  static bool IsAbsolute(std::string_view path) noexcept;
+
+  // Resolves the "." and ".." segments and removes the repeated separators.
+  // An empty path becomes ".".
+  static void Normalize(std::string_view path, std::string& result);
+
+  // Joins the non-empty paths with the separator and normalizes the result.
+  static void Join(span<const std::string_view> paths, std::string& result);
+
+  // Resolves the paths from right to left until an absolute path is built.
+  // The cwd absolute path is used when none of the paths is absolute. The
+  // result has no trailing separator.
+  static void Resolve(span<const std::string_view> paths,
+                      std::string_view cwd,
+                      std::string& result);
+
+  // Appends the relative path from the `from` to the `to` path after
+  // resolving both of them against the cwd.
+  static void Relative(std::string_view from,
+                       std::string_view to,
+                       std::string_view cwd,
+                       std::string& result);
+
+  // Return a part of the path.
+  static std::string_view Dirname(std::string_view path) noexcept;
+  static std::string_view Basename(std::string_view path,
+                                   std::string_view suffix = {}) noexcept;
+  static std::string_view Extname(std::string_view path) noexcept;
+
+  // Appends the "file:" URL of an absolute UTF-8 path like
+  // url.pathToFileURL: "file:///C:/dir/a%20b.mjs" on Windows and
+  // "file:///dir/a%20b.mjs" on POSIX. The bytes that a URL path cannot hold
+  // and '%' are percent-encoded.
+  static void ToFileUrl(std::string_view path, std::string& result);
+
+  // Appends the UTF-8 path of a "file:" URL like url.fileURLToPath. The
+  // query and the fragment are ignored. Returns false if the URL has a
+  // remote host, an invalid escape, or an encoded separator.
+  static bool FromFileUrl(std::string_view url, std::string& result);
+
+  static bool IsFileUrl(std::string_view specifier) noexcept;
+
+  // Defines the module functions and constants on the exports object.
+  static napi_value InitModule(napi_env env, napi_value exports);
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_PATH_H
@@ -0,0 +1,147 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include "node_lite.h"
+
+extern char** environ;
+
+namespace node_api_tests {
+
+//=============================================================================
+// NodeLitePlatform implementation
+//=============================================================================
+
+/*static*/ void* NodeLitePlatform::OpenLibrary(
+    const std::filesystem::path& lib_path, std::string& error) noexcept {
+  // The addons resolve the Node-API functions exported by the executable.
+  void* lib_handle = ::dlopen(lib_path.c_str(), RTLD_LAZY | RTLD_LOCAL);
+  if (lib_handle == nullptr) {
+    const char* dl_error = ::dlerror();
+    error = dl_error != nullptr ? dl_error : "Unknown dlopen error";
+  }
+  return lib_handle;
+}
+
+/*static*/ void* NodeLitePlatform::FindFunction(
+    void* lib_handle, const char* function_name) noexcept {
+  return ::dlsym(lib_handle, function_name);
+}
+
+/*static*/ void NodeLitePlatform::CloseLibrary(void* lib_handle) noexcept {
+  ::dlclose(lib_handle);
+}
+
+/*static*/ const void* NodeLitePlatform::MapFile(
+    const std::filesystem::path& file_path,
+    size_t& size,
+    std::string& error) noexcept {
+  int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error = std::strerror(errno);
+    return nullptr;
+  }
+  struct stat file_stat {};
+  if (::fstat(fd, &file_stat) != 0) {
+    error = std::strerror(errno);
+    ::close(fd);
+    return nullptr;
+  }
+  if (file_stat.st_size <= 0) {
+    error = "Empty file";
+    ::close(fd);
+    return nullptr;
+  }
+  size = static_cast<size_t>(file_stat.st_size);
+  // The mapping keeps the file open.
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    error = std::strerror(errno);
+    return nullptr;
+  }
+  return data;
+}
+
+/*static*/ void NodeLitePlatform::UnmapFile(const void* data,
+                                            size_t size) noexcept {
+  ::munmap(const_cast<void*>(data), size);
+}
+
+/*static*/ int64_t NodeLitePlatform::ReadStdin(char* buffer,
+                                              size_t size,
+                                              std::string& error) noexcept {
+  for (;;) {
+    ssize_t result = ::read(STDIN_FILENO, buffer, size);
+    if (result >= 0) {
+      return result;
+    }
+    if (errno != EINTR) {
+      error = std::string("read: ") + std::strerror(errno);
+      return -1;
+    }
+  }
+}
+
+/*static*/ std::filesystem::path NodeLitePlatform::CreatePrivateTempDirectory(
+    std::string_view prefix, std::string& error) noexcept {
+  std::error_code ec;
+  std::filesystem::path temp_dir = std::filesystem::temp_directory_path(ec);
+  if (ec) {
+    error = ec.message();
+    return {};
+  }
+  std::string path_template =
+      (temp_dir / std::string(prefix)).string() + "XXXXXX";
+  // mkdtemp creates the folder with the 0700 mode.
+  if (::mkdtemp(path_template.data()) == nullptr) {
+    error = std::string("mkdtemp: ") + std::strerror(errno);
+    return {};
+  }
+  return path_template;
+}
+
+/*static*/ int32_t NodeLitePlatform::RunProcess(
+    const std::filesystem::path& program,
+    const std::vector<std::string>& args,
+    std::string& error) noexcept {
+  std::string program_path = program.string();
+  std::vector<char*> argv;
+  argv.reserve(args.size() + 2);
+  argv.push_back(program_path.data());
+  for (const std::string& arg : args) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+  pid_t pid{};
+  // posix_spawnp looks up the program in the PATH like a shell would.
+  int result = ::posix_spawnp(
+      &pid, program_path.c_str(), nullptr, nullptr, argv.data(), environ);
+  if (result != 0) {
+    error = std::string("posix_spawnp: ") + std::strerror(result);
+    return -1;
+  }
+  int status{};
+  while (::waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      error = std::string("waitpid: ") + std::strerror(errno);
+      return -1;
+    }
+  }
+  if (!WIFEXITED(status)) {
+    error = "The process was terminated by a signal";
+    return -1;
+  }
+  return WEXITSTATUS(status);
+}
+
+}  // namespace node_api_tests
@@ -0,0 +1,597 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_readline.h"
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "node_lite_cpu.h"
+
+namespace fs = std::filesystem;
+
+namespace node_api_tests {
+
+namespace {
+
+using Line = NodeLiteLineScanner::Line;
+
+// The lines of one chunk are created in batches of this size.
+constexpr size_t kChunkLineBatchSize = 256;
+
+inline uint32_t CountTrailingZeros(uint64_t value) noexcept {
+#ifdef _MSC_VER
+  unsigned long index{};
+  _BitScanForward64(&index, value);
+  return index;
+#else
+  return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+// Returns the mask of the bits from the bit index to the end.
+inline uint64_t MaskFrom(size_t bit_index) noexcept {
+  return bit_index >= 64 ? 0 : ~((uint64_t{1} << bit_index) - 1);
+}
+
+bool HasNonAscii(const char* data, size_t size) noexcept {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word{};
+    std::memcpy(&word, data + i, 8);
+    if ((word & 0x8080808080808080u) != 0) {
+      return true;
+    }
+  }
+  for (; i < size; ++i) {
+    if ((static_cast<uint8_t>(data[i]) & 0x80) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// The state of a line search. The SIMD kernels pass the newline and non-ASCII
+// byte masks of each block to it.
+struct LineSearch {
+  const char* data;
+  Line* lines;
+  size_t max_lines;
+  size_t count;
+  size_t line_start;
+  bool line_has_non_ascii;
+
+  // Returns false when the lines are full.
+  bool AddLine(size_t newline_pos, bool has_non_ascii) noexcept {
+    size_t line_end = newline_pos;
+    if (line_end > line_start && data[line_end - 1] == '\r') {
+      --line_end;
+    }
+    lines[count++] = Line{line_start, line_end, !has_non_ascii};
+    line_start = newline_pos + 1;
+    line_has_non_ascii = false;
+    return count < max_lines;
+  }
+
+  // Adds the lines that end in a block of up to 64 bytes. Bit i of the masks
+  // is set if the byte at block_pos + i is a newline or a non-ASCII byte.
+  // Returns false when the lines are full.
+  bool AddBlock(size_t block_pos,
+                uint64_t newline_mask,
+                uint64_t non_ascii_mask) noexcept {
+    while (newline_mask != 0) {
+      uint32_t bit = CountTrailingZeros(newline_mask);
+      uint64_t line_mask =
+          GetLineMask(block_pos) & ((uint64_t{1} << bit) - 1);
+      if (!AddLine(block_pos + bit,
+                   line_has_non_ascii || (non_ascii_mask & line_mask) != 0)) {
+        return false;
+      }
+      newline_mask &= newline_mask - 1;
+    }
+    line_has_non_ascii = line_has_non_ascii ||
+                         (non_ascii_mask & GetLineMask(block_pos)) != 0;
+    return true;
+  }
+
+  // Returns the mask of the block bits from the current line start.
+  uint64_t GetLineMask(size_t block_pos) const noexcept {
+    return line_start > block_pos ? MaskFrom(line_start - block_pos)
+                                  : ~uint64_t{0};
+  }
+};
+
+// The line start may precede the position when the search continues a line.
+void FindLinesScalar(LineSearch& search, size_t pos, size_t size) noexcept {
+  while (pos < size) {
+    const void* newline = std::memchr(search.data + pos, '\n', size - pos);
+    if (newline == nullptr) {
+      search.line_has_non_ascii = search.line_has_non_ascii ||
+                                  HasNonAscii(search.data + pos, size - pos);
+      return;
+    }
+    size_t newline_pos = static_cast<const char*>(newline) - search.data;
+    bool has_non_ascii = search.line_has_non_ascii ||
+                         HasNonAscii(search.data + pos, newline_pos - pos);
+    if (!search.AddLine(newline_pos, has_non_ascii)) {
+      return;
+    }
+    pos = newline_pos + 1;
+  }
+}
+
+#ifdef NODE_LITE_X64
+
+void FindLinesSse2(LineSearch& search, size_t pos, size_t size) noexcept {
+  const __m128i newline = _mm_set1_epi8('\n');
+  auto get_masks = [&newline](const char* data, uint64_t& newline_mask) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    newline_mask = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+    return static_cast<uint64_t>(
+        static_cast<uint32_t>(_mm_movemask_epi8(block)));
+  };
+  for (; pos + 64 <= size; pos += 64) {
+    uint64_t newline_mask{};
+    uint64_t non_ascii_mask{};
+    for (size_t i = 0; i < 4; ++i) {
+      uint64_t part_newline_mask{};
+      non_ascii_mask |= get_masks(search.data + pos + i * 16, part_newline_mask)
+                        << (i * 16);
+      newline_mask |= part_newline_mask << (i * 16);
+    }
+    if (!search.AddBlock(pos, newline_mask, non_ascii_mask)) {
+      return;
+    }
+  }
+  FindLinesScalar(search, pos, size);
+}
+
+NODE_LITE_TARGET("avx2")
+void FindLinesAvx2(LineSearch& search, size_t pos, size_t size) noexcept {
+  const __m256i newline = _mm256_set1_epi8('\n');
+  for (; pos + 64 <= size; pos += 64) {
+    __m256i low = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(search.data + pos));
+    __m256i high = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(search.data + pos + 32));
+    uint64_t newline_mask =
+        static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline))) |
+        (static_cast<uint64_t>(static_cast<uint32_t>(
+             _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline))))
+         << 32);
+    uint64_t non_ascii_mask =
+        static_cast<uint32_t>(_mm256_movemask_epi8(low)) |
+        (static_cast<uint64_t>(
+             static_cast<uint32_t>(_mm256_movemask_epi8(high)))
+         << 32);
+    if (!search.AddBlock(pos, newline_mask, non_ascii_mask)) {
+      return;
+    }
+  }
+  FindLinesScalar(search, pos, size);
+}
+
+#endif  // NODE_LITE_X64
+
+napi_value CreateLineString(napi_env env, const char* data, const Line& line) {
+  napi_value result{};
+  if (line.is_ascii) {
+    NODE_LITE_CALL(napi_create_string_latin1(
+        env, data + line.start, line.end - line.start, &result));
+  } else {
+    NODE_LITE_CALL(napi_create_string_utf8(
+        env, data + line.start, line.end - line.start, &result));
+  }
+  return result;
+}
+
+// Creates a string from UTF-8 text without its trailing "\r".
+napi_value CreateTrimmedString(napi_env env, const char* data, size_t size) {
+  if (size > 0 && data[size - 1] == '\r') {
+    --size;
+  }
+  napi_value result{};
+  NODE_LITE_CALL(napi_create_string_utf8(env, data, size, &result));
+  return result;
+}
+
+std::string_view GetTypedArrayData(napi_env env, napi_value value) {
+  bool is_typedarray{};
+  NODE_LITE_CALL(napi_is_typedarray(env, value, &is_typedarray));
+  NODE_LITE_ASSERT(is_typedarray, "Expected a Uint8Array");
+  napi_typedarray_type type{};
+  size_t length{};
+  void* data{};
+  NODE_LITE_CALL(napi_get_typedarray_info(
+      env, value, &type, &length, &data, nullptr, nullptr));
+  NODE_LITE_ASSERT(type == napi_uint8_array, "Expected a Uint8Array");
+  return std::string_view(static_cast<const char*>(data), length);
+}
+
+}  // namespace
+
+//=============================================================================
+// NodeLiteLineScanner implementation
+//=============================================================================
+
+/*static*/ size_t NodeLiteLineScanner::FindLines(const char* data,
+                                                 size_t size,
+                                                 size_t& position,
+                                                 Line* lines,
+                                                 size_t max_lines) noexcept {
+  if (max_lines == 0) {
+    return 0;
+  }
+  LineSearch search{data, lines, max_lines, 0, position, false};
+#ifdef NODE_LITE_X64
+  static const auto find_lines = NodeLiteCpuFeatures::Get().has_avx2
+                                     ? FindLinesAvx2
+                                     : FindLinesSse2;
+  find_lines(search, position, size);
+#else
+  FindLinesScalar(search, position, size);
+#endif
+  position = search.line_start;
+  return search.count;
+}
+
+//=============================================================================
+// NodeLiteReadline implementation
+//=============================================================================
+
+/*static*/ napi_value NodeLiteReadline::CreateBinding(napi_env env) {
+  napi_value binding = NodeApi::CreateObject(env);
+
+  // splitLines(chunk, pendingChunks) -> lines
+  // Returns the lines that end in the chunk. The pending chunks are the start
+  // of the first line. The chunk must have a newline.
+  NodeApi::SetMethod(
+      env, binding, "splitLines", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        std::string_view chunk = GetTypedArrayData(env, args[0]);
+        napi_value result{};
+        NODE_LITE_CALL(napi_create_array(env, &result));
+        uint32_t index = 0;
+        size_t pos = 0;
+
+        uint32_t pending_count = 0;
+        if (NodeApi::TypeOf(env, args[1]) == napi_object) {
+          NODE_LITE_CALL(napi_get_array_length(env, args[1], &pending_count));
+        }
+        if (pending_count > 0) {
+          size_t newline_pos = chunk.find('\n');
+          NODE_LITE_ASSERT(newline_pos != std::string_view::npos,
+                           "Expected a newline in the chunk");
+          std::string first_line;
+          for (uint32_t i = 0; i < pending_count; ++i) {
+            napi_value pending{};
+            NODE_LITE_CALL(napi_get_element(env, args[1], i, &pending));
+            first_line.append(GetTypedArrayData(env, pending));
+          }
+          first_line.append(chunk.data(), newline_pos);
+          NODE_LITE_CALL(napi_set_element(
+              env,
+              result,
+              index++,
+              CreateTrimmedString(env, first_line.data(), first_line.size())));
+          pos = newline_pos + 1;
+        }
+
+        Line lines[kChunkLineBatchSize];
+        for (;;) {
+          size_t count = NodeLiteLineScanner::FindLines(
+              chunk.data(), chunk.size(), pos, lines, kChunkLineBatchSize);
+          for (size_t i = 0; i < count; ++i) {
+            NODE_LITE_CALL(napi_set_element(
+                env,
+                result,
+                index++,
+                CreateLineString(env, chunk.data(), lines[i])));
+          }
+          if (count < kChunkLineBatchSize) {
+            break;
+          }
+        }
+        return result;
+      });
+
+  // readLinesSync(path, callback, batchSize) -> line count
+  // Maps the file and passes its lines to the callback in arrays of up to
+  // batchSize lines. Stops if the callback returns false.
+  NodeApi::SetMethod(
+      env, binding, "readLinesSync", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 3, "Expected 3 arguments");
+        fs::path path = fs::path{NodeApi::ToStdString(env, args[0])};
+        NODE_LITE_ASSERT(NodeApi::TypeOf(env, args[1]) == napi_function,
+                         "Expected function as second argument");
+        size_t batch_size = NodeApi::GetValueUInt32(env, args[2]);
+        NODE_LITE_ASSERT(batch_size > 0, "The batch size must be positive");
+
+        std::error_code error_code;
+        uintmax_t file_size = fs::file_size(path, error_code);
+        NODE_LITE_ASSERT(!error_code,
+                         "Failed to read file %s: %s",
+                         path.string().c_str(),
+                         error_code.message().c_str());
+        if (file_size == 0) {
+          return NodeApi::CreateUInt32(env, 0);
+        }
+        size_t size{};
+        std::string error;
+        const void* mapped_data = NodeLitePlatform::MapFile(path, size, error);
+        NODE_LITE_ASSERT(mapped_data != nullptr,
+                         "Failed to map file %s: %s",
+                         path.string().c_str(),
+                         error.c_str());
+        std::unique_ptr<const void, NodeLiteMappedFileDeleter> mapping{
+            mapped_data, NodeLiteMappedFileDeleter{size}};
+        const char* data = static_cast<const char*>(mapped_data);
+
+        std::vector<Line> lines(batch_size);
+        double line_count = 0;
+        size_t pos = 0;
+        while (pos < size) {
+          NodeApiHandleScope scope{env};
+          size_t count = NodeLiteLineScanner::FindLines(
+              data, size, pos, lines.data(), batch_size);
+          // The last line may have no newline.
+          bool has_last_line = count < batch_size && pos < size;
+          napi_value batch{};
+          NODE_LITE_CALL(napi_create_array_with_length(
+              env, count + (has_last_line ? 1 : 0), &batch));
+          for (size_t i = 0; i < count; ++i) {
+            NODE_LITE_CALL(napi_set_element(
+                env, batch, i, CreateLineString(env, data, lines[i])));
+          }
+          if (has_last_line) {
+            NODE_LITE_CALL(napi_set_element(
+                env,
+                batch,
+                count,
+                CreateTrimmedString(env, data + pos, size - pos)));
+            pos = size;
+            ++count;
+          }
+          if (count == 0) {
+            break;
+          }
+          line_count += count;
+          napi_value callback_result =
+              NodeApi::CallFunction(env, args[1], {batch});
+          if (NodeApi::TypeOf(env, callback_result) == napi_boolean) {
+            bool should_continue{};
+            NODE_LITE_CALL(
+                napi_get_value_bool(env, callback_result, &should_continue));
+            if (!should_continue) {
+              break;
+            }
+          }
+        }
+        return NodeApi::CreateDouble(env, line_count);
+      });
+
+  return binding;
+}
+
+/*static*/ const std::string_view NodeLiteReadline::kModuleSource = R"JS(
+(function (binding, require) {
+  'use strict';
+  const EventEmitter = require('events');
+  const kNewline = new Uint8Array([10]);
+  const kDefaultBatchSize = 1024;
+
+  function inherits(ctor, superCtor) {
+    Object.setPrototypeOf(ctor.prototype, superCtor.prototype);
+    Object.setPrototypeOf(ctor, superCtor);
+  }
+
+  // Splits the chunks of a text into lines that end with "\n" or "\r\n".
+  // The Uint8Array chunks are split natively with one call per chunk. The
+  // incomplete last line is kept until the next chunk.
+  function LineSplitter() {
+    if (!(this instanceof LineSplitter)) {
+      return new LineSplitter();
+    }
+    // The Uint8Array parts of the incomplete line.
+    this._pending = [];
+    // The incomplete line of the string chunks.
+    this._pendingText = '';
+  }
+
+  // Returns the array of the lines completed by the chunk.
+  LineSplitter.prototype.push = function (chunk) {
+    if (typeof chunk === 'string') {
+      return this._pushText(chunk);
+    }
+    const end = chunk.lastIndexOf(10);
+    if (end < 0) {
+      if (chunk.length > 0) {
+        this._pending.push(chunk);
+      }
+      return [];
+    }
+    const lines = binding.splitLines(
+        chunk, this._pending.length > 0 ? this._pending : undefined);
+    this._pending = end + 1 < chunk.length ? [chunk.subarray(end + 1)] : [];
+    return lines;
+  };
+
+  LineSplitter.prototype._pushText = function (text) {
+    const end = text.lastIndexOf('\n');
+    if (end < 0) {
+      this._pendingText += text;
+      return [];
+    }
+    const lines = (this._pendingText + text.slice(0, end)).split('\n');
+    this._pendingText = text.slice(end + 1);
+    for (let i = 0; i < lines.length; ++i) {
+      const line = lines[i];
+      if (line.charCodeAt(line.length - 1) === 13) {
+        lines[i] = line.slice(0, -1);
+      }
+    }
+    return lines;
+  };
+
+  // Returns the incomplete last line at the end of the input.
+  LineSplitter.prototype.flush = function () {
+    let lines = [];
+    if (this._pending.length > 0) {
+      lines = binding.splitLines(kNewline, this._pending);
+      this._pending = [];
+    }
+    if (this._pendingText.length > 0) {
+      lines.push(this._pushText('\n')[0]);
+    }
+    return lines;
+  };
+
+  // Emits the 'line' events of a readable stream. The 'lines' event receives
+  // all lines of an input chunk in one array before their 'line' events.
+  function Interface(input) {
+    if (!(this instanceof Interface)) {
+      return new Interface(input);
+    }
+    EventEmitter.call(this);
+    this.input = input;
+    this.closed = false;
+    this.paused = false;
+    this._splitter = new LineSplitter();
+    this._onData = (chunk) => this._emitLines(this._splitter.push(chunk));
+    this._onEnd = () => {
+      this._emitLines(this._splitter.flush());
+      this.close();
+    };
+    this._onError = (error) => this.emit('error', error);
+    input.on('data', this._onData);
+    input.on('end', this._onEnd);
+    input.on('error', this._onError);
+  }
+  inherits(Interface, EventEmitter);
+
+  Interface.prototype._emitLines = function (lines) {
+    if (lines.length === 0 || this.closed) {
+      return;
+    }
+    this.emit('lines', lines);
+    for (let i = 0; i < lines.length && !this.closed; ++i) {
+      this.emit('line', lines[i]);
+    }
+  };
+
+  Interface.prototype.close = function () {
+    if (this.closed) {
+      return;
+    }
+    this.closed = true;
+    this.input.removeListener('data', this._onData);
+    this.input.removeListener('end', this._onEnd);
+    this.input.removeListener('error', this._onError);
+    if (typeof this.input.pause === 'function') {
+      this.input.pause();
+    }
+    this.emit('close');
+  };
+
+  Interface.prototype.pause = function () {
+    if (!this.paused && !this.closed) {
+      this.paused = true;
+      this.input.pause();
+      this.emit('pause');
+    }
+    return this;
+  };
+
+  Interface.prototype.resume = function () {
+    if (this.paused && !this.closed) {
+      this.paused = false;
+      this.input.resume();
+      this.emit('resume');
+    }
+    return this;
+  };
+
+  // Pauses the input while the iterator has unread lines.
+  Interface.prototype[Symbol.asyncIterator] = function () {
+    const rl = this;
+    const batches = [];
+    let lineIndex = 0;
+    let waiter = null;
+    let error = null;
+    function settle() {
+      if (waiter === null) {
+        return;
+      }
+      const {resolve, reject} = waiter;
+      if (batches.length > 0) {
+        waiter = null;
+        const value = batches[0][lineIndex++];
+        if (lineIndex === batches[0].length) {
+          batches.shift();
+          lineIndex = 0;
+        }
+        resolve({value, done: false});
+      } else if (error !== null) {
+        waiter = null;
+        reject(error);
+      } else if (rl.closed) {
+        waiter = null;
+        resolve({value: undefined, done: true});
+      }
+    }
+    rl.on('lines', (lines) => {
+      batches.push(lines);
+      rl.pause();
+      settle();
+    });
+    rl.on('close', settle);
+    rl.on('error', (e) => {
+      error = e;
+      settle();
+    });
+    return {
+      next() {
+        if (batches.length === 0) {
+          rl.resume();
+        }
+        return new Promise((resolve, reject) => {
+          waiter = {resolve, reject};
+          settle();
+        });
+      },
+      return() {
+        rl.close();
+        return Promise.resolve({value: undefined, done: true});
+      },
+      [Symbol.asyncIterator]() {
+        return this;
+      },
+    };
+  };
+
+  function createInterface(options) {
+    const input =
+        options && options.input !== undefined ? options.input : options;
+    return new Interface(input);
+  }
+
+  // Passes the lines of a file to the callback in arrays of up to batchSize
+  // lines. Stops if the callback returns false. Returns the line count.
+  function readLinesSync(path, callback, options) {
+    const batchSize = (options && options.batchSize) || kDefaultBatchSize;
+    return binding.readLinesSync(String(path), callback, batchSize);
+  }
+
+  return {
+    Interface,
+    LineSplitter,
+    createInterface,
+    readLinesSync,
+  };
+})
+)JS";
+
+}  // namespace node_api_tests
@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Line splitting for the "readline" built-in module.
+
+#ifndef NODE_API_TEST_NODE_LITE_READLINE_H
+#define NODE_API_TEST_NODE_LITE_READLINE_H
+
+#include <cstddef>
+#include <string_view>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+// Finds the lines of a text with SSE2 or AVX2 on x64 and with memchr on the
+// other CPUs. The lines end with "\n" or "\r\n".
+class NodeLiteLineScanner {
+ public:
+  struct Line {
+    size_t start;
+    // The end of the line before its "\n" or "\r\n".
+    size_t end;
+    // The line has only ASCII characters, so it can be passed to JS as a
+    // Latin-1 string without UTF-8 decoding.
+    bool is_ascii;
+  };
+
+  // Finds up to max_lines lines that end with "\n" starting from the
+  // position, which must be a line start. Sets the position to the start of
+  // the line after the last found one. Returns the number of found lines.
+  static size_t FindLines(const char* data,
+                          size_t size,
+                          size_t& position,
+                          Line* lines,
+                          size_t max_lines) noexcept;
+};
+
+// The native part of the "readline" module.
+class NodeLiteReadline {
+ public:
+  // The number of lines passed to JS in one array by readLinesSync.
+  static constexpr uint32_t kDefaultBatchSize = 1024;
+
+  // The JS source of the module function. It receives the binding object and
+  // the require function and returns the module exports.
+  static const std::string_view kModuleSource;
+
+  static napi_value CreateBinding(napi_env env);
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_READLINE_H
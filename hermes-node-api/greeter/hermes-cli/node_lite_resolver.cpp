@@ -0,0 +1,796 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_resolver.h"
+#include <array>
+#include <cctype>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include "node_lite.h"
+
+namespace fs = std::filesystem;
+
+namespace node_api_tests {
+
+namespace {
+
+using ExportsNode = NodeLitePackageInfo::ExportsNode;
+
+// The first line of the resolution cache file.
+constexpr std::string_view kCacheFileHeader = "hermes-cli-resolution-cache 1";
+
+// The extensions tried for the module paths without extension.
+constexpr std::array<std::string_view, 5> kModuleExtensions = {
+    ".js", ".cjs", ".mjs", ".json", ".node"};
+
+// Deeper JSON is rejected to protect the parser stack.
+constexpr int kMaxJsonDepth = 64;
+
+[[noreturn]] void ThrowResolveError(const std::string& message) {
+  throw NodeLiteException(napi_generic_failure, message.c_str());
+}
+
+// A minimal JSON parser for package.json files.
+// It validates the whole document, but keeps only the fields used by the
+// module resolution.
+class PackageJsonParser {
+ public:
+  explicit PackageJsonParser(std::string_view text) noexcept : text_(text) {}
+
+  bool Parse(NodeLitePackageInfo& info) {
+    SkipWhitespace();
+    if (!Consume('{')) {
+      return false;
+    }
+    SkipWhitespace();
+    if (Consume('}')) {
+      return AtEnd();
+    }
+    do {
+      std::string key;
+      SkipWhitespace();
+      if (!ParseString(key) || !ConsumeAfterWhitespace(':')) {
+        return false;
+      }
+      SkipWhitespace();
+      if (key == "main" && Peek() == '"') {
+        if (!ParseString(info.main)) {
+          return false;
+        }
+      } else if (key == "exports") {
+        info.exports.emplace();
+        if (!ParseExports(*info.exports, 1)) {
+          return false;
+        }
+      } else if (!SkipValue(1)) {
+        return false;
+      }
+    } while (ConsumeAfterWhitespace(','));
+    return ConsumeAfterWhitespace('}') && AtEnd();
+  }
+
+ private:
+  bool ParseExports(ExportsNode& node, int depth) {
+    if (depth > kMaxJsonDepth) {
+      return false;
+    }
+    SkipWhitespace();
+    switch (Peek()) {
+      case '"':
+        node.kind = ExportsNode::Kind::kString;
+        return ParseString(node.target);
+      case '[':
+        node.kind = ExportsNode::Kind::kArray;
+        ++pos_;
+        if (ConsumeAfterWhitespace(']')) {
+          return true;
+        }
+        do {
+          if (!ParseExports(node.items.emplace_back(), depth + 1)) {
+            return false;
+          }
+        } while (ConsumeAfterWhitespace(','));
+        return ConsumeAfterWhitespace(']');
+      case '{':
+        node.kind = ExportsNode::Kind::kObject;
+        ++pos_;
+        if (ConsumeAfterWhitespace('}')) {
+          return true;
+        }
+        do {
+          auto& [key, value] = node.members.emplace_back();
+          SkipWhitespace();
+          if (!ParseString(key) || !ConsumeAfterWhitespace(':') ||
+              !ParseExports(value, depth + 1)) {
+            return false;
+          }
+        } while (ConsumeAfterWhitespace(','));
+        return ConsumeAfterWhitespace('}');
+      case 'n':
+        node.kind = ExportsNode::Kind::kNull;
+        return ConsumeLiteral("null");
+      default:
+        // Other value types are invalid targets. They never match.
+        node.kind = ExportsNode::Kind::kNull;
+        return SkipValue(depth);
+    }
+  }
+
+  bool SkipValue(int depth) {
+    if (depth > kMaxJsonDepth) {
+      return false;
+    }
+    SkipWhitespace();
+    switch (Peek()) {
+      case '"': {
+        std::string ignored;
+        return ParseString(ignored);
+      }
+      case '[':
+        ++pos_;
+        if (ConsumeAfterWhitespace(']')) {
+          return true;
+        }
+        do {
+          if (!SkipValue(depth + 1)) {
+            return false;
+          }
+        } while (ConsumeAfterWhitespace(','));
+        return ConsumeAfterWhitespace(']');
+      case '{':
+        ++pos_;
+        if (ConsumeAfterWhitespace('}')) {
+          return true;
+        }
+        do {
+          std::string ignored;
+          SkipWhitespace();
+          if (!ParseString(ignored) || !ConsumeAfterWhitespace(':') ||
+              !SkipValue(depth + 1)) {
+            return false;
+          }
+        } while (ConsumeAfterWhitespace(','));
+        return ConsumeAfterWhitespace('}');
+      case 't':
+        return ConsumeLiteral("true");
+      case 'f':
+        return ConsumeLiteral("false");
+      case 'n':
+        return ConsumeLiteral("null");
+      default:
+        return SkipNumber();
+    }
+  }
+
+  bool ParseString(std::string& result) {
+    if (!Consume('"')) {
+      return false;
+    }
+    while (pos_ < text_.size()) {
+      char ch = text_[pos_++];
+      if (ch == '"') {
+        return true;
+      }
+      if (static_cast<unsigned char>(ch) < 0x20) {
+        return false;
+      }
+      if (ch != '\\') {
+        result += ch;
+        continue;
+      }
+      if (pos_ >= text_.size()) {
+        return false;
+      }
+      switch (text_[pos_++]) {
+        case '"':
+          result += '"';
+          break;
+        case '\\':
+          result += '\\';
+          break;
+        case '/':
+          result += '/';
+          break;
+        case 'b':
+          result += '\b';
+          break;
+        case 'f':
+          result += '\f';
+          break;
+        case 'n':
+          result += '\n';
+          break;
+        case 'r':
+          result += '\r';
+          break;
+        case 't':
+          result += '\t';
+          break;
+        case 'u': {
+          uint32_t code_point{};
+          if (!ParseHex4(code_point)) {
+            return false;
+          }
+          if (code_point >= 0xD800 && code_point <= 0xDBFF &&
+              text_.substr(pos_, 2) == "\\u") {
+            pos_ += 2;
+            uint32_t low{};
+            if (!ParseHex4(low) || low < 0xDC00 || low > 0xDFFF) {
+              return false;
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
+          }
+          AppendUtf8(result, code_point);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+    return false;
+  }
+
+  bool ParseHex4(uint32_t& result) {
+    if (pos_ + 4 > text_.size()) {
+      return false;
+    }
+    for (int i = 0; i < 4; ++i) {
+      char ch = text_[pos_++];
+      result <<= 4;
+      if (ch >= '0' && ch <= '9') {
+        result |= ch - '0';
+      } else if (ch >= 'a' && ch <= 'f') {
+        result |= ch - 'a' + 10;
+      } else if (ch >= 'A' && ch <= 'F') {
+        result |= ch - 'A' + 10;
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static void AppendUtf8(std::string& result, uint32_t code_point) {
+    if (code_point < 0x80) {
+      result += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+      result += static_cast<char>(0xC0 | (code_point >> 6));
+      result += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+      result += static_cast<char>(0xE0 | (code_point >> 12));
+      result += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      result += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+      result += static_cast<char>(0xF0 | (code_point >> 18));
+      result += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      result += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      result += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+  }
+
+  // Skips a number with the JSON grammar:
+  // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+  bool SkipNumber() {
+    Consume('-');
+    if (!Consume('0') && !SkipDigits()) {
+      return false;
+    }
+    if (Consume('.') && !SkipDigits()) {
+      return false;
+    }
+    if (Consume('e') || Consume('E')) {
+      if (!Consume('+')) {
+        Consume('-');
+      }
+      if (!SkipDigits()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Skips one or more decimal digits.
+  bool SkipDigits() {
+    size_t start = pos_;
+    while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') {
+      ++pos_;
+    }
+    return pos_ > start;
+  }
+
+  bool ConsumeLiteral(std::string_view literal) {
+    if (text_.substr(pos_, literal.size()) != literal) {
+      return false;
+    }
+    pos_ += literal.size();
+    return true;
+  }
+
+  bool Consume(char ch) {
+    if (Peek() != ch) {
+      return false;
+    }
+    ++pos_;
+    return true;
+  }
+
+  bool ConsumeAfterWhitespace(char ch) {
+    SkipWhitespace();
+    return Consume(ch);
+  }
+
+  char Peek() const noexcept {
+    return pos_ < text_.size() ? text_[pos_] : '\0';
+  }
+
+  void SkipWhitespace() noexcept {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' ||
+            text_[pos_] == '\r')) {
+      ++pos_;
+    }
+  }
+
+  bool AtEnd() {
+    SkipWhitespace();
+    return pos_ == text_.size();
+  }
+
+ private:
+  std::string_view text_;
+  size_t pos_{0};
+};
+
+// Reads the whole file with one read call.
+bool ReadWholeFile(const fs::path& path, std::string& result) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::streamsize size = file.tellg();
+  if (size < 0) {
+    return false;
+  }
+  result.resize(static_cast<size_t>(size));
+  file.seekg(0);
+  return static_cast<bool>(file.read(result.data(), size));
+}
+
+bool IsRegularFile(const fs::path& path) {
+  std::error_code ec;
+  return fs::is_regular_file(path, ec);
+}
+
+std::string MakeCacheKey(const std::string& parent_dir,
+                         std::string_view specifier) {
+  std::string key;
+  key.reserve(parent_dir.size() + 1 + specifier.size());
+  key += parent_dir;
+  key += '\t';
+  key += specifier;
+  return key;
+}
+
+// Returns true if the export target after its "./" has a ".", "..", or
+// "node_modules" segment. Like Node.js, such targets are rejected, so that
+// an export cannot point outside of the package folder.
+bool HasInvalidTargetSegment(std::string_view target) {
+  while (!target.empty()) {
+    size_t end = target.find_first_of("/\\");
+    std::string_view segment = target.substr(0, end);
+    if (segment == "." || segment == ".." ||
+        (segment.size() == 12 &&
+         std::equal(segment.begin(),
+                    segment.end(),
+                    "node_modules",
+                    [](char ch, char expected) {
+                      return std::tolower(static_cast<unsigned char>(ch)) ==
+                             expected;
+                    }))) {
+      return true;
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    target.remove_prefix(end + 1);
+  }
+  return false;
+}
+
+// Resolves the target of the "exports" node.
+// The '*' in the target is replaced by the pattern match.
+// Returns std::nullopt if there is no matching target.
+std::optional<fs::path> ResolveExportsTarget(
+    const fs::path& package_dir,
+    const ExportsNode& node,
+    std::string_view pattern_match,
+    const std::vector<std::string_view>& conditions) {
+  switch (node.kind) {
+    case ExportsNode::Kind::kString: {
+      // Targets must be relative to the package folder.
+      if (node.target.compare(0, 2, "./") != 0) {
+        return std::nullopt;
+      }
+      std::string target = node.target.substr(2);
+      if (size_t star = target.find('*'); star != std::string::npos) {
+        target.replace(star, 1, pattern_match);
+      }
+      if (HasInvalidTargetSegment(target)) {
+        return std::nullopt;
+      }
+      return fs::weakly_canonical(package_dir / fs::path(target));
+    }
+    case ExportsNode::Kind::kArray:
+      for (const ExportsNode& item : node.items) {
+        if (std::optional<fs::path> result = ResolveExportsTarget(
+                package_dir, item, pattern_match, conditions)) {
+          return result;
+        }
+      }
+      return std::nullopt;
+    case ExportsNode::Kind::kObject:
+      // The first matching condition in the declaration order wins.
+      for (const auto& [condition, value] : node.members) {
+        if (condition == "default" ||
+            std::find(conditions.begin(), conditions.end(), condition) !=
+                conditions.end()) {
+          if (std::optional<fs::path> result = ResolveExportsTarget(
+                  package_dir, value, pattern_match, conditions)) {
+            return result;
+          }
+        }
+      }
+      return std::nullopt;
+    case ExportsNode::Kind::kNull:
+    default:
+      return std::nullopt;
+  }
+}
+
+}  // namespace
+
+std::optional<fs::path> NodeLiteModuleResolver::ResolvePackage(
+    const fs::path& parent_dir,
+    std::string_view specifier,
+    const std::vector<std::string_view>& conditions) {
+  // The package name is the first path segment or the first two segments
+  // for the scoped packages.
+  size_t name_end = specifier.find('/');
+  if (!specifier.empty() && specifier[0] == '@' &&
+      name_end != std::string_view::npos) {
+    name_end = specifier.find('/', name_end + 1);
+  }
+  std::string_view package_name = specifier.substr(0, name_end);
+  std::string subpath =
+      name_end == std::string_view::npos
+          ? std::string(".")
+          : "." + std::string(specifier.substr(name_end));
+
+  for (fs::path dir = parent_dir;; dir = dir.parent_path()) {
+    if (dir.filename() != "node_modules") {
+      fs::path node_modules_dir = dir / "node_modules";
+      fs::path package_dir = node_modules_dir / fs::path(package_name);
+      if (IsDirectory(node_modules_dir) && IsDirectory(package_dir)) {
+        const NodeLitePackageInfo* package = GetPackageInfo(package_dir);
+        if (package != nullptr && package->exports) {
+          std::optional<fs::path> result = ResolveExports(
+              package_dir, *package->exports, subpath, conditions);
+          if (!result) {
+            ThrowResolveError("Package subpath '" + subpath +
+                              "' is not defined by \"exports\" in " +
+                              (package_dir / "package.json").string());
+          }
+          if (!IsRegularFile(*result)) {
+            ThrowResolveError("Cannot find module '" + result->string() +
+                              "' exported by " +
+                              (package_dir / "package.json").string());
+          }
+          return result;
+        }
+        std::optional<fs::path> result =
+            subpath == "."
+                ? ResolveFileOrDirectory(package_dir)
+                : ResolveFileOrDirectory(package_dir /
+                                         fs::path(subpath.substr(2)));
+        if (result) {
+          return result;
+        }
+      }
+    }
+    if (!dir.has_relative_path()) {
+      return std::nullopt;
+    }
+  }
+}
+
+std::optional<fs::path> NodeLiteModuleResolver::ResolveFileOrDirectory(
+    const fs::path& path) {
+  if (std::optional<fs::path> result = ResolveFile(path)) {
+    return result;
+  }
+  if (!IsDirectory(path)) {
+    return std::nullopt;
+  }
+  if (const NodeLitePackageInfo* package = GetPackageInfo(path);
+      package != nullptr && !package->main.empty()) {
+    fs::path main_path = fs::weakly_canonical(path / fs::path(package->main));
+    if (std::optional<fs::path> result = ResolveFile(main_path)) {
+      return result;
+    }
+    if (std::optional<fs::path> result = ResolveFile(main_path / "index")) {
+      return result;
+    }
+  }
+  return ResolveFile(path / "index");
+}
+
+std::optional<fs::path> NodeLiteModuleResolver::ResolveFile(
+    const fs::path& path) {
+  if (IsRegularFile(path)) {
+    return path;
+  }
+  for (std::string_view extension : kModuleExtensions) {
+    fs::path result = path;
+    result += extension;
+    if (IsRegularFile(result)) {
+      return result;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<fs::path> NodeLiteModuleResolver::ResolveExports(
+    const fs::path& package_dir,
+    const ExportsNode& exports,
+    const std::string& subpath,
+    const std::vector<std::string_view>& conditions) {
+  // A string, an array, or an object with condition keys is a shortcut for
+  // the "." subpath.
+  bool has_subpath_keys = exports.kind == ExportsNode::Kind::kObject &&
+                          !exports.members.empty() &&
+                          exports.members.front().first.compare(0, 1, ".") ==
+                              0;
+  if (!has_subpath_keys) {
+    return subpath == "." ? ResolveExportsTarget(
+                                package_dir, exports, "", conditions)
+                          : std::nullopt;
+  }
+
+  const ExportsNode* best_match{};
+  size_t best_prefix_size{};
+  std::string_view pattern_match;
+  for (const auto& [key, value] : exports.members) {
+    if (key == subpath) {
+      return ResolveExportsTarget(package_dir, value, "", conditions);
+    }
+    // Subpath patterns have one '*'. The longest prefix wins.
+    size_t star = key.find('*');
+    if (star == std::string::npos ||
+        key.find('*', star + 1) != std::string::npos) {
+      continue;
+    }
+    std::string_view prefix = std::string_view(key).substr(0, star);
+    std::string_view suffix = std::string_view(key).substr(star + 1);
+    if (subpath.size() >= key.size() &&
+        subpath.compare(0, prefix.size(), prefix) == 0 &&
+        subpath.compare(subpath.size() - suffix.size(), suffix.size(),
+                        suffix) == 0 &&
+        (best_match == nullptr || prefix.size() > best_prefix_size)) {
+      best_match = &value;
+      best_prefix_size = prefix.size();
+      pattern_match = std::string_view(subpath).substr(
+          prefix.size(), subpath.size() - prefix.size() - suffix.size());
+    }
+  }
+  if (best_match != nullptr) {
+    return ResolveExportsTarget(
+        package_dir, *best_match, pattern_match, conditions);
+  }
+  return std::nullopt;
+}
+
+void NodeLiteModuleResolver::ClearCaches() {
+  {
+    std::unique_lock lock{package_mutex_};
+    packages_.clear();
+    directories_.clear();
+  }
+  std::unique_lock lock{path_mutex_};
+  resolved_paths_.clear();
+  saved_paths_.clear();
+  // The cache file must not keep the entries that may be outdated now.
+  has_new_paths_ = true;
+}
+
+void NodeLiteModuleResolver::SetPackageJsonCallback(
+    std::function<void(const fs::path&)> callback) {
+  package_json_callback_ = std::move(callback);
+}
+
+const NodeLitePackageInfo* NodeLiteModuleResolver::GetPackageInfo(
+    const fs::path& package_dir) {
+  std::string key = package_dir.string();
+  {
+    std::shared_lock lock{package_mutex_};
+    if (auto it = packages_.find(key); it != packages_.end()) {
+      return it->second.get();
+    }
+  }
+  // The file is read and parsed without the lock. If two threads parse the
+  // same package.json, then the first inserted result is used.
+  fs::path package_json_path = package_dir / "package.json";
+  std::unique_ptr<NodeLitePackageInfo> package;
+  if (std::string text; ReadWholeFile(package_json_path, text)) {
+    if (package_json_callback_) {
+      package_json_callback_(package_json_path);
+    }
+    package = std::make_unique<NodeLitePackageInfo>();
+    if (!PackageJsonParser(text).Parse(*package)) {
+      ThrowResolveError("Invalid package config " +
+                        package_json_path.string());
+    }
+  }
+  std::unique_lock lock{package_mutex_};
+  return packages_.try_emplace(std::move(key), std::move(package))
+      .first->second.get();
+}
+
+bool NodeLiteModuleResolver::IsDirectory(const fs::path& path) {
+  std::string key = path.string();
+  {
+    std::shared_lock lock{package_mutex_};
+    if (auto it = directories_.find(key); it != directories_.end()) {
+      return it->second;
+    }
+  }
+  std::error_code ec;
+  bool is_directory = fs::is_directory(path, ec);
+  std::unique_lock lock{package_mutex_};
+  return directories_.try_emplace(std::move(key), is_directory).first->second;
+}
+
+std::optional<fs::path> NodeLiteModuleResolver::FindCachedPath(
+    const std::string& parent_dir, std::string_view specifier) {
+  std::string key = MakeCacheKey(parent_dir, specifier);
+  std::string resolved_path;
+  {
+    std::shared_lock lock{path_mutex_};
+    if (auto it = resolved_paths_.find(key); it != resolved_paths_.end()) {
+      return fs::path(it->second);
+    }
+    if (saved_paths_.empty()) {
+      return std::nullopt;
+    }
+  }
+  // The saved paths are checked once, because the files could be removed
+  // after the cache was saved.
+  {
+    std::unique_lock lock{path_mutex_};
+    auto it = saved_paths_.find(key);
+    if (it == saved_paths_.end()) {
+      // Another thread could move the entry to resolved_paths_.
+      if (auto resolved_it = resolved_paths_.find(key);
+          resolved_it != resolved_paths_.end()) {
+        return fs::path(resolved_it->second);
+      }
+      return std::nullopt;
+    }
+    resolved_path = std::move(it->second);
+    saved_paths_.erase(it);
+  }
+  bool is_valid = IsRegularFile(resolved_path);
+  std::unique_lock lock{path_mutex_};
+  if (!is_valid) {
+    has_new_paths_ = true;
+    return std::nullopt;
+  }
+  return fs::path(
+      resolved_paths_.try_emplace(std::move(key), std::move(resolved_path))
+          .first->second);
+}
+
+void NodeLiteModuleResolver::AddCachedPath(const std::string& parent_dir,
+                                           std::string_view specifier,
+                                           const fs::path& resolved_path) {
+  // Tabs and new lines are the separators of the cache file.
+  if (parent_dir.find_first_of("\t\n") != std::string::npos ||
+      specifier.find_first_of("\t\n") != std::string_view::npos) {
+    return;
+  }
+  std::string key = MakeCacheKey(parent_dir, specifier);
+  std::string value = resolved_path.string();
+  std::unique_lock lock{path_mutex_};
+  if (resolved_paths_.try_emplace(std::move(key), std::move(value)).second) {
+    has_new_paths_ = true;
+  }
+}
+
+void NodeLiteModuleResolver::LoadCache(const fs::path& cache_path) {
+  std::string text;
+  if (!ReadWholeFile(cache_path, text)) {
+    return;
+  }
+  // Each line is "<parent_dir>\t<specifier>\t<resolved_path>".
+  std::string_view rest = text;
+  auto next_line = [&rest]() {
+    size_t end = rest.find('\n');
+    std::string_view line = rest.substr(0, end);
+    rest = end == std::string_view::npos ? std::string_view{}
+                                         : rest.substr(end + 1);
+    return line;
+  };
+  if (next_line() != kCacheFileHeader) {
+    return;
+  }
+  std::unique_lock lock{path_mutex_};
+  while (!rest.empty()) {
+    std::string_view line = next_line();
+    size_t value_start = line.rfind('\t');
+    if (value_start == std::string_view::npos || value_start == 0) {
+      continue;
+    }
+    saved_paths_.try_emplace(std::string(line.substr(0, value_start)),
+                             std::string(line.substr(value_start + 1)));
+  }
+}
+
+void NodeLiteModuleResolver::SaveCache(const fs::path& cache_path) const {
+  std::string text{kCacheFileHeader};
+  text += '\n';
+  {
+    std::shared_lock lock{path_mutex_};
+    if (!has_new_paths_) {
+      return;
+    }
+    auto append_entries =
+        [&text](const std::unordered_map<std::string, std::string>& entries) {
+          for (const auto& [key, resolved_path] : entries) {
+            text += key;
+            text += '\t';
+            text += resolved_path;
+            text += '\n';
+          }
+        };
+    append_entries(resolved_paths_);
+    append_entries(saved_paths_);
+  }
+
+  // The new file replaces the old one only after it is completely written.
+  fs::path temp_path = cache_path;
+  temp_path += ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open() ||
+        !file.write(text.data(), static_cast<std::streamsize>(text.size()))) {
+      return;
+    }
+  }
+  std::error_code ec;
+  fs::rename(temp_path, cache_path, ec);
+}
+
+/*static*/ bool NodeLiteModuleResolver::IsBareSpecifier(
+    std::string_view specifier) noexcept {
+  if (specifier.empty() || specifier[0] == '.' || specifier[0] == '/' ||
+      specifier[0] == '\\') {
+    return false;
+  }
+  // Windows absolute paths such as "C:\dir" or "C:/dir".
+  return !(specifier.size() >= 2 && specifier[1] == ':');
+}
+
+/*static*/ const std::vector<std::string_view>&
+NodeLiteModuleResolver::RequireConditions() {
+  static const std::vector<std::string_view> conditions = {"node", "require"};
+  return conditions;
+}
+
+/*static*/ const std::vector<std::string_view>&
+NodeLiteModuleResolver::ImportConditions() {
+  static const std::vector<std::string_view> conditions = {"node", "import"};
+  return conditions;
+}
+
+}  // namespace node_api_tests
@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Node.js-style module path resolution with node_modules lookup and
+// package.json "main" and "exports" support.
+
+#ifndef NODE_API_TEST_NODE_LITE_RESOLVER_H
+#define NODE_API_TEST_NODE_LITE_RESOLVER_H
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace node_api_tests {
+
+// The package.json fields used by the module resolution.
+struct NodeLitePackageInfo {
+  // A node of the "exports" field. It is either a target path string,
+  // an array of alternatives, an object with subpath or condition keys in
+  // the declaration order, or null.
+  struct ExportsNode {
+    enum class Kind { kNull, kString, kArray, kObject };
+    Kind kind{Kind::kNull};
+    std::string target;
+    std::vector<ExportsNode> items;
+    std::vector<std::pair<std::string, ExportsNode>> members;
+  };
+
+  std::string main;
+  std::optional<ExportsNode> exports;
+};
+
+// Resolves module specifiers to file paths.
+// Each package.json is parsed once. The resolved paths are cached in memory
+// by the parent folder and the specifier. The cache can be saved to a file
+// and loaded by later runs, so that large dependency trees are resolved
+// without walking the node_modules folders on every start.
+// The resolver is thread-safe: the ES module loader resolves imports on its
+// pool threads. Errors are reported by throwing NodeLiteException.
+class NodeLiteModuleResolver {
+ public:
+  NodeLiteModuleResolver() = default;
+
+  NodeLiteModuleResolver(const NodeLiteModuleResolver&) = delete;
+  NodeLiteModuleResolver& operator=(const NodeLiteModuleResolver&) = delete;
+
+  // Resolves a bare specifier such as "pkg", "pkg/sub/path", or
+  // "@scope/pkg/sub/path" by looking for the package in the node_modules
+  // folders of the parent folder and all its ancestors.
+  // Returns std::nullopt if the package is not found.
+  std::optional<std::filesystem::path> ResolvePackage(
+      const std::filesystem::path& parent_dir,
+      std::string_view specifier,
+      const std::vector<std::string_view>& conditions);
+
+  // Resolves the path as a file with one of the module extensions, or as a
+  // folder with package.json "main" or an index file.
+  std::optional<std::filesystem::path> ResolveFileOrDirectory(
+      const std::filesystem::path& path);
+
+  // Returns the cached path of the specifier resolved from the parent folder.
+  std::optional<std::filesystem::path> FindCachedPath(
+      const std::string& parent_dir, std::string_view specifier);
+
+  void AddCachedPath(const std::string& parent_dir,
+                     std::string_view specifier,
+                     const std::filesystem::path& resolved_path);
+
+  // Loads the resolution map saved by a previous run with one file read.
+  // A missing or outdated file is ignored.
+  void LoadCache(const std::filesystem::path& cache_path);
+
+  // Saves the resolution map if it has new entries.
+  void SaveCache(const std::filesystem::path& cache_path) const;
+
+  // Drops all memoized results, so that the next resolutions see the current
+  // files. The watch mode calls it on the JS thread before a reload while no
+  // ES module graph is being loaded.
+  void ClearCaches();
+
+  // Sets the callback called with the path of each package.json file read
+  // by the resolver. It may be called on the ES module loader threads.
+  void SetPackageJsonCallback(
+      std::function<void(const std::filesystem::path&)> callback);
+
+  // Returns the parsed package.json of the folder or nullptr if there is none.
+  const NodeLitePackageInfo* GetPackageInfo(
+      const std::filesystem::path& package_dir);
+
+  static bool IsBareSpecifier(std::string_view specifier) noexcept;
+
+  // The "exports" conditions used by require().
+  static const std::vector<std::string_view>& RequireConditions();
+
+  // The "exports" conditions used by the ES module imports.
+  static const std::vector<std::string_view>& ImportConditions();
+
+ private:
+  std::optional<std::filesystem::path> ResolveFile(
+      const std::filesystem::path& path);
+  std::optional<std::filesystem::path> ResolveExports(
+      const std::filesystem::path& package_dir,
+      const NodeLitePackageInfo::ExportsNode& exports,
+      const std::string& subpath,
+      const std::vector<std::string_view>& conditions);
+  bool IsDirectory(const std::filesystem::path& path);
+
+ private:
+  // The resolution itself runs without a lock. Only the memo maps are
+  // guarded, so the ES module loader threads contend only on their lookups,
+  // which take a shared lock.
+  // Guards packages_ and directories_.
+  mutable std::shared_mutex package_mutex_;
+  // Guards resolved_paths_, saved_paths_, and has_new_paths_.
+  mutable std::shared_mutex path_mutex_;
+  // Parsed package.json files by their folder. nullptr if there is none.
+  // The returned pointers stay valid until ClearCaches is called.
+  std::unordered_map<std::string, std::unique_ptr<NodeLitePackageInfo>>
+      packages_;
+  // Results of the folder checks done by the node_modules walk.
+  std::unordered_map<std::string, bool> directories_;
+  // Resolved paths by "<parent_dir>\t<specifier>".
+  std::unordered_map<std::string, std::string> resolved_paths_;
+  // Entries loaded from the cache file. They are checked on first use.
+  std::unordered_map<std::string, std::string> saved_paths_;
+  bool has_new_paths_{false};
+  std::function<void(const std::filesystem::path&)> package_json_callback_;
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_RESOLVER_H
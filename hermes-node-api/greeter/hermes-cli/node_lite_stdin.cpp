@@ -0,0 +1,438 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_stdin.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+namespace node_api_tests {
+
+namespace {
+
+// Returns the size of the data without an incomplete UTF-8 sequence at its
+// end. The invalid sequences are left to the string decoder.
+size_t GetCompleteUtf8Size(std::string_view data) noexcept {
+  size_t max_tail_size = std::min<size_t>(data.size(), 3);
+  for (size_t tail_size = 1; tail_size <= max_tail_size; ++tail_size) {
+    uint8_t byte = static_cast<uint8_t>(data[data.size() - tail_size]);
+    if ((byte & 0xC0) == 0x80) {
+      continue;
+    }
+    size_t sequence_size = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : 2;
+    if (byte >= 0xC0 && sequence_size > tail_size) {
+      return data.size() - tail_size;
+    }
+    break;
+  }
+  return data.size();
+}
+
+}  // namespace
+
+//=============================================================================
+// NodeLiteStdin implementation
+//=============================================================================
+
+NodeLiteStdin::NodeLiteStdin(
+    napi_env env, std::shared_ptr<NodeLiteTaskRunner> task_runner) noexcept
+    : env_(env), state_(std::make_shared<ReaderState>()) {
+  state_->task_runner = std::move(task_runner);
+  state_->owner = this;
+}
+
+NodeLiteStdin::~NodeLiteStdin() {
+  std::lock_guard<std::mutex> lock{state_->mutex};
+  state_->owner = nullptr;
+}
+
+/*static*/ void NodeLiteStdin::ReadChunks(
+    const std::shared_ptr<ReaderState>& state) {
+  for (size_t tail = 0;; tail = (tail + 1) % kChunkCount) {
+    {
+      std::unique_lock<std::mutex> lock{state->mutex};
+      state->chunk_consumed.wait(
+          lock, [&state]() { return state->queued_count < kChunkCount; });
+    }
+    // The chunk after the queued ones is not accessed by the JS thread.
+    Chunk& chunk = state->chunks[tail];
+    if (chunk.data == nullptr) {
+      chunk.data = std::make_unique<char[]>(kChunkSize);
+    }
+    int64_t size =
+        NodeLitePlatform::ReadStdin(chunk.data.get(), kChunkSize, chunk.error);
+    chunk.size = size > 0 ? static_cast<size_t>(size) : 0;
+    chunk.status = size > 0    ? ChunkStatus::kData
+                   : size == 0 ? ChunkStatus::kEnd
+                               : ChunkStatus::kError;
+
+    std::lock_guard<std::mutex> lock{state->mutex};
+    ++state->queued_count;
+    PostDeliveryLocked(state);
+    if (chunk.status != ChunkStatus::kData) {
+      return;
+    }
+  }
+}
+
+/*static*/ void NodeLiteStdin::PostDeliveryLocked(
+    const std::shared_ptr<ReaderState>& state) {
+  if (state->is_delivery_posted || state->owner == nullptr) {
+    return;
+  }
+  state->is_delivery_posted = true;
+  // The task must not keep the state alive: the state owns the task runner.
+  state->task_runner->PostTask(
+      [weak_state = std::weak_ptr<ReaderState>(state)]() {
+        std::shared_ptr<ReaderState> state = weak_state.lock();
+        if (state == nullptr) {
+          return;
+        }
+        NodeLiteStdin* owner{};
+        {
+          std::lock_guard<std::mutex> lock{state->mutex};
+          state->is_delivery_posted = false;
+          owner = state->owner;
+        }
+        if (owner != nullptr) {
+          owner->DeliverChunk();
+        }
+      });
+}
+
+void NodeLiteStdin::DeliverChunk() {
+  napi_env env = env_;
+  Chunk* chunk{};
+  {
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    if (!is_flowing_ || state_->queued_count == 0) {
+      return;
+    }
+    chunk = &state_->chunks[state_->head];
+  }
+
+  ReportOnException(env, [this, env, chunk]() {
+    NodeApiHandleScope scope{env};
+    ChunkStatus status = chunk->status;
+    size_t size = chunk->size;
+    std::string error = std::move(chunk->error);
+    napi_value data{};
+    if (status == ChunkStatus::kData) {
+      if (is_utf8_) {
+        data = DecodeUtf8(chunk->data.get(), size);
+      } else {
+        void* buffer_data{};
+        napi_value buffer{};
+        NODE_LITE_CALL(
+            napi_create_arraybuffer(env, size, &buffer_data, &buffer));
+        std::memcpy(buffer_data, chunk->data.get(), size);
+        NODE_LITE_CALL(napi_create_typedarray(
+            env, napi_uint8_array, size, buffer, 0, &data));
+      }
+    }
+
+    // Release the chunk to the reader thread before calling JS. The next
+    // chunk is delivered by its own task, so that the microtasks and the
+    // other tasks run between the chunks.
+    {
+      std::lock_guard<std::mutex> lock{state_->mutex};
+      state_->head = (state_->head + 1) % kChunkCount;
+      --state_->queued_count;
+      if (state_->queued_count > 0) {
+        PostDeliveryLocked(state_);
+      }
+    }
+    state_->chunk_consumed.notify_one();
+
+    if (status == ChunkStatus::kData) {
+      CallJS(Callback::kOnData, {data, NodeApi::CreateUInt32(env, size)});
+      return;
+    }
+
+    // A flowing stream does not keep the event loop alive after its end.
+    is_ended_ = true;
+    if (is_flowing_) {
+      state_->task_runner->Unref();
+    }
+    if (status == ChunkStatus::kError) {
+      CallJS(Callback::kOnError, {NodeApi::CreateString(env, error)});
+      return;
+    }
+    if (!utf8_remainder_.empty()) {
+      // The incomplete sequence is decoded as a replacement character. Its
+      // bytes were counted with its chunk.
+      napi_value remainder{};
+      NODE_LITE_CALL(napi_create_string_utf8(
+          env, utf8_remainder_.data(), utf8_remainder_.size(), &remainder));
+      CallJS(Callback::kOnData, {remainder, NodeApi::CreateUInt32(env, 0)});
+      utf8_remainder_.clear();
+    }
+    CallJS(Callback::kOnEnd, {});
+  });
+}
+
+void NodeLiteStdin::SetFlowing(bool is_flowing) {
+  if (is_flowing_ == is_flowing) {
+    return;
+  }
+  is_flowing_ = is_flowing;
+  if (is_ended_) {
+    return;
+  }
+  // Only a flowing stream keeps the event loop alive, like in Node.js.
+  if (!is_flowing) {
+    state_->task_runner->Unref();
+    return;
+  }
+  state_->task_runner->Ref();
+  if (!is_reading_) {
+    is_reading_ = true;
+    std::thread([state = state_]() { ReadChunks(state); }).detach();
+  }
+  std::lock_guard<std::mutex> lock{state_->mutex};
+  if (state_->queued_count > 0) {
+    PostDeliveryLocked(state_);
+  }
+}
+
+napi_value NodeLiteStdin::DecodeUtf8(const char* data, size_t size) {
+  napi_env env = env_;
+  // A UTF-8 sequence split between chunks is completed by the next chunk.
+  std::string_view text{data, size};
+  bool has_remainder = !utf8_remainder_.empty();
+  if (has_remainder) {
+    utf8_remainder_.append(data, size);
+    text = utf8_remainder_;
+  }
+  size_t complete_size = GetCompleteUtf8Size(text);
+  napi_value result{};
+  NODE_LITE_CALL(
+      napi_create_string_utf8(env, text.data(), complete_size, &result));
+  if (has_remainder) {
+    utf8_remainder_.erase(0, complete_size);
+  } else {
+    utf8_remainder_.assign(text.substr(complete_size));
+  }
+  return result;
+}
+
+void NodeLiteStdin::CallJS(Callback callback, span<napi_value> args) {
+  napi_env env = env_;
+  NodeApiRef& callback_ref = callbacks_[static_cast<size_t>(callback)];
+  NODE_LITE_ASSERT(callback_ref != nullptr, "The stdin callbacks are not set");
+  NodeApi::CallFunction(
+      env, NodeApi::GetReferenceValue(env, callback_ref.get()), args);
+}
+
+napi_value NodeLiteStdin::CreateBinding(napi_env env) {
+  napi_value binding = NodeApi::CreateObject(env);
+
+  // setCallbacks({onData, onEnd, onError})
+  NodeApi::SetMethod(
+      env,
+      binding,
+      "setCallbacks",
+      [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected at least 1 argument");
+        constexpr const char* kCallbackNames[] = {
+            "onData", "onEnd", "onError"};
+        static_assert(std::size(kCallbackNames) ==
+                      static_cast<size_t>(Callback::kCount));
+        for (size_t i = 0; i < std::size(kCallbackNames); ++i) {
+          napi_value callback =
+              NodeApi::GetProperty(env, args[0], kCallbackNames[i]);
+          NODE_LITE_ASSERT(NodeApi::TypeOf(env, callback) == napi_function,
+                           "Expected function %s",
+                           kCallbackNames[i]);
+          callbacks_[i] = MakeNodeApiRef(env, callback);
+        }
+        return nullptr;
+      });
+
+  // setFlowing(isFlowing): the first call starts the reader thread.
+  NodeApi::SetMethod(
+      env, binding, "setFlowing", [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        bool is_flowing{};
+        NODE_LITE_CALL(napi_get_value_bool(env, args[0], &is_flowing));
+        SetFlowing(is_flowing);
+        return nullptr;
+      });
+
+  // setEncoding(isUtf8)
+  NodeApi::SetMethod(
+      env, binding, "setEncoding", [this](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        NODE_LITE_CALL(napi_get_value_bool(env, args[0], &is_utf8_));
+        return nullptr;
+      });
+
+  return binding;
+}
+
+/*static*/ const std::string_view NodeLiteStdin::kStreamSource = R"JS(
+(function (binding, require) {
+  'use strict';
+  const EventEmitter = require('events');
+
+  function ReadStream() {
+    EventEmitter.call(this);
+    this.fd = 0;
+    this.bytesRead = 0;
+    this.readable = true;
+    this.readableEnded = false;
+    this.readableFlowing = null;
+    this.destroyed = false;
+    this.readableEncoding = null;
+    // Like in Node.js, adding a 'data' listener starts the flow unless the
+    // stream was paused explicitly.
+    this.on('newListener', (type) => {
+      if (type === 'data' && this.readableFlowing !== false) {
+        this.resume();
+      }
+    });
+  }
+  Object.setPrototypeOf(ReadStream.prototype, EventEmitter.prototype);
+  Object.setPrototypeOf(ReadStream, EventEmitter);
+
+  ReadStream.prototype.resume = function () {
+    this.readableFlowing = true;
+    if (!this.destroyed) {
+      binding.setFlowing(true);
+    }
+    return this;
+  };
+
+  ReadStream.prototype.pause = function () {
+    this.readableFlowing = false;
+    if (!this.destroyed) {
+      binding.setFlowing(false);
+    }
+    return this;
+  };
+
+  ReadStream.prototype.isPaused = function () {
+    return this.readableFlowing === false;
+  };
+
+  ReadStream.prototype.setEncoding = function (encoding) {
+    const name = String(encoding || 'utf8').toLowerCase();
+    if (name !== 'utf8' && name !== 'utf-8') {
+      throw new TypeError('Unsupported encoding: ' + encoding);
+    }
+    this.readableEncoding = 'utf8';
+    binding.setEncoding(true);
+    return this;
+  };
+
+  ReadStream.prototype.destroy = function (error) {
+    if (this.destroyed) {
+      return this;
+    }
+    binding.setFlowing(false);
+    this.destroyed = true;
+    this.readable = false;
+    process.nextTick(() => {
+      if (error) {
+        this.emit('error', error);
+      }
+      this.emit('close');
+    });
+    return this;
+  };
+
+  // Pauses the input while the destination write buffer is full.
+  ReadStream.prototype.pipe = function (destination, options) {
+    this.on('data', (chunk) => {
+      if (destination.write(chunk) === false) {
+        this.pause();
+        destination.once('drain', () => this.resume());
+      }
+    });
+    if (!options || options.end !== false) {
+      this.once('end', () => destination.end());
+    }
+    return destination;
+  };
+
+  // Pauses the input while the iterator has unread chunks.
+  ReadStream.prototype[Symbol.asyncIterator] = function () {
+    const stream = this;
+    const chunks = [];
+    let waiter = null;
+    let error = null;
+    let isDone = false;
+    function settle() {
+      if (waiter === null) {
+        return;
+      }
+      const {resolve, reject} = waiter;
+      if (chunks.length > 0) {
+        waiter = null;
+        resolve({value: chunks.shift(), done: false});
+      } else if (error !== null) {
+        waiter = null;
+        reject(error);
+      } else if (isDone) {
+        waiter = null;
+        resolve({value: undefined, done: true});
+      }
+    }
+    stream.on('data', (chunk) => {
+      chunks.push(chunk);
+      stream.pause();
+      settle();
+    });
+    stream.once('end', () => {
+      isDone = true;
+      settle();
+    });
+    stream.once('error', (e) => {
+      error = e;
+      settle();
+    });
+    return {
+      next() {
+        if (chunks.length === 0 && !isDone && error === null) {
+          stream.resume();
+        }
+        return new Promise((resolve, reject) => {
+          waiter = {resolve, reject};
+          settle();
+        });
+      },
+      return() {
+        stream.destroy();
+        return Promise.resolve({value: undefined, done: true});
+      },
+      [Symbol.asyncIterator]() {
+        return this;
+      },
+    };
+  };
+
+  const stdin = new ReadStream();
+  binding.setCallbacks({
+    onData(chunk, size) {
+      stdin.bytesRead += size;
+      stdin.emit('data', chunk);
+    },
+    onEnd() {
+      stdin.readable = false;
+      stdin.readableEnded = true;
+      stdin.emit('end');
+      stdin.emit('close');
+    },
+    onError(message) {
+      stdin.readable = false;
+      stdin.destroyed = true;
+      stdin.emit('error', new Error(message));
+      stdin.emit('close');
+    },
+  });
+  return stdin;
+})
+)JS";
+
+}  // namespace node_api_tests
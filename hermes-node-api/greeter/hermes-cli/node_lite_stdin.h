@@ -0,0 +1,109 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// The standard input stream of the process.stdin object.
+
+#ifndef NODE_API_TEST_NODE_LITE_STDIN_H
+#define NODE_API_TEST_NODE_LITE_STDIN_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+// Reads the standard input on a background thread and passes it to JS in
+// chunks through the task runner. The thread reads ahead into a fixed ring
+// of buffers and waits while all of them are full, so a paused or slow
+// consumer stops the reads instead of growing the memory.
+class NodeLiteStdin {
+ public:
+  // Each read fills at most one chunk.
+  static constexpr size_t kChunkSize = 64 * 1024;
+  // The number of chunks that are read ahead of the JS consumer.
+  static constexpr size_t kChunkCount = 8;
+
+  // The JS callbacks set by the stream.
+  enum class Callback : size_t {
+    kOnData,
+    kOnEnd,
+    kOnError,
+    kCount,
+  };
+
+  // The JS source of the stream function. It receives the binding object and
+  // the require function and returns the process.stdin stream.
+  static const std::string_view kStreamSource;
+
+  NodeLiteStdin(napi_env env,
+                std::shared_ptr<NodeLiteTaskRunner> task_runner) noexcept;
+  ~NodeLiteStdin();
+
+  NodeLiteStdin(const NodeLiteStdin&) = delete;
+  NodeLiteStdin& operator=(const NodeLiteStdin&) = delete;
+
+  napi_value CreateBinding(napi_env env);
+
+ private:
+  enum class ChunkStatus {
+    kData,
+    kEnd,
+    kError,
+  };
+
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    size_t size{};
+    ChunkStatus status{ChunkStatus::kData};
+    std::string error;
+  };
+
+  // The state shared with the reader thread. The thread is detached because
+  // it may be blocked in a read when the process exits, so it owns the state
+  // together with the NodeLiteStdin.
+  struct ReaderState {
+    std::shared_ptr<NodeLiteTaskRunner> task_runner;
+    std::mutex mutex;
+    std::condition_variable chunk_consumed;
+    // The ring of chunks. The reader thread fills the chunk after the queued
+    // ones, and the JS thread consumes the queued ones from the head.
+    std::array<Chunk, kChunkCount> chunks;
+    size_t head{};
+    size_t queued_count{};
+    bool is_delivery_posted{};
+    // Cleared when the NodeLiteStdin is deleted.
+    NodeLiteStdin* owner{};
+  };
+
+  // Called on the reader thread.
+  static void ReadChunks(const std::shared_ptr<ReaderState>& state);
+  // Must be called with the mutex locked.
+  static void PostDeliveryLocked(const std::shared_ptr<ReaderState>& state);
+
+  // Passes the first queued chunk to JS.
+  void DeliverChunk();
+  void SetFlowing(bool is_flowing);
+  napi_value DecodeUtf8(const char* data, size_t size);
+  void CallJS(Callback callback, span<napi_value> args);
+
+ private:
+  napi_env env_;
+  std::shared_ptr<ReaderState> state_;
+  NodeApiRef callbacks_[static_cast<size_t>(Callback::kCount)];
+  bool is_reading_{};
+  bool is_flowing_{};
+  bool is_ended_{};
+  // The chunks are decoded as UTF-8 strings after setEncoding('utf8').
+  bool is_utf8_{};
+  // The trailing bytes of an incomplete UTF-8 sequence of the last chunk.
+  std::string utf8_remainder_;
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_STDIN_H
@@ -0,0 +1,875 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_text.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include "node_lite_cpu.h"
+
+namespace node_api_tests {
+
+namespace {
+
+constexpr char16_t kReplacementCharacter = 0xFFFD;
+
+inline bool IsSurrogate(uint32_t code_unit) noexcept {
+  return (code_unit & 0xF800) == 0xD800;
+}
+
+inline bool IsLeadSurrogate(uint32_t code_unit) noexcept {
+  return (code_unit & 0xFC00) == 0xD800;
+}
+
+inline bool IsTrailSurrogate(uint32_t code_unit) noexcept {
+  return (code_unit & 0xFC00) == 0xDC00;
+}
+
+// A UTF-8 sequence decoded by DecodeSequence.
+struct Utf8Sequence {
+  uint32_t code_point;
+  // The number of bytes in the sequence or in its maximal invalid prefix.
+  uint32_t length;
+  bool is_valid;
+};
+
+// Decodes the non-ASCII UTF-8 sequence at the position.
+inline Utf8Sequence DecodeSequence(const uint8_t* data,
+                                   size_t size,
+                                   size_t pos) noexcept {
+  uint8_t c = data[pos];
+  uint32_t length{};
+  uint32_t code_point{};
+  uint8_t min_next = 0x80;
+  uint8_t max_next = 0xBF;
+  if (c >= 0xC2 && c <= 0xDF) {
+    length = 2;
+    code_point = c & 0x1F;
+  } else if (c >= 0xE0 && c <= 0xEF) {
+    length = 3;
+    code_point = c & 0x0F;
+    // Reject the overlong forms and the surrogates.
+    min_next = c == 0xE0 ? 0xA0 : 0x80;
+    max_next = c == 0xED ? 0x9F : 0xBF;
+  } else if (c >= 0xF0 && c <= 0xF4) {
+    length = 4;
+    code_point = c & 0x07;
+    // Reject the overlong forms and the code points above U+10FFFF.
+    min_next = c == 0xF0 ? 0x90 : 0x80;
+    max_next = c == 0xF4 ? 0x8F : 0xBF;
+  } else {
+    return Utf8Sequence{0, 1, false};
+  }
+  uint32_t i = 1;
+  for (; i < length && pos + i < size; ++i) {
+    uint8_t next = data[pos + i];
+    if (next < min_next || next > max_next) {
+      break;
+    }
+    code_point = (code_point << 6) | (next & 0x3F);
+    min_next = 0x80;
+    max_next = 0xBF;
+  }
+  return i < length ? Utf8Sequence{0, i, false}
+                    : Utf8Sequence{code_point, length, true};
+}
+
+// Writes the non-ASCII sequences from the position until the next ASCII
+// byte. Returns the new position.
+size_t DecodeNonAsciiRun(const uint8_t* data,
+                         size_t size,
+                         size_t pos,
+                         char16_t* output,
+                         size_t& written) noexcept {
+  while (pos < size && data[pos] >= 0x80) {
+    Utf8Sequence sequence = DecodeSequence(data, size, pos);
+    pos += sequence.length;
+    if (!sequence.is_valid) {
+      output[written++] = kReplacementCharacter;
+    } else if (sequence.code_point >= 0x10000) {
+      uint32_t offset = sequence.code_point - 0x10000;
+      output[written++] = static_cast<char16_t>(0xD800 + (offset >> 10));
+      output[written++] = static_cast<char16_t>(0xDC00 + (offset & 0x3FF));
+    } else {
+      output[written++] = static_cast<char16_t>(sequence.code_point);
+    }
+  }
+  return pos;
+}
+
+// Encodes the non-ASCII code point at the position. Returns false if it does
+// not fit into the output.
+inline bool EncodeCodePoint(const char16_t* data,
+                            size_t size,
+                            size_t& pos,
+                            char* output,
+                            size_t capacity,
+                            size_t& written) noexcept {
+  uint32_t code_point = data[pos];
+  size_t length = 1;
+  if (IsLeadSurrogate(code_point) && pos + 1 < size &&
+      IsTrailSurrogate(data[pos + 1])) {
+    code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                 (data[pos + 1] - 0xDC00);
+    length = 2;
+  } else if (IsSurrogate(code_point)) {
+    code_point = kReplacementCharacter;
+  }
+  uint8_t* out = reinterpret_cast<uint8_t*>(output) + written;
+  if (code_point < 0x80) {
+    if (capacity - written < 1) {
+      return false;
+    }
+    out[0] = static_cast<uint8_t>(code_point);
+    written += 1;
+  } else if (code_point < 0x800) {
+    if (capacity - written < 2) {
+      return false;
+    }
+    out[0] = static_cast<uint8_t>(0xC0 | (code_point >> 6));
+    out[1] = static_cast<uint8_t>(0x80 | (code_point & 0x3F));
+    written += 2;
+  } else if (code_point < 0x10000) {
+    if (capacity - written < 3) {
+      return false;
+    }
+    out[0] = static_cast<uint8_t>(0xE0 | (code_point >> 12));
+    out[1] = static_cast<uint8_t>(0x80 | ((code_point >> 6) & 0x3F));
+    out[2] = static_cast<uint8_t>(0x80 | (code_point & 0x3F));
+    written += 3;
+  } else {
+    if (capacity - written < 4) {
+      return false;
+    }
+    out[0] = static_cast<uint8_t>(0xF0 | (code_point >> 18));
+    out[1] = static_cast<uint8_t>(0x80 | ((code_point >> 12) & 0x3F));
+    out[2] = static_cast<uint8_t>(0x80 | ((code_point >> 6) & 0x3F));
+    out[3] = static_cast<uint8_t>(0x80 | (code_point & 0x3F));
+    written += 4;
+  }
+  pos += length;
+  return true;
+}
+
+size_t FindNonAsciiScalar(const char* data, size_t size, size_t pos) noexcept {
+  for (; pos + 8 <= size; pos += 8) {
+    uint64_t word{};
+    std::memcpy(&word, data + pos, 8);
+    if ((word & 0x8080808080808080u) != 0) {
+      break;
+    }
+  }
+  while (pos < size && static_cast<uint8_t>(data[pos]) < 0x80) {
+    ++pos;
+  }
+  return pos;
+}
+
+bool IsValidScalar(const char* data, size_t size, size_t pos) noexcept {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  while (pos < size) {
+    if (bytes[pos] < 0x80) {
+      ++pos;
+      continue;
+    }
+    Utf8Sequence sequence = DecodeSequence(bytes, size, pos);
+    if (!sequence.is_valid) {
+      return false;
+    }
+    pos += sequence.length;
+  }
+  return true;
+}
+
+#ifdef NODE_LITE_X64
+
+inline uint32_t CountTrailingZeros(uint32_t value) noexcept {
+#ifdef _MSC_VER
+  unsigned long index{};
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+}
+
+// Counts the set bits without the POPCNT instruction, which is not in the
+// x64 baseline.
+inline uint32_t PopCount(uint32_t value) noexcept {
+  value = value - ((value >> 1) & 0x55555555u);
+  value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+  return (((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+size_t FindNonAsciiSse2(const char* data, size_t size) noexcept {
+  size_t pos = 0;
+  for (; pos + 16 <= size; pos += 16) {
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos))));
+    if (mask != 0) {
+      return pos + CountTrailingZeros(mask);
+    }
+  }
+  return FindNonAsciiScalar(data, size, pos);
+}
+
+NODE_LITE_TARGET("avx2")
+size_t FindNonAsciiAvx2(const char* data, size_t size) noexcept {
+  size_t pos = 0;
+  for (; pos + 64 <= size; pos += 64) {
+    __m256i low =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+    __m256i high =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 32));
+    if (_mm256_movemask_epi8(_mm256_or_si256(low, high)) != 0) {
+      break;
+    }
+  }
+  for (; pos + 32 <= size; pos += 32) {
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos))));
+    if (mask != 0) {
+      return pos + CountTrailingZeros(mask);
+    }
+  }
+  return FindNonAsciiScalar(data, size, pos);
+}
+
+// The error flags of the UTF-8 validation by the lookup of the first two
+// bytes of each sequence. It is the algorithm of "Validating UTF-8 In Less
+// Than One Instruction Per Byte" by John Keiser and Daniel Lemire.
+constexpr uint8_t kTooShort = 1 << 0;
+constexpr uint8_t kTooLong = 1 << 1;
+constexpr uint8_t kOverlong3 = 1 << 2;
+constexpr uint8_t kTooLarge = 1 << 3;
+constexpr uint8_t kSurrogate = 1 << 4;
+constexpr uint8_t kOverlong2 = 1 << 5;
+constexpr uint8_t kTooLarge1000 = 1 << 6;
+constexpr uint8_t kOverlong4 = 1 << 6;
+constexpr uint8_t kTwoConts = 1 << 7;
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+// Validates UTF-8 in 16-byte blocks with SSSE3. The sequences may cross the
+// block boundaries.
+class Utf8Validator {
+ public:
+  NODE_LITE_TARGET("ssse3")
+  void CheckBlock(__m128i input) noexcept {
+    // Indexed by the high nibble of the first byte.
+    static constexpr uint8_t kByte1High[16] = {
+        kTooLong, kTooLong, kTooLong, kTooLong,
+        kTooLong, kTooLong, kTooLong, kTooLong,
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        kTooShort | kOverlong2,
+        kTooShort,
+        kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4};
+    // Indexed by the low nibble of the first byte.
+    static constexpr uint8_t kByte1Low[16] = {
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+        kCarry | kOverlong2,
+        kCarry,
+        kCarry,
+        kCarry | kTooLarge,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000};
+    // Indexed by the high nibble of the second byte.
+    static constexpr uint8_t kByte2High[16] = {
+        kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 |
+            kOverlong4,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooShort, kTooShort, kTooShort, kTooShort};
+    // The bytes above these values at the block end start a sequence that
+    // continues in the next block.
+    static constexpr uint8_t kMaxCompleteEnd[16] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF};
+
+    if (_mm_movemask_epi8(input) == 0) {
+      CheckAsciiBlock(input);
+      return;
+    }
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, prev_input_, 15);
+    __m128i special_cases = _mm_and_si128(
+        _mm_and_si128(
+            _mm_shuffle_epi8(
+                LoadTable(kByte1High),
+                _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble)),
+            _mm_shuffle_epi8(LoadTable(kByte1Low),
+                             _mm_and_si128(prev1, low_nibble))),
+        _mm_shuffle_epi8(
+            LoadTable(kByte2High),
+            _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble)));
+    // The third and fourth bytes of the sequences must be continuations.
+    __m128i is_third_byte = _mm_subs_epu8(
+        _mm_alignr_epi8(input, prev_input_, 14), _mm_set1_epi8(0xE0 - 0x80));
+    __m128i is_fourth_byte = _mm_subs_epu8(
+        _mm_alignr_epi8(input, prev_input_, 13), _mm_set1_epi8(0xF0 - 0x80));
+    __m128i must_be_continuation =
+        _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte),
+                      _mm_set1_epi8(static_cast<char>(0x80)));
+    error_ = _mm_or_si128(error_,
+                          _mm_xor_si128(must_be_continuation, special_cases));
+    prev_incomplete_ = _mm_subs_epu8(input, LoadTable(kMaxCompleteEnd));
+    prev_input_ = input;
+  }
+
+  void CheckAsciiBlock(__m128i input) noexcept {
+    error_ = _mm_or_si128(error_, prev_incomplete_);
+    prev_incomplete_ = _mm_setzero_si128();
+    prev_input_ = input;
+  }
+
+  // Returns true if the checked blocks are valid and complete.
+  bool IsValid() const noexcept {
+    __m128i error = _mm_or_si128(error_, prev_incomplete_);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) ==
+           0xFFFF;
+  }
+
+ private:
+  static __m128i LoadTable(const uint8_t (&values)[16]) noexcept {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+  }
+
+  __m128i error_{};
+  __m128i prev_input_{};
+  __m128i prev_incomplete_{};
+};
+
+NODE_LITE_TARGET("ssse3")
+bool IsValidSsse3(const char* data, size_t size, size_t pos) noexcept {
+  Utf8Validator validator;
+  for (; pos + 64 <= size; pos += 64) {
+    const __m128i* blocks = reinterpret_cast<const __m128i*>(data + pos);
+    __m128i block0 = _mm_loadu_si128(blocks);
+    __m128i block1 = _mm_loadu_si128(blocks + 1);
+    __m128i block2 = _mm_loadu_si128(blocks + 2);
+    __m128i block3 = _mm_loadu_si128(blocks + 3);
+    if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(block0, block1),
+                                       _mm_or_si128(block2, block3))) == 0) {
+      validator.CheckAsciiBlock(block3);
+      continue;
+    }
+    validator.CheckBlock(block0);
+    validator.CheckBlock(block1);
+    validator.CheckBlock(block2);
+    validator.CheckBlock(block3);
+  }
+  for (; pos + 16 <= size; pos += 16) {
+    validator.CheckBlock(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)));
+  }
+  if (pos < size) {
+    // The zero padding finds the sequences cut by the end.
+    alignas(16) char last_block[16]{};
+    std::memcpy(last_block, data + pos, size - pos);
+    validator.CheckBlock(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(last_block)));
+  }
+  return validator.IsValid();
+}
+
+size_t DecodeToUtf16Sse2(const char* data,
+                         size_t size,
+                         char16_t* output) noexcept {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  const __m128i zero = _mm_setzero_si128();
+  size_t pos = 0;
+  size_t written = 0;
+  while (pos < size) {
+    // The output has room for the whole block, because each byte before the
+    // position produced at most one code unit.
+    for (; pos + 16 <= size; pos += 16, written += 16) {
+      __m128i block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+      __m128i* out = reinterpret_cast<__m128i*>(output + written);
+      _mm_storeu_si128(out, _mm_unpacklo_epi8(block, zero));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(block, zero));
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(block));
+      if (mask != 0) {
+        uint32_t ascii_length = CountTrailingZeros(mask);
+        pos += ascii_length;
+        written += ascii_length;
+        break;
+      }
+    }
+    for (; pos < size && bytes[pos] < 0x80; ++pos) {
+      output[written++] = bytes[pos];
+    }
+    pos = DecodeNonAsciiRun(bytes, size, pos, output, written);
+  }
+  return written;
+}
+
+size_t GetEncodedLengthSse2(const char16_t* data, size_t size) noexcept {
+  const __m128i non_ascii_bits = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i three_byte_bits = _mm_set1_epi16(static_cast<short>(0xF800));
+  const __m128i surrogate_bits = _mm_set1_epi16(static_cast<short>(0xD800));
+  const __m128i zero = _mm_setzero_si128();
+  size_t length = 0;
+  size_t pos = 0;
+  while (pos < size) {
+    for (; pos + 8 <= size; pos += 8) {
+      __m128i block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+      __m128i high_bits = _mm_and_si128(block, three_byte_bits);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, surrogate_bits)) != 0) {
+        break;
+      }
+      // Each code unit has one byte, plus one if it is not ASCII, plus one
+      // if it is above U+07FF. The masks have two bits per code unit.
+      uint32_t ascii_mask = static_cast<uint32_t>(_mm_movemask_epi8(
+          _mm_cmpeq_epi16(_mm_and_si128(block, non_ascii_bits), zero)));
+      uint32_t two_byte_mask = static_cast<uint32_t>(
+          _mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, zero)));
+      length += 8 + (16 - PopCount(ascii_mask)) / 2 +
+                (16 - PopCount(two_byte_mask)) / 2;
+    }
+    // Count the code points of one block with a surrogate or of the end.
+    size_t end = pos + 8 <= size ? pos + 8 : size;
+    while (pos < end) {
+      uint32_t code_unit = data[pos++];
+      if (code_unit < 0x80) {
+        length += 1;
+      } else if (code_unit < 0x800) {
+        length += 2;
+      } else if (IsLeadSurrogate(code_unit) && pos < size &&
+                 IsTrailSurrogate(data[pos])) {
+        length += 4;
+        ++pos;
+      } else {
+        length += 3;
+      }
+    }
+  }
+  return length;
+}
+
+size_t EncodeFromUtf16Sse2(const char16_t* data,
+                           size_t size,
+                           char* output,
+                           size_t capacity,
+                           size_t& read) noexcept {
+  const __m128i non_ascii_bits = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  size_t pos = 0;
+  size_t written = 0;
+  while (pos < size) {
+    for (; pos + 16 <= size && capacity - written >= 16;
+         pos += 16, written += 16) {
+      const __m128i* in = reinterpret_cast<const __m128i*>(data + pos);
+      __m128i low = _mm_loadu_si128(in);
+      __m128i high = _mm_loadu_si128(in + 1);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(
+              _mm_and_si128(_mm_or_si128(low, high), non_ascii_bits),
+              zero)) != 0xFFFF) {
+        break;
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + written),
+                       _mm_packus_epi16(low, high));
+    }
+    // Encode the code points until the next ASCII block can be tried.
+    size_t end = pos + 16 <= size ? pos + 16 : size;
+    while (pos < end) {
+      if (data[pos] < 0x80 && written < capacity) {
+        output[written++] = static_cast<char>(data[pos++]);
+      } else if (!EncodeCodePoint(
+                     data, size, pos, output, capacity, written)) {
+        read = pos;
+        return written;
+      }
+    }
+  }
+  read = pos;
+  return written;
+}
+
+#endif  // NODE_LITE_X64
+
+std::string_view GetTypedArrayData(napi_env env, napi_value value) {
+  span<uint8_t> bytes = NodeApi::GetUint8ArrayBytes(env, value);
+  return std::string_view(reinterpret_cast<const char*>(bytes.data()),
+                          bytes.size());
+}
+
+}  // namespace
+
+//=============================================================================
+// NodeLiteUtf8 implementation
+//=============================================================================
+
+/*static*/ size_t NodeLiteUtf8::FindNonAscii(const char* data,
+                                             size_t size) noexcept {
+#ifdef NODE_LITE_X64
+  static const auto find_non_ascii = NodeLiteCpuFeatures::Get().has_avx2
+                                         ? FindNonAsciiAvx2
+                                         : FindNonAsciiSse2;
+  return find_non_ascii(data, size);
+#else
+  return FindNonAsciiScalar(data, size, 0);
+#endif
+}
+
+/*static*/ bool NodeLiteUtf8::IsValid(const char* data, size_t size) noexcept {
+  size_t pos = FindNonAscii(data, size);
+#ifdef NODE_LITE_X64
+  static const auto is_valid =
+      NodeLiteCpuFeatures::Get().has_ssse3 ? IsValidSsse3 : IsValidScalar;
+  return is_valid(data, size, pos);
+#else
+  return IsValidScalar(data, size, pos);
+#endif
+}
+
+/*static*/ size_t NodeLiteUtf8::DecodeToUtf16(const char* data,
+                                              size_t size,
+                                              char16_t* output) noexcept {
+#ifdef NODE_LITE_X64
+  return DecodeToUtf16Sse2(data, size, output);
+#else
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  size_t pos = 0;
+  size_t written = 0;
+  while (pos < size) {
+    for (; pos < size && bytes[pos] < 0x80; ++pos) {
+      output[written++] = bytes[pos];
+    }
+    pos = DecodeNonAsciiRun(bytes, size, pos, output, written);
+  }
+  return written;
+#endif
+}
+
+/*static*/ size_t NodeLiteUtf8::GetIncompleteLength(const char* data,
+                                                    size_t size) noexcept {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  // Find the start of the last sequence among the last three bytes.
+  for (size_t length = 1; length <= 3 && length <= size; ++length) {
+    uint8_t c = bytes[size - length];
+    if (c < 0x80) {
+      return 0;
+    }
+    if (c >= 0xC0) {
+      // The sequence is incomplete if its valid prefix reaches the end.
+      Utf8Sequence sequence = DecodeSequence(bytes, size, size - length);
+      return !sequence.is_valid && sequence.length == length ? length : 0;
+    }
+  }
+  return 0;
+}
+
+/*static*/ size_t NodeLiteUtf8::GetEncodedLength(const char16_t* data,
+                                                 size_t size) noexcept {
+#ifdef NODE_LITE_X64
+  return GetEncodedLengthSse2(data, size);
+#else
+  size_t length = 0;
+  for (size_t pos = 0; pos < size;) {
+    uint32_t code_unit = data[pos++];
+    if (code_unit < 0x80) {
+      length += 1;
+    } else if (code_unit < 0x800) {
+      length += 2;
+    } else if (IsLeadSurrogate(code_unit) && pos < size &&
+               IsTrailSurrogate(data[pos])) {
+      length += 4;
+      ++pos;
+    } else {
+      length += 3;
+    }
+  }
+  return length;
+#endif
+}
+
+/*static*/ size_t NodeLiteUtf8::EncodeFromUtf16(const char16_t* data,
+                                                size_t size,
+                                                char* output,
+                                                size_t capacity,
+                                                size_t& read) noexcept {
+#ifdef NODE_LITE_X64
+  return EncodeFromUtf16Sse2(data, size, output, capacity, read);
+#else
+  size_t pos = 0;
+  size_t written = 0;
+  while (pos < size) {
+    if (data[pos] < 0x80 && written < capacity) {
+      output[written++] = static_cast<char>(data[pos++]);
+    } else if (!EncodeCodePoint(data, size, pos, output, capacity, written)) {
+      break;
+    }
+  }
+  read = pos;
+  return written;
+#endif
+}
+
+//=============================================================================
+// NodeLiteStringUtf16 implementation
+//=============================================================================
+
+NodeLiteStringUtf16::NodeLiteStringUtf16(napi_env env, napi_value value) {
+  NODE_LITE_CALL(napi_get_value_string_utf16(env, value, nullptr, 0, &size_));
+  data_ = stack_buffer_;
+  if (size_ >= kStackBufferSize) {
+    heap_buffer_ = std::make_unique<char16_t[]>(size_ + 1);
+    data_ = heap_buffer_.get();
+  }
+  NODE_LITE_CALL(
+      napi_get_value_string_utf16(env, value, data_, size_ + 1, &size_));
+}
+
+//=============================================================================
+// NodeLiteText implementation
+//=============================================================================
+
+/*static*/ napi_value NodeLiteText::CreateString(napi_env env,
+                                                 const char* data,
+                                                 size_t size) {
+  napi_value result{};
+  size_t ascii_length = NodeLiteUtf8::FindNonAscii(data, size);
+  if (ascii_length == size) {
+    NODE_LITE_CALL(napi_create_string_latin1(env, data, size, &result));
+    return result;
+  }
+
+  // Each byte produces at most one UTF-16 code unit.
+  if (size >= kExternalStringMinLength) {
+    // The text is decoded into the buffer that the engine owns until it
+    // finalizes the string. It may also copy the text and return
+    // copied = true.
+    char16_t* text =
+        static_cast<char16_t*>(std::malloc(size * sizeof(char16_t)));
+    NODE_LITE_ASSERT(text != nullptr, "Out of memory");
+    size_t length = NodeLiteUtf8::DecodeToUtf16(data, size, text);
+    // The multi-byte sequences leave the end of the buffer unused.
+    if (char16_t* shrunk = static_cast<char16_t*>(
+            std::realloc(text, length * sizeof(char16_t)))) {
+      text = shrunk;
+    }
+    bool copied{};
+    napi_status status = node_api_create_external_string_utf16(
+        env,
+        text,
+        length,
+        [](auto /*env*/, void* finalize_data, void* /*finalize_hint*/) {
+          std::free(finalize_data);
+        },
+        nullptr,
+        &result,
+        &copied);
+    if (status != napi_ok || copied) {
+      std::free(text);
+    }
+    NODE_LITE_CALL(status);
+    return result;
+  }
+  char16_t stack_buffer[NodeLiteStringUtf16::kStackBufferSize];
+  std::unique_ptr<char16_t[]> heap_buffer;
+  char16_t* buffer = stack_buffer;
+  if (size > NodeLiteStringUtf16::kStackBufferSize) {
+    heap_buffer = std::make_unique<char16_t[]>(size);
+    buffer = heap_buffer.get();
+  }
+  size_t length = NodeLiteUtf8::DecodeToUtf16(data, size, buffer);
+  NODE_LITE_CALL(napi_create_string_utf16(env, buffer, length, &result));
+  return result;
+}
+
+/*static*/ napi_value NodeLiteText::CreateBinding(napi_env env) {
+  napi_value binding = NodeApi::CreateObject(env);
+
+  // encode(string) -> Uint8Array
+  NodeApi::SetMethod(
+      env, binding, "encode", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        NodeLiteStringUtf16 text{env, args[0]};
+        size_t length =
+            NodeLiteUtf8::GetEncodedLength(text.data(), text.size());
+        void* data{};
+        napi_value array_buffer{};
+        NODE_LITE_CALL(
+            napi_create_arraybuffer(env, length, &data, &array_buffer));
+        size_t read{};
+        NodeLiteUtf8::EncodeFromUtf16(text.data(),
+                                      text.size(),
+                                      static_cast<char*>(data),
+                                      length,
+                                      read);
+        napi_value result{};
+        NODE_LITE_CALL(napi_create_typedarray(
+            env, napi_uint8_array, length, array_buffer, 0, &result));
+        return result;
+      });
+
+  // encodeInto(string, uint8Array) -> {read, written}
+  NodeApi::SetMethod(
+      env, binding, "encodeInto", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 2, "Expected 2 arguments");
+        NodeLiteStringUtf16 text{env, args[0]};
+        std::string_view destination = GetTypedArrayData(env, args[1]);
+        size_t read{};
+        size_t written =
+            NodeLiteUtf8::EncodeFromUtf16(text.data(),
+                                          text.size(),
+                                          const_cast<char*>(destination.data()),
+                                          destination.size(),
+                                          read);
+        napi_value result = NodeApi::CreateObject(env);
+        NodeApi::SetProperty(
+            env, result, "read", NodeApi::CreateDouble(env, read));
+        NodeApi::SetProperty(
+            env, result, "written", NodeApi::CreateDouble(env, written));
+        return result;
+      });
+
+  // decode(uint8Array, fatal, ignoreBOM) -> string or undefined
+  // Returns undefined for invalid UTF-8 if fatal is true.
+  NodeApi::SetMethod(
+      env, binding, "decode", [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 3, "Expected 3 arguments");
+        std::string_view bytes = GetTypedArrayData(env, args[0]);
+        bool fatal{};
+        NODE_LITE_CALL(napi_get_value_bool(env, args[1], &fatal));
+        bool ignore_bom{};
+        NODE_LITE_CALL(napi_get_value_bool(env, args[2], &ignore_bom));
+        if (!ignore_bom && bytes.substr(0, 3) == "\xEF\xBB\xBF") {
+          bytes.remove_prefix(3);
+        }
+        if (fatal && !NodeLiteUtf8::IsValid(bytes.data(), bytes.size())) {
+          return NodeApi::GetUndefined(env);
+        }
+        return CreateString(env, bytes.data(), bytes.size());
+      });
+
+  // getIncompleteLength(uint8Array) -> number of bytes
+  NodeApi::SetMethod(
+      env,
+      binding,
+      "getIncompleteLength",
+      [](napi_env env, span<napi_value> args) {
+        NODE_LITE_ASSERT(args.size() >= 1, "Expected 1 argument");
+        std::string_view bytes = GetTypedArrayData(env, args[0]);
+        size_t length =
+            NodeLiteUtf8::GetIncompleteLength(bytes.data(), bytes.size());
+        return NodeApi::CreateUInt32(env, static_cast<uint32_t>(length));
+      });
+
+  return binding;
+}
+
+/*static*/ const std::string_view NodeLiteText::kModuleSource = R"JS(
+(function (binding, require) {
+  'use strict';
+  const kUtf8Labels = ['utf-8', 'utf8', 'unicode-1-1-utf-8'];
+  const kEmpty = new Uint8Array(0);
+
+  function toUint8Array(input) {
+    if (input === undefined) {
+      return kEmpty;
+    }
+    if (input instanceof Uint8Array) {
+      return input;
+    }
+    if (input instanceof ArrayBuffer) {
+      return new Uint8Array(input);
+    }
+    if (ArrayBuffer.isView(input)) {
+      return new Uint8Array(input.buffer, input.byteOffset, input.byteLength);
+    }
+    throw new TypeError(
+        'The "input" argument must be an ArrayBuffer or an ArrayBufferView');
+  }
+
+  // Encodes strings to UTF-8.
+  function TextEncoder() {
+  }
+
+  Object.defineProperty(TextEncoder.prototype, 'encoding', {
+    get() { return 'utf-8'; },
+  });
+
+  TextEncoder.prototype.encode = function (input = '') {
+    return binding.encode(String(input));
+  };
+
+  TextEncoder.prototype.encodeInto = function (source, destination) {
+    if (!(destination instanceof Uint8Array)) {
+      throw new TypeError('The "destination" argument must be a Uint8Array');
+    }
+    return binding.encodeInto(String(source), destination);
+  };
+
+  // Decodes UTF-8 to strings. With {stream: true} an incomplete sequence at
+  // the end of the input is kept for the next call.
+  function TextDecoder(label = 'utf-8', options = {}) {
+    const encoding = String(label).trim().toLowerCase();
+    if (!kUtf8Labels.includes(encoding)) {
+      throw new RangeError(`The "${label}" encoding is not supported`);
+    }
+    this._fatal = Boolean(options.fatal);
+    this._ignoreBOM = Boolean(options.ignoreBOM);
+    this._pending = null;
+    this._isStreamStarted = false;
+  }
+
+  Object.defineProperties(TextDecoder.prototype, {
+    encoding: {get() { return 'utf-8'; }},
+    fatal: {get() { return this._fatal; }},
+    ignoreBOM: {get() { return this._ignoreBOM; }},
+  });
+
+  TextDecoder.prototype.decode = function (input, options) {
+    const stream = Boolean(options && options.stream);
+    let bytes = toUint8Array(input);
+    if (this._pending !== null) {
+      const joined = new Uint8Array(this._pending.length + bytes.length);
+      joined.set(this._pending);
+      joined.set(bytes, this._pending.length);
+      bytes = joined;
+      this._pending = null;
+    }
+    if (stream) {
+      const incompleteLength = binding.getIncompleteLength(bytes);
+      if (incompleteLength > 0) {
+        this._pending = bytes.slice(bytes.length - incompleteLength);
+        bytes = bytes.subarray(0, bytes.length - incompleteLength);
+      }
+    }
+    // Only the BOM at the start of a stream is removed.
+    const result = binding.decode(
+        bytes, this._fatal, this._ignoreBOM || this._isStreamStarted);
+    if (stream) {
+      this._isStreamStarted = this._isStreamStarted || bytes.length > 0;
+    } else {
+      this._isStreamStarted = false;
+    }
+    if (result === undefined) {
+      this._pending = null;
+      this._isStreamStarted = false;
+      throw new TypeError('The encoded data was not valid for encoding utf-8');
+    }
+    return result;
+  };
+
+  return {TextEncoder, TextDecoder};
+})
+)JS";
+
+}  // namespace node_api_tests
@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// UTF-8 conversions and the "util" built-in module with TextEncoder and
+// TextDecoder.
+
+#ifndef NODE_API_TEST_NODE_LITE_TEXT_H
+#define NODE_API_TEST_NODE_LITE_TEXT_H
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include "node_lite.h"
+
+namespace node_api_tests {
+
+// Converts between UTF-8 and UTF-16 with SSE2, SSSE3, or AVX2 fast paths on
+// x64. The unpaired surrogates and the invalid UTF-8 sequences become
+// U+FFFD like in TextEncoder and TextDecoder.
+class NodeLiteUtf8 {
+ public:
+  // Returns the position of the first non-ASCII byte or the size.
+  static size_t FindNonAscii(const char* data, size_t size) noexcept;
+
+  // Returns true if the text is valid UTF-8.
+  static bool IsValid(const char* data, size_t size) noexcept;
+
+  // Decodes UTF-8 to UTF-16. The output must have room for size code units.
+  // Each maximal invalid subsequence is replaced with U+FFFD.
+  // Returns the number of written code units.
+  static size_t DecodeToUtf16(const char* data,
+                              size_t size,
+                              char16_t* output) noexcept;
+
+  // Returns the length of the incomplete sequence at the end of a chunk,
+  // which may be completed by the next chunk: from 0 to 3 bytes.
+  static size_t GetIncompleteLength(const char* data, size_t size) noexcept;
+
+  // Returns the UTF-8 length of UTF-16 text.
+  static size_t GetEncodedLength(const char16_t* data, size_t size) noexcept;
+
+  // Encodes UTF-16 to UTF-8 until the input ends or the next character does
+  // not fit into the output. Sets read to the number of read code units.
+  // Returns the number of written bytes.
+  static size_t EncodeFromUtf16(const char16_t* data,
+                                size_t size,
+                                char* output,
+                                size_t capacity,
+                                size_t& read) noexcept;
+};
+
+// The UTF-16 code units of a JS string. The short strings are copied to a
+// buffer inside the object.
+class NodeLiteStringUtf16 {
+ public:
+  static constexpr size_t kStackBufferSize = 512;
+
+  NodeLiteStringUtf16(napi_env env, napi_value value);
+
+  NodeLiteStringUtf16(const NodeLiteStringUtf16&) = delete;
+  NodeLiteStringUtf16& operator=(const NodeLiteStringUtf16&) = delete;
+
+  const char16_t* data() const noexcept { return data_; }
+  size_t size() const noexcept { return size_; }
+
+ private:
+  char16_t stack_buffer_[kStackBufferSize];
+  std::unique_ptr<char16_t[]> heap_buffer_;
+  char16_t* data_{};
+  size_t size_{};
+};
+
+// The native part of the "util" module.
+class NodeLiteText {
+ public:
+  // The UTF-8 texts of this length or longer with non-ASCII characters are
+  // decoded into external UTF-16 strings without a copy to the JS heap.
+  static constexpr size_t kExternalStringMinLength = 4096;
+
+  // The JS source of the module function. It receives the binding object and
+  // the require function and returns the module exports.
+  static const std::string_view kModuleSource;
+
+  static napi_value CreateBinding(napi_env env);
+
+  // Creates a string from UTF-8 text.
+  static napi_value CreateString(napi_env env, const char* data, size_t size);
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_TEXT_H
@@ -0,0 +1,190 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "node_lite_watcher.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace node_api_tests {
+
+namespace {
+
+// Editors often write a file in several steps. The changes are collected
+// until there are no new changes for this period.
+constexpr std::chrono::milliseconds kDebouncePeriod{50};
+
+constexpr std::chrono::milliseconds kPollPeriod{200};
+
+// Checks the file modification times periodically.
+class PollingFileWatcher : public NodeLiteFileWatcher {
+ public:
+  void Watch(const fs::path& file_path) override {
+    std::error_code ec;
+    fs::file_time_type write_time = fs::last_write_time(file_path, ec);
+    std::scoped_lock lock{mutex_};
+    write_times_.try_emplace(file_path.string(), write_time);
+  }
+
+  std::vector<fs::path> WaitForChanges() override {
+    std::unique_lock lock{mutex_};
+    std::vector<fs::path> changed;
+    for (;;) {
+      if (stop_requested_.wait_for(
+              lock, changed.empty() ? kPollPeriod : kDebouncePeriod, [this]() {
+                return is_stopped_;
+              })) {
+        return {};
+      }
+      size_t changed_count = changed.size();
+      for (auto& [file_path, write_time] : write_times_) {
+        std::error_code ec;
+        fs::file_time_type new_write_time = fs::last_write_time(file_path, ec);
+        if (new_write_time != write_time) {
+          write_time = new_write_time;
+          changed.emplace_back(file_path);
+        }
+      }
+      if (!changed.empty() && changed.size() == changed_count) {
+        return changed;
+      }
+    }
+  }
+
+  void Stop() override {
+    std::scoped_lock lock{mutex_};
+    is_stopped_ = true;
+    stop_requested_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable stop_requested_;
+  std::unordered_map<std::string, fs::file_time_type> write_times_;
+  bool is_stopped_{false};
+};
+
+#ifdef __linux__
+
+// Watches the folders of the files with inotify.
+class InotifyFileWatcher : public NodeLiteFileWatcher {
+ public:
+  InotifyFileWatcher(int inotify_fd, int stop_read_fd, int stop_write_fd)
+      : inotify_fd_(inotify_fd),
+        stop_read_fd_(stop_read_fd),
+        stop_write_fd_(stop_write_fd) {}
+
+  ~InotifyFileWatcher() override {
+    ::close(inotify_fd_);
+    ::close(stop_read_fd_);
+    ::close(stop_write_fd_);
+  }
+
+  void Watch(const fs::path& file_path) override {
+    std::scoped_lock lock{mutex_};
+    if (!files_.insert(file_path.string()).second) {
+      return;
+    }
+    std::string dir = file_path.parent_path().string();
+    if (watched_dirs_.count(dir) != 0) {
+      return;
+    }
+    // Saving a file either writes it in place or renames a new file over it.
+    int watch_descriptor = ::inotify_add_watch(
+        inotify_fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch_descriptor >= 0) {
+      watched_dirs_.insert(dir);
+      dirs_.try_emplace(watch_descriptor, std::move(dir));
+    }
+  }
+
+  std::vector<fs::path> WaitForChanges() override {
+    std::set<std::string> changed;
+    for (;;) {
+      pollfd poll_fds[2] = {{inotify_fd_, POLLIN, 0},
+                            {stop_read_fd_, POLLIN, 0}};
+      int timeout_ms =
+          changed.empty() ? -1 : static_cast<int>(kDebouncePeriod.count());
+      int ready_count = ::poll(poll_fds, 2, timeout_ms);
+      if (ready_count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return {};
+      }
+      if (ready_count == 0) {
+        return std::vector<fs::path>(changed.begin(), changed.end());
+      }
+      if (poll_fds[1].revents != 0) {
+        return {};
+      }
+      alignas(inotify_event) char buffer[4096];
+      ssize_t size = ::read(inotify_fd_, buffer, sizeof(buffer));
+      if (size <= 0) {
+        continue;
+      }
+      std::scoped_lock lock{mutex_};
+      for (char* ptr = buffer; ptr < buffer + size;) {
+        const inotify_event* event = reinterpret_cast<inotify_event*>(ptr);
+        ptr += sizeof(inotify_event) + event->len;
+        auto it = dirs_.find(event->wd);
+        if (it == dirs_.end() || event->len == 0) {
+          continue;
+        }
+        std::string file_path = (fs::path(it->second) / event->name).string();
+        if (files_.count(file_path) != 0) {
+          changed.insert(std::move(file_path));
+        }
+      }
+    }
+  }
+
+  void Stop() override {
+    char byte = 0;
+    [[maybe_unused]] ssize_t result = ::write(stop_write_fd_, &byte, 1);
+  }
+
+ private:
+  int inotify_fd_;
+  int stop_read_fd_;
+  int stop_write_fd_;
+  std::mutex mutex_;
+  std::unordered_set<std::string> files_;
+  std::unordered_set<std::string> watched_dirs_;
+  std::unordered_map<int, std::string> dirs_;
+};
+
+#endif  // __linux__
+
+}  // namespace
+
+/*static*/ std::unique_ptr<NodeLiteFileWatcher> NodeLiteFileWatcher::Create() {
+#ifdef __linux__
+  int inotify_fd = ::inotify_init1(IN_CLOEXEC);
+  int stop_fds[2]{-1, -1};
+  if (inotify_fd >= 0 && ::pipe2(stop_fds, O_CLOEXEC) == 0) {
+    return std::make_unique<InotifyFileWatcher>(
+        inotify_fd, stop_fds[0], stop_fds[1]);
+  }
+  if (inotify_fd >= 0) {
+    ::close(inotify_fd);
+  }
+#endif
+  return std::make_unique<PollingFileWatcher>();
+}
+
+}  // namespace node_api_tests
@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// File change notifications for the --watch mode.
+
+#ifndef NODE_API_TEST_NODE_LITE_WATCHER_H
+#define NODE_API_TEST_NODE_LITE_WATCHER_H
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace node_api_tests {
+
+// Watches files for changes.
+// On Linux it uses inotify on the folders of the watched files, so that the
+// editors that save files by renaming a temporary file are supported.
+// On other platforms it polls the file modification times.
+class NodeLiteFileWatcher {
+ public:
+  static std::unique_ptr<NodeLiteFileWatcher> Create();
+
+  virtual ~NodeLiteFileWatcher() = default;
+
+  // Adds the file to the watched set. Can be called from any thread.
+  virtual void Watch(const std::filesystem::path& file_path) = 0;
+
+  // Blocks until some watched files change and returns them. The changes
+  // that follow each other within a short period are returned together.
+  // Returns an empty list after Stop is called.
+  virtual std::vector<std::filesystem::path> WaitForChanges() = 0;
+
+  // Unblocks the WaitForChanges. Can be called from any thread.
+  virtual void Stop() = 0;
+};
+
+}  // namespace node_api_tests
+
+#endif  // !NODE_API_TEST_NODE_LITE_WATCHER_H
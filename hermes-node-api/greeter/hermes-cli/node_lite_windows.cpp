@@ -7,19 +7,198 @@
 
 namespace node_api_tests {
 
+namespace {
+
+// Appends the argument to the command line with the quoting rules of
+// CommandLineToArgvW, so that the child process gets it unchanged.
+void AppendQuotedArgument(std::wstring& command_line,
+                          const std::wstring& arg) {
+  if (!command_line.empty()) {
+    command_line += L' ';
+  }
+  if (!arg.empty() && arg.find_first_of(L" \t\n\v\"") == std::wstring::npos) {
+    command_line += arg;
+    return;
+  }
+  command_line += L'"';
+  for (auto it = arg.begin();; ++it) {
+    size_t backslash_count = 0;
+    while (it != arg.end() && *it == L'\\') {
+      ++it;
+      ++backslash_count;
+    }
+    if (it == arg.end()) {
+      // The backslashes before the closing quote are escaped.
+      command_line.append(backslash_count * 2, L'\\');
+      break;
+    }
+    if (*it == L'"') {
+      command_line.append(backslash_count * 2 + 1, L'\\');
+    } else {
+      command_line.append(backslash_count, L'\\');
+    }
+    command_line += *it;
+  }
+  command_line += L'"';
+}
+
+}  // namespace
+
 //=============================================================================
 // NodeLitePlatform implementation
 //=============================================================================
 
-/*static*/ void* NodeLitePlatform::LoadFunction(
-    napi_env env,
-    const std::filesystem::path& lib_path,
-    const std::string& function_name) noexcept {
-  HMODULE dll_module = ::LoadLibraryA(lib_path.string().c_str());
-  NODE_LITE_ASSERT(dll_module != NULL,
-                   "Failed to load DLL: %s. Error: %s",
-                   lib_path.c_str(),
-                   std::strerror(errno));
-  return ::GetProcAddress(dll_module, function_name.c_str());
+/*static*/ void* NodeLitePlatform::OpenLibrary(
+    const std::filesystem::path& lib_path, std::string& error) noexcept {
+  HMODULE lib_module = ::LoadLibraryW(lib_path.c_str());
+  if (lib_module == NULL) {
+    error = FormatString("Windows error code %lu", ::GetLastError());
+  }
+  return lib_module;
+}
+
+/*static*/ void* NodeLitePlatform::FindFunction(
+    void* lib_handle, const char* function_name) noexcept {
+  return ::GetProcAddress(static_cast<HMODULE>(lib_handle), function_name);
+}
+
+/*static*/ void NodeLitePlatform::CloseLibrary(void* lib_handle) noexcept {
+  ::FreeLibrary(static_cast<HMODULE>(lib_handle));
+}
+
+/*static*/ const void* NodeLitePlatform::MapFile(
+    const std::filesystem::path& file_path,
+    size_t& size,
+    std::string& error) noexcept {
+  HANDLE file = ::CreateFileW(file_path.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    error = FormatString("Windows error code %lu", ::GetLastError());
+    return nullptr;
+  }
+  LARGE_INTEGER file_size{};
+  if (!::GetFileSizeEx(file, &file_size)) {
+    error = FormatString("Windows error code %lu", ::GetLastError());
+    ::CloseHandle(file);
+    return nullptr;
+  }
+  if (file_size.QuadPart <= 0) {
+    error = "Empty file";
+    ::CloseHandle(file);
+    return nullptr;
+  }
+  // The view keeps the file and the mapping open.
+  HANDLE mapping =
+      ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  ::CloseHandle(file);
+  if (mapping == NULL) {
+    error = FormatString("Windows error code %lu", ::GetLastError());
+    return nullptr;
+  }
+  void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  ::CloseHandle(mapping);
+  if (data == nullptr) {
+    error = FormatString("Windows error code %lu", ::GetLastError());
+    return nullptr;
+  }
+  size = static_cast<size_t>(file_size.QuadPart);
+  return data;
 }
+
+/*static*/ void NodeLitePlatform::UnmapFile(const void* data,
+                                            size_t /*size*/) noexcept {
+  ::UnmapViewOfFile(data);
+}
+
+/*static*/ int64_t NodeLitePlatform::ReadStdin(char* buffer,
+                                              size_t size,
+                                              std::string& error) noexcept {
+  DWORD read_size{};
+  if (!::ReadFile(::GetStdHandle(STD_INPUT_HANDLE),
+                  buffer,
+                  static_cast<DWORD>(size),
+                  &read_size,
+                  nullptr)) {
+    DWORD error_code = ::GetLastError();
+    // The closed pipe is the end of the input.
+    if (error_code == ERROR_BROKEN_PIPE) {
+      return 0;
+    }
+    error = FormatString("Windows error code %lu", error_code);
+    return -1;
+  }
+  return read_size;
+}
+
+/*static*/ std::filesystem::path NodeLitePlatform::CreatePrivateTempDirectory(
+    std::string_view prefix, std::string& error) noexcept {
+  std::error_code ec;
+  std::filesystem::path temp_dir = std::filesystem::temp_directory_path(ec);
+  if (ec) {
+    error = ec.message();
+    return {};
+  }
+  // The folder inherits the ACL of the user temporary folder. The creation
+  // fails if the folder exists, so another user cannot prepare it.
+  for (uint32_t attempt = 0; attempt < 100; ++attempt) {
+    std::filesystem::path result =
+        temp_dir / FormatString("%.*s%lu-%lu",
+                                static_cast<int>(prefix.size()),
+                                prefix.data(),
+                                ::GetCurrentProcessId(),
+                                ::GetTickCount() + attempt);
+    if (::CreateDirectoryW(result.c_str(), nullptr)) {
+      return result;
+    }
+    if (::GetLastError() != ERROR_ALREADY_EXISTS) {
+      break;
+    }
+  }
+  error = FormatString("Windows error code %lu", ::GetLastError());
+  return {};
+}
+
+/*static*/ int32_t NodeLitePlatform::RunProcess(
+    const std::filesystem::path& program,
+    const std::vector<std::string>& args,
+    std::string& error) noexcept {
+  std::wstring command_line;
+  AppendQuotedArgument(command_line, program.wstring());
+  for (const std::string& arg : args) {
+    AppendQuotedArgument(command_line, std::filesystem::path(arg).wstring());
+  }
+  STARTUPINFOW startup_info{};
+  startup_info.cb = sizeof(startup_info);
+  PROCESS_INFORMATION process_info{};
+  if (!::CreateProcessW(nullptr,
+                        command_line.data(),
+                        nullptr,
+                        nullptr,
+                        FALSE,
+                        0,
+                        nullptr,
+                        nullptr,
+                        &startup_info,
+                        &process_info)) {
+    error = FormatString("Windows error code %lu", ::GetLastError());
+    return -1;
+  }
+  ::CloseHandle(process_info.hThread);
+  DWORD exit_code{};
+  bool has_exit_code =
+      ::WaitForSingleObject(process_info.hProcess, INFINITE) ==
+          WAIT_OBJECT_0 &&
+      ::GetExitCodeProcess(process_info.hProcess, &exit_code);
+  if (!has_exit_code) {
+    error = FormatString("Windows error code %lu", ::GetLastError());
+  }
+  ::CloseHandle(process_info.hProcess);
+  return has_exit_code ? static_cast<int32_t>(exit_code) : -1;
+}
+
 }  // namespace node_api_tests
@@ -1,22 +1,70 @@
 #include "node_api.h"
 #include "node_lite.h"
 
+#include <chrono>
 #include <condition_variable>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <unordered_set>
 
-// !!! This is a "fake" implementation of TSFN that is good enough to run
-// !!! the C# demo.
+// !!! This is a minimal implementation of TSFN that is good enough to run
+// !!! the demos.
 // !!! Do not use it in production code.
 
 // The TSFN function is based on Node.js code
 // The code is reduced to a minimal implementation for demonstration purposes.
 // It mostly delegates napi_call_threadsafe_function calls to the task runner.
+// The TSFN keeps the task runner alive until it is released by all threads
+// or unref'ed.
+
+using node_api_tests::ReportOnException;
+using node_api_tests::NodeApi;
+using node_api_tests::NodeApiHandleScope;
+using node_api_tests::NodeLiteErrorHandler;
+using node_api_tests::NodeLiteTsfnMetrics;
 
 std::shared_ptr<node_api_tests::NodeLiteTaskRunner> tsfnTaskRunner;
 
+class ThreadSafeFunction;
+
+namespace {
+
+// The registry is used only on the JS thread.
+std::unordered_set<ThreadSafeFunction*> live_tsfns;
+// Released threadsafe functions are merged by their resource name.
+std::map<std::string, NodeLiteTsfnMetrics> released_tsfn_metrics;
+
+void MergeTsfnMetrics(NodeLiteTsfnMetrics& target,
+                      const NodeLiteTsfnMetrics& source) {
+  target.released_count += source.released_count;
+  target.items_pushed += source.items_pushed;
+  target.items_dispatched += source.items_dispatched;
+  target.queue_high_water_mark =
+      std::max(target.queue_high_water_mark, source.queue_high_water_mark);
+  for (size_t i = 0; i < NodeLiteTsfnMetrics::kLatencyBucketCount; ++i) {
+    target.latency_histogram[i] += source.latency_histogram[i];
+  }
+  target.max_latency = std::max(target.max_latency, source.max_latency);
+  target.js_callback_time += source.js_callback_time;
+}
+
+size_t GetLatencyBucket(std::chrono::nanoseconds latency) {
+  uint64_t latency_us = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+  size_t bucket = 0;
+  while (latency_us != 0 &&
+         bucket + 1 < NodeLiteTsfnMetrics::kLatencyBucketCount) {
+    latency_us >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+}  // namespace
+
 class ThreadSafeFunction {
  public:
   ThreadSafeFunction(napi_value func,
@@ -29,7 +77,10 @@ class ThreadSafeFunction {
                      void* finalize_data,
                      napi_finalize finalize_cb,
                      napi_threadsafe_function_call_js call_js_cb)
-      : context_(context),
+      : max_queue_size_(max_queue_size),
+        thread_count_(thread_count),
+        context_(context),
+        task_runner_(tsfnTaskRunner),
         env_(env),
         finalize_data_(finalize_data),
         finalize_cb_(finalize_cb),
@@ -37,41 +88,189 @@ class ThreadSafeFunction {
     if (func != nullptr) {
       napi_create_reference(env, func, 1, &func_ref_);
     }
+    size_t name_length{};
+    if (napi_get_value_string_utf8(env, name, nullptr, 0, &name_length) ==
+        napi_ok) {
+      metrics_.resource_name.resize(name_length + 1);
+      napi_get_value_string_utf8(env,
+                                 name,
+                                 metrics_.resource_name.data(),
+                                 name_length + 1,
+                                 &name_length);
+      metrics_.resource_name.resize(name_length);
+    }
+    live_tsfns.insert(this);
+    task_runner_->Ref();
+  }
+
+  // Called on the JS thread.
+  NodeLiteTsfnMetrics GetMetrics() {
+    NodeLiteTsfnMetrics result = metrics_;
+    std::scoped_lock lock{mutex_};
+    result.items_pushed = items_pushed_;
+    result.queue_high_water_mark = queue_high_water_mark_;
+    return result;
   }
 
   napi_status Push(void* data, napi_threadsafe_function_call_mode mode) {
+    std::unique_lock lock{mutex_};
+    while (max_queue_size_ > 0 && queue_.size() >= max_queue_size_ &&
+           !is_closing_) {
+      if (mode == napi_tsfn_nonblocking) {
+        return napi_queue_full;
+      }
+      queue_space_.wait(lock);
+    }
+    if (is_closing_) {
+      return thread_count_ == 0 ? napi_invalid_arg : napi_closing;
+    }
+    queue_.push(QueueItem{data, std::chrono::steady_clock::now()});
+    ++items_pushed_;
+    queue_high_water_mark_ = std::max(queue_high_water_mark_, queue_.size());
+    SendLocked();
+    return napi_ok;
+  }
+
+  napi_status Acquire() {
     std::scoped_lock lock{mutex_};
-    queue_.push(data);
-    Send();
+    if (is_closing_) {
+      return napi_closing;
+    }
+    ++thread_count_;
     return napi_ok;
   }
 
+  napi_status Release(napi_threadsafe_function_release_mode mode) {
+    std::scoped_lock lock{mutex_};
+    if (thread_count_ == 0) {
+      return napi_invalid_arg;
+    }
+    --thread_count_;
+    if (thread_count_ == 0 || mode == napi_tsfn_abort) {
+      if (!is_closing_) {
+        is_closing_ = mode == napi_tsfn_abort;
+        if (is_closing_ && max_queue_size_ > 0) {
+          queue_space_.notify_all();
+        }
+        SendLocked();
+      }
+    }
+    return napi_ok;
+  }
+
+  // Ref and Unref are called on the JS thread.
+  void Ref() {
+    if (!is_refed_) {
+      is_refed_ = true;
+      task_runner_->Ref();
+    }
+  }
+
+  void Unref() {
+    if (is_refed_) {
+      is_refed_ = false;
+      task_runner_->Unref();
+    }
+  }
+
   void* Context() { return context_; }
 
  private:
+  // Calls JS for all queued items in one task.
+  // Items pushed while the batch is running are handled by the next task.
   void Dispatch() {
-    bool popped_value = false;
-    void* data = nullptr;
+    std::queue<QueueItem> batch;
+    bool is_aborted{};
+    bool is_released{};
     {
       std::scoped_lock lock{mutex_};
-      if (!queue_.empty()) {
-        data = queue_.front();
-        queue_.pop();
-        popped_value = true;
+      is_dispatch_pending_ = false;
+      is_aborted = is_closing_;
+      if (!is_aborted) {
+        std::swap(batch, queue_);
+        if (max_queue_size_ > 0) {
+          queue_space_.notify_all();
+        }
       }
+      is_released = thread_count_ == 0;
     }
-    if (popped_value) {
-      call_js_cb_(env_, nullptr, context_, data);
+
+    if (is_aborted) {
+      Finalize();
+      return;
     }
 
+    napi_env env = env_;
+    ReportOnException(env, [this, env, &batch]() {
+      using Clock = std::chrono::steady_clock;
+      Clock::time_point start_time = Clock::now();
+      while (!batch.empty()) {
+        NodeApiHandleScope scope{env};
+        napi_value func = func_ref_ != nullptr
+                              ? NodeApi::GetReferenceValue(env, func_ref_)
+                              : nullptr;
+        std::chrono::nanoseconds latency = start_time - batch.front().post_time;
+        ++metrics_.latency_histogram[GetLatencyBucket(latency)];
+        metrics_.max_latency = std::max(metrics_.max_latency, latency);
+        call_js_cb_(env, func, context_, batch.front().data);
+        batch.pop();
+        ++metrics_.items_dispatched;
+        Clock::time_point end_time = Clock::now();
+        metrics_.js_callback_time += end_time - start_time;
+        start_time = end_time;
+        if (NodeApi::IsExceptionPending(env)) {
+          NODE_LITE_CALL(napi_pending_exception);
+        }
+      }
+    });
+    // A callback error in the watch mode leaves the rest of the batch.
+    // The items are passed without env to free their data.
+    while (!batch.empty()) {
+      call_js_cb_(nullptr, nullptr, context_, batch.front().data);
+      batch.pop();
+    }
+
+    // Items pushed before the last release are dispatched by the next task.
+    if (is_released && IsQueueEmpty()) {
+      Finalize();
+    }
+  }
+
+  bool IsQueueEmpty() {
     std::scoped_lock lock{mutex_};
-    if (!queue_.empty()) {
-      Send();
+    return queue_.empty();
+  }
+
+  void SendLocked() {
+    if (!is_dispatch_pending_) {
+      is_dispatch_pending_ = true;
+      task_runner_->PostTask([this]() { Dispatch(); });
     }
   }
 
-  void Send() {
-    tsfnTaskRunner->PostTask([this]() { Dispatch(); });
+  // Called on the JS thread after the last release or abort.
+  // Aborted items are passed to call_js_cb_ without env to free their data.
+  void Finalize() {
+    while (!queue_.empty()) {
+      call_js_cb_(nullptr, nullptr, context_, queue_.front().data);
+      queue_.pop();
+    }
+    if (finalize_cb_ != nullptr) {
+      NodeApiHandleScope scope{env_};
+      finalize_cb_(env_, finalize_data_, context_);
+    }
+    if (func_ref_ != nullptr) {
+      napi_delete_reference(env_, func_ref_);
+    }
+    Unref();
+    live_tsfns.erase(this);
+    NodeLiteTsfnMetrics metrics = GetMetrics();
+    metrics.released_count = 1;
+    NodeLiteTsfnMetrics& released =
+        released_tsfn_metrics[metrics.resource_name];
+    released.resource_name = metrics.resource_name;
+    MergeTsfnMetrics(released, metrics);
+    delete this;
   }
 
   // Default way of calling into JavaScript. Used when ThreadSafeFunction is
@@ -99,13 +298,26 @@ class ThreadSafeFunction {
   }
 
  private:
+  struct QueueItem {
+    void* data;
+    std::chrono::steady_clock::time_point post_time;
+  };
+
   // These are variables protected by the mutex.
   std::mutex mutex_;
-  std::queue<void*> queue_;
+  std::condition_variable queue_space_;
+  std::queue<QueueItem> queue_;
+  uint64_t items_pushed_{0};
+  size_t queue_high_water_mark_{0};
+  size_t max_queue_size_{0};
+  size_t thread_count_{0};
+  bool is_closing_{false};
+  bool is_dispatch_pending_{false};
 
   // These are variables set once, upon creation, and then never again, which
   // means we don't need the mutex to read them.
   void* context_{nullptr};
+  std::shared_ptr<node_api_tests::NodeLiteTaskRunner> task_runner_;
 
   // These are variables accessed only from the loop thread.
   napi_ref func_ref_{nullptr};
@@ -113,8 +325,55 @@ class ThreadSafeFunction {
   void* finalize_data_{nullptr};
   napi_finalize finalize_cb_{nullptr};
   napi_threadsafe_function_call_js call_js_cb_{nullptr};
+  bool is_refed_{true};
+  // The metrics updated by the JS thread. The pushed items and the queue
+  // high water mark are kept above under the mutex.
+  NodeLiteTsfnMetrics metrics_;
 };
 
+namespace node_api_tests {
+
+std::vector<NodeLiteTsfnMetrics> GetThreadSafeFunctionMetrics() {
+  std::vector<NodeLiteTsfnMetrics> result;
+  result.reserve(live_tsfns.size() + released_tsfn_metrics.size());
+  for (ThreadSafeFunction* tsfn : live_tsfns) {
+    result.push_back(tsfn->GetMetrics());
+  }
+  std::sort(result.begin(),
+            result.end(),
+            [](const NodeLiteTsfnMetrics& left,
+               const NodeLiteTsfnMetrics& right) {
+              return left.resource_name < right.resource_name;
+            });
+  for (const auto& [name, metrics] : released_tsfn_metrics) {
+    result.push_back(metrics);
+  }
+  return result;
+}
+
+uint64_t NodeLiteTsfnMetrics::GetLatencyPercentileUs(
+    double percentile) const noexcept {
+  uint64_t total_count = 0;
+  for (uint64_t count : latency_histogram) {
+    total_count += count;
+  }
+  if (total_count == 0) {
+    return 0;
+  }
+  uint64_t target_count =
+      static_cast<uint64_t>(static_cast<double>(total_count) * percentile);
+  uint64_t count = 0;
+  for (size_t i = 0; i < kLatencyBucketCount; ++i) {
+    count += latency_histogram[i];
+    if (count > target_count || count == total_count) {
+      return uint64_t{1} << i;
+    }
+  }
+  return uint64_t{1} << (kLatencyBucketCount - 1);
+}
+
+}  // namespace node_api_tests
+
 NAPI_EXTERN napi_status NAPI_CDECL
 napi_create_threadsafe_function(napi_env env,
                                 napi_value func,
@@ -198,24 +457,26 @@ napi_call_threadsafe_function(napi_threadsafe_function func,
 
 NAPI_EXTERN napi_status NAPI_CDECL
 napi_acquire_threadsafe_function(napi_threadsafe_function func) {
-  // Do nothing in this fake implementation
-  return napi_ok;
+  if (func == nullptr) return napi_invalid_arg;
+  return reinterpret_cast<ThreadSafeFunction*>(func)->Acquire();
 }
 
 NAPI_EXTERN napi_status NAPI_CDECL napi_release_threadsafe_function(
     napi_threadsafe_function func, napi_threadsafe_function_release_mode mode) {
-  // Do nothing in this fake implementation
-  return napi_ok;
+  if (func == nullptr) return napi_invalid_arg;
+  return reinterpret_cast<ThreadSafeFunction*>(func)->Release(mode);
 }
 
 NAPI_EXTERN napi_status NAPI_CDECL napi_unref_threadsafe_function(
     node_api_basic_env env, napi_threadsafe_function func) {
-  // Do nothing in this fake implementation
+  if (func == nullptr) return napi_invalid_arg;
+  reinterpret_cast<ThreadSafeFunction*>(func)->Unref();
   return napi_ok;
 }
 
 NAPI_EXTERN napi_status NAPI_CDECL napi_ref_threadsafe_function(
     node_api_basic_env env, napi_threadsafe_function func) {
-  // Do nothing in this fake implementation
+  if (func == nullptr) return napi_invalid_arg;
+  reinterpret_cast<ThreadSafeFunction*>(func)->Ref();
   return napi_ok;
-}
\ No newline at end of file
+}